@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+namespace bench {
+
+/**
+ * The number of the heap allocations made by the process.
+ * Incremented by the global operator new replacement in the benchmark TU.
+ */
+extern size_t allocations;
+
+/**
+ * Keeps the compiler from optimizing the value away.
+ */
+template <typename T>
+inline void keep(T&& value) noexcept {
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+/**
+ * A hardware counter of the calling thread, see perf_event_open(2).
+ * The counter is silently unavailable if the kernel does not allow the access (perf_event_paranoid).
+ */
+class PerfCounter {
+
+	int _fd;
+
+public:
+
+	PerfCounter(const PerfCounter&) = delete;
+	PerfCounter& operator=(const PerfCounter&) = delete;
+
+	PerfCounter(uint32_t type, uint64_t config) noexcept : _fd(-1) {
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = type;
+		attr.size = sizeof(attr);
+		attr.config = config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		_fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+
+	~PerfCounter() noexcept {
+		if(_fd >= 0) {
+			close(_fd);
+		}
+	}
+
+	inline bool valid() const noexcept {
+		return _fd >= 0;
+	}
+
+	inline void start() noexcept {
+		if(_fd >= 0) {
+			ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+
+	inline uint64_t stop() noexcept {
+		uint64_t value = 0u;
+		if(_fd >= 0) {
+			ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+			if(read(_fd, &value, sizeof(value)) != sizeof(value)) {
+				value = 0u;
+			}
+		}
+		return value;
+	}
+};
+
+struct Result {
+	std::string name;
+	double ns_per_op;
+	double allocs_per_op;
+	double cache_misses_per_op;  // Negative if the counter is not available.
+	double instructions_per_op;  // Negative if the counter is not available.
+};
+
+class Runner {
+
+	FILE* _out;
+	std::vector<Result> _results;
+	PerfCounter _cache_misses;
+	PerfCounter _instructions;
+	unsigned _failures;  // The benchmarks not run as their input is rejected.
+
+public:
+
+	/**
+	 * @param out - The report stream.
+	 */
+	explicit Runner(FILE* out) noexcept :
+		_out(out),
+		_cache_misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES),
+		_instructions(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS),
+		_failures(0u) {
+	}
+
+	/**
+	 * Runs 'op' 'iterations' times after a warm-up of the tenth of that.
+	 */
+	template <typename Op>
+	void run(const char* name, const size_t iterations, Op&& op) noexcept {
+		for(size_t i = 0; i < iterations / 10u + 1u; ++i) {
+			op();
+		}
+
+		const auto allocs_before = allocations;
+		_cache_misses.start();
+		_instructions.start();
+		const auto time_before = now_ns();
+
+		for(size_t i = 0; i < iterations; ++i) {
+			op();
+		}
+
+		const auto time_after = now_ns();
+		const auto instructions = _instructions.stop();
+		const auto cache_misses = _cache_misses.stop();
+		const auto allocs = allocations - allocs_before;
+
+		const auto n = static_cast<double>(iterations);
+		Result res {
+			name,
+			static_cast<double>(time_after - time_before) / n,
+			static_cast<double>(allocs) / n,
+			_cache_misses.valid() ? static_cast<double>(cache_misses) / n : -1.,
+			_instructions.valid() ? static_cast<double>(instructions) / n : -1.
+		};
+		_results.push_back(res);
+		print(_out, res);
+	}
+
+	/**
+	 * Reports the benchmark failed instead of measuring an operation which does nothing.
+	 */
+	void fail(const char* name, const char* reason) noexcept {
+		fprintf(_out, "%-44s FAILED: %s\n", name, reason);
+		fflush(_out);
+		_failures++;
+	}
+
+	inline unsigned failures() const noexcept {
+		return _failures;
+	}
+
+	inline const std::vector<Result>& results() const noexcept {
+		return _results;
+	}
+
+	static void print_header(FILE* out) noexcept {
+		fprintf(out, "%-44s %14s %12s %14s %14s\n", "benchmark", "ns/op", "allocs/op", "cache-miss/op", "instr/op");
+	}
+
+	static void print(FILE* out, const Result& res) noexcept {
+		fprintf(out, "%-44s %14.1f %12.2f ", res.name.c_str(), res.ns_per_op, res.allocs_per_op);
+		if(res.cache_misses_per_op >= 0.) {
+			fprintf(out, "%14.2f ", res.cache_misses_per_op);
+		} else {
+			fprintf(out, "%14s ", "n/a");
+		}
+		if(res.instructions_per_op >= 0.) {
+			fprintf(out, "%14.1f\n", res.instructions_per_op);
+		} else {
+			fprintf(out, "%14s\n", "n/a");
+		}
+		fflush(out);
+	}
+
+	/**
+	 * Writes the results as 'name ns_per_op allocs_per_op' lines.
+	 */
+	bool save(const char* path) const noexcept {
+		FILE* out = fopen(path, "w");
+		if(out == nullptr) {
+			return false;
+		}
+		for(const auto& res : _results) {
+			fprintf(out, "%s %.1f %.2f\n", res.name.c_str(), res.ns_per_op, res.allocs_per_op);
+		}
+		fclose(out);
+		return true;
+	}
+
+	/**
+	 * The regression gate. A benchmark regresses if it gets slower than the baseline by more than
+	 * 'tolerance_percent' or makes more allocations per operation.
+	 * @return - The number of the regressions, or -1 if the baseline can not be read.
+	 */
+	int compare(const char* path, const double tolerance_percent) const noexcept {
+		std::ifstream in(path);
+		if(not in) {
+			return -1;
+		}
+
+		std::map<std::string, std::pair<double, double>> baseline;
+		std::string line;
+		while(std::getline(in, line)) {
+			std::istringstream ss(line);
+			std::string name;
+			double ns;
+			double allocs;
+			if(ss >> name >> ns >> allocs) {
+				baseline[name] = std::make_pair(ns, allocs);
+			}
+		}
+
+		int regressions = 0;
+		for(const auto& res : _results) {
+			const auto it = baseline.find(res.name);
+			if(it == baseline.end()) {
+				fprintf(_out, "%-44s no baseline\n", res.name.c_str());
+				continue;
+			}
+
+			const auto ns_base = it->second.first;
+			const auto allocs_base = it->second.second;
+			const auto delta_percent = ns_base > 0. ? (res.ns_per_op - ns_base) / ns_base * 100. : 0.;
+			const bool slower = delta_percent > tolerance_percent;
+			const bool allocates = res.allocs_per_op > allocs_base + .005;
+
+			fprintf(_out, "%-44s %+8.1f%% allocs %.2f -> %.2f %s\n", res.name.c_str(), delta_percent, allocs_base,
+			        res.allocs_per_op, (slower || allocates) ? "REGRESSION" : "ok");
+			regressions += (slower || allocates);
+		}
+		return regressions;
+	}
+
+private:
+
+	static inline uint64_t now_ns() noexcept {
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec);
+	}
+
+};
+
+}; // namespace bench
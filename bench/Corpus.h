@@ -0,0 +1,181 @@
+#pragma once
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+namespace bench {
+
+/**
+ * Fixed payloads shaped as the Binance responses.
+ * The large ones are generated deterministically, so every run parses exactly the same bytes.
+ */
+struct Corpus {
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/web-socket-streams.md#individual-symbol-ticker-streams
+	 */
+	static std::string symbol_ticker() {
+		return R"({"e":"24hrTicker","E":1672515782136,"s":"BNBBTC","p":"0.00150000","P":"250.000",)"
+		       R"("w":"0.00180000","x":"0.00090000","c":"0.00250000","Q":"10.00000000","b":"0.00240000",)"
+		       R"("B":"10.00000000","a":"0.00260000","A":"100.00000000","o":"0.00100000","h":"0.00250000",)"
+		       R"("l":"0.00100000","v":"10000.00000000","q":"18.00000000","O":0,"C":1672515782136,"F":0,)"
+		       R"("L":18150,"n":18151})";
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#account-information-user_data
+	 * @param balances_nb - The number of the extra assets besides BNB and BTC.
+	 */
+	static std::string account_information(const size_t balances_nb) {
+		std::string result;
+		result.reserve(128u + balances_nb * 80u);
+		result += R"({"makerCommission":15,"takerCommission":15,"buyerCommission":0,"sellerCommission":0,)"
+		          R"("commissionRates":{"maker":"0.00150000","taker":"0.00150000","buyer":"0.00000000",)"
+		          R"("seller":"0.00000000"},"canTrade":true,"canWithdraw":true,"canDeposit":true,"brokered":false,)"
+		          R"("requireSelfTradePrevention":false,"preventSor":false,"updateTime":123456789,)"
+		          R"("accountType":"SPOT","balances":[)";
+		result += R"({"asset":"BNB","free":"1000.00000000","locked":"0.00000000"},)";
+		result += R"({"asset":"BTC","free":"4723846.89208129","locked":"0.00000000"})";
+
+		char buffer[128];
+		for(size_t idx = 0; idx < balances_nb; ++idx) {
+			snprintf(buffer, sizeof(buffer), R"(,{"asset":"A%04zu","free":"%zu.%08zu","locked":"%zu.00000000"})",
+			         idx, idx * 7u, idx * 13u, idx % 3u);
+			result += buffer;
+		}
+
+		result += R"(],"permissions":["SPOT"],"uid":354937868})";
+		return result;
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#all-orders-user_data
+	 */
+	static std::string all_orders(const size_t orders_nb) {
+		std::string result;
+		result.reserve(16u + orders_nb * 560u);
+		result += "[";
+
+		char buffer[1024];
+		for(size_t idx = 0; idx < orders_nb; ++idx) {
+			snprintf(buffer, sizeof(buffer),
+			         R"(%s{"symbol":"BNBBTC","orderId":%zu,"orderListId":-1,"clientOrderId":"bintest-%08zu",)"
+			         R"("price":"0.%08zu","origQty":"1.00000000","executedQty":"1.00000000",)"
+			         R"("cummulativeQuoteQty":"0.01000000","status":"FILLED","timeInForce":"GTC","type":"MARKET",)"
+			         R"("side":"%s","stopPrice":"0.00000000","icebergQty":"0.00000000","time":%zu,)"
+			         R"("updateTime":%zu,"isWorking":true,"workingTime":%zu,"origQuoteOrderQty":"0.01000000",)"
+			         R"("selfTradePreventionMode":"NONE","preventedMatchId":0,"preventedQuantity":"0.00000000"})",
+			         idx ? "," : "", 1000u + idx, idx, 1000000u + idx, (idx & 1u) ? "SELL" : "BUY",
+			         1499827319559u + idx, 1499827319559u + idx, 1499827319559u + idx);
+			result += buffer;
+		}
+
+		result += "]";
+		return result;
+	}
+
+	/**
+	 * A typical signed query string.
+	 */
+	static std::string signed_query() {
+		return "symbol=BNBBTC&side=BUY&type=MARKET&quoteOrderQty=0.001000&timestamp=1672515782136";
+	}
+
+	/**
+	 * The SBE trades event of the ticker above, schema 1 version 0.
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/sbe-market-data-streams.md
+	 */
+	static std::string sbe_trades() {
+		std::string result;
+		sbe_header(result, 18u, 10000u);
+		put<int64_t>(result, 1672515782136000);   // eventTime
+		put<int64_t>(result, 1672515782136000);   // transactTime
+		put<int8_t>(result, -8);                  // priceExponent
+		put<int8_t>(result, -8);                  // qtyExponent
+		put<uint16_t>(result, 25u);               // trades: blockLength
+		put<uint32_t>(result, 1u);                // trades: numInGroup
+		put<int64_t>(result, 18150);              // id
+		put<int64_t>(result, 250000);             // price
+		put<int64_t>(result, 1000000000);         // qty
+		put<uint8_t>(result, 1u);                 // isBuyerMaker
+		sbe_symbol(result, "BNBBTC");
+		return result;
+	}
+
+	/**
+	 * The SBE partial book depth event.
+	 */
+	static std::string sbe_depth_snapshot(const size_t levels_nb) {
+		std::string result;
+		sbe_header(result, 18u, 10002u);
+		put<int64_t>(result, 1672515782136000);   // eventTime
+		put<int64_t>(result, 160);                // bookUpdateId
+		put<int8_t>(result, -8);                  // priceExponent
+		put<int8_t>(result, -8);                  // qtyExponent
+		for(const int64_t side : {-1, 1}) {
+			put<uint16_t>(result, 16u);
+			put<uint16_t>(result, static_cast<uint16_t>(levels_nb));
+			for(size_t idx = 0; idx < levels_nb; ++idx) {
+				put<int64_t>(result, 250000 + side * static_cast<int64_t>(idx + 1u) * 100);
+				put<int64_t>(result, static_cast<int64_t>(idx + 1u) * 100000000);
+			}
+		}
+		sbe_symbol(result, "BNBBTC");
+		return result;
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/web-socket-streams.md#diff-depth-stream
+	 * A capture record, the levels around 0.0025 of both sides.
+	 * @param update_id - Varies the quantities, so the consecutive updates change every level.
+	 */
+	static std::string depth_update(const size_t levels_nb, const uint64_t update_id) {
+		std::string result;
+		result.reserve(128u + levels_nb * 64u);
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), R"(/ws/bnbbtc@depth@100ms {"e":"depthUpdate","E":%llu,"s":"BNBBTC","U":%llu,"u":%llu,"b":[)",
+		         static_cast<unsigned long long>(1672515782136u + update_id), static_cast<unsigned long long>(update_id),
+		         static_cast<unsigned long long>(update_id));
+		result += buffer;
+		for(const int side : {-1, 1}) {
+			for(size_t idx = 0; idx < levels_nb; ++idx) {
+				snprintf(buffer, sizeof(buffer), R"(%s["0.%08zu","%zu.%08llu"])", idx ? "," : "",
+				         static_cast<size_t>(250000 + side * static_cast<int>(idx + 1u)), idx + 1u,
+				         static_cast<unsigned long long>((update_id & 1u) * 50000000u));
+				result += buffer;
+			}
+			result += (side < 0) ? R"(],"a":[)" : "]}";
+		}
+		return result;
+	}
+
+	static std::string secret_key() {
+		return "NhqPtmdSJYdKjVHjA7PZj4Mge3R5YNiP1e3UZjInClVN65XAbvqqM6A7H5fATj0j";
+	}
+
+private:
+
+	template <typename T>
+	static void put(std::string& out, const T value) {
+		char buffer[sizeof(T)];
+		memcpy(buffer, &value, sizeof(T));
+		out.append(buffer, sizeof(T));
+	}
+
+	static void sbe_header(std::string& out, const uint16_t block_length, const uint16_t template_id) {
+		put<uint16_t>(out, block_length);
+		put<uint16_t>(out, template_id);
+		put<uint16_t>(out, 1u);  // schemaId
+		put<uint16_t>(out, 0u);  // version
+	}
+
+	static void sbe_symbol(std::string& out, const char* symbol) {
+		put<uint8_t>(out, static_cast<uint8_t>(strlen(symbol)));
+		out.append(symbol);
+	}
+
+};
+
+}; // namespace bench
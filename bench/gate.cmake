@@ -0,0 +1,15 @@
+# The benchmark regression gate, run by 'make bench_gate'.
+# The baseline is specific to the machine, so none is committed: the gate is skipped until 'make bench_baseline'
+# records one. Otherwise it fails if any benchmark is slower than the baseline by more than TOLERANCE percent
+# or allocates more.
+#   cmake -DBENCH=<bintest_bench> -DBASELINE=<file> -DTOLERANCE=<percent> -P gate.cmake
+
+if(NOT EXISTS "${BASELINE}")
+    message(WARNING "bench_gate is skipped: no baseline '${BASELINE}'. Record one on this machine with 'make bench_baseline'.")
+    return()
+endif()
+
+execute_process(COMMAND "${BENCH}" -b "${BASELINE}" -t "${TOLERANCE}" RESULT_VARIABLE BENCH_RESULT)
+if(NOT BENCH_RESULT EQUAL 0)
+    message(FATAL_ERROR "bench_gate has failed against '${BASELINE}' with the tolerance of ${TOLERANCE}%.")
+endif()
@@ -0,0 +1,568 @@
+#include <cstdlib>
+#include <new>
+#include <fcntl.h>
+
+#include "Bench.h"
+#include "Corpus.h"
+
+#include "CliConfig.h"
+#include "binance/rest/Connector.h"
+#include "binance/ws/Connector.h"
+#include "market/Plane.h"
+#include "market/Triangles.h"
+#include "pnl/Position.h"
+#include "shm/Publisher.h"
+#include "shm/Subscriber.h"
+#include "sim/Exchange.h"
+#include "sim/Latency.h"
+#include "sim/Market.h"
+#include "app/AppDefault.h"
+#include "coro/Task.h"
+#include "coro/Runtime.h"
+
+// ---------------------------------
+// The allocations accounting.
+// ---------------------------------
+
+size_t bench::allocations = 0u;
+
+void* operator new(size_t size) {
+	bench::allocations++;
+	void* ptr = malloc(size ? size : 1u);
+	if(ptr == nullptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept {
+	free(ptr);
+}
+
+// ---------------------------------
+// The access to the AppDefault internals.
+// ---------------------------------
+
+namespace bench {
+
+struct AppDefaultProbe {
+
+	/**
+	 * Puts the state machine into the Trading state with no timeout in the sight.
+	 */
+	static void trading(AppDefault& app, const double price) noexcept {
+		app._state = AppDefault::State::Trading;
+		app._price_start = price;
+		app._price_last = price;
+		app._next_event = ~std::time_t(0u) >> 1u;
+	}
+
+	static inline void price_update(AppDefault& app, const double price) noexcept {
+		app.price_update(price);
+	}
+
+	/**
+	 * Subscribes the app to the plane as init() does, but with no stream registered.
+	 */
+	static void subscribe(market::Plane& plane, AppDefault& app) noexcept {
+		plane.feed(app._sym_pair).subscribers.push_back(
+			market::Plane::Subscriber{AppDefault::cb_tick, AppDefault::cb_stream_state, &app});
+	}
+
+	/**
+	 * The frame as the stream of the app's pair delivers it: parsed and stored by the plane, fanned out.
+	 */
+	static inline int ticker(market::Plane& plane, AppDefault& app, std::string_view text) noexcept {
+		return market::Plane::cb_ticker(&plane.feed(app._sym_pair), text);
+	}
+
+};
+
+}; // namespace bench
+
+// ---------------------------------
+// The benchmarks.
+// ---------------------------------
+
+static bool match(const char* filter, const char* name) noexcept {
+	return filter == nullptr || strstr(name, filter) != nullptr;
+}
+
+/**
+ * @return - The payloads of the capture written by 'bintest -X'.
+ */
+static std::vector<std::string> load_capture(const char* path) {
+	std::vector<std::string> result;
+	std::ifstream in(path);
+	std::string line;
+	while(std::getline(in, line)) {
+		const auto space = line.find(' ');
+		if(space != std::string::npos) {
+			result.emplace_back(line.substr(space + 1u));
+		}
+	}
+	return result;
+}
+
+/**
+ * Awaits the price moves forever.
+ */
+static coro::Task<> price_move_loop(coro::Runtime& rt, const double pct, size_t& moves) noexcept {
+	for(;;) {
+		co_await rt.price_move(pct);
+		moves++;
+	}
+}
+
+static void run_all(bench::Runner& runner, const char* filter, const size_t scale, const char* capture_path) {
+	using namespace bench;
+
+	Json::Reader reader;
+
+	// ws::SymbolTicker::parse
+	{
+		const auto payload = Corpus::symbol_ticker();
+		Json::Value root;
+		reader.parse(payload, root);
+
+		if(match(filter, "ws::SymbolTicker::parse")) {
+			binance::ws::SymbolTicker ticker;
+			runner.run("ws::SymbolTicker::parse", 200000u * scale, [&]() {
+				ticker.parse(root);
+				keep(ticker);
+			});
+		}
+
+		if(match(filter, "ws::SymbolTicker::parse_text")) {
+			binance::ws::SymbolTicker ticker;
+			runner.run("ws::SymbolTicker::parse_text", 1000000u * scale, [&]() {
+				ticker.parse(std::string_view(payload));
+				keep(ticker);
+			});
+		}
+
+		if(match(filter, "ws::SymbolTicker::json+parse")) {
+			binance::ws::SymbolTicker ticker;
+			runner.run("ws::SymbolTicker::json+parse", 100000u * scale, [&]() {
+				Json::Value json;
+				reader.parse(payload, json);
+				ticker.parse(json);
+				keep(ticker);
+			});
+		}
+	}
+
+	// sbe::Frame::wrap
+	if(match(filter, "sbe::Frame::wrap/trades")) {
+		const auto payload = Corpus::sbe_trades();
+		binance::sbe::Frame check;
+		if(check.wrap(payload.data(), payload.size()) && check.trades()) {
+			binance::ws::SymbolTicker ticker;
+			runner.run("sbe::Frame::wrap/trades", 1000000u * scale, [&]() {
+				binance::sbe::Frame frame;
+				if(frame.wrap(payload.data(), payload.size())) {
+					ticker.parse(*frame.trades());
+				}
+				keep(ticker);
+			});
+		} else {
+			runner.fail("sbe::Frame::wrap/trades", "the frame is rejected");
+		}
+	}
+
+	if(match(filter, "sbe::Frame::wrap/depth20")) {
+		const auto payload = Corpus::sbe_depth_snapshot(20u);
+		binance::sbe::Frame check;
+		if(check.wrap(payload.data(), payload.size()) && check.depth_snapshot()
+		   && check.depth_snapshot()->bids().size() == 20u) {
+			runner.run("sbe::Frame::wrap/depth20", 1000000u * scale, [&]() {
+				binance::sbe::Frame frame;
+				double notional = 0.;
+				if(frame.wrap(payload.data(), payload.size())) {
+					const auto& bids = frame.depth_snapshot()->bids();
+					for(size_t idx = 0; idx < bids.size(); ++idx) {
+						notional += bids[idx].price() * bids[idx].qty();
+					}
+				}
+				keep(notional);
+			});
+		} else {
+			runner.fail("sbe::Frame::wrap/depth20", "the frame is rejected");
+		}
+	}
+
+	// rest::AccountInformation::parse
+	for(const size_t balances_nb : {10u, 500u}) {
+		const auto payload = Corpus::account_information(balances_nb);
+		Json::Value root;
+		reader.parse(payload, root);
+
+		const auto name = "rest::AccountInformation::parse/" + std::to_string(balances_nb);
+		if(match(filter, name.c_str())) {
+			binance::rest::AccountInformation info;
+			runner.run(name.c_str(), 20000u * scale / balances_nb + 10u, [&]() {
+				info.parse(root);
+				keep(info);
+			});
+		}
+
+		const auto name_body = "rest::AccountInformation::parse_body/" + std::to_string(balances_nb);
+		if(match(filter, name_body.c_str())) {
+			binance::rest::AccountInformation info;
+			const std::string_view body(payload);
+			runner.run(name_body.c_str(), 20000u * scale / balances_nb + 10u, [&]() {
+				info.parse(body);
+				keep(info);
+			});
+		}
+
+		const auto name_get = "rest::AccountInformation::get_balance/" + std::to_string(balances_nb);
+		if(match(filter, name_get.c_str())) {
+			binance::rest::AccountInformation info;
+			info.parse(root);
+			const std::string symbol("btc");
+			double balance = 0.;
+			runner.run(name_get.c_str(), 200000u * scale / balances_nb + 10u, [&]() {
+				info.get_balance(symbol, balance);
+				keep(balance);
+			});
+		}
+
+		const auto name_id = "rest::AccountInformation::get_balance_id/" + std::to_string(balances_nb);
+		if(match(filter, name_id.c_str())) {
+			binance::rest::AccountInformation info;
+			info.parse(root);
+			const auto asset = binance::Assets::intern("BTC");
+			double balance = 0.;
+			runner.run(name_id.c_str(), 1000000u * scale, [&]() {
+				info.get_balance(asset, balance);
+				keep(balance);
+			});
+		}
+
+		const auto name_diff = "rest::AccountInformation::diff/" + std::to_string(balances_nb);
+		if(match(filter, name_diff.c_str())) {
+			binance::rest::AccountInformation prev;
+			binance::rest::AccountInformation last;
+			prev.parse(root);
+			last.parse(root);
+			last.balances.front().free += 1.;
+			binance::rest::AccountInformation::BalanceDeltas_t deltas;
+			runner.run(name_diff.c_str(), 2000000u * scale / balances_nb + 10u, [&]() {
+				binance::rest::AccountInformation::diff(prev, last, deltas);
+				keep(deltas);
+			});
+		}
+	}
+
+	// rest::AllOrders::parse
+	for(const size_t orders_nb : {1u, 1000u}) {
+		const auto payload = Corpus::all_orders(orders_nb);
+		Json::Value root;
+		reader.parse(payload, root);
+
+		const auto name = "rest::AllOrders::parse/" + std::to_string(orders_nb);
+		if(match(filter, name.c_str())) {
+			binance::rest::AllOrders orders;
+			runner.run(name.c_str(), 20000u * scale / orders_nb + 10u, [&]() {
+				orders.parse(root);
+				keep(orders);
+			});
+		}
+
+		const auto name_json = "rest::AllOrders::json+parse/" + std::to_string(orders_nb);
+		if(match(filter, name_json.c_str())) {
+			binance::rest::AllOrders orders;
+			runner.run(name_json.c_str(), 5000u * scale / orders_nb + 10u, [&]() {
+				Json::Value json;
+				reader.parse(payload, json);
+				orders.parse(json);
+				keep(orders);
+			});
+		}
+
+		// The whole request lifetime: the body is received into the arena, parsed and released.
+		const auto name_view = "rest::AllOrdersView::body+parse/" + std::to_string(orders_nb);
+		if(match(filter, name_view.c_str())) {
+			Arena arena;
+			binance::rest::AllOrdersView orders(arena);
+			runner.run(name_view.c_str(), 5000u * scale / orders_nb + 10u, [&]() {
+				orders.body.assign(payload.data(), payload.size());
+				orders.parse(orders.body);
+				keep(orders);
+				orders.reset();
+			});
+		}
+	}
+
+	// rest::Connector::sign
+	if(match(filter, "rest::Connector::sign")) {
+		binance::rest::Connector conn(nullptr, "", "api-key", Corpus::secret_key());
+		const auto query = Corpus::signed_query();
+		runner.run("rest::Connector::sign", 100000u * scale, [&]() {
+			auto signature = conn.sign(query);
+			keep(signature);
+		});
+	}
+
+	// Utils::bin_to_hex
+	if(match(filter, "Utils::bin_to_hex")) {
+		uint8_t digest[32];
+		for(size_t idx = 0; idx < sizeof(digest); ++idx) {
+			digest[idx] = static_cast<uint8_t>(idx * 37u);
+		}
+		runner.run("Utils::bin_to_hex", 1000000u * scale, [&]() {
+			auto hex = Utils::bin_to_hex(digest, sizeof(digest));
+			keep(hex);
+		});
+	}
+
+	// AppDefault::handle_event
+	if(match(filter, "AppDefault::")) {
+		CliConfig cli;
+		binance::rest::Connector rest_conn(nullptr, "", "api-key", Corpus::secret_key());
+		binance::ws::Connector ws_conn;
+		market::Plane plane(ws_conn, false, cli.tick_store_sec);
+		AppDefault app(rest_conn, plane, cli);
+		AppDefaultProbe::subscribe(plane, app);
+
+		// The prices stay within the trigger, so the machine keeps Trading.
+		const double price = 100.;
+		const double step = price * cli.price_trigger_percent / 1000.;
+
+		if(match(filter, "AppDefault::handle_event/PriceUpdated")) {
+			AppDefaultProbe::trading(app, price);
+			size_t idx = 0;
+			runner.run("AppDefault::handle_event/PriceUpdated", 100000u * scale, [&]() {
+				AppDefaultProbe::price_update(app, price + step * static_cast<double>(idx++ & 7u));
+			});
+		}
+
+		if(match(filter, "AppDefault::cb_ticker")) {
+			const auto payload = Corpus::symbol_ticker();
+			binance::ws::SymbolTicker ticker;
+			ticker.parse(std::string_view(payload));
+			AppDefaultProbe::trading(app, ticker.lastPrice);
+			runner.run("AppDefault::cb_ticker", 100000u * scale, [&]() {
+				AppDefaultProbe::ticker(plane, app, payload);
+			});
+		}
+
+		if(capture_path && match(filter, "AppDefault::replay")) {
+			const auto capture = load_capture(capture_path);
+			if(not capture.empty()) {
+				CliConfig cli_replay;
+				cli_replay.price_trigger_percent = 1e9; // Keeps the machine Trading whatever the capture is.
+				params::Store::instance().publish(cli_replay.params());
+				market::Plane plane_replay(ws_conn, false, cli_replay.tick_store_sec);
+				AppDefault app_replay(rest_conn, plane_replay, cli_replay);
+				AppDefaultProbe::subscribe(plane_replay, app_replay);
+				AppDefaultProbe::trading(app_replay, 1.);
+
+				size_t idx = 0;
+				runner.run("AppDefault::replay", capture.size() * scale, [&]() {
+					AppDefaultProbe::ticker(plane_replay, app_replay, capture[idx]);
+					idx = (idx + 1u < capture.size()) ? idx + 1u : 0u;
+				});
+				params::Store::instance().publish(cli.params());
+				params::Store::instance().reclaim();
+			}
+		}
+	}
+
+	// coro::Runtime; one suspension and one resumption per iteration.
+	if(match(filter, "coro::Runtime::price_move")) {
+		binance::rest::Connector rest_conn(nullptr, "", "api-key", Corpus::secret_key());
+		binance::ws::Connector ws_conn;
+		coro::Runtime rt(rest_conn, ws_conn, false);
+		size_t moves = 0u;
+
+		rt.price(100.);
+		auto task = price_move_loop(rt, 1., moves);
+		task.start();
+
+		size_t idx = 0;
+		runner.run("coro::Runtime::price_move", 1000000u * scale, [&]() {
+			rt.price((idx++ & 1u) ? 100. : 102.);
+			rt.poll(0u);
+		});
+		keep(moves);
+	}
+
+	// market::Triangles; a quote of one of the 276 pairs over 24 assets, all connected.
+	if(match(filter, "market::Triangles::update")) {
+		market::Triangles triangles;
+		std::vector<binance::AssetId> assets;
+		for(unsigned idx = 0; idx < 24u; ++idx) {
+			assets.push_back(binance::Assets::intern("BENCH" + std::to_string(idx)));
+		}
+		for(size_t base = 0; base < assets.size(); ++base) {
+			for(size_t quote = base + 1u; quote < assets.size(); ++quote) {
+				triangles.add_pair(assets[base], assets[quote]);
+			}
+		}
+		triangles.build(0.001, 0.0005);
+		for(uint32_t pair = 0; pair < triangles.pairs_nb(); ++pair) {
+			triangles.update(pair, 0.999, 1.001);
+		}
+
+		uint32_t pair = 0;
+		size_t idx = 0;
+		runner.run("market::Triangles::update", 1000000u * scale, [&]() {
+			const double move = 0.0001 * static_cast<double>(idx++ & 7u);
+			triangles.update(pair, 0.999 + move, 1.001 + move);
+			pair = (pair + 1u < triangles.pairs_nb()) ? pair + 1u : 0u;
+		});
+		keep(triangles.evaluations());
+	}
+
+	// pnl::Position; the mark to market of a tick, an open position.
+	if(match(filter, "pnl::Position::mark")) {
+		pnl::Position position(pnl::Portfolio::instance(), binance::Assets::intern(Config::BasicSymbol),
+		                       binance::Assets::intern("BENCHQ"));
+		position.fill(1, true, 10., 0.0025, 0., binance::Assets::intern(Config::BasicSymbol));
+		size_t idx = 0;
+		runner.run("pnl::Position::mark", 1000000u * scale, [&]() {
+			position.mark(0.0025 + 0.000001 * static_cast<double>(idx++ & 7u));
+		});
+		keep(position.unrealized());
+	}
+
+	// sim::Market; a depth update of 20 levels a side through the book and a resting order of the backtest.
+	if(match(filter, "sim::Market::process")) {
+		sim::Latency latency;
+		sim::Market market(latency);
+		market.add_pair(Config::BasicSymbol, "BTC");
+		sim::Exchange exchange(market);
+		const std::string updates[2] = {Corpus::depth_update(20u, 1u), Corpus::depth_update(20u, 2u)};
+		market.process(updates[0]);
+		exchange.request(sim::Exchange::Method::Post, "order",
+		                 "symbol=BNBBTC&side=BUY&type=LIMIT_MAKER&quantity=1&price=0.00249990&newClientOrderId=bench");
+
+		size_t idx = 0;
+		runner.run("sim::Market::process", 100000u * scale, [&]() {
+			market.process(updates[idx++ & 1u]);
+		});
+		keep(market.pair(0u).book.best(sim::Book::Side::Bid));
+	}
+
+	// shm::Publisher -> shm::Subscriber; a tick through the market data bus, the reader keeping up.
+	if(match(filter, "shm::Ring::publish_read")) {
+		shm::Publisher publisher;
+		shm::Subscriber subscriber;
+		if(publisher.create("/bintest_bench", 1024u) && subscriber.open("/bintest_bench")) {
+			binance::ws::SymbolTicker ticker;
+			ticker.parse(std::string_view(Corpus::symbol_ticker()));
+			shm::Tick tick;
+			runner.run("shm::Ring::publish_read", 1000000u * scale, [&]() {
+				publisher.publish(ticker);
+				subscriber.read(tick);
+			});
+			keep(tick.last_price);
+		}
+	}
+}
+
+static void print_usage(FILE* out, const char* bin) noexcept {
+	fprintf(out, "usage %s [options]\n", bin);
+	fprintf(out, "\t-f String. Run the benchmarks which names contain the string only.\n");
+	fprintf(out, "\t-n Integer. Iterations scale. [default value = 1]\n");
+	fprintf(out, "\t-r String. Replay the WebSocket capture recorded by 'bintest -X' through AppDefault.\n");
+	fprintf(out, "\t-s String. Save the results as the baseline file.\n");
+	fprintf(out, "\t-b String. Compare the results with the baseline file, fail on a regression.\n");
+	fprintf(out, "\t-t Float. Tolerated slowdown percent for -b. [default value = 10.0]\n");
+	fprintf(out, "\t-h Print this screen and exit.\n");
+}
+
+int main(int argc, char** argv) {
+	const char* filter = nullptr;
+	const char* save_path = nullptr;
+	const char* baseline_path = nullptr;
+	const char* capture_path = nullptr;
+	unsigned scale = 1u;
+	double tolerance = 10.;
+
+	int opt;
+	while((opt = getopt(argc, argv, "f:n:r:s:b:t:h")) != EOF) {
+		switch(opt) {
+			case 'f':
+				filter = optarg;
+				break;
+
+			case 'n':
+				if(not cli::Integer::parse(optarg, scale) || scale == 0u) {
+					print_usage(stderr, argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+
+			case 'r':
+				capture_path = optarg;
+				break;
+
+			case 's':
+				save_path = optarg;
+				break;
+
+			case 'b':
+				baseline_path = optarg;
+				break;
+
+			case 't':
+				if(not cli::Float::parse(optarg, tolerance)) {
+					print_usage(stderr, argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+
+			case 'h':
+				print_usage(stdout, argv[0]);
+				return EXIT_SUCCESS;
+
+			default:
+				print_usage(stderr, argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	// The application logging goes to the standard output, so the report takes its own copy of it.
+	FILE* report = fdopen(dup(STDOUT_FILENO), "w");
+	const int null_fd = open("/dev/null", O_WRONLY);
+	if(report == nullptr || null_fd < 0) {
+		fprintf(stderr, "Unable to redirect the standard output.\n");
+		return EXIT_FAILURE;
+	}
+	fflush(stdout);
+	dup2(null_fd, STDOUT_FILENO);
+
+	bench::Runner runner(report);
+	bench::Runner::print_header(report);
+	run_all(runner, filter, scale, capture_path);
+
+	int err = runner.failures() ? EXIT_FAILURE : EXIT_SUCCESS;
+
+	if(save_path) {
+		if(not runner.save(save_path)) {
+			fprintf(stderr, "Unable to save the baseline '%s'.\n", save_path);
+			err = EXIT_FAILURE;
+		}
+	}
+
+	if(baseline_path) {
+		const auto regressions = runner.compare(baseline_path, tolerance);
+		if(regressions < 0) {
+			fprintf(stderr, "Unable to read the baseline '%s'.\n", baseline_path);
+			err = EXIT_FAILURE;
+		} else if(regressions > 0) {
+			fprintf(report, "%d regression(s) against '%s'.\n", regressions, baseline_path);
+			err = EXIT_FAILURE;
+		}
+	}
+
+	fclose(report);
+	return err;
+}
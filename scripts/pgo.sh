@@ -0,0 +1,57 @@
+#!/bin/sh
+#
+# Profile guided optimization pipeline.
+#
+#   scripts/pgo.sh [capture]
+#
+# capture - WebSocket frames recorded by 'bintest -X <file>'. A synthetic BNBBTC ticker walk is used if omitted.
+#
+# 1. Builds the reference Release binaries and records the benchmark results.
+# 2. Builds the instrumented binaries and trains them: bintest replays the capture against
+#    the mock REST responses from pgo/rest, bintest_bench runs its corpora and the capture.
+# 3. Rebuilds with the profile and compares the benchmark against the reference.
+#
+set -e
+
+SRC=$(cd "$(dirname "$0")/.." && pwd)
+BUILD=${BUILD:-$SRC/build-pgo}
+JOBS=${JOBS:-$(nproc)}
+PROFILE=$BUILD/profile
+CAPTURE=$1
+
+mkdir -p "$BUILD"
+
+if [ -z "$CAPTURE" ]; then
+    CAPTURE=$BUILD/ticks.capture
+    awk -v n=100000 'BEGIN {
+        srand(1); p = 0.0025;
+        for(i = 0; i < n; ++i) {
+            p *= 1. + (rand() - .5) * .002;
+            printf "/ws/bnbbtc@ticker {\"e\":\"24hrTicker\",\"E\":%.0f,\"s\":\"BNBBTC\",\"p\":\"0.00001000\",\"P\":\"0.400\",", 1672515782136 + i * 100;
+            printf "\"w\":\"%.8f\",\"x\":\"%.8f\",\"c\":\"%.8f\",\"Q\":\"%.8f\",\"b\":\"%.8f\",\"B\":\"%.8f\",", p, p, p, rand() * 10, p * .9999, rand() * 100, p * 1.0001;
+            printf "\"a\":\"%.8f\",\"A\":\"%.8f\",\"o\":\"0.00250000\",\"h\":\"0.00260000\",\"l\":\"0.00240000\",", p * 1.0001, rand() * 100;
+            printf "\"v\":\"10000.00000000\",\"q\":\"18.00000000\",\"O\":0,\"C\":%.0f,\"F\":0,\"L\":%d,\"n\":%d}\n", 1672515782136 + i * 100, i, i + 1;
+        }
+    }' > "$CAPTURE"
+fi
+
+TRAIN_ARGS="-k pgo -s pgo -c BTC -t 1 -w 1 -p 0.05 -Y $CAPTURE -M $SRC/pgo/rest"
+
+echo "==== Reference build ===="
+cmake -S "$SRC" -B "$BUILD/ref" -DCMAKE_BUILD_TYPE=Release -DBINTEST_PGO=OFF
+cmake --build "$BUILD/ref" -j "$JOBS"
+"$BUILD/ref/bintest_bench" -r "$CAPTURE" -s "$BUILD/reference.txt"
+
+echo "==== Instrumented build and training ===="
+rm -rf "$PROFILE"
+cmake -S "$SRC" -B "$BUILD/pgo" -DCMAKE_BUILD_TYPE=Release -DBINTEST_PGO=GENERATE -DBINTEST_PGO_DIR="$PROFILE"
+cmake --build "$BUILD/pgo" -j "$JOBS" --clean-first
+"$BUILD/pgo/bintest" $TRAIN_ARGS > /dev/null
+"$BUILD/pgo/bintest_bench" -r "$CAPTURE" > /dev/null
+
+echo "==== Optimized build ===="
+cmake -S "$SRC" -B "$BUILD/pgo" -DCMAKE_BUILD_TYPE=Release -DBINTEST_PGO=USE -DBINTEST_PGO_DIR="$PROFILE"
+cmake --build "$BUILD/pgo" -j "$JOBS" --clean-first
+"$BUILD/pgo/bintest_bench" -r "$CAPTURE" -b "$BUILD/reference.txt" -t "${PGO_TOLERANCE:-0}"
+
+echo "The profile optimized binary: $BUILD/pgo/bintest"
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <memory_resource>
+
+#include "Config.h"
+
+/**
+ * A monotonic arena for the data living as long as one request does.
+ * The allocations are bumps of a pointer, the deallocations are no-ops and everything is released at once by reset().
+ * The initial buffer is kept between the resets, so a request fitting into it makes no heap allocations at all.
+ */
+class Arena {
+
+	std::vector<char> _initial;
+	std::pmr::monotonic_buffer_resource _resource;
+
+public:
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	Arena(Arena&&) = delete;
+	Arena& operator=(Arena&&) = delete;
+
+	explicit Arena(size_t initial_bytes = Config::ArenaInitialBytes) noexcept :
+		_initial(initial_bytes),
+		_resource(_initial.data(), _initial.size()) {
+	}
+
+	inline std::pmr::memory_resource* resource() noexcept {
+		return &_resource;
+	}
+
+	/**
+	 * Releases everything allocated. Nothing allocated from the arena MUST be used afterwards.
+	 */
+	inline void reset() noexcept {
+		_resource.release();
+	}
+
+};
@@ -3,48 +3,112 @@
 #include <cstdio>
 #include <cstring>
 #include <getopt.h>
+#include <sched.h>
 #include <vector>
 #include <sstream>
 
+#include "cli/types/CpuList.h"
 #include "cli/types/Integer.h"
 #include "cli/types/Float.h"
+#include "params/Params.h"
 #include "Utils.h"
 
 struct CliConfig {
 
 
 	// application
+	std::string app;
 	std::string api_key;
 	std::string secret_key;
+	std::vector<std::string> accounts;  // The additional 'api_key:secret_key' accounts.
 	std::string currency_symbol;
 	unsigned trade_period_sec;
 	unsigned wait_period_sec;
 	double price_trigger_percent;
 	double quantity;
+	double price_tick;
+	unsigned ws_standby_links;
+	unsigned tick_store_sec;
+	unsigned metrics_port;
+	std::vector<std::string> ws_endpoints;
+	std::string record_path;
+	std::string replay_path;
+	std::string mock_dir;
+	std::string history_path;
+	std::vector<std::string> history_symbols;
+	std::vector<std::string> arbitrage;  // The 'BASE/QUOTE' pairs of the arbitrage scanner.
+	std::string snapshot_path;
+	std::string params_path;
+	std::string shm_name;
+	std::string latency_model;
+	int loop_cpu;                       // -1 if the service loop is not pinned.
+	std::vector<unsigned> helper_cpus;
+	unsigned fifo_priority;
+	bool ws_api;
+	bool sbe;
+	bool busy_poll;
+	bool backtest;
+	bool lock_memory;
 	bool help;
 
 	// common
 	std::string all_args;
 
 	CliConfig() noexcept {
+		app = "default";
 		currency_symbol = "BTC";
 		trade_period_sec = 30u;
 		wait_period_sec = 15u;
 		price_trigger_percent = .25;
 		quantity = .001;
+		price_tick = 0.;
+		ws_standby_links = Config::WSStandbyLinks;
+		tick_store_sec = Config::TickStoreDurationSec;
+		metrics_port = 0u;
+		loop_cpu = -1;
+		fifo_priority = 0u;
+		ws_api = false;
+		sbe = false;
+		busy_poll = false;
+		backtest = false;
+		lock_memory = false;
 		help = false;
 	}
 
 	bool parse_args(int argc, char** argv) noexcept {
 
 		static const char* short_options =
+			"a:"  // application
 			"k:"  // API key
 			"s:"  // secret key
+			"A:"  // additional account, may be repeated.
 			"c:"  // currency symbols to trade
 			"t:"  // trade period seconds
 			"w:"  // wait period seconds
 			"p:"  // price rigger in percents.
 			"q:"  // quantity to trade at once.
+			"T:"  // price tick, enables the exchange side price trigger.
+			"R:"  // hot-standby WS connections per stream.
+			"e:"  // WS endpoint, may be repeated.
+			"d:"  // tick store retention seconds.
+			"X:"  // record the WS frames into a file.
+			"Y:"  // replay the WS frames from a file.
+			"M:"  // mock REST responses directory.
+			"H:"  // order history marks file.
+			"o:"  // order history symbol, may be repeated.
+			"x:"  // arbitrage pair, may be repeated.
+			"P:"  // metrics port.
+			"S:"  // state snapshot file.
+			"F:"  // hot-reloaded parameters file.
+			"Z:"  // shared memory market data bus.
+			"L:"  // backtest latency model.
+			"C:"  // service loop and helper cores.
+			"f:"  // service loop SCHED_FIFO priority.
+			"E"  // SBE market data.
+			"W"  // order entry over the WebSocket API.
+			"B"  // busy-poll event loop.
+			"U"  // backtest over the replay.
+			"m"  // lock and prefault the memory.
 			"h"  // help
 		;
 
@@ -60,6 +124,10 @@ struct CliConfig {
 
 		while((opt = getopt(argc, argv, short_options)) != EOF) {
 			switch(opt) {
+				case 'a':
+					app = std::string(optarg);
+					break;
+
 				case 'k':
 					api_key = std::string(optarg);
 					break;
@@ -68,6 +136,10 @@ struct CliConfig {
 					secret_key = std::string(optarg);
 					break;
 
+				case 'A':
+					accounts.emplace_back(optarg);
+					break;
+
 				case 'c':
 					currency_symbol = std::string(optarg);
 					break;
@@ -88,6 +160,96 @@ struct CliConfig {
 					result &= cli::Float::parse(optarg, quantity);
 					break;
 
+				case 'T':
+					result &= cli::Float::parse(optarg, price_tick);
+					break;
+
+				case 'R':
+					result &= cli::Integer::parse(optarg, ws_standby_links);
+					break;
+
+				case 'd':
+					result &= cli::Integer::parse(optarg, tick_store_sec);
+					break;
+
+				case 'e':
+					ws_endpoints.emplace_back(optarg);
+					break;
+
+				case 'X':
+					record_path = std::string(optarg);
+					break;
+
+				case 'Y':
+					replay_path = std::string(optarg);
+					break;
+
+				case 'M':
+					mock_dir = std::string(optarg);
+					break;
+
+				case 'H':
+					history_path = std::string(optarg);
+					break;
+
+				case 'o':
+					history_symbols.emplace_back(optarg);
+					Utils::string_to_upper(history_symbols.back());
+					break;
+
+				case 'x':
+					arbitrage.emplace_back(optarg);
+					Utils::string_to_upper(arbitrage.back());
+					break;
+
+				case 'P':
+					result &= cli::Integer::parse(optarg, metrics_port);
+					break;
+
+				case 'S':
+					snapshot_path = std::string(optarg);
+					break;
+
+				case 'F':
+					params_path = std::string(optarg);
+					break;
+
+				case 'Z':
+					shm_name = std::string(optarg);
+					break;
+
+				case 'L':
+					latency_model = std::string(optarg);
+					break;
+
+				case 'E':
+					sbe = true;
+					break;
+
+				case 'W':
+					ws_api = true;
+					break;
+
+				case 'B':
+					busy_poll = true;
+					break;
+
+				case 'U':
+					backtest = true;
+					break;
+
+				case 'C':
+					result &= parse_cores(optarg);
+					break;
+
+				case 'f':
+					result &= cli::Integer::parse(optarg, fifo_priority);
+					break;
+
+				case 'm':
+					lock_memory = true;
+					break;
+
 				case 'h':
 					help = true;
 					break;
@@ -107,13 +269,102 @@ struct CliConfig {
 
 	bool validate() const noexcept {
 		bool result = true;
+		result &= (app == "default" || app == "volatility" || app == "decay" || app == "coro" || app == "arbitrage");
 		result &= (not api_key.empty());
 		result &= (not secret_key.empty());
 		result &= (not currency_symbol.empty());
-		result &= (trade_period_sec > 0u);
-		result &= (wait_period_sec > 0u);
-		result &= (price_trigger_percent > .0);
-		result &= (quantity > .0);
+		result &= params().validate();
+		result &= (price_tick >= .0);
+		result &= (tick_store_sec > 0u);
+		result &= (metrics_port <= 0xFFFFu);
+		result &= (snapshot_path.empty() || app == "default" || app == "volatility" || app == "decay");
+		result &= (not sbe || app != "arbitrage");  // The SBE trade stream has no bid and ask.
+		for(const auto& item : arbitrage) {
+			const auto slash = item.find('/');
+			result &= (slash != std::string::npos && slash > 0u && slash + 1u < item.size());
+		}
+		result &= (shm_name.empty() || (shm_name[0] == '/' && shm_name.find('/', 1u) == std::string::npos));
+		result &= (not backtest || not replay_path.empty());
+		result &= (not backtest || (mock_dir.empty() && history_path.empty() && not ws_api && not sbe));
+		result &= (latency_model.empty() || backtest);
+		result &= (fifo_priority <= 99u);
+		result &= (helper_cpus.empty() || loop_cpu >= 0);
+		for(const auto cpu : helper_cpus) {
+			result &= (static_cast<int>(cpu) != loop_cpu && cpu < CPU_SETSIZE);
+		}
+		result &= (loop_cpu < CPU_SETSIZE);
+		for(const auto& item : accounts) {
+			const auto colon = item.find(':');
+			result &= (colon != std::string::npos && colon > 0u && colon + 1u < item.size());
+		}
+		for(const auto& item : ws_endpoints) {
+			const auto colon = item.rfind(':');
+			unsigned port;
+			result &= (colon != std::string::npos && colon > 0u);
+			result &= result && cli::Integer::parse(item.c_str() + colon + 1u, port) && port > 0u && port <= 0xFFFFu;
+		}
+		return result;
+	}
+
+	/**
+	 * @param arg - 'loop[:helpers]', e.g. '3:0-1'.
+	 */
+	bool parse_cores(const char* arg) noexcept {
+		const char* colon = strchr(arg, ':');
+		const std::string loop(arg, colon ? static_cast<size_t>(colon - arg) : strlen(arg));
+		unsigned cpu;
+		if(not cli::Integer::parse(loop.c_str(), cpu) || cpu >= CPU_SETSIZE) {
+			return false;
+		}
+		loop_cpu = static_cast<int>(cpu);
+		return colon == nullptr || cli::CpuList::parse(colon + 1, helper_cpus);
+	}
+
+	/**
+	 * @return - The parameters which may be reloaded while trading.
+	 */
+	params::Params params() const noexcept {
+		return params::Params {price_trigger_percent, trade_period_sec, wait_period_sec, quantity};
+	}
+
+	/**
+	 * @return - The pairs of the arbitrage scanner, the BNB/BTC/USDT triangle if none is given.
+	 */
+	std::vector<std::string> arbitrage_pairs() const noexcept {
+		if(not arbitrage.empty()) {
+			return arbitrage;
+		}
+		return {
+			std::string(Config::BasicSymbol) + "/BTC",
+			std::string(Config::BasicSymbol) + "/USDT",
+			"BTC/USDT"
+		};
+	}
+
+	/**
+	 * @return - The number of the accounts, the -k -s one included.
+	 */
+	inline size_t accounts_nb() const noexcept {
+		return accounts.size() + 1u;
+	}
+
+	/**
+	 * @param idx - Zero is the -k -s account, the -A ones follow.
+	 * @return - The config of the account: its keys and its own snapshot file.
+	 * The WebSocket API session is of the first account only.
+	 */
+	CliConfig account(const size_t idx) const noexcept {
+		CliConfig result(*this);
+		if(idx) {
+			const auto& item = accounts[idx - 1u];
+			const auto colon = item.find(':');
+			result.api_key = item.substr(0, colon);
+			result.secret_key = item.substr(colon + 1u);
+			result.ws_api = false;
+			if(not result.snapshot_path.empty()) {
+				result.snapshot_path += "." + std::to_string(idx);
+			}
+		}
 		return result;
 	}
 
@@ -122,13 +373,37 @@ struct CliConfig {
 		printf("usage %s -ks[cth]\n", bin);
 
 		fprintf(out, "Application options:\n");
+		fprintf(out, "\t-a String. The strategy: 'default', 'volatility' (the trigger follows the volatility), 'decay' (the trigger shrinks with the position age) or 'coro' (the default one as a coroutine) or 'arbitrage' (reports the triangles of the -x pairs profitable net of the fees, no trading). [default value = '%s']\n", def.app.c_str());
 		fprintf(out, "\t-k String. API key. (not an empty string)\n");
 		fprintf(out, "\t-s String. Secret key. (not an empty string)\n");
+		fprintf(out, "\t-A String. An additional account 'api_key:secret_key' trading the same strategy over the same market data. May be repeated.\n");
 		fprintf(out, "\t-c String. Symbol to trade. (not an empty string) [default value = '%s']\n", def.currency_symbol.c_str());
 		fprintf(out, "\t-t Integer. Trade period seconds. (greater than zero) [default value = %d]\n", def.trade_period_sec);
 		fprintf(out, "\t-t Integer. Wait period seconds. (greater than zero) [default value = %d]\n", def.wait_period_sec);
 		fprintf(out, "\t-p Float. Price trigger percent. (greater than zero) [default value = %f]\n", def.price_trigger_percent);
 		fprintf(out, "\t-q Float. Quantity to trade. (greater than zero) [default value = %f]\n", def.quantity);
+		fprintf(out, "\t-T Float. The PRICE_FILTER tick of the pair. If set, the price trigger is an OCO order on the exchange. [default value = %f]\n", def.price_tick);
+		fprintf(out, "\t-R Integer. Hot-standby WebSocket connections per stream. [default value = %u]\n", def.ws_standby_links);
+		fprintf(out, "\t-d Integer. Recent ticks retention seconds. (greater than zero) [default value = %u]\n", def.tick_store_sec);
+		fprintf(out, "\t-e String. WebSocket endpoint 'host:port', repeat to arbitrate between several. [default value = '%s:%d']\n", Config::BinanceWsHost, Config::BinanceWsPort);
+		fprintf(out, "\t-X String. Record the received WebSocket frames into the file.\n");
+		fprintf(out, "\t-Y String. Replay the WebSocket frames from the file instead of connecting.\n");
+		fprintf(out, "\t-M String. Answer the REST requests from '<dir>/<endpoint>.json' instead of connecting.\n");
+		fprintf(out, "\t-H String. Sync the order history at the start, keeping the high-water marks in the file and appending the records to '<file>.orders' and '<file>.trades'.\n");
+		fprintf(out, "\t-o String. Additional symbol pair to sync the order history of, e.g. 'ETHBTC'. May be repeated.\n");
+		fprintf(out, "\t-x String. A pair 'BASE/QUOTE' of the 'arbitrage' triangles, e.g. 'ETH/BTC'. May be repeated. [default value = '%s/BTC %s/USDT BTC/USDT']\n", Config::BasicSymbol, Config::BasicSymbol);
+		fprintf(out, "\t-P Integer. Expose the metrics at 'http://%s:<port>/metrics', zero is off. [default value = %u]\n", Config::MetricsBindAddress, def.metrics_port);
+		fprintf(out, "\t-S String. Snapshot the trading state into the file and resume from it at the start. Not for 'coro' and 'arbitrage'.\n");
+		fprintf(out, "\t-F String. Read the -t -w -p -q parameters from the file as 'trade_period_sec = 60', 'wait_period_sec', 'price_trigger_percent', 'quantity' lines over the CLI ones, reread it once changed or on SIGHUP.\n");
+		fprintf(out, "\t-Z String. Publish the ticks into the shared memory bus of the name, e.g. '/bintest', for the other processes of the host, see 'bintest_shm_tail'.\n");
+		fprintf(out, "\t-U Backtest: fill the orders by the simulated exchange over the -Y capture, in the time of the capture. Not with -M -H -W -E.\n");
+		fprintf(out, "\t-L String. The -U latency model: either a metrics dump of a live run, e.g. 'curl http://%s:<port>/metrics', or the fixed 'send:ack:market' milliseconds, e.g. '5:5:2'. [default value = '%g:%g:%g']\n", Config::MetricsBindAddress, Config::SimSendMS, Config::SimAckMS, Config::SimMarketMS);
+		fprintf(out, "\t-C String. Pin the service loop, which runs the market data, the strategies and the REST requests, to the core, and the helper threads (metrics, parameters, snapshots) to the cores after ':', e.g. '3' or '3:0-1'. The loop core is best isolated by 'isolcpus' and 'nohz_full'.\n");
+		fprintf(out, "\t-f Integer. Run the service loop as SCHED_FIFO of the priority, 1 to 99, zero is off. Needs CAP_SYS_NICE. [default value = %u]\n", def.fifo_priority);
+		fprintf(out, "\t-m Lock the memory and prefault the stack and the heap at the start, so no page fault is taken while trading. Needs 'ulimit -l'.\n");
+		fprintf(out, "\t-E Take the price from the SBE trade stream at '%s:%d' instead of the JSON ticker. The API key MUST be an Ed25519 one.\n", Config::BinanceWsSbeHost, Config::BinanceWsSbePort);
+		fprintf(out, "\t-W Place the orders over the WebSocket API session, REST is the fallback. [API at '%s:%d']\n", Config::BinanceWsApiHost, Config::BinanceWsApiPort);
+		fprintf(out, "\t-B Busy-poll the event loop instead of sleeping. Takes a CPU core for the lowest wakeup latency.\n");
 		fprintf(out, "\t-h Print this screen and exit.\n");
 
 	}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 class Config {
 public:
 
@@ -8,15 +11,102 @@ public:
 	static constexpr const char* BinanceRestHost = "https://testnet.binance.vision";
 	static constexpr unsigned NextAttemptSec = 5u;
 
+	// Order history sync, see binance::rest::HistorySync.
+	static constexpr unsigned RestWeightLimit1M = 6000u;     // The REQUEST_WEIGHT limit of Binance per minute.
+	static constexpr unsigned HistoryWeightBudget1M = 3000u; // The share of the limit the sync may use, the rest is for trading.
+	static constexpr unsigned HistoryWeightPerPage = 20u;    // The weight of an 'allOrders' or a 'myTrades' request.
+	static constexpr unsigned HistoryPageLimit = 1000u;      // The records per page, the maximum Binance allows.
+	static constexpr unsigned HistoryParallel = 4u;          // The requests in flight at once.
+	static constexpr unsigned HistoryRetries = 3u;           // The attempts of a page before the symbol gives up.
+	static constexpr long HistoryTimeoutMS = 10000;          // A page request timeout.
+
+	// The triangular arbitrage scanner, see market::Triangles.
+	static constexpr double ArbitrageMinProfitPercent = 0.05;  // The net profit a cycle is reported from.
+
+	// The PnL of the fills, see pnl::Position.
+	static constexpr size_t PnlOrdersKept = 16u;  // The recent orders a position tells the repeated states of.
+
+	// The market data bus, see shm::Publisher.
+	static constexpr uint32_t ShmRingCapacity = 1u << 16u;  // The ticks a client may fall behind by, a power of two.
+
+	// The backtest, see sim::Market, sim::Exchange and sim::Latency.
+	static constexpr double SimMakerFee = 0.001;              // The commission rates of the simulated accounts.
+	static constexpr double SimTakerFee = 0.001;
+	static constexpr double SimStartBalance = 1000.;          // Of every asset of the simulated pairs.
+	static constexpr double SimSendMS = 5.;                   // The latencies if no metrics dump is given.
+	static constexpr double SimAckMS = 5.;
+	static constexpr double SimMarketMS = 2.;
+	static constexpr double SimSendShare = .5;                // The share of an order round trip before the match.
+	static constexpr uint64_t SimSeed = 0x9E3779B97F4A7C15ull; // The latency draws, fixed so a backtest repeats.
+
+	// The orders of an account, see binance::rest::Connector.
+	static constexpr unsigned RestOrderLimit = 50u;          // The ORDERS limit of Binance per window and account.
+	static constexpr uint64_t RestOrderWindowMS = 10000u;    // The window of RestOrderLimit.
+	static constexpr uint64_t ExitQueryIntervalMS = 1000u;   // How often the OCO exit is queried while the price is past a leg.
+
 	static constexpr const char* BinanceWsHost = "stream.binance.com";
 	static constexpr int BinanceWsPort = 9443;
+	static constexpr const char* BinanceWsSbeHost = "stream-sbe.binance.com";
+	static constexpr int BinanceWsSbePort = 9443;
+
+	// The WebSocket API, the same account as BinanceRestHost.
+	static constexpr const char* BinanceWsApiHost = "ws-api.testnet.binance.vision";
+	static constexpr int BinanceWsApiPort = 443;
+	static constexpr const char* BinanceWsApiPath = "/ws-api/v3";
+	static constexpr unsigned WSApiTimeoutMS = 5000u;  // A request with no response for that long fails.
 
 	static constexpr const char* BasicSymbol = "BNB";
+	static constexpr double BasicLotStep = 0.001;  // The LOT_SIZE step of the basic symbol, the base asset of the pairs.
+	static constexpr const char* ClientOrderIdPrefix = "bt-";  // The newClientOrderId prefix, see binance::OrderTable.
+
+	static constexpr unsigned TickStoreDurationSec = 300u;  // The recent ticks retention period.
+	static constexpr unsigned TickStoreRatePerSec = 4u;     // The ticks rate the store is sized for.
+
+	// strategy::VolatilityTrigger
+	static constexpr unsigned VolatilityWindowSec = 60u;    // The ticks the deviation is measured over.
+	static constexpr size_t VolatilityMinTicks = 8u;        // Fewer ticks fall back to the fixed trigger.
+	static constexpr double VolatilityTriggerK = 2.;        // The trigger in the deviations.
+	static constexpr double VolatilityFloorRatio = .25;     // The trigger lower bound relative to the fixed one.
+
+	static constexpr int ReactorMaxEvents = 64;  // The events handled per one Reactor wakeup.
+
+	// The service loop tuning, see Realtime.
+	static constexpr size_t RtPrefaultStackBytes = 512u * 1024u;  // The stack of the loop touched at the start.
+	static constexpr size_t RtPrefaultHeapBytes = 64u << 20u;     // The heap grown and kept by the allocator.
+
+	static constexpr size_t CoroFrameBytes = 1024u;     // The coroutine frame block, see coro::FramePool.
+	static constexpr size_t CoroFramePoolGrowth = 16u;  // The blocks the pool grows by.
+
+	static constexpr size_t ArenaInitialBytes = 1u << 20u;  // The per-request arena buffer, kept between the requests.
+
+	static constexpr unsigned SnapshotIntervalSec = 5u;  // The state snapshot period, a state transition makes one at once.
+
+	// params::Watcher
+	static constexpr int ParamsPollTimeoutMS = 500;      // Also bounds the watcher stop time.
+	static constexpr size_t ParamsEventBytes = 4096u;    // The inotify events read at once.
+
+	// metrics::Registry and metrics::Exporter
+	static constexpr size_t MetricsThreads = 8u;       // The counter shards; more threads share them.
+	static constexpr size_t MetricsMaxBuckets = 16u;   // The histogram buckets upper bound.
+	static constexpr const char* MetricsBindAddress = "127.0.0.1";
+	static constexpr int MetricsBacklog = 8;
+	static constexpr int MetricsPollTimeoutMS = 500;   // Also bounds a slow scrape and the exporter stop time.
+	static constexpr size_t MetricsRequestBytes = 1024u;
 
 	static constexpr const char* WSProtocolName = "binance-test";
 	static constexpr size_t WSSessionData = 0xFFFF;
 	static constexpr size_t WSRxBuffer = 0xFFFF;
-	static constexpr int WSServiceTimeoutMS = 1000;
+	static constexpr int WSServiceTimeoutMS = 100;
+	static constexpr unsigned WSSuperviseIntervalMS = 100u;  // The supervisor period when driven by the Reactor.
 	static constexpr size_t WSProtocols_nb = 1u;
 
+	// WebSocket connection supervision.
+	static constexpr unsigned WSReconnectMinMS = 250u;     // The first reconnect delay, doubled on every failure.
+	static constexpr unsigned WSReconnectMaxMS = 30000u;   // The reconnect delay upper bound.
+	static constexpr unsigned WSPingIntervalMS = 15000u;   // How often a client ping is sent over an idle link.
+	static constexpr unsigned WSPongTimeoutMS = 5000u;     // A link is dropped if the pong is not received in time.
+	static constexpr unsigned WSStaleTimeoutMS = 5000u;    // A stream with no frames for that long is stale.
+	static constexpr uint64_t WSMaxSessionAgeMS = 23ull * 3600u * 1000u; // Binance drops a session at 24h.
+	static constexpr unsigned WSStandbyLinks = 0u;         // Hot-standby duplicate connections per stream.
+
 };
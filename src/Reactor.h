@@ -0,0 +1,281 @@
+#pragma once
+
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <initializer_list>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+
+#include "Config.h"
+#include "Log.h"
+
+/**
+ * The single event loop of the process built on epoll.
+ * The sockets of LWS and curl_multi, the timers (timerfd) and the signals (signalfd) are all the file descriptors
+ * of the one epoll instance, so the loop sleeps until something has really happened.
+ * In the busy-poll mode the loop never sleeps, trading a CPU core for the wakeup latency.
+ * Not thread safe; the handlers are called from run_once() only.
+ */
+class Reactor {
+public:
+
+	/**
+	 * @param events - EPOLLIN, EPOLLOUT, EPOLLERR, EPOLLHUP as reported by epoll.
+	 */
+	using Handler_t = void (*)(void* instance, int fd, uint32_t events);
+
+	// The signal consumer callback.
+	using SignalHandler_t = void (*)(void* instance, int signum);
+
+private:
+
+	enum class Kind : unsigned {
+		None,
+		Socket,
+		Timer,
+		Signal
+	};
+
+	struct Entry {
+		Kind kind;
+		Handler_t handler;
+		SignalHandler_t signal_handler;
+		void* instance;
+	};
+
+	int _epoll;
+	const bool _busy_poll;
+	std::vector<Entry> _entries;  // Indexed by the file descriptor.
+
+public:
+
+	Reactor(const Reactor&) = delete;
+	Reactor& operator=(const Reactor&) = delete;
+
+	Reactor(Reactor&&) = delete;
+	Reactor& operator=(Reactor&&) = delete;
+
+	explicit Reactor(const bool busy_poll = false) noexcept :
+		_epoll(-1),
+		_busy_poll(busy_poll) {
+		LOG_DEBUG("Reactor()\n");
+	}
+
+	~Reactor() noexcept {
+		for(size_t fd = 0; fd < _entries.size(); ++fd) {
+			if(_entries[fd].kind == Kind::Timer || _entries[fd].kind == Kind::Signal) {
+				close(static_cast<int>(fd));
+			}
+		}
+		if(_epoll >= 0) {
+			close(_epoll);
+		}
+		LOG_DEBUG("~Reactor()\n");
+	}
+
+	bool init() noexcept {
+		LOG_DEBUG("Reactor::init() busy_poll=%d\n", _busy_poll);
+		_epoll = epoll_create1(EPOLL_CLOEXEC);
+		if(_epoll < 0) {
+			LOG_ERROR("epoll_create1() fails. %s\n", strerror(errno));
+			return false;
+		}
+		return true;
+	}
+
+	inline bool busy_poll() const noexcept {
+		return _busy_poll;
+	}
+
+	/**
+	 * Watches a socket owned by the caller.
+	 */
+	bool add(const int fd, const uint32_t events, Handler_t handler, void* instance) noexcept {
+		return add_entry(fd, events, Entry{Kind::Socket, handler, nullptr, instance});
+	}
+
+	bool modify(const int fd, const uint32_t events) noexcept {
+		epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = events;
+		ev.data.fd = fd;
+		if(epoll_ctl(_epoll, EPOLL_CTL_MOD, fd, &ev)) {
+			LOG_ERROR("Reactor::modify(%d) fails. %s\n", fd, strerror(errno));
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Stops watching the descriptor. A timer or a signal descriptor is closed as well, a socket is not.
+	 */
+	void remove(const int fd) noexcept {
+		if(fd < 0 || static_cast<size_t>(fd) >= _entries.size() || _entries[fd].kind == Kind::None) {
+			return;
+		}
+		epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+		if(_entries[fd].kind != Kind::Socket) {
+			close(fd);
+		}
+		_entries[fd] = Entry{Kind::None, nullptr, nullptr, nullptr};
+	}
+
+	/**
+	 * Creates a disarmed timer.
+	 * @return - The timer descriptor to arm, -1 on failure.
+	 */
+	int add_timer(Handler_t handler, void* instance) noexcept {
+		const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if(fd < 0) {
+			LOG_ERROR("timerfd_create() fails. %s\n", strerror(errno));
+			return -1;
+		}
+		if(not add_entry(fd, EPOLLIN, Entry{Kind::Timer, handler, nullptr, instance})) {
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	/**
+	 * @param delay_ms - The first expiration. Zero expires right away.
+	 * @param interval_ms - The period of the following expirations, zero for a one-shot timer.
+	 */
+	bool arm_timer(const int fd, const unsigned delay_ms, const unsigned interval_ms = 0u) noexcept {
+		itimerspec spec;
+		spec.it_value = to_timespec(delay_ms);
+		spec.it_interval = to_timespec(interval_ms);
+		if(delay_ms == 0u) {
+			spec.it_value.tv_nsec = 1; // All zeroes disarm the timer.
+		}
+		if(timerfd_settime(fd, 0, &spec, nullptr)) {
+			LOG_ERROR("timerfd_settime(%d) fails. %s\n", fd, strerror(errno));
+			return false;
+		}
+		return true;
+	}
+
+	bool disarm_timer(const int fd) noexcept {
+		itimerspec spec;
+		memset(&spec, 0, sizeof(spec));
+		return timerfd_settime(fd, 0, &spec, nullptr) == 0;
+	}
+
+	/**
+	 * Delivers the signals through the loop instead of the asynchronous handlers.
+	 * The signals get blocked, so MUST be called before any thread is started.
+	 */
+	bool watch_signals(std::initializer_list<int> signals, SignalHandler_t handler, void* instance) noexcept {
+		sigset_t mask;
+		sigemptyset(&mask);
+		for(const auto item : signals) {
+			sigaddset(&mask, item);
+		}
+
+		if(sigprocmask(SIG_BLOCK, &mask, nullptr)) {
+			LOG_ERROR("sigprocmask() fails. %s\n", strerror(errno));
+			return false;
+		}
+
+		const int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+		if(fd < 0) {
+			LOG_ERROR("signalfd() fails. %s\n", strerror(errno));
+			return false;
+		}
+		if(not add_entry(fd, EPOLLIN, Entry{Kind::Signal, nullptr, handler, instance})) {
+			close(fd);
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Waits for the events and calls their handlers.
+	 * @param timeout_ms - The longest wait, -1 to wait for an event however long. Ignored in the busy-poll mode.
+	 * @return - The number of the events handled, -1 on failure.
+	 */
+	int run_once(const int timeout_ms = -1) noexcept {
+		epoll_event events[Config::ReactorMaxEvents];
+		const int nb = epoll_wait(_epoll, events, Config::ReactorMaxEvents, _busy_poll ? 0 : timeout_ms);
+		if(nb < 0) {
+			if(errno == EINTR) {
+				return 0;
+			}
+			LOG_ERROR("epoll_wait() fails. %s\n", strerror(errno));
+			return -1;
+		}
+
+		for(int idx = 0; idx < nb; ++idx) {
+			dispatch(events[idx].data.fd, events[idx].events);
+		}
+		return nb;
+	}
+
+private:
+
+	bool add_entry(const int fd, const uint32_t events, const Entry& entry) noexcept {
+		if(fd < 0) {
+			return false;
+		}
+
+		epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = events;
+		ev.data.fd = fd;
+		if(epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &ev)) {
+			LOG_ERROR("Reactor::add(%d) fails. %s\n", fd, strerror(errno));
+			return false;
+		}
+
+		if(static_cast<size_t>(fd) >= _entries.size()) {
+			_entries.resize(fd + 1u, Entry{Kind::None, nullptr, nullptr, nullptr});
+		}
+		_entries[fd] = entry;
+		return true;
+	}
+
+	void dispatch(const int fd, const uint32_t events) noexcept {
+		if(static_cast<size_t>(fd) >= _entries.size()) {
+			return;
+		}
+
+		// A copy; the handler may remove the descriptor.
+		const Entry entry = _entries[fd];
+		switch(entry.kind) {
+			case Kind::None:
+				break;
+
+			case Kind::Socket:
+				entry.handler(entry.instance, fd, events);
+				break;
+
+			case Kind::Timer: {
+				uint64_t expirations;
+				if(read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+					entry.handler(entry.instance, fd, events);
+				}
+			}
+				break;
+
+			case Kind::Signal: {
+				signalfd_siginfo info;
+				while(read(fd, &info, sizeof(info)) == sizeof(info)) {
+					entry.signal_handler(entry.instance, static_cast<int>(info.ssi_signo));
+				}
+			}
+				break;
+		}
+	}
+
+	static inline timespec to_timespec(const unsigned ms) noexcept {
+		timespec result;
+		result.tv_sec = ms / 1000u;
+		result.tv_nsec = static_cast<long>(ms % 1000u) * 1000000l;
+		return result;
+	}
+
+};
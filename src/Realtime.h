@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "cli/types/CpuList.h"
+#include "Config.h"
+#include "Log.h"
+
+/**
+ * The tuning of the process for the latency of the service loop: the cores, the scheduling and the memory.
+ *
+ * The market data, the strategies and the REST requests are all the one service loop thread; the other threads
+ * are the helpers, i.e. the metrics exporter, the parameters watcher and the snapshot writer.
+ *  - init(), at the start before any thread: pins the process to the helper cores, so the threads started later
+ *    inherit them; locks the memory and prefaults the heap and the stack of the loop.
+ *  - enter(), on the loop thread right before the loop: pins it to its core and makes it SCHED_FIFO.
+ * A thread started by the loop afterwards inherits its core and its priority.
+ * A failure is reported and the run goes on as is, the privileges (CAP_SYS_NICE, RLIMIT_MEMLOCK) vary by host.
+ */
+class Realtime {
+
+	const int _loop_cpu;  // -1 if not pinned.
+	std::vector<unsigned> _helper_cpus;
+	const unsigned _fifo_priority;  // Zero if not SCHED_FIFO.
+	const bool _lock_memory;
+	rusage _entered;
+
+public:
+
+	Realtime(const Realtime&) = delete;
+	Realtime& operator=(const Realtime&) = delete;
+
+	/**
+	 * @param helper_cpus - Empty is the cores of the process but the loop one.
+	 */
+	Realtime(const int loop_cpu, std::vector<unsigned> helper_cpus, const unsigned fifo_priority, const bool lock_memory) noexcept :
+		_loop_cpu(loop_cpu),
+		_helper_cpus(std::move(helper_cpus)),
+		_fifo_priority(fifo_priority),
+		_lock_memory(lock_memory),
+		_entered{} {
+	}
+
+	inline bool enabled() const noexcept {
+		return _loop_cpu >= 0 || _fifo_priority || _lock_memory;
+	}
+
+	/**
+	 * Called on the thread which runs the loop later, before any other thread is started.
+	 */
+	bool init() noexcept {
+		if(not enabled()) {
+			return true;
+		}
+		self_check();
+
+		bool result = true;
+		if(_loop_cpu >= 0) {
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			if(_helper_cpus.empty()) {
+				result &= (sched_getaffinity(0, sizeof(set), &set) == 0);
+				CPU_CLR(_loop_cpu, &set);
+			} else {
+				for(const auto cpu : _helper_cpus) {
+					CPU_SET(cpu, &set);
+				}
+			}
+			if(result && CPU_COUNT(&set) == 0) {
+				LOG_ERROR("No core is left to the helper threads.\n");
+				result = false;
+			} else if(not result || sched_setaffinity(0, sizeof(set), &set)) {
+				LOG_ERROR("The helper threads are not pinned. %s\n", strerror(errno));
+				result = false;
+			}
+		}
+
+		if(_lock_memory) {
+			if(mlockall(MCL_CURRENT | MCL_FUTURE)) {
+				LOG_ERROR("The memory is not locked, see 'ulimit -l'. %s\n", strerror(errno));
+				result = false;
+			}
+			prefault_heap();
+			prefault_stack();
+		}
+		return result;
+	}
+
+	/**
+	 * Called on the loop thread right before the loop.
+	 */
+	bool enter() noexcept {
+		bool result = true;
+		if(_loop_cpu >= 0) {
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(_loop_cpu, &set);
+			const int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+			if(err) {
+				LOG_ERROR("The service loop is not pinned to the core %d. %s\n", _loop_cpu, strerror(err));
+				result = false;
+			}
+		}
+
+		if(_fifo_priority) {
+			sched_param param {};
+			param.sched_priority = static_cast<int>(_fifo_priority);
+			const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+			if(err) {
+				LOG_ERROR("The service loop is not SCHED_FIFO, CAP_SYS_NICE or 'ulimit -r' is needed. %s\n", strerror(err));
+				result = false;
+			}
+		}
+
+		getrusage(RUSAGE_THREAD, &_entered);
+		return result;
+	}
+
+	/**
+	 * The context switches and the page faults of the loop thread since enter(), called on it.
+	 */
+	void dump() const noexcept {
+		rusage now;
+		if(getrusage(RUSAGE_THREAD, &now)) {
+			return;
+		}
+		LOG_INFO("Service loop : context switches voluntary=%ld involuntary=%ld page faults minor=%ld major=%ld\n",
+		         now.ru_nvcsw - _entered.ru_nvcsw, now.ru_nivcsw - _entered.ru_nivcsw,
+		         now.ru_minflt - _entered.ru_minflt, now.ru_majflt - _entered.ru_majflt);
+	}
+
+private:
+
+	/**
+	 * Reports whether the kernel keeps the loop core quiet: 'isolcpus' takes it off the scheduler, 'nohz_full' off
+	 * the tick; the RT throttling preempts a SCHED_FIFO thread which never sleeps, i.e. the busy-poll loop.
+	 */
+	void self_check() const noexcept {
+		const auto isolated = read_line("/sys/devices/system/cpu/isolated");
+		const auto nohz_full = read_line("/sys/devices/system/cpu/nohz_full");
+		LOG_INFO("Realtime : isolated='%s' nohz_full='%s'", isolated.c_str(), nohz_full.c_str());
+		if(_loop_cpu >= 0) {
+			LOG_PLAIN(" loop core %d isolated=%s nohz_full=%s", _loop_cpu, contains(isolated, _loop_cpu) ? "yes" : "no",
+			          contains(nohz_full, _loop_cpu) ? "yes" : "no");
+		}
+		if(_fifo_priority) {
+			const auto runtime = read_line("/proc/sys/kernel/sched_rt_runtime_us");
+			LOG_PLAIN(" rt_runtime_us=%s%s", runtime.c_str(), (runtime == "-1") ? "" : " (throttled)");
+		}
+		LOG_PLAIN("\n");
+	}
+
+	/**
+	 * Grows the main arena by the bytes, touches them and keeps them: the allocator neither trims the heap
+	 * nor maps the large blocks apart, so the allocations while trading take no page fault.
+	 */
+	static void prefault_heap() noexcept {
+		mallopt(M_TRIM_THRESHOLD, -1);
+		mallopt(M_MMAP_MAX, 0);
+		auto block = static_cast<char*>(malloc(Config::RtPrefaultHeapBytes));
+		if(block) {
+			const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+			for(size_t offset = 0; offset < Config::RtPrefaultHeapBytes; offset += page) {
+				reinterpret_cast<volatile char*>(block)[offset] = 0;
+			}
+			free(block);
+		}
+	}
+
+	static void prefault_stack() noexcept {
+		char buffer[Config::RtPrefaultStackBytes];
+		const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		for(size_t offset = 0; offset < sizeof(buffer); offset += page) {
+			reinterpret_cast<volatile char*>(buffer)[offset] = 0;
+		}
+	}
+
+	static std::string read_line(const char* path) noexcept {
+		std::string result;
+		FILE* file = fopen(path, "r");
+		if(file) {
+			char buffer[256];
+			if(fgets(buffer, sizeof(buffer), file)) {
+				result = buffer;
+				while(not result.empty() && (result.back() == '\n' || result.back() == ' ')) {
+					result.pop_back();
+				}
+			}
+			fclose(file);
+		}
+		return result;
+	}
+
+	static bool contains(const std::string& list, const int cpu) noexcept {
+		std::vector<unsigned> cpus;
+		return cli::CpuList::parse(list.c_str(), cpus)
+		       && std::find(cpus.begin(), cpus.end(), static_cast<unsigned>(cpu)) != cpus.end();
+	}
+
+};
@@ -2,7 +2,10 @@
 
 #include <string>
 #include <algorithm>
+#include <atomic>
 #include <ctime>
+#include <cstdint>
+#include <cstdio>
 #include "Config.h"
 
 class Utils {
@@ -28,8 +31,95 @@ public:
 		return result;
 	}
 
+	/**
+	 * The reverse of bin_to_hex(), either case.
+	 * @return false - if the input is not an even number of the hex digits.
+	 */
+	static bool hex_to_bin(const char* hex, const size_t hex_len, std::string& bin) noexcept {
+		const auto digit = [](const char ch) -> int {
+			if(ch >= '0' && ch <= '9') {
+				return ch - '0';
+			}
+			if(ch >= 'A' && ch <= 'F') {
+				return ch - 'A' + 10;
+			}
+			if(ch >= 'a' && ch <= 'f') {
+				return ch - 'a' + 10;
+			}
+			return -1;
+		};
+
+		if(hex_len % 2u) {
+			return false;
+		}
+		bin.resize(hex_len / 2u);
+		for(size_t i = 0; i < bin.size(); ++i) {
+			const int high = digit(hex[i * 2u]);
+			const int low = digit(hex[i * 2u + 1u]);
+			if(high < 0 || low < 0) {
+				return false;
+			}
+			bin[i] = static_cast<char>((high << 4) | low);
+		}
+		return true;
+	}
+
+	/**
+	 * @return - The decimal with no exponent and no trailing zeros, as Binance expects a price or a quantity.
+	 */
+	static std::string decimal_to_string(const double value) noexcept {
+		char buffer[64];
+		int len = snprintf(buffer, sizeof(buffer), "%.8f", value);
+		while(len > 1 && buffer[len - 1] == '0') {
+			len--;
+		}
+		if(len > 1 && buffer[len - 1] == '.') {
+			len--;
+		}
+		return std::string(buffer, static_cast<size_t>(len));
+	}
+
 	static inline std::time_t time_now_sec() noexcept {
-		return std::time(nullptr);
+		const auto sim = _sim_ms.load(std::memory_order_relaxed);
+		return sim ? static_cast<std::time_t>(sim / 1000u) : std::time(nullptr);
 	}
 
+	/**
+	 * @return - Milliseconds since the Epoch, comparable with the exchange timestamps.
+	 */
+	static inline uint64_t time_wall_ms() noexcept {
+		const auto sim = _sim_ms.load(std::memory_order_relaxed);
+		if(sim) {
+			return sim;
+		}
+		timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		return static_cast<uint64_t>(ts.tv_sec) * 1000u + static_cast<uint64_t>(ts.tv_nsec) / 1000000u;
+	}
+
+	/**
+	 * @return - Milliseconds of the monotonic clock. Not related to the wall time.
+	 */
+	static inline uint64_t time_now_ms() noexcept {
+		const auto sim = _sim_ms.load(std::memory_order_relaxed);
+		if(sim) {
+			return sim;
+		}
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return static_cast<uint64_t>(ts.tv_sec) * 1000u + static_cast<uint64_t>(ts.tv_nsec) / 1000000u;
+	}
+
+	/**
+	 * Drives all the clocks above by the simulated time of a backtest, see sim::Market.
+	 * @param ms - Milliseconds since the Epoch, zero is back to the system clocks.
+	 */
+	static inline void time_simulate(const uint64_t ms) noexcept {
+		_sim_ms.store(ms, std::memory_order_relaxed);
+	}
+
+private:
+
+	static inline std::atomic<uint64_t> _sim_ms {0u};
+
 };
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../binance/rest/Connector.h"
+#include "../binance/ws/Connector.h"
+#include "../binance/ws/api.h"
+#include "../binance/Assets.h"
+#include "../market/Plane.h"
+#include "../market/Triangles.h"
+#include "../metrics/Metrics.h"
+#include "../CliConfig.h"
+#include "../Config.h"
+#include "../Log.h"
+
+/**
+ * Watches the triangles over the -x pairs and reports the cycles profitable net of the taker commission.
+ * Reports only, no order is placed.
+ */
+class AppArbitrage {
+
+	// The plane calls back with the leg, so a tick finds its pair with no lookup.
+	struct Leg {
+		AppArbitrage* app;
+		uint32_t id;
+		std::string pair;
+	};
+
+	binance::rest::Connector& _conn_rest;
+	market::Plane& _plane;
+
+	const std::vector<std::string> _pair_names;  // 'BASE/QUOTE'
+	market::Triangles _triangles;
+	std::vector<Leg> _legs;
+
+	metrics::Counter& _opportunities;
+
+public:
+
+	AppArbitrage(const AppArbitrage&) = delete;
+	AppArbitrage& operator=(const AppArbitrage&) = delete;
+
+	AppArbitrage(AppArbitrage&&) = delete;
+	AppArbitrage& operator=(AppArbitrage&&) = delete;
+
+	AppArbitrage(binance::rest::Connector& conn_rest, market::Plane& plane, const CliConfig& cli) noexcept :
+		_conn_rest(conn_rest),
+		_plane(plane),
+		_pair_names(cli.arbitrage_pairs()),
+		_opportunities(metrics::Registry::instance().counter(
+			"bintest_arbitrage_opportunities_total", "The triangles became profitable net of the fees.")) {
+
+		LOG_DEBUG("AppArbitrage::AppArbitrage()\n");
+	}
+
+	~AppArbitrage() noexcept {
+		LOG_DEBUG("AppArbitrage::~AppArbitrage()\n");
+	}
+
+	bool init() noexcept {
+		LOG_DEBUG("AppArbitrage::init()\n");
+
+		binance::rest::AccountInformation account;
+		if(not _conn_rest.account(account)) {
+			LOG_ERROR("Unable to get the commission rates.\n");
+			return false;
+		}
+
+		_legs.reserve(_pair_names.size());
+		for(const auto& item : _pair_names) {
+			const auto slash = item.find('/');
+			const auto base = item.substr(0, slash);
+			const auto quote = item.substr(slash + 1u);
+			const auto id = _triangles.add_pair(binance::Assets::intern(base), binance::Assets::intern(quote));
+			_legs.push_back(Leg{this, id, base + quote});
+		}
+
+		const double fee = account.commissionRates.taker;
+		_triangles.build(fee, Config::ArbitrageMinProfitPercent / 100.);
+		LOG_INFO("Arbitrage over %zu assets, %zu pairs, %zu cycles; taker fee %f, min profit %f%%.\n",
+		         _triangles.assets_nb(), _triangles.pairs_nb(), _triangles.cycles_nb(), fee,
+		         Config::ArbitrageMinProfitPercent);
+		if(_triangles.cycles_nb() == 0u) {
+			LOG_ERROR("The pairs make no triangle.\n");
+			return false;
+		}
+
+		for(auto& item : _legs) {
+			if(not _plane.subscribe(item.pair, cb_tick, cb_stream_state, &item)) {
+				LOG_ERROR("Fail to register the ticker listener of '%s'.\n", item.pair.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * The cycles are evaluated by the ticks, from within the market::Plane service.
+	 */
+	inline bool service() noexcept {
+		return true;
+	}
+
+	void finit() noexcept {
+		for(auto& item : _legs) {
+			_plane.unsubscribe(item.pair, &item);
+		}
+		LOG_INFO("Arbitrage : updates=%llu cycles evaluated=%llu\n",
+		         static_cast<unsigned long long>(_triangles.updates()),
+		         static_cast<unsigned long long>(_triangles.evaluations()));
+	}
+
+private:
+
+	void report() noexcept {
+		for(const auto cycle : _triangles.opened()) {
+			_opportunities.inc();
+			LOG_INFO("Arbitrage %s -> %s -> %s -> %s net %+f%%\n",
+			         binance::Assets::name(_triangles.asset(cycle, 0u)).c_str(),
+			         binance::Assets::name(_triangles.asset(cycle, 1u)).c_str(),
+			         binance::Assets::name(_triangles.asset(cycle, 2u)).c_str(),
+			         binance::Assets::name(_triangles.asset(cycle, 0u)).c_str(),
+			         (_triangles.rate(cycle) - 1.) * 100.);
+		}
+	}
+
+	static void cb_tick(void* instance, const binance::ws::SymbolTicker& ticker) noexcept {
+		const auto leg = reinterpret_cast<Leg*>(instance);
+		if(leg->app->_triangles.update(leg->id, ticker.bestBidPrice, ticker.bestAskPrice)) {
+			leg->app->report();
+		}
+	}
+
+	/**
+	 * The quotes of a stale stream are taken out until it recovers.
+	 */
+	static void cb_stream_state(void* instance, binance::ws::Connector::StreamState state) noexcept {
+		const auto leg = reinterpret_cast<Leg*>(instance);
+		if(state == binance::ws::Connector::StreamState::Stale) {
+			leg->app->_triangles.update(leg->id, 0., 0.);
+		}
+	}
+
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <string>
+#include <cmath>
+#include <random>
+
+#include "../binance/rest/Connector.h"
+#include "../binance/ws/Connector.h"
+#include "../binance/ws/api.h"
+#include "../binance/OrderTable.h"
+#include "../coro/Task.h"
+#include "../coro/Runtime.h"
+#include "../market/Plane.h"
+#include "../market/TickStore.h"
+#include "../params/Store.h"
+#include "TradeReport.h"
+
+/**
+ * The strategy of AppDefault written as a coroutine: buy, hold until the price moves by the trigger
+ * or the trade period is over, sell, take a break, repeat. The exchange side OCO exit is not supported.
+ */
+class AppCoro {
+
+	static constexpr unsigned PriceUpdateTimeoutSec = 10u;
+
+	using Wake = coro::Runtime::Wake;
+
+	// ---------------------------------
+	// The connectors.
+	// ---------------------------------
+	binance::rest::Connector& _conn_rest;
+	market::Plane& _plane;
+
+	// ---------------------------------
+	// The user defined trader parameters.
+	// ---------------------------------
+	const std::string _symbol;
+	const std::string _sym_pair;
+	const binance::AssetId _asset_basic;
+	const binance::AssetId _asset_symbol;
+
+	// ---------------------------------
+	// The state.
+	// ---------------------------------
+	params::Params _params;  // A copy taken at the start of a trade, so a reload applies from the next one.
+	coro::Runtime _rt;
+	TradeReport _report;
+	const market::TickStore& _ticks;  // The recent ticks of the symbol, shared by the accounts.
+	binance::OrderTable _orders;
+	std::mt19937 _random;  // Draws the first wait.
+	coro::Task<> _main;
+
+public:
+
+	AppCoro(const AppCoro&) = delete;
+	AppCoro& operator=(const AppCoro&) = delete;
+
+	AppCoro(AppCoro&&) = delete;
+	AppCoro& operator=(AppCoro&&) = delete;
+
+	AppCoro(binance::rest::Connector& conn_rest, market::Plane& plane, const CliConfig& cli) noexcept :
+		_conn_rest(conn_rest),
+		_plane(plane),
+		_symbol(cli.currency_symbol),
+		_sym_pair(Config::BasicSymbol + cli.currency_symbol),
+		_asset_basic(binance::Assets::intern(Config::BasicSymbol)),
+		_asset_symbol(binance::Assets::intern(cli.currency_symbol)),
+		_params(params::Store::instance().get()),
+		_rt(conn_rest, plane.ws(), cli.ws_api),
+		_report(_asset_basic, _asset_symbol),
+		_ticks(plane.ticks(_sym_pair)),
+		_random(std::random_device()()) {
+
+		LOG_DEBUG("AppCoro::AppCoro()\n");
+	}
+
+	~AppCoro() noexcept {
+		LOG_DEBUG("AppCoro::~AppCoro()\n");
+	}
+
+	bool init() noexcept {
+		LOG_DEBUG("AppCoro::init()\n");
+
+		if(not _report.start(_conn_rest)) {
+			return false;
+		}
+
+		double balance;
+		if(not _report.initial().get_balance(_asset_symbol, balance)) {
+			LOG_ERROR("Symbol '%s' is not available to trade.\n", _sym_pair.c_str());
+			return false;
+		}
+
+		if(not _plane.subscribe(_sym_pair, cb_tick, cb_stream_state, this)) {
+			LOG_ERROR("Fail to register the ticker listener.");
+			return false;
+		}
+
+		_main = trade();
+		_main.start();
+		return true;
+	}
+
+	inline bool service() noexcept {
+		_rt.poll(Utils::time_now_ms());
+		return not _main.done();
+	}
+
+	void finit() noexcept {
+		_plane.unsubscribe(_sym_pair, this);
+		if(not _main.done()) {
+			LOG_DEBUG("Stop trading by user.\n");
+		}
+		_main.reset();
+	}
+
+private:
+
+	coro::Task<> trade() noexcept {
+		LOG_DEBUG("The trading coroutine is starting...\n");
+		LOG_DEBUG("symbol='%s'", _sym_pair.c_str());
+		LOG_PLAIN(" price_trigger_percent=%f", _params.price_trigger_percent);
+		LOG_PLAIN(" trade_period_sec=%u", _params.trade_period_sec);
+		LOG_PLAIN(" wait_period_sec=%u", _params.wait_period_sec);
+		LOG_PLAIN(" quantity=%f\n", _params.quantity);
+
+		if(co_await _rt.next_price(PriceUpdateTimeoutSec) != Wake::Price) {
+			LOG_DEBUG("Stop waiting for the first price updated by timeout.\n");
+			co_return;
+		}
+
+		std::uniform_int_distribution<unsigned> first_wait(0u, _params.wait_period_sec ? _params.wait_period_sec - 1u : 0u);
+		const unsigned timeout_sec = first_wait(_random);
+		LOG_DEBUG("The price for symbol '%s' is obtained %f.\n", _sym_pair.c_str(), _rt.last_price());
+		LOG_DEBUG("Waiting for %u seconds before start trading...\n", timeout_sec);
+		co_await _rt.sleep(timeout_sec);
+
+		for(;;) {
+			_params = params::Store::instance().get();
+			if(_rt.feed_stale()) {
+				LOG_DEBUG("The price feed is stale, postponing trading for %u seconds...\n", _params.wait_period_sec);
+				co_await _rt.sleep(_params.wait_period_sec);
+				continue;
+			}
+
+			LOG_DEBUG("Start trading...\n");
+			LOG_DEBUG("buying %f of '%s'...\n", _params.quantity, _sym_pair.c_str());
+			if(not co_await market_order(binance::rest::Order::Side::SELL)) {
+				co_return;
+			}
+
+			switch(co_await _rt.price_move(_params.price_trigger_percent, _params.trade_period_sec)) {
+				case Wake::Price:
+					LOG_DEBUG("Stop trading by price trigger.\n");
+					break;
+
+				case Wake::Timeout:
+					LOG_DEBUG("Stop trading by timeout.\n");
+					break;
+
+				case Wake::Stale:
+					LOG_DEBUG("Stop trading by the stale price feed.\n");
+					break;
+			}
+
+			LOG_DEBUG("selling %f of '%s'...\n", _params.quantity, _sym_pair.c_str());
+			if(not co_await market_order(binance::rest::Order::Side::BUY) || not report_trade()) {
+				co_return;
+			}
+
+			co_await _rt.sleep(_params.wait_period_sec);
+		}
+	}
+
+	coro::Task<bool> market_order(const binance::rest::Order::Side side) noexcept {
+		binance::rest::OrderRequest order {};
+		order.symbol = _sym_pair;
+		order.side = side;
+		order.type = binance::rest::OrderRequest::Type::MARKET;
+		order.quoteOrderQty = _params.quantity;
+		order.newClientOrderId = _orders.next_client_id();
+		_orders.open(order);
+
+		binance::rest::OrderResult result;
+		if(not co_await _rt.place_order(order, result)) {
+			LOG_ERROR("The order '%s' has failed.\n", order.newClientOrderId.c_str());
+			_orders.lost(order.newClientOrderId);
+			co_return false;
+		}
+
+		_orders.apply(result);
+		_orders.prune();
+		_report.fill(result);
+		result.dump();
+		co_return true;
+	}
+
+	bool report_trade() noexcept {
+		_report.trade();
+		_ticks.dump(_sym_pair.c_str(), _ticks.duration_ms());
+		LOG_DEBUG("Waiting for %u seconds before start trading again...\n", _params.wait_period_sec)
+		return true;
+	}
+
+	static void cb_tick(void* instance, const binance::ws::SymbolTicker& ticker) noexcept {
+		auto obj = reinterpret_cast<AppCoro*>(instance);
+		obj->_report.mark(ticker.lastPrice);
+		obj->_rt.price(ticker.lastPrice);
+	}
+
+	static void cb_stream_state(void* instance, binance::ws::Connector::StreamState state) noexcept {
+		auto obj = reinterpret_cast<AppCoro*>(instance);
+		obj->_rt.feed(state == binance::ws::Connector::StreamState::Stale);
+	}
+
+};
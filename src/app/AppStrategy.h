@@ -0,0 +1,849 @@
+#pragma once
+
+#include <string>
+#include <cmath>
+
+#include "../binance/rest/Connector.h"
+#include "../binance/ws/Connector.h"
+#include "../binance/ws/api.h"
+#include "../binance/OrderTable.h"
+#include "../binance/OrderBatcher.h"
+#include "../market/Plane.h"
+#include "../market/TickStore.h"
+#include "../metrics/Metrics.h"
+#include "../snapshot/File.h"
+#include "../strategy/Policies.h"
+#include "TradeReport.h"
+
+namespace bench {
+struct AppDefaultProbe;
+}; // namespace bench
+
+/**
+ * The trading state machine assembled from the policies at compile time, see strategy/Policies.h.
+ * Buys, holds until the price moves by the Signal threshold scaled by the Exit or the holding period is over,
+ * sells and takes a break, as long as the Risk allows.
+ */
+template <typename Signal, typename Entry, typename Exit, typename Sizing, typename Risk>
+class AppStrategy {
+
+	friend struct bench::AppDefaultProbe;
+
+	static constexpr unsigned PriceUpdateTimeoutSec = 10u;
+	static constexpr uint32_t SnapshotVersion = 2u;  // The layout of save(), bump on any change.
+
+	// -----------------------------
+	// State machine.
+	// -----------------------------
+	enum class State : unsigned {
+		Init,          // The instance has been created.
+		WaitForPrice,  // Wait for the first price update via WS.
+		Trading,       // Wait for any of two events; price changing or the trading time out.
+		Wait,          // Take a break before trading.
+		Stopped        // The trading process is stopped.
+	};
+	static constexpr size_t State_nb = static_cast<size_t>(State::Stopped) + 1u;
+
+	enum class Event : unsigned {
+		Start,
+		Stop,
+		PriceUpdated,
+		FeedStale,     // The price stream has delivered nothing for a while.
+		FeedRestored,  // The price stream is live again.
+		OrderRejected, // An order sent over the WebSocket API has failed.
+		Timeout
+	};
+
+	// ---------------------------------
+	// The connectors.
+	// ---------------------------------
+	binance::rest::Connector& _conn_rest;
+	binance::ws::Connector& _conn_ws;  // The WebSocket API order entry.
+	market::Plane& _plane;
+
+	// ---------------------------------
+	// The user defined trader parameters.
+	// ---------------------------------
+	const std::string _symbol;
+	const std::string _sym_pair;
+	const binance::AssetId _asset_basic;
+	const binance::AssetId _asset_symbol;
+	const double  _price_tick;   // If not zero, the price trigger is an OCO order on the exchange.
+	const bool _ws_api;          // The market orders go over the WebSocket API while it is up.
+
+	// ---------------------------------
+	// The policies.
+	// ---------------------------------
+	Signal _signal;
+	Entry _entry;
+	Exit _exit;
+	Sizing _sizing;
+	Risk _risk;
+
+	// ---------------------------------
+	// The state.
+	// ---------------------------------
+	State _state;
+	metrics::Counter* _transitions[State_nb];  // Per the state entered.
+
+	TradeReport _report;
+
+	double _price_last;      // The recent obtained price of the symbol.
+	double _price_start;     // The symbol price before the last trade.
+	double _trigger_percent; // The price move closing the position, fixed at the entry.
+	double _quantity;        // The quote quantity of the last trade.
+	uint64_t _entry_ms;      // The time the position has been opened.
+	bool _feed_stale;        // The price stream is not trusted at the moment.
+	const market::TickStore& _ticks; // The recent ticks of the symbol, shared by the accounts.
+	std::time_t _next_event; // The time in the future that the Event::Timeout will be generated.
+
+	binance::OrderTable _orders;
+	binance::OrderBatcher _batcher;
+	std::string _exit_above;  // The client IDs of the OCO legs closing the position.
+	std::string _exit_below;
+	bool _protected;          // The position is closed by the exchange once the price trigger is hit.
+	uint64_t _exit_query_ms;  // The last query of the OCO exit, see exit_crossed().
+
+	// ---------------------------------
+	// The warm restart.
+	// ---------------------------------
+	snapshot::File _snapshot;
+	std::string _snapshot_buffer;  // The encoded state, reused.
+	std::time_t _snapshot_next;    // The time the next snapshot is taken, zero makes it at once.
+
+public:
+
+	AppStrategy(const AppStrategy&) = delete;
+	AppStrategy& operator=(const AppStrategy&) = delete;
+
+	AppStrategy(AppStrategy&&) = delete;
+	AppStrategy& operator=(AppStrategy&&) = delete;
+
+	AppStrategy(binance::rest::Connector& conn_rest, market::Plane& plane, const CliConfig& cli) noexcept :
+		_conn_rest(conn_rest),
+		_conn_ws(plane.ws()),
+		_plane(plane),
+		_symbol(cli.currency_symbol),
+		_sym_pair(Config::BasicSymbol + cli.currency_symbol),
+		_asset_basic(binance::Assets::intern(Config::BasicSymbol)),
+		_asset_symbol(binance::Assets::intern(cli.currency_symbol)),
+		_price_tick(cli.price_tick),
+		_ws_api(cli.ws_api),
+		_signal(cli),
+		_entry(cli),
+		_exit(cli),
+		_sizing(cli),
+		_risk(cli),
+		_state(State::Init),
+		_report(_asset_basic, _asset_symbol),
+		_price_start(0.),
+		_trigger_percent(params::Store::instance().get().price_trigger_percent),
+		_quantity(params::Store::instance().get().quantity),
+		_entry_ms(0u),
+		_feed_stale(false),
+		_ticks(plane.ticks(_sym_pair)),
+		_next_event(Utils::time_now_sec() + PriceUpdateTimeoutSec),
+		_batcher(conn_rest, _orders),
+		_protected(false),
+		_exit_query_ms(0u),
+		_snapshot(cli.snapshot_path, SnapshotVersion),
+		_snapshot_next(0) {
+
+		LOG_DEBUG("AppStrategy::AppStrategy()\n");
+		for(size_t idx = 0; idx < State_nb; ++idx) {
+			_transitions[idx] = &metrics::Registry::instance().counter(
+				"bintest_state_transitions_total", "The trading state machine transitions by the state entered.",
+				metrics::label("state", to_string(static_cast<State>(idx))));
+		}
+	}
+
+	~AppStrategy() noexcept {
+		LOG_DEBUG("AppStrategy::~AppStrategy()\n");
+		_conn_ws.api_forget(this);
+	}
+
+	bool init() noexcept {
+		LOG_DEBUG("AppStrategy::init()\n");
+
+		bool resumed = false;
+		if(not _snapshot.path().empty() && not restore(resumed)) {
+			return false;
+		}
+
+		// Getting the account information
+		if(not _report.start(_conn_rest)) {
+			return false;
+		}
+
+		if(not _report.initial().get_balance(_asset_symbol, _price_last)) {
+			LOG_ERROR("Symbol '%s' is not available to trade.\n", _sym_pair.c_str());
+			return false;
+		}
+
+		// Register a price watcher callback.
+		if(not _plane.subscribe(_sym_pair, cb_tick, cb_stream_state, this)) {
+			LOG_ERROR("Fail to register the ticker listener.");
+			return false;
+		}
+
+		if(not _snapshot.path().empty()) {
+			_snapshot.start();
+		}
+
+		if(not resumed) {
+			handle_event(Event::Start);
+		}
+		return true;
+	}
+
+	/**
+	 * The timers of the state machine, the prices come from the market::Plane service.
+	 */
+	inline bool service() noexcept {
+		const auto now = Utils::time_now_sec();
+		if(now > _next_event) {
+			handle_event(Event::Timeout);
+		}
+		if(now >= _snapshot_next && not _snapshot.path().empty()) {
+			take_snapshot(now);
+		}
+		return _state != State::Stopped;
+	}
+
+	void finit() noexcept {
+		_plane.unsubscribe(_sym_pair, this);
+		handle_event(Event::Stop);
+		if(not _snapshot.path().empty()) {
+			take_snapshot(Utils::time_now_sec());
+			_snapshot.stop();
+		}
+		_conn_ws.api_forget(this);
+	}
+
+private:
+
+	static void cb_tick(void* instance, const binance::ws::SymbolTicker& ticker) noexcept {
+		auto obj = reinterpret_cast<AppStrategy*>(instance);
+		obj->_report.mark(ticker.lastPrice);
+		obj->price_update(ticker.lastPrice);
+	}
+
+	static void cb_stream_state(void* instance, binance::ws::Connector::StreamState state) noexcept {
+		auto obj = reinterpret_cast<AppStrategy*>(instance);
+		switch(state) {
+			case binance::ws::Connector::StreamState::Stale:
+				obj->_feed_stale = true;
+				obj->handle_event(Event::FeedStale);
+				break;
+
+			case binance::ws::Connector::StreamState::Live:
+				obj->_feed_stale = false;
+				obj->handle_event(Event::FeedRestored);
+				break;
+		}
+	}
+
+	inline void price_update(double price) noexcept {
+		_price_last = price;
+		handle_event(Event::PriceUpdated);
+	}
+
+	inline void handle_event(const Event event) noexcept {
+
+		switch(_state) {
+
+			// ------------------
+			// Init
+			// ------------------
+			case State::Init:
+
+				switch(event) {
+					case Event::Start:
+						LOG_DEBUG("The trading state machine is starting...\n");
+						LOG_DEBUG("symbol='%s'", _sym_pair.c_str());
+						LOG_PLAIN(" price_trigger_percent=%f", _trigger_percent);
+						LOG_PLAIN(" trade_period_sec=%u", _exit.hold_sec());
+						LOG_PLAIN(" wait_period_sec=%u", _entry.wait_sec());
+						LOG_PLAIN(" quantity=%f\n", _quantity);
+						state_transition(State::WaitForPrice, PriceUpdateTimeoutSec);
+						break;
+
+					case Event::PriceUpdated:
+					case Event::FeedStale:
+					case Event::FeedRestored:
+					case Event::OrderRejected:
+						break;
+
+					default:
+						LOG_DEBUG("Starting the trading machine has been canceled.\n");
+						state_transition(State::Stopped, 0);
+						break;
+				}
+				break;
+
+
+			// ------------------
+			// WaitForPrice
+			// ------------------
+			case State::WaitForPrice:
+
+				switch(event) {
+					case Event::PriceUpdated: {
+
+						const unsigned timeout_sec = _entry.first_wait_sec();
+						LOG_DEBUG("The price for symbol '%s' is obtained %f.\n", _sym_pair.c_str(), _price_last);
+						LOG_DEBUG("Waiting for %u seconds before start trading...\n", timeout_sec)
+						state_transition(State::Wait, timeout_sec);
+					}
+						break;
+
+					case Event::Timeout:
+						LOG_DEBUG("Stop waiting for the first price updated by timeout.\n");
+						state_transition(State::Stopped, 0);
+						break;
+
+					case Event::Stop:
+						LOG_DEBUG("Stop waiting for the first price updated by user.\n");
+						state_transition(State::Stopped, 0);
+						break;
+
+					case Event::FeedStale:
+					case Event::FeedRestored:
+					case Event::OrderRejected:
+						break;
+
+					default:
+						LOG_CRITICAL("Inconsistent state transition.\n");
+						break;
+				}
+				break;
+
+
+			// ------------------
+			// Wait
+			// ------------------
+			case State::Wait:
+
+				switch(event) {
+					case Event::Timeout:
+						if(not _risk.allow_entry(_feed_stale)) {
+							LOG_DEBUG("The price feed is stale, postponing trading for %u seconds...\n", _entry.wait_sec());
+							state_transition(State::Wait, _entry.wait_sec());
+							break;
+						}
+						_price_start = _price_last;
+						_trigger_percent = _signal.threshold_percent(_ticks);
+						_quantity = _sizing.quote_quantity(_price_start);
+						_entry_ms = Utils::time_now_ms();
+						LOG_DEBUG("Start trading...\n");
+						// The exit is protected once the entry is confirmed filled, see entry_filled().
+						if(action_buy()) {
+							state_transition(State::Trading, _exit.hold_sec());
+						} else {
+							state_transition(State::Stopped, 0u);
+						}
+						break;
+
+					case Event::Stop:
+						LOG_DEBUG("Stop waiting by user.\n");
+						state_transition(State::Stopped, 0);
+						break;
+
+					case Event::OrderRejected:
+						// The closing order of the previous trade has failed, the position is unknown.
+						LOG_DEBUG("Stop waiting by the order failure.\n");
+						state_transition(State::Stopped, 0);
+						break;
+
+					case Event::PriceUpdated:
+					case Event::FeedStale:
+					case Event::FeedRestored:
+						break;
+
+					default:
+						LOG_CRITICAL("Inconsistent state transition.\n");
+						break;
+				}
+				break;
+
+			// ------------------
+			// Trading
+			// ------------------
+			case State::Trading:
+
+				switch(event) {
+					case Event::Timeout:
+						LOG_DEBUG("Stop trading by timeout.\n");
+						// Unprotecting sells on its own if the exit is not filled.
+						if(_protected ? action_unprotect() : action_sell()) {
+							state_transition(State::Wait, _entry.wait_sec());
+						} else {
+							state_transition(State::Stopped, 0u);
+						}
+						break;
+
+					case Event::PriceUpdated: {
+						const double price_delta = _price_last - _price_start;
+						const double price_delta_percent = (price_delta / _price_start) * 100.;
+
+						print_price_stats(price_delta, price_delta_percent);
+
+						const bool triggered = std::abs(price_delta_percent) > _trigger_percent * _exit.scale(_entry_ms);
+
+						if(_protected) {
+							// The exchange closes the position, the fill is only to be confirmed.
+							if(exit_crossed() && action_exit_filled()) {
+								LOG_DEBUG("Stopped trading by the exchange price trigger.\n");
+								state_transition(State::Wait, _entry.wait_sec());
+							}
+						} else if(triggered) {
+							LOG_DEBUG("Stop trading by price trigger.\n");
+							if(action_sell()) {
+								state_transition(State::Wait, _entry.wait_sec());
+							} else {
+								state_transition(State::Stopped, 0u);
+							}
+						}
+					}
+						break;
+
+					case Event::FeedStale:
+						if(_protected) {
+							LOG_DEBUG("The price feed is stale, the position is protected by the exchange.\n");
+							break;
+						}
+						if(not _risk.exit_on_stale()) {
+							break;
+						}
+						// The price trigger can not be evaluated anymore, so closing the position.
+						LOG_DEBUG("Stop trading by the stale price feed.\n");
+						if(action_sell()) {
+							state_transition(State::Wait, _entry.wait_sec());
+						} else {
+							state_transition(State::Stopped, 0u);
+						}
+						break;
+
+					case Event::FeedRestored:
+						break;
+
+					case Event::OrderRejected:
+						LOG_DEBUG("Stop trading by the order failure.\n");
+						if(_protected) {
+							_batcher.cancel_all(_sym_pair);
+							_batcher.flush();
+							_protected = false;
+						}
+						state_transition(State::Stopped, 0);
+						break;
+
+					case Event::Stop:
+						LOG_DEBUG("Stop trading by user.\n");
+						if(_protected) {
+							_batcher.cancel_all(_sym_pair);
+							_batcher.flush();
+							_protected = false;
+						}
+						state_transition(State::Stopped, 0);
+						break;
+
+					default:
+						LOG_CRITICAL("Inconsistent state transition.\n");
+						break;
+
+				}
+				break;
+
+			// ------------------
+			// Stopped
+			// ------------------
+			case State::Stopped:
+				break;
+		}
+
+	}
+
+
+	inline void state_transition(const State state_new, unsigned timeout) noexcept {
+		_next_event = Utils::time_now_sec() + timeout;
+		_state = state_new;
+		_transitions[static_cast<size_t>(state_new)]->inc();
+		_snapshot_next = 0;
+	}
+
+	static const char* to_string(const State state) noexcept {
+		switch(state) {
+			case State::Init:
+				return "Init";
+			case State::WaitForPrice:
+				return "WaitForPrice";
+			case State::Trading:
+				return "Trading";
+			case State::Wait:
+				return "Wait";
+			case State::Stopped:
+				return "Stopped";
+		}
+		return "";
+	}
+
+	bool action_buy() noexcept {
+		LOG_DEBUG("buying %f of '%s'...\n", _quantity, _sym_pair.c_str());
+
+		if(_ws_api && _conn_ws.api_ready()) {
+			return place_market_order(binance::rest::Order::Side::SELL, cb_order_buy);
+		}
+
+		binance::rest::NewOrderResponse response;
+		bool result = _conn_rest.new_market_order(response, _sym_pair, binance::rest::Order::Side::SELL, _quantity);
+		if(result) {
+			response.dump();
+			_report.fill(response);
+			entry_filled(response);
+		}
+
+		return result;
+	}
+
+	bool action_sell() noexcept {
+		LOG_DEBUG("selling %f of '%s'...\n", _quantity, _sym_pair.c_str());
+
+		if(_ws_api && _conn_ws.api_ready()) {
+			return place_market_order(binance::rest::Order::Side::BUY, cb_order_sell);
+		}
+
+		binance::rest::NewOrderResponse response;
+		bool result = _conn_rest.new_market_order(response, _sym_pair, binance::rest::Order::Side::BUY, _quantity);
+		if(result) {
+			response.dump();
+			_report.fill(response);
+			result = report_trade();
+		}
+
+		return result;
+	}
+
+	/**
+	 * Sends the market order over the WebSocket API, the outcome comes to the callback.
+	 * @return false - if the request can not be sent.
+	 */
+	bool place_market_order(
+		const binance::rest::Order::Side side, binance::ws::Connector::ApiCallBack_t callback
+	                       ) noexcept {
+		binance::rest::OrderRequest order {};
+		order.symbol = _sym_pair;
+		order.side = side;
+		order.type = binance::rest::OrderRequest::Type::MARKET;
+		order.quoteOrderQty = _quantity;
+		order.newClientOrderId = _orders.next_client_id();
+
+		_orders.open(order);
+		if(_conn_ws.order_place(order, callback, this) == 0u) {
+			_orders.lost(order.newClientOrderId);
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Updates the order table from a WebSocket API response.
+	 * @return true - if the order has been accepted.
+	 */
+	bool order_response(const int status, const Json::Value& result, binance::rest::OrderResult& response) noexcept {
+		if(status != 200) {
+			LOG_ERROR("The order has failed. status=%d '%s'\n", status, Json::FastWriter().write(result).c_str());
+			return false;
+		}
+
+		if(not response.parse(result)) {
+			LOG_ERROR("Failed to parse the order response.\n");
+			return false;
+		}
+		_orders.apply(response);
+		_orders.prune();
+		_report.fill(response);
+		response.dump();
+		return true;
+	}
+
+	static void cb_order_buy(void* instance, uint64_t, int status, const Json::Value& result) noexcept {
+		auto obj = reinterpret_cast<AppStrategy*>(instance);
+		binance::rest::OrderResult response;
+		if(obj->order_response(status, result, response)) {
+			// The position may have been given up while the order has been in flight.
+			if(obj->_state == State::Trading) {
+				obj->entry_filled(response);
+			}
+		} else {
+			obj->handle_event(Event::OrderRejected);
+		}
+	}
+
+	static void cb_order_sell(void* instance, uint64_t, int status, const Json::Value& result) noexcept {
+		auto obj = reinterpret_cast<AppStrategy*>(instance);
+		binance::rest::OrderResult response;
+		if(not obj->order_response(status, result, response) || not obj->report_trade()) {
+			obj->handle_event(Event::OrderRejected);
+		}
+	}
+
+	/**
+	 * Protects the position by the exchange, sized by the quantity the entry has actually moved: the executed one
+	 * net of the commission charged in the basic asset.
+	 */
+	template <typename Response>
+	void entry_filled(const Response& response) noexcept {
+		if(_price_tick <= 0. || _protected) {
+			return;
+		}
+		double quantity = response.executedQty;
+		for(const auto& fill : response.fills) {
+			if(fill.commissionAsset == _asset_basic) {
+				quantity -= fill.commission;
+			}
+		}
+		quantity = std::floor(quantity / Config::BasicLotStep) * Config::BasicLotStep;
+		if(quantity <= 0.) {
+			LOG_ERROR("The entry has not been filled, the position is not protected.\n");
+			return;
+		}
+		action_protect(quantity);
+	}
+
+	/**
+	 * Places the OCO closing the position once the price moves by the trigger either way:
+	 * a post-only limit below the start price and a stop above it.
+	 */
+	bool action_protect(const double quantity) noexcept {
+		const double ratio = _trigger_percent / 100.;
+
+		binance::rest::OrderRequest below {};
+		below.symbol = _sym_pair;
+		below.side = binance::rest::Order::Side::BUY;
+		below.type = binance::rest::OrderRequest::Type::LIMIT_MAKER;
+		below.price = std::floor(_price_start * (1. - ratio) / _price_tick) * _price_tick;
+		below.quantity = quantity;
+
+		binance::rest::OrderRequest above = below;
+		above.type = binance::rest::OrderRequest::Type::STOP_LOSS;
+		above.price = 0.;
+		above.stopPrice = std::ceil(_price_start * (1. + ratio) / _price_tick) * _price_tick;
+
+		_exit_below = _batcher.submit(below);
+		_exit_above = _batcher.submit(above);
+		_protected = _batcher.flush();
+
+		if(not _protected) {
+			LOG_ERROR("The OCO exit has failed, falling back to the local price trigger.\n");
+			_batcher.cancel_all(_sym_pair);
+			_batcher.flush();
+		}
+		return _protected;
+	}
+
+	/**
+	 * Cancels the OCO and closes the position by the market unless the OCO has been filled meanwhile.
+	 */
+	bool action_unprotect() noexcept {
+		_batcher.cancel_all(_sym_pair);
+		_batcher.flush();
+		_protected = false;
+
+		if(action_exit_filled()) {
+			return true;
+		}
+		return action_sell();
+	}
+
+	/**
+	 * @return true - if the price is past a leg of the OCO exit and the exit has not been queried for
+	 * Config::ExitQueryIntervalMS, so the fill is worth querying.
+	 */
+	bool exit_crossed() noexcept {
+		const auto above = _orders.find(_exit_above);
+		const auto below = _orders.find(_exit_below);
+		const bool crossed = (above && _price_last >= above->request.stopPrice)
+		                     || (below && _price_last <= below->request.price);
+		const auto now = Utils::time_now_ms();
+		if(not crossed || now < _exit_query_ms + Config::ExitQueryIntervalMS) {
+			return false;
+		}
+		_exit_query_ms = now;
+		return true;
+	}
+
+	/**
+	 * @return true - if a leg of the OCO exit is filled, the trade is reported then.
+	 */
+	bool action_exit_filled() noexcept {
+		bool filled = false;
+		for(const auto& client_id : {_exit_above, _exit_below}) {
+			binance::rest::OrderResult response;
+			if(_conn_rest.query_order(response, _sym_pair, client_id)) {
+				_orders.apply(response);
+				_report.fill(response);
+			}
+			const auto entry = _orders.find(client_id);
+			filled |= (entry && entry->status == binance::OrderTable::Status::FILLED);
+		}
+
+		if(filled) {
+			_protected = false;
+			_orders.prune();
+			report_trade();
+		}
+		return filled;
+	}
+
+	/**
+	 * Prints the PnL made by the last trade and by the whole session.
+	 */
+	bool report_trade() noexcept {
+		_report.trade();
+		_ticks.dump(_sym_pair.c_str(), _ticks.duration_ms());
+
+		LOG_DEBUG("Waiting for %u seconds before start trading again...\n", _entry.wait_sec())
+
+		return true;
+	}
+
+
+	// ------------------------------
+	// Warm restart
+	// ------------------------------
+
+	/**
+	 * Encodes the state and hands it over to the snapshot writer.
+	 * The monotonic times are saved as the wall ones, so they survive the restart.
+	 */
+	void take_snapshot(const std::time_t now) noexcept {
+		_snapshot_next = now + Config::SnapshotIntervalSec;
+
+		_snapshot_buffer.clear();
+		snapshot::Encoder enc(_snapshot_buffer);
+		enc.put(_sym_pair);
+		enc.put(static_cast<uint8_t>(_state));
+		enc.put(static_cast<int64_t>(_next_event));
+		enc.put(_price_last);
+		enc.put(_price_start);
+		enc.put(_trigger_percent);
+		enc.put(_quantity);
+		enc.put(_entry_ms ? Utils::time_wall_ms() - (Utils::time_now_ms() - _entry_ms) : uint64_t(0u));
+		enc.put(static_cast<uint8_t>(_protected));
+		enc.put(_exit_above);
+		enc.put(_exit_below);
+		_report.save(enc);
+		_orders.save(enc);
+		_ticks.save(enc);
+
+		_snapshot.submit(_snapshot_buffer);
+	}
+
+	/**
+	 * Restores the state of the latest snapshot and reconciles it with the exchange.
+	 * A snapshot of another symbol or taken out of the trading cycle is ignored, the trading starts from scratch.
+	 * @param resumed - Set if the trading goes on from the snapshot.
+	 * @return false - if the exchange state can not be obtained.
+	 */
+	bool restore(bool& resumed) noexcept {
+		resumed = false;
+		if(not _snapshot.load(_snapshot_buffer)) {
+			return true;
+		}
+
+		snapshot::Decoder dec(_snapshot_buffer.data(), _snapshot_buffer.size());
+		std::string sym_pair;
+		uint8_t state = 0u;
+		int64_t next_event = 0;
+		uint64_t entry_wall_ms = 0u;
+		uint8_t protect = 0u;
+
+		dec.get(sym_pair);
+		dec.get(state);
+		if(not dec.ok() || sym_pair != _sym_pair) {
+			LOG_INFO("The snapshot is not of '%s', starting from scratch.\n", _sym_pair.c_str());
+			return true;
+		}
+		if(static_cast<State>(state) != State::Wait && static_cast<State>(state) != State::Trading) {
+			LOG_INFO("The snapshot is taken out of the trading cycle, starting from scratch.\n");
+			return true;
+		}
+
+		dec.get(next_event);
+		dec.get(_price_last);
+		dec.get(_price_start);
+		dec.get(_trigger_percent);
+		dec.get(_quantity);
+		dec.get(entry_wall_ms);
+		dec.get(protect);
+		dec.get(_exit_above);
+		dec.get(_exit_below);
+		if(not dec.ok() || not _report.restore(dec) || not _orders.restore(dec)
+		   || not _plane.ticks(_sym_pair).restore(dec)
+		   || not dec.done()) {
+			LOG_ERROR("AppStrategy::restore() the snapshot can not be restored.\n");
+			return false;
+		}
+
+		const auto now_ms = Utils::time_now_ms();
+		const auto age_ms = std::min(Utils::time_wall_ms() - std::min(entry_wall_ms, Utils::time_wall_ms()), now_ms);
+		_entry_ms = entry_wall_ms ? now_ms - age_ms : 0u;
+		_protected = protect;
+		_state = static_cast<State>(state);
+		_next_event = static_cast<std::time_t>(next_event);
+		if(_state == State::Wait) {
+			// The price of the snapshot is not to be traded on, the stream has the time to deliver a fresh one.
+			_next_event = std::max(_next_event, Utils::time_now_sec() + static_cast<std::time_t>(PriceUpdateTimeoutSec));
+		}
+
+		LOG_INFO("Resuming '%s' in the state '%s' from the snapshot '%s'.\n", _sym_pair.c_str(), to_string(_state),
+		         _snapshot.path().c_str());
+		reconcile();
+		resumed = true;
+		return true;
+	}
+
+	/**
+	 * Brings the orders of the snapshot up to date. The position is closed already if an exit leg has been
+	 * filled while the process has been down; the local price trigger takes over if the exit is gone otherwise.
+	 */
+	void reconcile() noexcept {
+		_orders.for_each_live([this](const binance::String& client_id, const binance::OrderTable::Entry& entry) {
+			binance::rest::OrderResult response;
+			if(_conn_rest.query_order(response, entry.request.symbol, client_id)) {
+				_orders.apply(response);
+				_report.fill(response);
+			}
+		});
+
+		if(_state == State::Trading && _protected) {
+			const auto above = _orders.find(_exit_above);
+			const auto below = _orders.find(_exit_below);
+			if(action_exit_filled()) {
+				LOG_DEBUG("The position has been closed by the exchange meanwhile.\n");
+				state_transition(State::Wait, _entry.wait_sec());
+			} else if(not (above && above->live()) && not (below && below->live())) {
+				LOG_ERROR("The OCO exit is gone, falling back to the local price trigger.\n");
+				_protected = false;
+			}
+		}
+
+		_orders.prune();
+		_orders.dump();
+	}
+
+	// ------------------------------
+	// Printing stuff
+	// ------------------------------
+
+	void print_price_stats(const double price_delta, const double price_delta_percent) noexcept {
+		LOG_DEBUG("'%s' price=", _sym_pair.c_str());
+		LOG_LESS_GREATER_FLOAT(_price_last, _price_start);
+		LOG_PLAIN("  price-delta=");
+		LOG_LESS_GREATER_FLOAT(price_delta, .0);
+		LOG_PLAIN("  price-delta-percent=");
+		LOG_LESS_GREATER_FLOAT(price_delta_percent, .0);
+		LOG_PLAIN("\n");
+	}
+
+};
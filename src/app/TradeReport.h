@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../binance/Assets.h"
+#include "../binance/rest/api.h"
+#include "../binance/rest/Connector.h"
+#include "../Log.h"
+#include "../pnl/Portfolio.h"
+#include "../pnl/Position.h"
+#include "../snapshot/Buffer.h"
+
+/**
+ * The PnL of a trading session, built from the fills of the orders and marked to the ticks, see pnl::Position.
+ * The account state is taken once, before the first trade, to check the balances; the report needs no REST then.
+ */
+class TradeReport {
+
+	const binance::AssetId _asset_basic;
+	const binance::AssetId _asset_symbol;
+
+	binance::rest::AccountInformation _acc_info_init;  // The account state before trading process is started.
+
+	pnl::Position _position;
+	double _realized_last;  // The realized PnL by the previous trade.
+
+public:
+
+	TradeReport(const TradeReport&) = delete;
+	TradeReport& operator=(const TradeReport&) = delete;
+
+	TradeReport(const binance::AssetId asset_basic, const binance::AssetId asset_symbol) noexcept :
+		_asset_basic(asset_basic),
+		_asset_symbol(asset_symbol),
+		_position(pnl::Portfolio::instance(), asset_basic, asset_symbol),
+		_realized_last(0.) {
+	}
+
+	/**
+	 * Takes the initial account state.
+	 */
+	bool start(binance::rest::Connector& conn) noexcept {
+		if(not conn.account(_acc_info_init)) {
+			LOG_ERROR("Failed to get the account information.\n");
+			return false;
+		}
+		_acc_info_init.dump();
+		return true;
+	}
+
+	inline const binance::rest::AccountInformation& initial() const noexcept {
+		return _acc_info_init;
+	}
+
+	/**
+	 * Takes the fills of the order response, or the quantity executed since the last state if there are none.
+	 */
+	inline void fill(const binance::rest::OrderResult& result) noexcept {
+		if(not _position.fills(result)) {
+			_position.order(result);
+		}
+	}
+
+	inline void fill(const binance::rest::NewOrderResponse& response) noexcept {
+		_position.fills(response);
+	}
+
+	/**
+	 * Marks the position to the price of the pair.
+	 */
+	inline void mark(const double price) noexcept {
+		_position.mark(price);
+	}
+
+	/**
+	 * Writes the position; the account state is not, the balances are checked at the start only.
+	 */
+	void save(snapshot::Encoder& enc) const noexcept {
+		_position.save(enc);
+	}
+
+	/**
+	 * Continues the position of the snapshot.
+	 */
+	bool restore(snapshot::Decoder& dec) noexcept {
+		if(not _position.restore(dec)) {
+			return false;
+		}
+		_realized_last = _position.realized();
+		LOG_DEBUG("The position of the snapshot");
+		_position.dump();
+		return true;
+	}
+
+	/**
+	 * Prints the PnL made by the last trade, the position and the totals of the process.
+	 */
+	void trade() noexcept {
+		const double delta = _position.realized() - _realized_last;
+		_realized_last = _position.realized();
+
+		LOG_DEBUG("Last trade realized ");
+		LOG_LESS_GREATER_FLOAT(delta, .0);
+		LOG_PLAIN(" %s\n", binance::Assets::name(_asset_symbol).c_str());
+		LOG_DEBUG("Total");
+		_position.dump();
+		pnl::Portfolio::instance().dump();
+	}
+
+};
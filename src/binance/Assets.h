@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+#include "types.h"
+#include "../Utils.h"
+
+namespace binance {
+
+using AssetId = uint32_t;
+
+/**
+ * The process wide registry of the interned asset names.
+ * An asset gets a dense ID once, so the balances can be indexed by the ID instead of comparing the strings.
+ * The names are kept upper-cased as Binance reports them. Not thread safe.
+ */
+class Assets {
+
+	std::unordered_map<std::string, AssetId> _ids;
+	std::vector<std::string> _names;
+
+public:
+
+	static constexpr AssetId None = ~AssetId(0u);
+
+	Assets(const Assets&) = delete;
+	Assets& operator=(const Assets&) = delete;
+
+	/**
+	 * @return - The ID of the asset, a new one if the asset has not been seen before.
+	 */
+	static AssetId intern(std::string name) noexcept {
+		return intern_upper(name);
+	}
+
+	static AssetId intern(const char* name) noexcept {
+		return intern(std::string(name));
+	}
+
+	/**
+	 * Does not allocate if the asset has been seen before.
+	 */
+	static AssetId intern(std::string_view name) noexcept {
+		static std::string scratch;
+		scratch.assign(name.data(), name.size());
+		return intern_upper(scratch);
+	}
+
+	/**
+	 * @return - The ID of the asset or Assets::None if the asset has never been interned.
+	 */
+	static AssetId find(std::string name) noexcept {
+		const auto& reg = instance();
+		Utils::string_to_upper(name);
+		const auto it = reg._ids.find(name);
+		return it != reg._ids.end() ? it->second : None;
+	}
+
+	static inline const std::string& name(const AssetId id) noexcept {
+		return instance()._names[id];
+	}
+
+	/**
+	 * @return - The upper bound of the IDs issued so far.
+	 */
+	static inline size_t size() noexcept {
+		return instance()._names.size();
+	}
+
+private:
+
+	Assets() noexcept = default;
+
+	static Assets& instance() noexcept {
+		static Assets reg;
+		return reg;
+	}
+
+	/**
+	 * @param name - Upper-cased in place.
+	 */
+	static AssetId intern_upper(std::string& name) noexcept {
+		auto& reg = instance();
+		Utils::string_to_upper(name);
+		const auto it = reg._ids.find(name);
+		if(it != reg._ids.end()) {
+			return it->second;
+		}
+		const auto id = static_cast<AssetId>(reg._names.size());
+		reg._names.push_back(name);
+		reg._ids.emplace(name, id);
+		return id;
+	}
+
+};
+
+}; // namespace binance
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "types.h"
+#include "OrderTable.h"
+#include "rest/api.h"
+#include "rest/Connector.h"
+#include "../Log.h"
+
+namespace binance {
+
+/**
+ * Collects the order intents of a strategy and sends them in as few signed requests as possible:
+ *
+ *  - the cancels covering all the orders of a symbol become one cancel-all (DELETE /api/v3/openOrders),
+ *    which also replaces any other cancel of the symbol;
+ *  - a take-profit and a stop-loss of the same symbol, side and quantity become one OCO order list;
+ *  - a cancel followed by a new order of the same symbol become one cancel-replace;
+ *  - the rest is sent as is.
+ *
+ * The cancels go first, so a new order never competes with the one it is meant to replace.
+ * Every order is registered in the OrderTable before it is sent.
+ */
+class OrderBatcher {
+
+	struct Cancel {
+		String symbol;
+		String client_id;
+	};
+
+	rest::Connector& _conn;
+	OrderTable& _orders;
+
+	std::vector<rest::OrderRequest> _new;
+	std::vector<Cancel> _cancel;
+	std::vector<String> _cancel_all;
+
+public:
+
+	OrderBatcher(const OrderBatcher&) = delete;
+	OrderBatcher& operator=(const OrderBatcher&) = delete;
+
+	OrderBatcher(rest::Connector& conn, OrderTable& orders) noexcept :
+		_conn(conn),
+		_orders(orders) {
+	}
+
+	/**
+	 * @param order - Its newClientOrderId is assigned if empty.
+	 * @return - The client ID of the order.
+	 */
+	String submit(rest::OrderRequest order) noexcept {
+		if(order.newClientOrderId.empty()) {
+			order.newClientOrderId = _orders.next_client_id();
+		}
+		_new.push_back(std::move(order));
+		return _new.back().newClientOrderId;
+	}
+
+	void cancel(const String& symbol, const String& client_id) noexcept {
+		_cancel.push_back(Cancel {symbol, client_id});
+	}
+
+	void cancel_all(const String& symbol) noexcept {
+		if(std::find(_cancel_all.begin(), _cancel_all.end(), symbol) == _cancel_all.end()) {
+			_cancel_all.push_back(symbol);
+		}
+	}
+
+	inline bool empty() const noexcept {
+		return _new.empty() && _cancel.empty() && _cancel_all.empty();
+	}
+
+	/**
+	 * Sends the intents queued.
+	 * @return false - if any of the requests has failed. The orders affected are left in the table as Unknown,
+	 *                 except the ones of a failed cancel-all which are queried to learn if the cancel has happened.
+	 */
+	bool flush() noexcept {
+		bool result = true;
+		merge_cancels();
+		const auto ocos = extract_ocos();
+
+		// Cancel-all.
+		for(const auto& symbol : _cancel_all) {
+			rest::CancelAllResult response;
+			_orders.cancel_all(symbol);
+			if(_conn.cancel_open_orders(response, symbol)) {
+				_orders.apply(response);
+			} else {
+				reconcile(symbol);
+				result = false;
+			}
+		}
+		_cancel_all.clear();
+
+		// Cancel-replace.
+		for(auto it = _cancel.begin(); it != _cancel.end();) {
+			const auto order = std::find_if(_new.begin(), _new.end(), [&](const rest::OrderRequest& item) {
+				return item.symbol == it->symbol;
+			});
+			if(order == _new.end()) {
+				++it;
+				continue;
+			}
+
+			rest::CancelReplaceResult response;
+			_orders.replace(it->client_id, *order);
+			if(_conn.cancel_replace(response, it->client_id, *order)) {
+				_orders.apply(response);
+			} else {
+				_orders.lost(it->client_id);
+				_orders.lost(order->newClientOrderId);
+				result = false;
+			}
+			_new.erase(order);
+			it = _cancel.erase(it);
+		}
+
+		// The rest.
+		for(const auto& item : _cancel) {
+			rest::OrderResult response;
+			_orders.cancel(item.client_id);
+			if(_conn.cancel_order(response, item.symbol, item.client_id)) {
+				_orders.apply(response);
+			} else {
+				_orders.lost(item.client_id);
+				result = false;
+			}
+		}
+		_cancel.clear();
+
+		for(const auto& item : ocos) {
+			result &= send_oco(item);
+		}
+
+		for(const auto& item : _new) {
+			rest::OrderResult response;
+			_orders.open(item);
+			if(_conn.new_order(response, item)) {
+				_orders.apply(response);
+			} else {
+				_orders.lost(item.newClientOrderId);
+				result = false;
+			}
+		}
+		_new.clear();
+
+		return result;
+	}
+
+private:
+
+	/**
+	 * Queries the orders a failed cancel-all has left pending, the cancel may or may not have reached the exchange.
+	 * The orders failed to be queried are marked Unknown.
+	 */
+	void reconcile(const String& symbol) noexcept {
+		_orders.for_each_live([&](const String& client_id, const OrderTable::Entry& entry) {
+			if(entry.request.symbol != symbol || entry.status != OrderTable::Status::PendingCancel) {
+				return;
+			}
+			rest::OrderResult response;
+			if(_conn.query_order(response, symbol, client_id)) {
+				_orders.apply(response);
+			}
+			if(entry.status == OrderTable::Status::PendingCancel) {
+				_orders.lost(client_id);
+			}
+		});
+	}
+
+	/**
+	 * Turns the cancels into the cancel-alls where possible, drops the cancels the cancel-alls cover.
+	 */
+	void merge_cancels() noexcept {
+		for(const auto& item : _cancel) {
+			const auto symbol_cancels = std::count_if(_cancel.begin(), _cancel.end(), [&](const Cancel& other) {
+				return other.symbol == item.symbol;
+			});
+			const auto live_nb = _orders.live_nb(item.symbol);
+			if(symbol_cancels > 1 && static_cast<size_t>(symbol_cancels) >= live_nb) {
+				cancel_all(item.symbol);
+			}
+		}
+
+		_cancel.erase(std::remove_if(_cancel.begin(), _cancel.end(), [&](const Cancel& item) {
+			return std::find(_cancel_all.begin(), _cancel_all.end(), item.symbol) != _cancel_all.end();
+		}), _cancel.end());
+	}
+
+	static inline bool take_profit(const rest::OrderRequest& order) noexcept {
+		return order.type == rest::OrderRequest::Type::LIMIT_MAKER || order.type == rest::OrderRequest::Type::TAKE_PROFIT
+		       || order.type == rest::OrderRequest::Type::TAKE_PROFIT_LIMIT;
+	}
+
+	static inline bool stop_loss(const rest::OrderRequest& order) noexcept {
+		return order.type == rest::OrderRequest::Type::STOP_LOSS || order.type == rest::OrderRequest::Type::STOP_LOSS_LIMIT;
+	}
+
+	static bool oco_pair(const rest::OrderRequest& lhs, const rest::OrderRequest& rhs) noexcept {
+		return lhs.symbol == rhs.symbol && lhs.side == rhs.side && lhs.quantity == rhs.quantity
+		       && lhs.quantity > 0. && lhs.level() != rhs.level()
+		       && ((take_profit(lhs) && stop_loss(rhs)) || (stop_loss(lhs) && take_profit(rhs)));
+	}
+
+	/**
+	 * Takes the take-profit and stop-loss pairs out of the new orders.
+	 */
+	std::vector<rest::OcoRequest> extract_ocos() noexcept {
+		std::vector<rest::OcoRequest> result;
+		for(size_t idx = 0; idx < _new.size(); ++idx) {
+			for(size_t pair = idx + 1u; pair < _new.size(); ++pair) {
+				const auto& lhs = _new[idx];
+				const auto& rhs = _new[pair];
+				if(oco_pair(lhs, rhs)) {
+					const bool lhs_above = lhs.level() > rhs.level();
+					result.push_back(rest::OcoRequest {_orders.next_client_id(), lhs_above ? lhs : rhs, lhs_above ? rhs : lhs});
+					_new.erase(_new.begin() + pair);
+					_new.erase(_new.begin() + idx);
+					idx--;
+					break;
+				}
+			}
+		}
+		return result;
+	}
+
+	bool send_oco(const rest::OcoRequest& oco) noexcept {
+		_orders.open(oco.above);
+		_orders.open(oco.below);
+
+		rest::OrderListResult response;
+		if(_conn.new_oco(response, oco)) {
+			_orders.apply(response);
+			return true;
+		}
+
+		_orders.lost(oco.above.newClientOrderId);
+		_orders.lost(oco.below.newClientOrderId);
+		return false;
+	}
+
+};
+
+}; // namespace binance
@@ -0,0 +1,407 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+
+#include "types.h"
+#include "rest/api.h"
+#include "../Config.h"
+#include "../Log.h"
+#include "../Utils.h"
+#include "../metrics/Metrics.h"
+#include "../snapshot/Buffer.h"
+
+namespace binance {
+
+/**
+ * The local state of the orders keyed by the client order ID assigned before the order is sent.
+ * An order is known from the moment it is sent, so a lost or late response does not lose it.
+ * The state is updated from the REST responses; a response older than the state known is ignored.
+ */
+class OrderTable {
+public:
+
+	enum class Status {
+		PendingNew,      // Sent, no response yet.
+		PendingCancel,   // Cancel sent, no response yet.
+		Unknown,         // The request has failed in the transit, the order is to be queried.
+		NEW,
+		PARTIALLY_FILLED,
+		FILLED,
+		CANCELED,
+		REJECTED,
+		EXPIRED,
+		EXPIRED_IN_MATCH
+	};
+	static constexpr size_t Status_nb = static_cast<size_t>(Status::EXPIRED_IN_MATCH) + 1u;
+
+	struct Entry {
+		rest::OrderRequest request;
+		Status status;
+		SInteger orderId;
+		Float executedQty;
+		Float cummulativeQuoteQty;
+		Time time;            // The exchange time of the state.
+
+		inline bool live() const noexcept {
+			return not OrderTable::terminal(status);
+		}
+	};
+
+private:
+
+	std::unordered_map<String, Entry> _orders;
+	String _id_prefix;
+	uint64_t _id_seq;
+
+public:
+
+	OrderTable(const OrderTable&) = delete;
+	OrderTable& operator=(const OrderTable&) = delete;
+
+	OrderTable() noexcept : _id_seq(0u) {
+		// Unique across the restarts: the IDs of a previous run are not reused.
+		_id_prefix = Config::ClientOrderIdPrefix + to_base36(Utils::time_wall_ms()) + "-";
+	}
+
+	/**
+	 * @return - A new ID matching '^[\.A-Z\:/a-z0-9_-]{1,36}$' as Binance requires.
+	 */
+	String next_client_id() noexcept {
+		return _id_prefix + to_base36(++_id_seq);
+	}
+
+	/**
+	 * Registers the order about to be sent.
+	 */
+	Entry& open(const rest::OrderRequest& request) noexcept {
+		auto& entry = _orders[request.newClientOrderId];
+		entry = Entry {request, Status::PendingNew, 0, 0., 0., 0u};
+		return entry;
+	}
+
+	/**
+	 * Registers a cancel about to be sent.
+	 */
+	bool cancel(const String& client_id) noexcept {
+		auto entry = find(client_id);
+		if(entry == nullptr || not entry->live()) {
+			return false;
+		}
+		entry->status = Status::PendingCancel;
+		return true;
+	}
+
+	/**
+	 * Registers a cancel-replace about to be sent.
+	 */
+	Entry& replace(const String& client_id, const rest::OrderRequest& request) noexcept {
+		cancel(client_id);
+		return open(request);
+	}
+
+	/**
+	 * Marks the order whose request has failed without a response. The order MAY exist on the exchange.
+	 */
+	void lost(const String& client_id) noexcept {
+		auto entry = find(client_id);
+		if(entry && entry->live()) {
+			entry->status = Status::Unknown;
+			count_outcome(Status::Unknown);
+		}
+	}
+
+	/**
+	 * Updates the order from a response to a new order, a cancel or a query.
+	 * @return false - if the order is unknown.
+	 */
+	bool apply(const rest::OrderResult& result) noexcept {
+		const auto& client_id = result.origClientOrderId.empty() ? result.clientOrderId : result.origClientOrderId;
+		auto entry = find(client_id);
+		if(entry == nullptr) {
+			LOG_ERROR("OrderTable::apply() unknown order '%s'\n", client_id.c_str());
+			return false;
+		}
+
+		const auto status = parse_status(result.status);
+		if(result.time < entry->time || (terminal(entry->status) && not terminal(status))) {
+			return true; // Stale.
+		}
+
+		if(terminal(status) && not terminal(entry->status)) {
+			count_outcome(status);
+		}
+
+		entry->status = status;
+		entry->orderId = result.orderId;
+		entry->executedQty = result.executedQty;
+		entry->cummulativeQuoteQty = result.cummulativeQuoteQty;
+		entry->time = result.time;
+		return true;
+	}
+
+	/**
+	 * Applies both parts of a cancel-replace response.
+	 */
+	void apply(const rest::CancelReplaceResult& result) noexcept {
+		if(result.cancelResult == "SUCCESS") {
+			apply(result.cancelResponse);
+		}
+		if(result.newOrderResult == "SUCCESS") {
+			apply(result.newOrderResponse);
+		}
+	}
+
+	/**
+	 * Applies the orders of an OCO response.
+	 */
+	void apply(const rest::OrderListResult& result) noexcept {
+		for(const auto& item : result.orderReports) {
+			apply(item);
+		}
+	}
+
+	/**
+	 * Applies a cancel-all response. The orders of the symbol not reported are left as they are.
+	 */
+	void apply(const rest::CancelAllResult& result) noexcept {
+		for(const auto& item : result.orders) {
+			apply(item);
+		}
+	}
+
+	/**
+	 * Registers a cancel-all about to be sent.
+	 */
+	void cancel_all(const String& symbol) noexcept {
+		for(auto& item : _orders) {
+			if(item.second.request.symbol == symbol && item.second.live()) {
+				item.second.status = Status::PendingCancel;
+			}
+		}
+	}
+
+	/**
+	 * @return - The number of the orders of the symbol not in a final state.
+	 */
+	size_t live_nb(const String& symbol) const noexcept {
+		size_t result = 0u;
+		for(const auto& item : _orders) {
+			result += (item.second.request.symbol == symbol && item.second.live());
+		}
+		return result;
+	}
+
+	/**
+	 * @return - The number of the orders not in a final state.
+	 */
+	size_t live_nb() const noexcept {
+		size_t result = 0u;
+		for(const auto& item : _orders) {
+			result += item.second.live();
+		}
+		return result;
+	}
+
+	inline Entry* find(const String& client_id) noexcept {
+		const auto it = _orders.find(client_id);
+		return it != _orders.end() ? &it->second : nullptr;
+	}
+
+	inline const Entry* find(const String& client_id) const noexcept {
+		const auto it = _orders.find(client_id);
+		return it != _orders.end() ? &it->second : nullptr;
+	}
+
+	/**
+	 * @param cb - Called for each order not in a final state.
+	 */
+	template <typename CallBack>
+	void for_each_live(CallBack&& cb) {
+		for(auto& item : _orders) {
+			if(item.second.live()) {
+				cb(item.first, item.second);
+			}
+		}
+	}
+
+	/**
+	 * Forgets the orders in a final state.
+	 */
+	void prune() noexcept {
+		for(auto it = _orders.begin(); it != _orders.end();) {
+			it = it->second.live() ? std::next(it) : _orders.erase(it);
+		}
+	}
+
+	inline size_t size() const noexcept {
+		return _orders.size();
+	}
+
+	/**
+	 * Writes the orders not in a final state, the others are of no use after a restart.
+	 */
+	void save(snapshot::Encoder& enc) const noexcept {
+		enc.put(static_cast<uint64_t>(live_nb()));
+		for(const auto& item : _orders) {
+			const auto& entry = item.second;
+			if(not entry.live()) {
+				continue;
+			}
+			const auto& req = entry.request;
+			enc.put(req.symbol);
+			enc.put(static_cast<uint8_t>(req.side));
+			enc.put(static_cast<uint8_t>(req.type));
+			enc.put(static_cast<uint8_t>(req.timeInForce));
+			enc.put(req.price);
+			enc.put(req.stopPrice);
+			enc.put(req.quantity);
+			enc.put(req.quoteOrderQty);
+			enc.put(req.newClientOrderId);
+			enc.put(static_cast<uint8_t>(entry.status));
+			enc.put(entry.orderId);
+			enc.put(entry.executedQty);
+			enc.put(entry.cummulativeQuoteQty);
+			enc.put(entry.time);
+		}
+	}
+
+	/**
+	 * Adds the saved orders. Their state is as old as the snapshot, so they are to be queried.
+	 */
+	bool restore(snapshot::Decoder& dec) noexcept {
+		uint64_t count = 0u;
+		dec.get(count);
+		for(uint64_t idx = 0; idx < count && dec.ok(); ++idx) {
+			Entry entry {};
+			uint8_t side = 0u;
+			uint8_t type = 0u;
+			uint8_t tif = 0u;
+			uint8_t status = 0u;
+			auto& req = entry.request;
+			dec.get(req.symbol);
+			dec.get(side);
+			dec.get(type);
+			dec.get(tif);
+			dec.get(req.price);
+			dec.get(req.stopPrice);
+			dec.get(req.quantity);
+			dec.get(req.quoteOrderQty);
+			dec.get(req.newClientOrderId);
+			dec.get(status);
+			dec.get(entry.orderId);
+			dec.get(entry.executedQty);
+			dec.get(entry.cummulativeQuoteQty);
+			dec.get(entry.time);
+			if(side > static_cast<uint8_t>(rest::Order::Side::SELL)
+			   || type > static_cast<uint8_t>(rest::OrderRequest::Type::TAKE_PROFIT_LIMIT)
+			   || tif > static_cast<uint8_t>(rest::OrderRequest::TimeInForce::FOK)
+			   || status > static_cast<uint8_t>(Status::EXPIRED_IN_MATCH)) {
+				dec.fail();
+				break;
+			}
+			req.side = static_cast<rest::Order::Side>(side);
+			req.type = static_cast<rest::OrderRequest::Type>(type);
+			req.timeInForce = static_cast<rest::OrderRequest::TimeInForce>(tif);
+			entry.status = static_cast<Status>(status);
+			_orders[req.newClientOrderId] = entry;
+		}
+		return dec.ok();
+	}
+
+	static inline bool terminal(const Status status) noexcept {
+		return status == Status::FILLED || status == Status::CANCELED || status == Status::REJECTED
+		       || status == Status::EXPIRED || status == Status::EXPIRED_IN_MATCH;
+	}
+
+	/**
+	 * Counts an order reaching the final status, or getting lost.
+	 */
+	static void count_outcome(const Status status) noexcept {
+		static const auto counters = [] {
+			std::array<metrics::Counter*, Status_nb> result;
+			for(size_t idx = 0; idx < Status_nb; ++idx) {
+				result[idx] = &metrics::Registry::instance().counter(
+					"bintest_orders_total", "The orders by the outcome.",
+					metrics::label("status", to_string(static_cast<Status>(idx))));
+			}
+			return result;
+		}();
+		counters[static_cast<size_t>(status)]->inc();
+	}
+
+	static Status parse_status(const String& str) noexcept {
+		if(str == "NEW") {
+			return Status::NEW;
+		} else if(str == "PARTIALLY_FILLED") {
+			return Status::PARTIALLY_FILLED;
+		} else if(str == "FILLED") {
+			return Status::FILLED;
+		} else if(str == "CANCELED") {
+			return Status::CANCELED;
+		} else if(str == "PENDING_CANCEL") {
+			return Status::PendingCancel;
+		} else if(str == "REJECTED") {
+			return Status::REJECTED;
+		} else if(str == "EXPIRED") {
+			return Status::EXPIRED;
+		} else if(str == "EXPIRED_IN_MATCH") {
+			return Status::EXPIRED_IN_MATCH;
+		}
+		return Status::Unknown;
+	}
+
+	static const char* to_string(const Status status) noexcept {
+		switch(status) {
+			case Status::PendingNew:
+				return "PendingNew";
+			case Status::PendingCancel:
+				return "PendingCancel";
+			case Status::Unknown:
+				return "Unknown";
+			case Status::NEW:
+				return "NEW";
+			case Status::PARTIALLY_FILLED:
+				return "PARTIALLY_FILLED";
+			case Status::FILLED:
+				return "FILLED";
+			case Status::CANCELED:
+				return "CANCELED";
+			case Status::REJECTED:
+				return "REJECTED";
+			case Status::EXPIRED:
+				return "EXPIRED";
+			case Status::EXPIRED_IN_MATCH:
+				return "EXPIRED_IN_MATCH";
+		}
+		return "";
+	}
+
+	void dump() const noexcept {
+		LOG_INFO("==== Orders ====\n");
+		for(const auto& item : _orders) {
+			const auto& entry = item.second;
+			LOG_INFO("  '%s' %s %s %s price=%.8f qty=%.8f executed=%.8f status=%s\n", item.first.c_str(),
+			         entry.request.symbol.c_str(), rest::OrderRequest::to_string(entry.request.side),
+			         rest::OrderRequest::to_string(entry.request.type), entry.request.price, entry.request.quantity,
+			         entry.executedQty, to_string(entry.status));
+		}
+	}
+
+private:
+
+	static String to_base36(uint64_t value) noexcept {
+		static constexpr char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+		char buffer[16];
+		size_t pos = sizeof(buffer);
+		do {
+			buffer[--pos] = digits[value % 36u];
+			value /= 36u;
+		} while(value && pos);
+		return String(buffer + pos, sizeof(buffer) - pos);
+	}
+
+};
+
+}; // namespace binance
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include <openssl/hmac.h>
+
+#include "../Utils.h"
+
+namespace binance {
+
+/**
+ * Signs the requests of both the REST and the WebSocket APIs with the HMAC SHA256 of the secret key.
+ * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#signed-trade-user_data-and-margin-endpoint-security
+ */
+class Signer {
+
+	const std::string _secret_key;
+
+public:
+
+	explicit Signer(std::string secret_key) noexcept : _secret_key(std::move(secret_key)) {
+	}
+
+	/**
+	 * @return - HMAC SHA256 signature of the payload as a hex string.
+	 */
+	std::string sign(std::string_view payload) const noexcept {
+		unsigned char digest[EVP_MAX_MD_SIZE];
+		unsigned int digest_len = 0;
+
+		HMAC(
+			EVP_sha256(),
+			_secret_key.c_str(),
+			static_cast<int>(_secret_key.length()),
+			reinterpret_cast<const unsigned char*>(payload.data()),
+			payload.length(),
+			digest,
+			&digest_len
+		);
+
+		return Utils::bin_to_hex(digest, digest_len);
+	}
+
+};
+
+}; // namespace binance
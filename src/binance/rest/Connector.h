@@ -1,14 +1,17 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <string_view>
 
 #include <curl/curl.h>
-#include <openssl/hmac.h>
 
 #include "api.h"
+#include "../Signer.h"
 #include "../../Log.h"
 #include "../../Utils.h"
+#include "../../metrics/Metrics.h"
+#include "../../sim/Exchange.h"
 
 namespace binance {
 namespace rest {
@@ -17,13 +20,29 @@ class Connector {
 
 	using HttpHeaders = std::vector<std::string>;
 
+	enum class ErrorKind {
+		Transport,
+		Exchange,
+		Parse,
+		Budget
+	};
+	static constexpr size_t ErrorKind_nb = static_cast<size_t>(ErrorKind::Budget) + 1u;
+
 	CURL* _curl;
 	const std::string _host;
 	const std::string _api_key;
-	const std::string _secret_key;
+	const Signer _signer;
 
 	HttpHeaders _http_headers;
 	std::string _response;
+	std::string _mock_dir;  // Canned responses replacing the network. Optional.
+	sim::Exchange* _sim;    // The simulated exchange replacing the network. Optional.
+
+	// The ORDERS rate limit is per account, so is the budget.
+	Time _orders_window;  // The start of the current window, ms.
+	unsigned _orders_nb;  // The orders posted within the window.
+
+	std::vector<std::pair<std::string, metrics::Histogram*>> _latency;  // Per endpoint, registered on the first call.
 
 public:
 
@@ -48,7 +67,10 @@ public:
 		_curl(curl),
 		_host(std::move(host)),
 		_api_key(std::move(api_key)),
-		_secret_key(std::move(secret_key)) {
+		_signer(std::move(secret_key)),
+		_sim(nullptr),
+		_orders_window(0u),
+		_orders_nb(0u) {
 
 		LOG_DEBUG("binance::rest::Connector()\n");
 		_http_headers.emplace_back(std::string("X-MBX-APIKEY: " + _api_key));
@@ -87,7 +109,7 @@ public:
 		std::string url(_host + "/api/v3/account?");
 		url.append(request);
 
-		return do_get(url.c_str()) && parse_response(acc_info);
+		return do_get(url.c_str(), _response) && parse_body(acc_info, _response);
 	}
 
 	/**
@@ -111,7 +133,29 @@ public:
 		std::string url(_host + "/api/v3/allOrders?");
 		url.append(request);
 
-		return do_get(url.c_str()) && parse_response(all_orders);
+		return do_get(url.c_str(), _response) && parse_response(all_orders);
+	}
+
+	/**
+	 * The same as above, but both the response body and the orders live in the arena of 'all_orders'.
+	 * The caller calls all_orders.reset() once done with the result.
+	 */
+	bool all_orders(AllOrdersView& all_orders, const String& symbol) noexcept {
+		LOG_DEBUG("binance::rest::Connector::all_orders()\n");
+
+		// Request
+		std::string request("symbol=" + symbol);
+		request.append("&timestamp=" + timestamp());
+
+		const auto signature = sign(request);
+		request.append("&signature=");
+		request.append(signature);
+
+		// URL
+		std::string url(_host + "/api/v3/allOrders?");
+		url.append(request);
+
+		return do_get(url.c_str(), all_orders.body) && parse_body(all_orders, all_orders.body);
 	}
 
 	bool new_market_order(
@@ -149,7 +193,214 @@ public:
 		// URL
 		std::string url(_host + "/api/v3/order?");
 
-		return do_post(url.c_str(), request) && parse_response(response);
+		return do_post(url.c_str(), request, _response) && parse_response(response);
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#new-order-trade
+	 * Places an order of any type supported by OrderRequest. The response is the FULL one, the fills included.
+	 */
+	bool new_order(OrderResult& result, const OrderRequest& order, const Time recv_window = 0u) noexcept {
+		LOG_DEBUG("binance::rest::Connector::new_order('%s')\n", order.newClientOrderId.c_str());
+
+		if(not order.validate()) {
+			LOG_ERROR("binance::rest::Connector::new_order() invalid order '%s'\n", order.newClientOrderId.c_str());
+			return false;
+		}
+
+		// Request
+		std::string request;
+		append_order(request, order);
+		request.append("&newOrderRespType=FULL");
+		append_signature(request, recv_window);
+
+		// URL
+		std::string url(_host + "/api/v3/order");
+
+		return do_post(url.c_str(), request, _response) && parse_body(result, _response);
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#cancel-order-trade
+	 */
+	bool cancel_order(OrderResult& result, const String& symbol, const String& client_order_id, const Time recv_window = 0u) noexcept {
+		LOG_DEBUG("binance::rest::Connector::cancel_order('%s')\n", client_order_id.c_str());
+
+		// Request
+		std::string request("symbol=" + symbol);
+		request.append("&origClientOrderId=" + client_order_id);
+		append_signature(request, recv_window);
+
+		// URL
+		std::string url(_host + "/api/v3/order?");
+		url.append(request);
+
+		return do_delete(url.c_str(), _response) && parse_body(result, _response);
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#cancel-an-existing-order-and-send-a-new-order-trade
+	 * Amends an order in one request. Nothing is placed if the cancel fails (STOP_ON_FAILURE).
+	 * @param cancel_client_order_id - The order to cancel.
+	 * @param order - The order to place, its ID MUST be a new one.
+	 */
+	bool cancel_replace(
+		CancelReplaceResult& result, const String& cancel_client_order_id, const OrderRequest& order
+		, const Time recv_window = 0u
+	                   ) noexcept {
+		LOG_DEBUG("binance::rest::Connector::cancel_replace('%s' -> '%s')\n", cancel_client_order_id.c_str(),
+		          order.newClientOrderId.c_str());
+
+		if(not order.validate()) {
+			LOG_ERROR("binance::rest::Connector::cancel_replace() invalid order '%s'\n", order.newClientOrderId.c_str());
+			return false;
+		}
+
+		// Request
+		std::string request;
+		append_order(request, order);
+		request.append("&cancelReplaceMode=STOP_ON_FAILURE");
+		request.append("&cancelOrigClientOrderId=" + cancel_client_order_id);
+		request.append("&newOrderRespType=RESULT");
+		append_signature(request, recv_window);
+
+		// URL
+		std::string url(_host + "/api/v3/order/cancelReplace");
+
+		return do_post(url.c_str(), request, _response) && parse_body(result, _response);
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#new-order-list---oco-trade
+	 * Places both legs of the OCO in one request.
+	 */
+	bool new_oco(OrderListResult& result, const OcoRequest& oco, const Time recv_window = 0u) noexcept {
+		LOG_DEBUG("binance::rest::Connector::new_oco('%s')\n", oco.listClientOrderId.c_str());
+
+		if(not oco.validate()) {
+			LOG_ERROR("binance::rest::Connector::new_oco() invalid order list '%s'\n", oco.listClientOrderId.c_str());
+			return false;
+		}
+
+		// Request
+		std::string request("symbol=" + oco.above.symbol);
+		request.append("&side=");
+		request.append(OrderRequest::to_string(oco.above.side));
+		request.append("&quantity=" + Utils::decimal_to_string(oco.above.quantity));
+		request.append("&listClientOrderId=" + oco.listClientOrderId);
+		append_oco_leg(request, "above", oco.above);
+		append_oco_leg(request, "below", oco.below);
+		request.append("&newOrderRespType=RESULT");
+		append_signature(request, recv_window);
+
+		// URL
+		std::string url(_host + "/api/v3/orderList/oco");
+
+		return do_post(url.c_str(), request, _response) && parse_body(result, _response);
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#cancel-all-open-orders-on-a-symbol-trade
+	 * Cancels all the orders and the order lists of the symbol in one request.
+	 */
+	bool cancel_open_orders(CancelAllResult& result, const String& symbol, const Time recv_window = 0u) noexcept {
+		LOG_DEBUG("binance::rest::Connector::cancel_open_orders('%s')\n", symbol.c_str());
+
+		// Request
+		std::string request("symbol=" + symbol);
+		append_signature(request, recv_window);
+
+		// URL
+		std::string url(_host + "/api/v3/openOrders?");
+		url.append(request);
+
+		return do_delete(url.c_str(), _response) && parse_body(result, _response);
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#query-order-user_data
+	 */
+	bool query_order(OrderResult& result, const String& symbol, const String& client_order_id, const Time recv_window = 0u) noexcept {
+		LOG_DEBUG("binance::rest::Connector::query_order('%s')\n", client_order_id.c_str());
+
+		// Request
+		std::string request("symbol=" + symbol);
+		request.append("&origClientOrderId=" + client_order_id);
+		append_signature(request, recv_window);
+
+		// URL
+		std::string url(_host + "/api/v3/order?");
+		url.append(request);
+
+		return do_get(url.c_str(), _response) && parse_body(result, _response);
+	}
+
+	/**
+	 * @return - HMAC SHA256 signature of the payload as a hex string.
+	 */
+	inline std::string sign(const std::string& payload) const noexcept {
+		return _signer.sign(payload);
+	}
+
+	/**
+	 * Builds the URL of a signed request for the requests performed outside of the instance, e.g. by HistorySync.
+	 * In the offline mode the URL is the 'file://' one of the canned response.
+	 * @param endpoint - The path after '/api/v3/', e.g. 'allOrders'.
+	 * @param query - The parameters except the timestamp and the signature.
+	 */
+	std::string signed_url(const char* endpoint, std::string query) const noexcept {
+		if(not _mock_dir.empty()) {
+			std::string path(endpoint);
+			std::replace(path.begin(), path.end(), '/', '_');
+			return "file://" + _mock_dir + "/" + path + ".json";
+		}
+
+		if(not query.empty()) {
+			query.append("&");
+		}
+		query.append("timestamp=" + timestamp());
+
+		const auto signature = sign(query);
+		query.append("&signature=");
+		query.append(signature);
+
+		std::string url(_host + "/api/v3/");
+		url.append(endpoint);
+		url.append("?");
+		url.append(query);
+		return url;
+	}
+
+	/**
+	 * @return - The HTTP headers every request carries, the API key among them.
+	 */
+	inline const HttpHeaders& http_headers() const noexcept {
+		return _http_headers;
+	}
+
+	/**
+	 * Switches the instance to the offline mode. A request to '/api/v3/<endpoint>' is answered
+	 * with the content of the '<dir>/<endpoint>.json' file. Used to replay a session, e.g. for PGO training.
+	 */
+	inline void mock(std::string dir) noexcept {
+		LOG_DEBUG("binance::rest::Connector::mock('%s')\n", dir.c_str());
+		_mock_dir = std::move(dir);
+	}
+
+	/**
+	 * @return true - if the requests are answered with the canned responses.
+	 */
+	inline bool mocked() const noexcept {
+		return not _mock_dir.empty();
+	}
+
+	/**
+	 * Switches the instance to the backtest mode. The requests are served by the simulated exchange in the
+	 * simulated time, see sim::Exchange. The exchange MUST outlive the instance.
+	 */
+	inline void simulate(sim::Exchange* exchange) noexcept {
+		LOG_DEBUG("binance::rest::Connector::simulate()\n");
+		_sim = exchange;
 	}
 
 private:
@@ -161,41 +412,230 @@ private:
 		return std::string(std::to_string(time));
 	}
 
-	inline std::string sign(const std::string& payload) const noexcept {
-		const auto payload_ptr = reinterpret_cast<const unsigned char*>(payload.c_str());
-		const auto payload_len = static_cast<int>(_secret_key.length());
+	static void append_order(std::string& request, const OrderRequest& order) noexcept {
+		order.for_each_param([&request](const char* key, const std::string& value) {
+			if(not request.empty()) {
+				request.append("&");
+			}
+			request.append(key);
+			request.append("=");
+			request.append(value);
+		});
+	}
+
+	/**
+	 * @param leg - Either 'above' or 'below'.
+	 */
+	static void append_oco_leg(std::string& request, const char* leg, const OrderRequest& order) noexcept {
+		const std::string prefix(std::string("&") + leg);
+
+		request.append(prefix + "Type=");
+		request.append(OrderRequest::to_string(order.type));
+		request.append(prefix + "ClientOrderId=" + order.newClientOrderId);
+
+		if(order.has_price()) {
+			request.append(prefix + "Price=" + Utils::decimal_to_string(order.price));
+		}
+
+		if(order.has_stop_price()) {
+			request.append(prefix + "StopPrice=" + Utils::decimal_to_string(order.stopPrice));
+		}
+
+		if(order.has_time_in_force()) {
+			request.append(prefix + "TimeInForce=");
+			request.append(OrderRequest::to_string(order.timeInForce));
+		}
+	}
+
+	void append_signature(std::string& request, const Time recv_window) const noexcept {
+		if(recv_window) {
+			request.append("&recvWindow=" + std::to_string(recv_window));
+		}
+		request.append("&timestamp=" + timestamp());
+
+		const auto signature = sign(request);
+		request.append("&signature=");
+		request.append(signature);
+	}
+
+	/**
+	 * @return - The path after '/api/v3/' without the query, e.g. 'order/cancelReplace'. Empty if none.
+	 */
+	static std::string_view endpoint_of(const char* url) noexcept {
+		static constexpr const char* Prefix = "/api/v3/";
+
+		const char* begin = strstr(url, Prefix);
+		if(begin == nullptr) {
+			return {};
+		}
+		begin += strlen(Prefix);
+		return std::string_view(begin, strchrnul(begin, '?') - begin);
+	}
+
+	/**
+	 * Accounts the total time of the last transfer to the endpoint of the URL.
+	 */
+	void observe_latency(const char* url) noexcept {
+		double sec = 0.;
+		if(curl_easy_getinfo(_curl, CURLINFO_TOTAL_TIME, &sec) != CURLE_OK) {
+			return;
+		}
+
+		const auto endpoint = endpoint_of(url);
+		auto it = std::find_if(_latency.begin(), _latency.end(), [endpoint](const auto& item) {
+			return item.first == endpoint;
+		});
+		if(it == _latency.end()) {
+			auto& hist = metrics::Registry::instance().histogram(
+				"bintest_rest_latency_seconds", "The REST request latency.", metrics::label("endpoint", endpoint));
+			_latency.emplace_back(std::string(endpoint), &hist);
+			it = std::prev(_latency.end());
+		}
+		it->second->observe(sec);
+	}
+
+	static void count_error(const ErrorKind kind) noexcept {
+		static const auto counters = [] {
+			std::array<metrics::Counter*, ErrorKind_nb> result;
+			for(size_t idx = 0; idx < ErrorKind_nb; ++idx) {
+				result[idx] = &metrics::Registry::instance().counter(
+					"bintest_rest_errors_total", "The failed REST requests.",
+					metrics::label("kind", to_string(static_cast<ErrorKind>(idx))));
+			}
+			return result;
+		}();
+		counters[static_cast<size_t>(kind)]->inc();
+	}
+
+	static const char* to_string(const ErrorKind kind) noexcept {
+		switch(kind) {
+			case ErrorKind::Transport:
+				return "transport";
+			case ErrorKind::Exchange:
+				return "exchange";
+			case ErrorKind::Parse:
+				return "parse";
+			case ErrorKind::Budget:
+				return "budget";
+		}
+		return "unknown";
+	}
+
+	template <typename Body>
+	bool do_mock(const char* url, Body& body) noexcept {
+		body.clear();
+
+		const auto endpoint_view = endpoint_of(url);
+		if(endpoint_view.empty()) {
+			return false;
+		}
 
-		const auto digest = HMAC(
-			EVP_sha256(),
-			_secret_key.c_str(),
-			payload_len,
-			payload_ptr,
-			payload.length(),
-			NULL,
-			NULL
-		);
+		std::string endpoint(endpoint_view);
+		std::replace(endpoint.begin(), endpoint.end(), '/', '_');
+		const std::string path(_mock_dir + "/" + endpoint + ".json");
 
-		return Utils::bin_to_hex(digest, 32u);
+		FILE* file = fopen(path.c_str(), "r");
+		if(file == nullptr) {
+			LOG_ERROR("binnance::rest::Connector::do_mock() no response '%s'\n", path.c_str());
+			return false;
+		}
+
+		char buffer[4096];
+		size_t read;
+		while((read = fread(buffer, 1u, sizeof(buffer), file)) > 0u) {
+			body.append(buffer, read);
+		}
+		fclose(file);
+		return true;
 	}
 
-	bool do_get(const char* url) noexcept {
-		prepare(url);
+	/**
+	 * @param query - The parameters of the POST body, nullptr if they are in the URL.
+	 */
+	template <typename Body>
+	bool do_simulate(const sim::Exchange::Method method, const char* url, const char* query, Body& body) noexcept {
+		body.clear();
+
+		const auto endpoint = endpoint_of(url);
+		if(endpoint.empty()) {
+			return false;
+		}
+		if(query == nullptr) {
+			const char* mark = strchr(url, '?');
+			query = mark ? mark + 1 : "";
+		}
+
+		const auto& response = _sim->request(method, endpoint, query);
+		body.append(response.data(), response.size());
+		return true;
+	}
+
+	template <typename Body>
+	bool do_get(const char* url, Body& body) noexcept {
+		if(_sim) {
+			return do_simulate(sim::Exchange::Method::Get, url, nullptr, body);
+		}
+		if(not _mock_dir.empty()) {
+			return do_mock(url, body);
+		}
+
+		prepare(url, body);
 		const auto err = curl_easy_perform(_curl);
 
 		if(err != CURLE_OK) {
+			count_error(ErrorKind::Transport);
 			LOG_ERROR("binnance::rest::Connector::do_get() '%s'\n", curl_easy_strerror(err));
+		} else {
+			observe_latency(url);
 		}
 
 		return err == CURLE_OK;
 	}
 
-	bool do_post(const char* url, const std::string& post_data) {
-		prepare(url);
+	/**
+	 * Counts an order against the ORDERS budget of the account.
+	 * @return false - if the budget of the window is spent, the order is not to be sent.
+	 */
+	bool order_budget() noexcept {
+		const auto now = Utils::time_now_ms();
+		if(now - _orders_window >= Config::RestOrderWindowMS) {
+			_orders_window = now;
+			_orders_nb = 0u;
+		}
+		if(_orders_nb >= Config::RestOrderLimit) {
+			count_error(ErrorKind::Budget);
+			LOG_ERROR("binnance::rest::Connector::do_post() the order budget of %u per %llu ms is spent\n",
+			          Config::RestOrderLimit, static_cast<unsigned long long>(Config::RestOrderWindowMS));
+			return false;
+		}
+		_orders_nb++;
+		return true;
+	}
+
+	/**
+	 * All the POST requests are the order ones.
+	 */
+	template <typename Body>
+	bool do_post(const char* url, const std::string& post_data, Body& body) {
+		if(not order_budget()) {
+			return false;
+		}
+		if(_sim) {
+			return do_simulate(sim::Exchange::Method::Post, url, post_data.c_str(), body);
+		}
+		if(not _mock_dir.empty()) {
+			return do_mock(url, body);
+		}
+
+		prepare(url, body);
 		curl_easy_setopt(_curl, CURLOPT_POSTFIELDS, post_data.c_str());
 		const auto err = curl_easy_perform(_curl);
 
 		if(err != CURLE_OK) {
+			count_error(ErrorKind::Transport);
 			LOG_ERROR("binnance::rest::Connector::do_post() '%s'\n", curl_easy_strerror(err));
+		} else {
+			observe_latency(url);
 		}
 
 //		LOG_INFO("%s\n", _response.c_str());
@@ -204,13 +644,37 @@ private:
 
 	}
 
-	void prepare(const char* url) noexcept {
-		_response.clear();
+	template <typename Body>
+	bool do_delete(const char* url, Body& body) noexcept {
+		if(_sim) {
+			return do_simulate(sim::Exchange::Method::Delete, url, nullptr, body);
+		}
+		if(not _mock_dir.empty()) {
+			return do_mock(url, body);
+		}
+
+		prepare(url, body);
+		curl_easy_setopt(_curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+		const auto err = curl_easy_perform(_curl);
+
+		if(err != CURLE_OK) {
+			count_error(ErrorKind::Transport);
+			LOG_ERROR("binnance::rest::Connector::do_delete() '%s'\n", curl_easy_strerror(err));
+		} else {
+			observe_latency(url);
+		}
+
+		return err == CURLE_OK;
+	}
+
+	template <typename Body>
+	void prepare(const char* url, Body& body) noexcept {
+		body.clear();
 		curl_easy_reset(_curl);
 
 		curl_easy_setopt(_curl, CURLOPT_URL, url);
-		curl_easy_setopt(_curl, CURLOPT_WRITEFUNCTION, receiver);
-		curl_easy_setopt(_curl, CURLOPT_WRITEDATA, &_response);
+		curl_easy_setopt(_curl, CURLOPT_WRITEFUNCTION, receiver<Body>);
+		curl_easy_setopt(_curl, CURLOPT_WRITEDATA, &body);
 		curl_easy_setopt(_curl, CURLOPT_SSL_VERIFYPEER, false);
 		curl_easy_setopt(_curl, CURLOPT_ENCODING, "gzip");
 
@@ -224,7 +688,8 @@ private:
 	}
 
 
-	static size_t receiver(void* content, size_t size, size_t nmemb, std::string* response) noexcept {
+	template <typename Body>
+	static size_t receiver(void* content, size_t size, size_t nmemb, Body* response) noexcept {
 		response->append((char*) content, size * nmemb);
 		return size * nmemb;
 	}
@@ -236,12 +701,15 @@ private:
 		Json::Value root;
 		Json::Reader reader;
 
+		bool rejected = false;
 		if(reader.parse(_response, root)) {
 
 //				Json::FastWriter fw;
 //				LOG_INFO("response='%s'\n", fw.write(root).c_str());
 
 			if(not root.isArray() && root.isMember("code") && root.isMember("msg")) {
+				rejected = true;
+				count_error(ErrorKind::Exchange);
 				LOG_ERROR("Bad-response:");
 				LOG_PLAIN(" code='%s'", root["code"].asString().c_str());
 				LOG_PLAIN("msg='%s'\n", root["msg"].asString().c_str());
@@ -251,9 +719,33 @@ private:
 
 		}
 
+		if(not result && not rejected) {
+			count_error(ErrorKind::Parse);
+		}
+
 		return result;
 	}
 
+	/**
+	 * The DOM-less counterpart of parse_response() for the types parsing the body in place.
+	 */
+	template <typename T>
+	static bool parse_body(T& struct_api, std::string_view body) noexcept {
+		ErrorResponse error;
+		if(error.parse(body)) {
+			count_error(ErrorKind::Exchange);
+			LOG_ERROR("Bad-response:");
+			LOG_PLAIN(" code='%ld'", static_cast<long>(error.code));
+			LOG_PLAIN("msg='%s'\n", error.msg.c_str());
+			return false;
+		}
+		if(not struct_api.parse(body)) {
+			count_error(ErrorKind::Parse);
+			return false;
+		}
+		return true;
+	}
+
 };
 
 }; // namespace rest
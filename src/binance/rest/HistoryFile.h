@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "api.h"
+#include "../../Log.h"
+
+namespace binance {
+namespace rest {
+
+/**
+ * The records fetched by HistorySync appended to the tab separated files next to the marks:
+ *   '<path>.orders' - symbol orderId clientOrderId side type status price origQty executedQty cummulativeQuoteQty time updateTime
+ *   '<path>.trades' - symbol id orderId side price qty quoteQty commission commissionAsset isMaker time
+ *
+ * The marks let a sync fetch the new records only, so the files keep growing run by run. An order found open
+ * is fetched again by the next sync, so the last line of an orderId is its latest status.
+ * The records are flushed by close() before the marks are saved, a crash in between repeats the page next time.
+ */
+class HistoryFile {
+
+	FILE* _orders;
+	FILE* _trades;
+
+public:
+
+	HistoryFile(const HistoryFile&) = delete;
+	HistoryFile& operator=(const HistoryFile&) = delete;
+
+	HistoryFile() noexcept :
+		_orders(nullptr),
+		_trades(nullptr) {
+	}
+
+	~HistoryFile() noexcept {
+		close();
+	}
+
+	/**
+	 * @param path - The marks file of the sync.
+	 */
+	bool open(const std::string& path) noexcept {
+		_orders = fopen((path + ".orders").c_str(), "a");
+		_trades = fopen((path + ".trades").c_str(), "a");
+		if(_orders == nullptr || _trades == nullptr) {
+			LOG_ERROR("binance::rest::HistoryFile::open() unable to open '%s.orders' and '%s.trades'\n", path.c_str(),
+			          path.c_str());
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @return false - if any record has failed to be written.
+	 */
+	bool close() noexcept {
+		bool result = true;
+		for(auto file : {&_orders, &_trades}) {
+			if(*file) {
+				result &= (fflush(*file) == 0) && (fsync(fileno(*file)) == 0);
+				result &= (fclose(*file) == 0);
+				*file = nullptr;
+			}
+		}
+		if(not result) {
+			LOG_ERROR("binance::rest::HistoryFile::close() the records are not written\n");
+		}
+		return result;
+	}
+
+	/**
+	 * HistorySync::OrdersCallBack_t
+	 */
+	static void cb_orders(void* instance, const String& symbol, const std::pmr::vector<OrderView>& orders) noexcept {
+		auto obj = reinterpret_cast<HistoryFile*>(instance);
+		for(const auto& item : orders) {
+			fprintf(obj->_orders, "%s\t%lld\t%.*s\t%.*s\t%.*s\t%.*s\t%.8f\t%.8f\t%.8f\t%.8f\t%llu\t%llu\n", symbol.c_str(),
+			        static_cast<long long>(item.orderId), static_cast<int>(item.clientOrderId.size()),
+			        item.clientOrderId.data(), static_cast<int>(item.side.size()), item.side.data(),
+			        static_cast<int>(item.type.size()), item.type.data(), static_cast<int>(item.status.size()),
+			        item.status.data(), item.price, item.origQty, item.executedQty, item.cummulativeQuoteQty,
+			        static_cast<unsigned long long>(item.time), static_cast<unsigned long long>(item.updateTime));
+		}
+	}
+
+	/**
+	 * HistorySync::TradesCallBack_t
+	 */
+	static void cb_trades(void* instance, const String& symbol, const std::pmr::vector<TradeView>& trades) noexcept {
+		auto obj = reinterpret_cast<HistoryFile*>(instance);
+		for(const auto& item : trades) {
+			fprintf(obj->_trades, "%s\t%lld\t%lld\t%s\t%.8f\t%.8f\t%.8f\t%.8f\t%.*s\t%d\t%llu\n", symbol.c_str(),
+			        static_cast<long long>(item.id), static_cast<long long>(item.orderId), item.isBuyer ? "BUY" : "SELL",
+			        item.price, item.qty, item.quoteQty, item.commission, static_cast<int>(item.commissionAsset.size()),
+			        item.commissionAsset.data(), item.isMaker ? 1 : 0, static_cast<unsigned long long>(item.time));
+		}
+	}
+
+};
+
+}; // namespace rest
+}; // namespace binance
@@ -0,0 +1,621 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <curl/curl.h>
+
+#include "api.h"
+#include "Connector.h"
+#include "../../Arena.h"
+#include "../../Config.h"
+#include "../../Reactor.h"
+#include "../../Log.h"
+#include "../../Utils.h"
+
+namespace binance {
+namespace rest {
+
+/**
+ * The incremental order history sync.
+ *
+ * Pages through 'allOrders' (by orderId) and 'myTrades' (by fromId) of several symbols at once over curl_multi,
+ * keeping the requests within the share of the REQUEST_WEIGHT budget given to it. Binance reports the weight used
+ * in the 'X-MBX-USED-WEIGHT-1M' header, the sync backs off if the trading has taken the budget.
+ *
+ * The progress is persisted as a high-water mark per symbol, so a later sync fetches the new records only.
+ * The order mark never passes an order found open, the next sync fetches it again to see its final status.
+ *
+ * Either polls on its own by service() or runs on the sockets and the timer of a Reactor once attached.
+ *
+ * In the offline mode of the connector a canned response is the whole history, it is fetched as a single page.
+ *
+ * The pages are delivered to the callbacks as they come. The records are views into the page body
+ * and MUST NOT be kept after the callback returns.
+ */
+class HistorySync {
+public:
+
+	using OrdersCallBack_t = void (*)(void* instance, const String& symbol, const std::pmr::vector<OrderView>& orders);
+	using TradesCallBack_t = void (*)(void* instance, const String& symbol, const std::pmr::vector<TradeView>& trades);
+
+	struct Mark {
+		String symbol;
+		SInteger order_id;  // The first orderId to fetch next time.
+		SInteger trade_id;  // The first trade id to fetch next time.
+	};
+
+private:
+
+	enum class Kind {
+		Orders,
+		Trades
+	};
+
+	struct Cursor {
+		SInteger next;      // The first id of the next page.
+		SInteger mark;      // The value persisted.
+		size_t records;     // The records fetched by the sync.
+		unsigned attempts;  // The failed attempts of the current page.
+		bool busy;
+		bool done;
+		bool failed;
+		bool open_seen;     // Orders only. An open order holds the mark.
+	};
+
+	struct Symbol {
+		String name;
+		Cursor orders;
+		Cursor trades;
+	};
+
+	struct Job {
+		HistorySync* owner;
+		CURL* curl;
+		curl_slist* headers;
+		Symbol* symbol;
+		Kind kind;
+		Arena arena;
+		AllOrdersView orders;
+		MyTradesView trades;
+		unsigned used_weight;   // As reported by the response, 0 if missing.
+		unsigned retry_after;   // Seconds, as reported by a 429/418 response.
+
+		explicit Job(HistorySync* owner) noexcept :
+			owner(owner),
+			curl(curl_easy_init()),
+			headers(nullptr),
+			symbol(nullptr),
+			kind(Kind::Orders),
+			arena(),
+			orders(arena),
+			trades(arena),
+			used_weight(0u),
+			retry_after(0u) {
+		}
+
+		~Job() noexcept {
+			if(curl) {
+				curl_easy_cleanup(curl);
+			}
+			curl_slist_free_all(headers);
+		}
+
+		inline Cursor& cursor() noexcept {
+			return kind == Kind::Orders ? symbol->orders : symbol->trades;
+		}
+	};
+
+	const Connector& _conn;
+	CURLM* _multi;
+	std::vector<Symbol> _symbols;
+	std::vector<std::unique_ptr<Job>> _jobs;
+	std::vector<Job*> _idle;
+	size_t _running;
+
+	// The weight accounting of the current minute window.
+	uint64_t _window;
+	unsigned _weight;
+	uint64_t _paused_till_ms;
+
+	OrdersCallBack_t _orders_cb;
+	TradesCallBack_t _trades_cb;
+	void* _instance;
+
+	Reactor* _reactor;  // Optional.
+	int _timer;         // The curl_multi timeouts and the budget waits.
+
+public:
+
+	HistorySync(const HistorySync&) = delete;
+	HistorySync& operator=(const HistorySync&) = delete;
+
+	HistorySync(HistorySync&&) = delete;
+	HistorySync& operator=(HistorySync&&) = delete;
+
+	/**
+	 * @param conn - Builds and signs the URLs. Not used to perform the requests.
+	 */
+	HistorySync(
+		const Connector& conn,
+		OrdersCallBack_t orders_cb = nullptr,
+		TradesCallBack_t trades_cb = nullptr,
+		void* instance = nullptr
+	           ) noexcept :
+		_conn(conn),
+		_multi(curl_multi_init()),
+		_running(0u),
+		_window(0u),
+		_weight(0u),
+		_paused_till_ms(0u),
+		_orders_cb(orders_cb),
+		_trades_cb(trades_cb),
+		_instance(instance),
+		_reactor(nullptr),
+		_timer(-1) {
+		LOG_DEBUG("binance::rest::HistorySync()\n");
+		if(_multi == nullptr) {
+			LOG_CRITICAL("curl_multi_init() fails.\n");
+		}
+
+		for(unsigned idx = 0; idx < Config::HistoryParallel; ++idx) {
+			_jobs.emplace_back(new Job(this));
+			_idle.push_back(_jobs.back().get());
+		}
+	}
+
+	~HistorySync() noexcept {
+		LOG_DEBUG("binance::rest::~HistorySync()\n");
+		for(auto& job : _jobs) {
+			if(job->symbol) {
+				curl_multi_remove_handle(_multi, job->curl);
+			}
+		}
+		_jobs.clear();
+		if(_multi) {
+			curl_multi_cleanup(_multi);
+		}
+		if(_reactor) {
+			_reactor->remove(_timer);
+		}
+	}
+
+	/**
+	 * Adds a symbol to sync starting from the mark.
+	 */
+	void add_symbol(const String& name, const SInteger order_id = 0, const SInteger trade_id = 0) noexcept {
+		for(auto& item : _symbols) {
+			if(item.name == name) {
+				return;
+			}
+		}
+		_symbols.push_back(Symbol {name, cursor(order_id), cursor(trade_id)});
+	}
+
+	/**
+	 * Reads the marks saved by save(). A missing file is a first sync.
+	 * The symbols not added before are ignored.
+	 */
+	bool load(const char* path) noexcept {
+		FILE* file = fopen(path, "r");
+		if(file == nullptr) {
+			LOG_INFO("No history marks in '%s', the full history is to be fetched.\n", path);
+			return true;
+		}
+
+		char name[64];
+		long long order_id;
+		long long trade_id;
+		int read;
+		while((read = fscanf(file, "%63s %lld %lld", name, &order_id, &trade_id)) == 3) {
+			for(auto& item : _symbols) {
+				if(item.name == name) {
+					item.orders = cursor(order_id);
+					item.trades = cursor(trade_id);
+				}
+			}
+		}
+		fclose(file);
+
+		if(read != EOF) {
+			LOG_ERROR("binance::rest::HistorySync::load() malformed '%s'\n", path);
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Writes the marks atomically, a crash leaves either the previous or the new file.
+	 */
+	bool save(const char* path) const noexcept {
+		const std::string tmp_path(std::string(path) + ".tmp");
+		FILE* file = fopen(tmp_path.c_str(), "w");
+		if(file == nullptr) {
+			LOG_ERROR("binance::rest::HistorySync::save() unable to open '%s'\n", tmp_path.c_str());
+			return false;
+		}
+
+		for(const auto& item : _symbols) {
+			fprintf(file, "%s %lld %lld\n", item.name.c_str(), static_cast<long long>(item.orders.mark),
+			        static_cast<long long>(item.trades.mark));
+		}
+
+		bool result = (fflush(file) == 0) && (fsync(fileno(file)) == 0);
+		result &= (fclose(file) == 0);
+		result = result && (rename(tmp_path.c_str(), path) == 0);
+
+		if(not result) {
+			LOG_ERROR("binance::rest::HistorySync::save() unable to write '%s'\n", path);
+		}
+		return result;
+	}
+
+	std::vector<Mark> marks() const noexcept {
+		std::vector<Mark> result;
+		for(const auto& item : _symbols) {
+			result.push_back(Mark {item.name, item.orders.mark, item.trades.mark});
+		}
+		return result;
+	}
+
+	/**
+	 * Hands the curl_multi sockets and timeouts over to the reactor. The reactor MUST outlive the instance.
+	 */
+	bool attach(Reactor& reactor) noexcept {
+		if(_multi == nullptr) {
+			return false;
+		}
+		_timer = reactor.add_timer(cb_timer, this);
+		if(_timer < 0) {
+			return false;
+		}
+		_reactor = &reactor;
+		curl_multi_setopt(_multi, CURLMOPT_SOCKETFUNCTION, cb_curl_socket);
+		curl_multi_setopt(_multi, CURLMOPT_SOCKETDATA, this);
+		curl_multi_setopt(_multi, CURLMOPT_TIMERFUNCTION, cb_curl_timer);
+		curl_multi_setopt(_multi, CURLMOPT_TIMERDATA, this);
+		return true;
+	}
+
+	/**
+	 * Starts the new requests and completes the finished ones, waits for the network no longer than 'timeout_ms'.
+	 * If attached to a reactor, runs the reactor once instead.
+	 * @return false - if the sync is over.
+	 */
+	bool service(const int timeout_ms = Config::WSServiceTimeoutMS) noexcept {
+		if(_multi == nullptr) {
+			return false;
+		}
+
+		schedule();
+
+		if(_reactor) {
+			if(_running == 0u) {
+				if(finished()) {
+					return false;
+				}
+				// Waiting for the budget.
+				_reactor->arm_timer(_timer, static_cast<unsigned>(timeout_ms));
+			}
+			return _reactor->run_once() >= 0;
+		}
+
+		int running;
+		curl_multi_perform(_multi, &running);
+		complete();
+		schedule();
+
+		if(_running == 0u) {
+			if(finished()) {
+				return false;
+			}
+			// Waiting for the budget.
+			usleep(static_cast<useconds_t>(timeout_ms) * 1000u);
+			return true;
+		}
+
+		int fds;
+		curl_multi_poll(_multi, nullptr, 0u, timeout_ms, &fds);
+		return true;
+	}
+
+	/**
+	 * @return false - if any of the symbols has failed. Its mark stays where the failure has happened.
+	 */
+	bool succeeded() const noexcept {
+		if(_multi == nullptr) {
+			return false;
+		}
+		for(const auto& item : _symbols) {
+			if(item.orders.failed || item.trades.failed) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void dump() const noexcept {
+		LOG_INFO("==== History sync ====\n");
+		for(const auto& item : _symbols) {
+			LOG_INFO("  %s orders=%zu%s next-order-id=%lld trades=%zu%s next-trade-id=%lld\n", item.name.c_str(),
+			         item.orders.records, item.orders.failed ? " (failed)" : "", static_cast<long long>(item.orders.mark),
+			         item.trades.records, item.trades.failed ? " (failed)" : "", static_cast<long long>(item.trades.mark));
+		}
+	}
+
+private:
+
+	static int cb_curl_socket(CURL*, curl_socket_t fd, int what, void* instance, void* assigned) noexcept {
+		auto obj = reinterpret_cast<HistorySync*>(instance);
+		if(what == CURL_POLL_REMOVE) {
+			obj->_reactor->remove(fd);
+			return EXIT_SUCCESS;
+		}
+
+		const uint32_t events = ((what & CURL_POLL_IN) ? EPOLLIN : 0u) | ((what & CURL_POLL_OUT) ? EPOLLOUT : 0u);
+		if(assigned) {
+			obj->_reactor->modify(fd, events);
+		} else {
+			obj->_reactor->add(fd, events, cb_socket, obj);
+			curl_multi_assign(obj->_multi, fd, obj);
+		}
+		return EXIT_SUCCESS;
+	}
+
+	static int cb_curl_timer(CURLM*, long timeout_ms, void* instance) noexcept {
+		auto obj = reinterpret_cast<HistorySync*>(instance);
+		if(timeout_ms < 0) {
+			obj->_reactor->disarm_timer(obj->_timer);
+		} else {
+			obj->_reactor->arm_timer(obj->_timer, static_cast<unsigned>(timeout_ms));
+		}
+		return EXIT_SUCCESS;
+	}
+
+	static void cb_socket(void* instance, int fd, uint32_t events) noexcept {
+		auto obj = reinterpret_cast<HistorySync*>(instance);
+		const int flags = ((events & EPOLLIN) ? CURL_CSELECT_IN : 0) | ((events & EPOLLOUT) ? CURL_CSELECT_OUT : 0)
+		                  | ((events & (EPOLLERR | EPOLLHUP)) ? CURL_CSELECT_ERR : 0);
+		int running;
+		curl_multi_socket_action(obj->_multi, fd, flags, &running);
+		obj->complete();
+		obj->schedule();
+	}
+
+	static void cb_timer(void* instance, int, uint32_t) noexcept {
+		auto obj = reinterpret_cast<HistorySync*>(instance);
+		int running;
+		curl_multi_socket_action(obj->_multi, CURL_SOCKET_TIMEOUT, 0, &running);
+		obj->complete();
+		obj->schedule();
+	}
+
+	static inline Cursor cursor(const SInteger mark) noexcept {
+		return Cursor {mark, mark, 0u, 0u, false, false, false, false};
+	}
+
+	bool finished() const noexcept {
+		for(const auto& item : _symbols) {
+			if(not item.orders.done || not item.trades.done) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @return true - if a page may be requested now.
+	 */
+	bool budget_available() noexcept {
+		const auto now_ms = Utils::time_wall_ms();
+		if(now_ms < _paused_till_ms) {
+			return false;
+		}
+
+		// Binance counts the weight within the calendar minutes.
+		const auto window = now_ms / 60000u;
+		if(window != _window) {
+			_window = window;
+			_weight = 0u;
+		}
+		return _weight + Config::HistoryWeightPerPage <= Config::HistoryWeightBudget1M;
+	}
+
+	void schedule() noexcept {
+		for(auto& item : _symbols) {
+			for(const auto kind : {Kind::Orders, Kind::Trades}) {
+				auto& cur = (kind == Kind::Orders) ? item.orders : item.trades;
+				if(cur.busy || cur.done) {
+					continue;
+				}
+				if(_idle.empty() || not budget_available()) {
+					return;
+				}
+				auto job = _idle.back();
+				_idle.pop_back();
+				start(*job, item, kind);
+			}
+		}
+	}
+
+	void start(Job& job, Symbol& symbol, const Kind kind) noexcept {
+		job.symbol = &symbol;
+		job.kind = kind;
+		job.used_weight = 0u;
+		job.retry_after = 0u;
+
+		auto& cur = job.cursor();
+		cur.busy = true;
+		_weight += Config::HistoryWeightPerPage;
+
+		std::string query("symbol=" + symbol.name);
+		query.append((kind == Kind::Orders) ? "&orderId=" : "&fromId=");
+		query.append(std::to_string(cur.next));
+		query.append("&limit=" + std::to_string(Config::HistoryPageLimit));
+
+		const auto url = _conn.signed_url((kind == Kind::Orders) ? "allOrders" : "myTrades", query);
+
+		curl_slist_free_all(job.headers);
+		job.headers = nullptr;
+		for(const auto& str : _conn.http_headers()) {
+			job.headers = curl_slist_append(job.headers, str.c_str());
+		}
+
+		curl_easy_reset(job.curl);
+		curl_easy_setopt(job.curl, CURLOPT_URL, url.c_str());
+		curl_easy_setopt(job.curl, CURLOPT_HTTPHEADER, job.headers);
+		curl_easy_setopt(job.curl, CURLOPT_WRITEFUNCTION, receiver);
+		curl_easy_setopt(job.curl, CURLOPT_WRITEDATA, &job);
+		curl_easy_setopt(job.curl, CURLOPT_HEADERFUNCTION, header_receiver);
+		curl_easy_setopt(job.curl, CURLOPT_HEADERDATA, &job);
+		curl_easy_setopt(job.curl, CURLOPT_PRIVATE, &job);
+		curl_easy_setopt(job.curl, CURLOPT_SSL_VERIFYPEER, false);
+		curl_easy_setopt(job.curl, CURLOPT_ENCODING, "gzip");
+		curl_easy_setopt(job.curl, CURLOPT_TIMEOUT_MS, Config::HistoryTimeoutMS);
+
+		curl_multi_add_handle(_multi, job.curl);
+		_running++;
+	}
+
+	void complete() noexcept {
+		CURLMsg* msg;
+		int left;
+		while((msg = curl_multi_info_read(_multi, &left)) != nullptr) {
+			if(msg->msg != CURLMSG_DONE) {
+				continue;
+			}
+
+			Job* job = nullptr;
+			curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &job);
+			const auto err = msg->data.result;
+			curl_multi_remove_handle(_multi, msg->easy_handle);
+			_running--;
+
+			finish(*job, err);
+
+			job->orders.reset();
+			job->trades.reset();
+			job->symbol = nullptr;
+			_idle.push_back(job);
+		}
+	}
+
+	void finish(Job& job, const CURLcode err) noexcept {
+		auto& cur = job.cursor();
+		const auto& body = (job.kind == Kind::Orders) ? job.orders.body : job.trades.body;
+		cur.busy = false;
+
+		if(job.used_weight > _weight) {
+			_weight = job.used_weight;
+		}
+
+		long code = 0;
+		curl_easy_getinfo(job.curl, CURLINFO_RESPONSE_CODE, &code);
+
+		if(code == 429 || code == 418) {
+			const auto delay_sec = job.retry_after ? job.retry_after : 60u;
+			LOG_ERROR("History sync is rate limited (%ld), pausing for %u sec.\n", code, delay_sec);
+			_paused_till_ms = Utils::time_wall_ms() + delay_sec * 1000u;
+			return;
+		}
+
+		ErrorResponse error;
+		bool result = (err == CURLE_OK);
+		if(not result) {
+			LOG_ERROR("binance::rest::HistorySync '%s' '%s'\n", job.symbol->name.c_str(), curl_easy_strerror(err));
+		} else if(error.parse(body)) {
+			LOG_ERROR("binance::rest::HistorySync '%s' code=%lld msg='%s'\n", job.symbol->name.c_str(),
+			          static_cast<long long>(error.code), error.msg.c_str());
+			result = false;
+		} else {
+			result = (job.kind == Kind::Orders) ? accept_orders(job) : accept_trades(job);
+		}
+
+		if(result) {
+			cur.attempts = 0u;
+		} else if(++cur.attempts >= Config::HistoryRetries) {
+			cur.failed = true;
+			cur.done = true;
+		}
+	}
+
+	bool accept_orders(Job& job) noexcept {
+		auto& cur = job.symbol->orders;
+		if(not job.orders.parse(job.orders.body)) {
+			LOG_ERROR("binance::rest::HistorySync '%s' malformed orders page\n", job.symbol->name.c_str());
+			return false;
+		}
+
+		for(const auto& item : job.orders.orders) {
+			const bool open = (item.status == "NEW" || item.status == "PARTIALLY_FILLED" || item.status == "PENDING_NEW");
+			if(open && not cur.open_seen) {
+				cur.open_seen = true;
+				cur.mark = item.orderId;
+			}
+			cur.next = item.orderId + 1;
+		}
+
+		if(not cur.open_seen) {
+			cur.mark = cur.next;
+		}
+		cur.records += job.orders.orders.size();
+		cur.done = (job.orders.orders.size() < Config::HistoryPageLimit) || _conn.mocked();
+
+		if(_orders_cb && not job.orders.orders.empty()) {
+			_orders_cb(_instance, job.symbol->name, job.orders.orders);
+		}
+		return true;
+	}
+
+	bool accept_trades(Job& job) noexcept {
+		auto& cur = job.symbol->trades;
+		if(not job.trades.parse(job.trades.body)) {
+			LOG_ERROR("binance::rest::HistorySync '%s' malformed trades page\n", job.symbol->name.c_str());
+			return false;
+		}
+
+		for(const auto& item : job.trades.trades) {
+			cur.next = item.id + 1;
+		}
+
+		cur.mark = cur.next;
+		cur.records += job.trades.trades.size();
+		cur.done = (job.trades.trades.size() < Config::HistoryPageLimit) || _conn.mocked();
+
+		if(_trades_cb && not job.trades.trades.empty()) {
+			_trades_cb(_instance, job.symbol->name, job.trades.trades);
+		}
+		return true;
+	}
+
+	static size_t receiver(void* content, size_t size, size_t nmemb, Job* job) noexcept {
+		auto& body = (job->kind == Kind::Orders) ? job->orders.body : job->trades.body;
+		body.append(static_cast<const char*>(content), size * nmemb);
+		return size * nmemb;
+	}
+
+	/**
+	 * Picks the rate limit headers.
+	 */
+	static size_t header_receiver(char* content, size_t size, size_t nmemb, Job* job) noexcept {
+		static constexpr const char* UsedWeight = "x-mbx-used-weight-1m:";
+		static constexpr const char* RetryAfter = "retry-after:";
+
+		const auto len = size * nmemb;
+		if(len > strlen(UsedWeight) && strncasecmp(content, UsedWeight, strlen(UsedWeight)) == 0) {
+			job->used_weight = static_cast<unsigned>(strtoul(content + strlen(UsedWeight), nullptr, 10));
+		} else if(len > strlen(RetryAfter) && strncasecmp(content, RetryAfter, strlen(RetryAfter)) == 0) {
+			job->retry_after = static_cast<unsigned>(strtoul(content + strlen(RetryAfter), nullptr, 10));
+		}
+		return len;
+	}
+
+};
+
+}; // namespace rest
+}; // namespace binance
@@ -1,16 +1,58 @@
+#pragma once
+
 #include "../types.h"
+#include "../Assets.h"
 
 #include <vector>
+#include <algorithm>
 #include <string>
+#include <string_view>
+#include <memory_resource>
 #include <cstdio>
 
 #include <jsoncpp/json/json.h>
 
 #include "../../Log.h"
+#include "../../Utils.h"
+#include "../../Arena.h"
+#include "../../parser/Scanner.h"
 
 namespace binance {
 namespace rest {
 
+/**
+ * https://github.com/binance/binance-spot-api-docs/blob/master/errors.md
+ */
+struct ErrorResponse {
+	SInteger code = 0;
+	String msg;
+
+	/**
+	 * @return true - if the body is an error response rather than the data expected.
+	 */
+	bool parse(std::string_view body) {
+		parser::Scanner scan(body);
+		std::string_view key;
+		bool has_code = false;
+		if(scan.begin_object()) {
+			while(scan.member(key)) {
+				if(key == "code") {
+					has_code = scan.integer(code);
+				} else if(not has_code) {
+					return false;
+				} else if(key == "msg") {
+					std::string_view value;
+					scan.string(value);
+					msg.assign(value.data(), value.size());
+				} else {
+					scan.skip();
+				}
+			}
+		}
+		return has_code && scan.ok();
+	}
+};
+
 struct AccountInformation {
 
 	struct CommissionRates {
@@ -21,12 +63,20 @@ struct AccountInformation {
 	};
 
 	struct Balance {
-		String asset;
-		String free;
-		String locked;
+		AssetId asset;
+		Float free;
+		Float locked;
+	};
+
+	struct BalanceDelta {
+		AssetId asset;
+		Float free;
+		Float locked;
 	};
 
 	using Balances_t = std::vector<Balance>;
+	using BalanceDeltas_t = std::vector<BalanceDelta>;
+	using BalanceIndex_t = std::vector<uint32_t>;
 	using Permissions_t = std::vector<std::string>;
 
 	UInteger makerCommission;
@@ -48,6 +98,8 @@ struct AccountInformation {
 	Balances_t balances;
 	Permissions_t permissions;
 
+	BalanceIndex_t balance_index;  // AssetId -> the balances index + 1, zero if the asset is missing.
+
 	bool parse(const Json::Value& root) {
 
 		makerCommission = root["makerCommission"].asUInt64();
@@ -74,12 +126,19 @@ struct AccountInformation {
 		const auto bal_nb = bal.size();
 
 		balances.clear();
+		balances.reserve(bal_nb);
 		for(Json::ArrayIndex idx = 0; idx < bal_nb; ++idx) {
-			const auto record = bal[idx];
-			Balance item {record["asset"].asString(), record["free"].asString(), record["locked"].asString()};
+			const auto& record = bal[idx];
+			Balance item {
+				Assets::intern(record["asset"].asString()),
+				std::stod(record["free"].asString()),
+				std::stod(record["locked"].asString())
+			};
 			balances.push_back(item);
 		}
 
+		build_index();
+
 		const auto perm = root["permissions"];
 		const auto perm_nb = perm.size();
 		permissions.clear();
@@ -90,6 +149,86 @@ struct AccountInformation {
 		return validate();
 	}
 
+	/**
+	 * Reads the response body in place, no DOM is built.
+	 * The containers keep their capacity, so a repeated parsing does not allocate.
+	 */
+	bool parse(std::string_view body) noexcept {
+		parser::Scanner scan(body);
+		std::string_view key;
+		std::string_view value;
+
+		balances.clear();
+		permissions.clear();
+
+		if(scan.begin_object()) {
+			while(scan.member(key)) {
+				if(key == "makerCommission") {
+					scan.integer(makerCommission);
+				} else if(key == "takerCommission") {
+					scan.integer(takerCommission);
+				} else if(key == "buyerCommission") {
+					scan.integer(buyerCommission);
+				} else if(key == "sellerCommission") {
+					scan.integer(sellerCommission);
+				} else if(key == "commissionRates" && scan.begin_object()) {
+					while(scan.member(key)) {
+						if(key == "maker") {
+							scan.decimal(commissionRates.maker);
+						} else if(key == "taker") {
+							scan.decimal(commissionRates.taker);
+						} else if(key == "buyer") {
+							scan.decimal(commissionRates.buyer);
+						} else if(key == "seller") {
+							scan.decimal(commissionRates.seller);
+						} else {
+							scan.skip();
+						}
+					}
+				} else if(key == "canTrade") {
+					scan.boolean(canTrade);
+				} else if(key == "canWithdraw") {
+					scan.boolean(canWithdraw);
+				} else if(key == "canDeposit") {
+					scan.boolean(canDeposit);
+				} else if(key == "brokered") {
+					scan.boolean(brokered);
+				} else if(key == "requireSelfTradePrevention") {
+					scan.boolean(requireSelfTradePrevention);
+				} else if(key == "updateTime") {
+					scan.integer(updateTime);
+				} else if(key == "accountType" && scan.string(value)) {
+					accountType.assign(value.data(), value.size());
+				} else if(key == "balances" && scan.begin_array()) {
+					while(scan.element() && scan.begin_object()) {
+						Balance item {Assets::None, 0., 0.};
+						while(scan.member(key)) {
+							if(key == "asset" && scan.string(value)) {
+								item.asset = Assets::intern(value);
+							} else if(key == "free") {
+								scan.decimal(item.free);
+							} else if(key == "locked") {
+								scan.decimal(item.locked);
+							} else {
+								scan.skip();
+							}
+						}
+						balances.push_back(item);
+					}
+				} else if(key == "permissions" && scan.begin_array()) {
+					while(scan.element() && scan.string(value)) {
+						permissions.emplace_back(value.data(), value.size());
+					}
+				} else {
+					scan.skip();
+				}
+			}
+		}
+
+		build_index();
+		return scan.ok() && validate();
+	}
+
 	inline bool validate() const noexcept {
 		return true;
 	}
@@ -118,7 +257,7 @@ struct AccountInformation {
 
 		LOG_INFO("  balances :\n");
 		for(const auto& item : balances) {
-			LOG_INFO("    asset='%s' free='%s' locked='%s'\n", item.asset.c_str(), item.free.c_str(), item.locked.c_str());
+			LOG_INFO("    asset='%s' free='%.8f' locked='%.8f'\n", Assets::name(item.asset).c_str(), item.free, item.locked);
 		}
 
 		LOG_INFO("  permissions : ");
@@ -128,17 +267,59 @@ struct AccountInformation {
 		LOG_PLAIN("\n");
 	}
 
-	bool get_balance(std::string symbol, double& balance) const noexcept {
-		Utils::string_to_lower(symbol);
-		for(const auto& sym : balances) {
-			std::string asset = sym.asset;
-			Utils::string_to_lower(asset);
-			if(asset == symbol) {
-				balance = std::stod(sym.free);
-				return true;
+	void build_index() noexcept {
+		balance_index.assign(Assets::size(), 0u);
+		for(size_t idx = 0; idx < balances.size(); ++idx) {
+			if(balances[idx].asset != Assets::None) {
+				balance_index[balances[idx].asset] = static_cast<uint32_t>(idx + 1u);
+			}
+		}
+	}
+
+	/**
+	 * O(1), no allocations.
+	 * @return - The balance record or nullptr if the asset is missing.
+	 */
+	inline const Balance* find_balance(const AssetId asset) const noexcept {
+		if(asset < balance_index.size() && balance_index[asset]) {
+			return &balances[balance_index[asset] - 1u];
+		}
+		return nullptr;
+	}
+
+	inline bool get_balance(const AssetId asset, double& balance) const noexcept {
+		const auto record = find_balance(asset);
+		if(record) {
+			balance = record->free;
+		}
+		return record != nullptr;
+	}
+
+	inline bool get_balance(const std::string& symbol, double& balance) const noexcept {
+		return get_balance(Assets::find(symbol), balance);
+	}
+
+	/**
+	 * Collects the balances changed between the snapshots in one pass over the asset IDs.
+	 * An asset missing in a snapshot counts as a zero balance there.
+	 */
+	static void diff(const AccountInformation& prev, const AccountInformation& last, BalanceDeltas_t& deltas) noexcept {
+		deltas.clear();
+		const auto ids_nb = std::max(prev.balance_index.size(), last.balance_index.size());
+		for(AssetId id = 0; id < ids_nb; ++id) {
+			const auto bal_prev = prev.find_balance(id);
+			const auto bal_last = last.find_balance(id);
+			if(bal_prev || bal_last) {
+				const BalanceDelta delta {
+					id,
+					(bal_last ? bal_last->free : 0.) - (bal_prev ? bal_prev->free : 0.),
+					(bal_last ? bal_last->locked : 0.) - (bal_prev ? bal_prev->locked : 0.)
+				};
+				if(delta.free != 0. || delta.locked != 0.) {
+					deltas.push_back(delta);
+				}
 			}
 		}
-		return false;
 	}
 
 };
@@ -184,15 +365,16 @@ struct Order {
 		cummulativeQuoteQty = std::stod(root["cummulativeQuoteQty"].asString());
 		status = root["status"].asString();
 		timeInForce = root["timeInForce"].asString();
-		symbol = root["symbol"].asString();
+		type = root["type"].asString();
 		side = root["side"].asString();
 		stopPrice = std::stod(root["stopPrice"].asString());
 		icebergQty = std::stod(root["icebergQty"].asString());
-		time = root["icebergQty"].asLargestUInt();
+		time = root["time"].asLargestUInt();
+		updateTime = root["updateTime"].asLargestUInt();
 		isWorking = root["isWorking"].asBool();
 		origQuoteOrderQty = std::stod(root["origQuoteOrderQty"].asString());
 		workingTime = root["workingTime"].asLargestUInt();
-		selfTradePreventionMode = root["symbol"].asString();
+		selfTradePreventionMode = root["selfTradePreventionMode"].asString();
 		preventedMatchId = root["preventedMatchId"].asLargestInt();
 		preventedQuantity = std::stod(root["preventedQuantity"].asString());
 
@@ -216,7 +398,7 @@ struct AllOrders {
 		const auto size = root.size();
 		orders.resize(size);
 		for(Json::ArrayIndex idx = 0; idx < size; ++idx) {
-			if(orders[idx].parse(root[idx])) {
+			if(not orders[idx].parse(root[idx])) {
 				return false;
 			}
 		}
@@ -230,16 +412,769 @@ struct AllOrders {
 	}
 };
 
+/**
+ * The POD counterpart of Order. The strings are views into the response body.
+ */
+struct OrderView {
+	std::string_view symbol;
+	SInteger orderId;
+	SInteger orderListId;
+	std::string_view clientOrderId;
+	Float price;
+	Float origQty;
+	Float executedQty;
+	Float cummulativeQuoteQty;
+	std::string_view status;
+	std::string_view timeInForce;
+	std::string_view type;
+	std::string_view side;
+	Float stopPrice;
+	Float icebergQty;
+	Time time;
+	Time updateTime;
+	Bool isWorking;
+	Float origQuoteOrderQty;
+	Time workingTime;
+	std::string_view selfTradePreventionMode;
+	SInteger preventedMatchId;
+	Float preventedQuantity;
+
+	bool parse(parser::Scanner& scan) noexcept {
+		std::string_view key;
+		if(not scan.begin_object()) {
+			return false;
+		}
+		while(scan.member(key)) {
+			if(key == "symbol") {
+				scan.string(symbol);
+			} else if(key == "orderId") {
+				scan.integer(orderId);
+			} else if(key == "orderListId") {
+				scan.integer(orderListId);
+			} else if(key == "clientOrderId") {
+				scan.string(clientOrderId);
+			} else if(key == "price") {
+				scan.decimal(price);
+			} else if(key == "origQty") {
+				scan.decimal(origQty);
+			} else if(key == "executedQty") {
+				scan.decimal(executedQty);
+			} else if(key == "cummulativeQuoteQty") {
+				scan.decimal(cummulativeQuoteQty);
+			} else if(key == "status") {
+				scan.string(status);
+			} else if(key == "timeInForce") {
+				scan.string(timeInForce);
+			} else if(key == "type") {
+				scan.string(type);
+			} else if(key == "side") {
+				scan.string(side);
+			} else if(key == "stopPrice") {
+				scan.decimal(stopPrice);
+			} else if(key == "icebergQty") {
+				scan.decimal(icebergQty);
+			} else if(key == "time") {
+				scan.integer(time);
+			} else if(key == "updateTime") {
+				scan.integer(updateTime);
+			} else if(key == "isWorking") {
+				scan.boolean(isWorking);
+			} else if(key == "origQuoteOrderQty") {
+				scan.decimal(origQuoteOrderQty);
+			} else if(key == "workingTime") {
+				scan.integer(workingTime);
+			} else if(key == "selfTradePreventionMode") {
+				scan.string(selfTradePreventionMode);
+			} else if(key == "preventedMatchId") {
+				scan.integer(preventedMatchId);
+			} else if(key == "preventedQuantity") {
+				scan.decimal(preventedQuantity);
+			} else {
+				scan.skip();
+			}
+		}
+		return scan.ok();
+	}
+
+	void dump() const noexcept {
+		LOG_INFO("==== Order ====\n");
+		LOG_INFO("symbol='%.*s' orderId=%ld side='%.*s' status='%.*s' executedQty=%f\n",
+		         static_cast<int>(symbol.size()), symbol.data(), static_cast<long>(orderId),
+		         static_cast<int>(side.size()), side.data(), static_cast<int>(status.size()), status.data(), executedQty);
+	}
+};
+
+/**
+ * The arena backed counterpart of AllOrders. The arena owns the response body, the orders and everything they point to.
+ * One arena per request; reset() releases the whole result at once.
+ */
+struct AllOrdersView {
+	Arena& arena;
+	std::pmr::string body;
+	std::pmr::vector<OrderView> orders;
+
+	explicit AllOrdersView(Arena& arena) noexcept :
+		arena(arena),
+		body(arena.resource()),
+		orders(arena.resource()) {
+	}
+
+	bool parse(std::string_view text) noexcept {
+		parser::Scanner scan(text);
+		orders.clear();
+		if(not scan.begin_array()) {
+			return false;
+		}
+		while(scan.element()) {
+			orders.emplace_back();
+			if(not orders.back().parse(scan)) {
+				return false;
+			}
+		}
+		return scan.ok();
+	}
+
+	/**
+	 * Releases the body, the orders and the arena. The instance is empty and reusable afterwards.
+	 */
+	void reset() noexcept {
+		std::pmr::string(arena.resource()).swap(body);
+		std::pmr::vector<OrderView>(arena.resource()).swap(orders);
+		arena.reset();
+	}
+
+	void dump() const noexcept {
+		for(const auto& item : orders) {
+			item.dump();
+		}
+	}
+};
+
+/**
+ * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#account-trade-list-user_data
+ * The strings are views into the response body.
+ */
+struct TradeView {
+	std::string_view symbol;
+	SInteger id;
+	SInteger orderId;
+	SInteger orderListId;
+	Float price;
+	Float qty;
+	Float quoteQty;
+	Float commission;
+	std::string_view commissionAsset;
+	Time time;
+	Bool isBuyer;
+	Bool isMaker;
+	Bool isBestMatch;
+
+	bool parse(parser::Scanner& scan) noexcept {
+		std::string_view key;
+		if(not scan.begin_object()) {
+			return false;
+		}
+		while(scan.member(key)) {
+			if(key == "symbol") {
+				scan.string(symbol);
+			} else if(key == "id") {
+				scan.integer(id);
+			} else if(key == "orderId") {
+				scan.integer(orderId);
+			} else if(key == "orderListId") {
+				scan.integer(orderListId);
+			} else if(key == "price") {
+				scan.decimal(price);
+			} else if(key == "qty") {
+				scan.decimal(qty);
+			} else if(key == "quoteQty") {
+				scan.decimal(quoteQty);
+			} else if(key == "commission") {
+				scan.decimal(commission);
+			} else if(key == "commissionAsset") {
+				scan.string(commissionAsset);
+			} else if(key == "time") {
+				scan.integer(time);
+			} else if(key == "isBuyer") {
+				scan.boolean(isBuyer);
+			} else if(key == "isMaker") {
+				scan.boolean(isMaker);
+			} else if(key == "isBestMatch") {
+				scan.boolean(isBestMatch);
+			} else {
+				scan.skip();
+			}
+		}
+		return scan.ok();
+	}
+};
+
+/**
+ * The arena backed list of the account trades, see AllOrdersView.
+ */
+struct MyTradesView {
+	Arena& arena;
+	std::pmr::string body;
+	std::pmr::vector<TradeView> trades;
+
+	explicit MyTradesView(Arena& arena) noexcept :
+		arena(arena),
+		body(arena.resource()),
+		trades(arena.resource()) {
+	}
+
+	bool parse(std::string_view text) noexcept {
+		parser::Scanner scan(text);
+		trades.clear();
+		if(not scan.begin_array()) {
+			return false;
+		}
+		while(scan.element()) {
+			trades.emplace_back();
+			if(not trades.back().parse(scan)) {
+				return false;
+			}
+		}
+		return scan.ok();
+	}
+
+	void reset() noexcept {
+		std::pmr::string(arena.resource()).swap(body);
+		std::pmr::vector<TradeView>(arena.resource()).swap(trades);
+		arena.reset();
+	}
+};
+
+/**
+ * The order entry parameters.
+ * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#new-order-trade
+ */
+struct OrderRequest {
+
+	enum class Type {
+		MARKET,
+		LIMIT,
+		LIMIT_MAKER,       // Post-only, rejected if it would take.
+		STOP_LOSS,         // A MARKET one once the stop price is reached.
+		STOP_LOSS_LIMIT,
+		TAKE_PROFIT,
+		TAKE_PROFIT_LIMIT
+	};
+
+	enum class TimeInForce {
+		GTC,
+		IOC,
+		FOK
+	};
+
+	String symbol;
+	Order::Side side;
+	Type type;
+	TimeInForce timeInForce;  // The *LIMIT types except LIMIT_MAKER.
+	Float price;              // The *LIMIT* types.
+	Float stopPrice;          // The STOP_LOSS* and TAKE_PROFIT* types.
+	Float quantity;           // The base asset quantity.
+	Float quoteOrderQty;      // MARKET only, used if the quantity is zero.
+	String newClientOrderId;  // Preassigned, see OrderTable::next_client_id().
+
+	bool validate() const noexcept {
+		bool result = not symbol.empty() && not newClientOrderId.empty();
+		switch(type) {
+			case Type::MARKET:
+				result &= (quantity > 0.) || (quoteOrderQty > 0.);
+				break;
+
+			case Type::LIMIT:
+			case Type::LIMIT_MAKER:
+				result &= (quantity > 0.) && (price > 0.);
+				break;
+
+			case Type::STOP_LOSS:
+			case Type::TAKE_PROFIT:
+				result &= (quantity > 0.) && (stopPrice > 0.);
+				break;
+
+			case Type::STOP_LOSS_LIMIT:
+			case Type::TAKE_PROFIT_LIMIT:
+				result &= (quantity > 0.) && (price > 0.) && (stopPrice > 0.);
+				break;
+		}
+		return result;
+	}
+
+	inline bool has_price() const noexcept {
+		return type != Type::MARKET && type != Type::STOP_LOSS && type != Type::TAKE_PROFIT;
+	}
+
+	inline bool has_stop_price() const noexcept {
+		return type == Type::STOP_LOSS || type == Type::STOP_LOSS_LIMIT || type == Type::TAKE_PROFIT
+		       || type == Type::TAKE_PROFIT_LIMIT;
+	}
+
+	inline bool has_time_in_force() const noexcept {
+		return type == Type::LIMIT || type == Type::STOP_LOSS_LIMIT || type == Type::TAKE_PROFIT_LIMIT;
+	}
+
+	/**
+	 * Enumerates the request parameters, the same for the REST and the WebSocket APIs.
+	 * @param cb - Called as cb(const char* key, const std::string& value).
+	 */
+	template <typename CallBack>
+	void for_each_param(CallBack&& cb) const {
+		cb("symbol", symbol);
+		cb("side", to_string(side));
+		cb("type", to_string(type));
+
+		if(has_time_in_force()) {
+			cb("timeInForce", to_string(timeInForce));
+		}
+
+		if(quantity > 0.) {
+			cb("quantity", Utils::decimal_to_string(quantity));
+		} else {
+			cb("quoteOrderQty", Utils::decimal_to_string(quoteOrderQty));
+		}
+
+		if(has_price()) {
+			cb("price", Utils::decimal_to_string(price));
+		}
+
+		if(has_stop_price()) {
+			cb("stopPrice", Utils::decimal_to_string(stopPrice));
+		}
+
+		cb("newClientOrderId", newClientOrderId);
+	}
+
+	/**
+	 * @return - The price the order is triggered or rests at.
+	 */
+	inline Float level() const noexcept {
+		return has_stop_price() ? stopPrice : price;
+	}
+
+	static const char* to_string(const Order::Side side) noexcept {
+		return side == Order::Side::BUY ? "BUY" : "SELL";
+	}
+
+	static const char* to_string(const Type type) noexcept {
+		switch(type) {
+			case Type::MARKET:
+				return "MARKET";
+			case Type::LIMIT:
+				return "LIMIT";
+			case Type::LIMIT_MAKER:
+				return "LIMIT_MAKER";
+			case Type::STOP_LOSS:
+				return "STOP_LOSS";
+			case Type::STOP_LOSS_LIMIT:
+				return "STOP_LOSS_LIMIT";
+			case Type::TAKE_PROFIT:
+				return "TAKE_PROFIT";
+			case Type::TAKE_PROFIT_LIMIT:
+				return "TAKE_PROFIT_LIMIT";
+		}
+		return "";
+	}
+
+	static const char* to_string(const TimeInForce tif) noexcept {
+		switch(tif) {
+			case TimeInForce::GTC:
+				return "GTC";
+			case TimeInForce::IOC:
+				return "IOC";
+			case TimeInForce::FOK:
+				return "FOK";
+		}
+		return "";
+	}
+};
+
+/**
+ * The members of a JSON value the WebSocket API delivers parsed, empty or zero if absent or of the other type.
+ * The decimals are read as parser::Scanner reads the REST responses.
+ */
+inline String json_text(const Json::Value& root, const char* key) noexcept {
+	const auto& value = root[key];
+	return value.isString() ? value.asString() : String();
+}
+
+inline Float json_decimal(const Json::Value& root, const char* key) noexcept {
+	const auto& value = root[key];
+	const char* begin = nullptr;
+	const char* end = nullptr;
+	double result = 0.;
+	if(value.isString() && value.getString(&begin, &end)
+	   && parser::Scanner::to_decimal(std::string_view(begin, static_cast<size_t>(end - begin)), result)) {
+		return result;
+	}
+	return 0.;
+}
+
+inline SInteger json_integer(const Json::Value& root, const char* key) noexcept {
+	const auto& value = root[key];
+	return value.isIntegral() ? value.asLargestInt() : 0;
+}
+
+/**
+ * A trade of an order, an item of the 'fills' of the FULL order response.
+ */
+struct Fill {
+	Float    price;
+	Float    qty;
+	Float    commission;
+	AssetId  commissionAsset;
+	SInteger tradeId;
+
+	bool parse(const Json::Value& root) noexcept {
+		if(not root.isObject()) {
+			return false;
+		}
+		price = json_decimal(root, "price");
+		qty = json_decimal(root, "qty");
+		commission = json_decimal(root, "commission");
+		commissionAsset = Assets::intern(json_text(root, "commissionAsset"));
+		tradeId = json_integer(root, "tradeId");
+		return true;
+	}
+
+	bool parse(parser::Scanner& scan) noexcept {
+		std::string_view key;
+		std::string_view value;
+		if(not scan.begin_object()) {
+			return false;
+		}
+		while(scan.member(key)) {
+			if(key == "price") {
+				scan.decimal(price);
+			} else if(key == "qty") {
+				scan.decimal(qty);
+			} else if(key == "commission") {
+				scan.decimal(commission);
+			} else if(key == "commissionAsset" && scan.string(value)) {
+				commissionAsset = Assets::intern(value);
+			} else if(key == "tradeId") {
+				scan.integer(tradeId);
+			} else {
+				scan.skip();
+			}
+		}
+		return scan.ok();
+	}
+};
+
+/**
+ * The order state as returned by the order entry (newOrderRespType=FULL), the cancel and the query.
+ */
+struct OrderResult {
+	String   symbol;
+	SInteger orderId;
+	String   clientOrderId;
+	String   origClientOrderId;  // The cancel only, the ID of the order canceled.
+	Float    price;
+	Float    origQty;
+	Float    executedQty;
+	Float    cummulativeQuoteQty;
+	String   status;
+	String   timeInForce;
+	String   type;
+	String   side;
+	Time     time;               // The latest of 'transactTime', 'time' and 'updateTime'.
+	std::vector<Fill> fills;     // The order entry only.
+
+	bool parse(std::string_view body) noexcept {
+		parser::Scanner scan(body);
+		return parse(scan);
+	}
+
+	bool parse(parser::Scanner& scan) noexcept {
+		std::string_view key;
+
+		clear();
+		if(not scan.begin_object()) {
+			return false;
+		}
+		while(scan.member(key)) {
+			if(not parse_member(key, scan)) {
+				scan.skip();
+			}
+		}
+		return scan.ok() && orderId > 0;
+	}
+
+	bool parse(const Json::Value& root) noexcept {
+		clear();
+		if(not root.isObject()) {
+			return false;
+		}
+		symbol = json_text(root, "symbol");
+		orderId = json_integer(root, "orderId");
+		clientOrderId = json_text(root, "clientOrderId");
+		origClientOrderId = json_text(root, "origClientOrderId");
+		price = json_decimal(root, "price");
+		origQty = json_decimal(root, "origQty");
+		executedQty = json_decimal(root, "executedQty");
+		cummulativeQuoteQty = json_decimal(root, "cummulativeQuoteQty");
+		status = json_text(root, "status");
+		timeInForce = json_text(root, "timeInForce");
+		type = json_text(root, "type");
+		side = json_text(root, "side");
+		for(const char* key : {"transactTime", "time", "updateTime"}) {
+			time = std::max(time, static_cast<Time>(std::max(json_integer(root, key), SInteger(0))));
+		}
+		const auto& items = root["fills"];
+		if(items.isArray()) {
+			for(const auto& record : items) {
+				Fill item {0., 0., 0., Assets::None, 0};
+				if(item.parse(record)) {
+					fills.push_back(item);
+				}
+			}
+		}
+		return orderId > 0;
+	}
+
+	/**
+	 * Reads the value of the member if it is known.
+	 * @return false - if the member is unknown and its value is to be skipped.
+	 */
+	bool parse_member(std::string_view key, parser::Scanner& scan) noexcept {
+		std::string_view value;
+		Time ts;
+
+		if(key == "symbol" && scan.string(value)) {
+			symbol.assign(value.data(), value.size());
+		} else if(key == "orderId") {
+			scan.integer(orderId);
+		} else if(key == "clientOrderId" && scan.string(value)) {
+			clientOrderId.assign(value.data(), value.size());
+		} else if(key == "origClientOrderId" && scan.string(value)) {
+			origClientOrderId.assign(value.data(), value.size());
+		} else if(key == "price") {
+			scan.decimal(price);
+		} else if(key == "origQty") {
+			scan.decimal(origQty);
+		} else if(key == "executedQty") {
+			scan.decimal(executedQty);
+		} else if(key == "cummulativeQuoteQty") {
+			scan.decimal(cummulativeQuoteQty);
+		} else if(key == "status" && scan.string(value)) {
+			status.assign(value.data(), value.size());
+		} else if(key == "timeInForce" && scan.string(value)) {
+			timeInForce.assign(value.data(), value.size());
+		} else if(key == "type" && scan.string(value)) {
+			type.assign(value.data(), value.size());
+		} else if(key == "side" && scan.string(value)) {
+			side.assign(value.data(), value.size());
+		} else if((key == "transactTime" || key == "time" || key == "updateTime") && scan.integer(ts)) {
+			time = std::max(time, ts);
+		} else if(key == "fills" && scan.begin_array()) {
+			while(scan.element()) {
+				Fill item {0., 0., 0., Assets::None, 0};
+				if(item.parse(scan)) {
+					fills.push_back(item);
+				}
+			}
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+	void clear() noexcept {
+		symbol.clear();
+		orderId = 0;
+		clientOrderId.clear();
+		origClientOrderId.clear();
+		price = 0.;
+		origQty = 0.;
+		executedQty = 0.;
+		cummulativeQuoteQty = 0.;
+		status.clear();
+		timeInForce.clear();
+		type.clear();
+		side.clear();
+		time = 0u;
+		fills.clear();
+	}
+
+	void dump() const noexcept {
+		LOG_INFO("OrderResult : symbol='%s' orderId=%lld clientOrderId='%s' %s %s %s price=%.8f origQty=%.8f executedQty=%.8f status='%s'\n",
+		         symbol.c_str(), static_cast<long long>(orderId), clientOrderId.c_str(), side.c_str(), type.c_str(),
+		         timeInForce.c_str(), price, origQty, executedQty, status.c_str());
+	}
+};
+
+/**
+ * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#cancel-an-existing-order-and-send-a-new-order-trade
+ */
+struct CancelReplaceResult {
+	String cancelResult;       // SUCCESS or FAILURE.
+	String newOrderResult;     // SUCCESS, FAILURE or NOT_ATTEMPTED.
+	OrderResult cancelResponse;
+	OrderResult newOrderResponse;
+
+	bool parse(std::string_view body) noexcept {
+		parser::Scanner scan(body);
+		std::string_view key;
+		std::string_view value;
+
+		cancelResult.clear();
+		newOrderResult.clear();
+		cancelResponse.clear();
+		newOrderResponse.clear();
+
+		if(not scan.begin_object()) {
+			return false;
+		}
+		while(scan.member(key)) {
+			if(key == "cancelResult" && scan.string(value)) {
+				cancelResult.assign(value.data(), value.size());
+			} else if(key == "newOrderResult" && scan.string(value)) {
+				newOrderResult.assign(value.data(), value.size());
+			} else if(key == "cancelResponse") {
+				cancelResponse.parse(scan);
+			} else if(key == "newOrderResponse") {
+				newOrderResponse.parse(scan);
+			} else {
+				scan.skip();
+			}
+		}
+		return scan.ok();
+	}
+};
+
+/**
+ * The OCO order list entry, a pair of the orders sharing the quantity and the side; one fill cancels the other.
+ * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#new-order-list---oco-trade
+ */
+struct OcoRequest {
+	String listClientOrderId;
+	OrderRequest above;  // The leg with the higher price, e.g. the take profit of a SELL.
+	OrderRequest below;  // The leg with the lower price, e.g. the stop loss of a SELL.
+
+	bool validate() const noexcept {
+		bool result = not listClientOrderId.empty() && above.validate() && below.validate();
+		result &= (above.symbol == below.symbol) && (above.side == below.side) && (above.quantity == below.quantity);
+		result &= (above.type != OrderRequest::Type::MARKET) && (below.type != OrderRequest::Type::MARKET);
+		result &= (above.type != OrderRequest::Type::LIMIT) && (below.type != OrderRequest::Type::LIMIT);
+		result &= (above.level() > below.level());
+		return result;
+	}
+};
+
+/**
+ * The order list as returned by the OCO entry, the orders are the RESULT ones.
+ */
+struct OrderListResult {
+	SInteger orderListId;
+	String listClientOrderId;
+	String listStatusType;    // RESPONSE, EXEC_STARTED, ALL_DONE.
+	String listOrderStatus;   // EXECUTING, ALL_DONE, REJECT.
+	std::vector<OrderResult> orderReports;
+
+	bool parse(std::string_view body) noexcept {
+		parser::Scanner scan(body);
+		std::string_view key;
+		std::string_view value;
+
+		orderListId = -1;
+		listClientOrderId.clear();
+		listStatusType.clear();
+		listOrderStatus.clear();
+		orderReports.clear();
+
+		if(not scan.begin_object()) {
+			return false;
+		}
+		while(scan.member(key)) {
+			if(key == "orderListId") {
+				scan.integer(orderListId);
+			} else if(key == "listClientOrderId" && scan.string(value)) {
+				listClientOrderId.assign(value.data(), value.size());
+			} else if(key == "listStatusType" && scan.string(value)) {
+				listStatusType.assign(value.data(), value.size());
+			} else if(key == "listOrderStatus" && scan.string(value)) {
+				listOrderStatus.assign(value.data(), value.size());
+			} else if(key == "orderReports" && scan.begin_array()) {
+				while(scan.element()) {
+					orderReports.emplace_back();
+					orderReports.back().parse(scan);
+				}
+			} else {
+				scan.skip();
+			}
+		}
+		return scan.ok() && orderListId >= 0;
+	}
+};
+
+/**
+ * https://github.com/binance/binance-spot-api-docs/blob/master/rest-api.md#cancel-all-open-orders-on-a-symbol-trade
+ * The response mixes the orders and the order lists, the orders of the lists are flattened into 'orders'.
+ */
+struct CancelAllResult {
+	std::vector<OrderResult> orders;
+
+	bool parse(std::string_view body) noexcept {
+		parser::Scanner scan(body);
+		std::string_view key;
+
+		orders.clear();
+		if(not scan.begin_array()) {
+			return false;
+		}
+		while(scan.element() && scan.begin_object()) {
+			OrderResult item;
+			item.clear();
+			while(scan.member(key)) {
+				if(key == "orderReports" && scan.begin_array()) {
+					while(scan.element()) {
+						orders.emplace_back();
+						orders.back().parse(scan);
+					}
+				} else if(not item.parse_member(key, scan)) {
+					scan.skip();
+				}
+			}
+			if(item.orderId > 0) {
+				orders.push_back(std::move(item));
+			}
+		}
+		return scan.ok();
+	}
+};
+
 struct NewOrderResponse {
 
 	String	 symbol;
 	SInteger orderId;
 	String	 clientOrderId;
+	String   side;
+	Float    executedQty;
+	Float    cummulativeQuoteQty;
+	std::vector<Fill> fills;
 
 	bool parse(const Json::Value& root) {
 		symbol = root["symbol"].asString();
 		orderId = root["orderId"].asLargestInt();
 		clientOrderId = root["clientOrderId"].asString();
+		side = root["side"].asString();
+		executedQty = root.isMember("executedQty") ? std::stod(root["executedQty"].asString()) : 0.;
+		cummulativeQuoteQty = root.isMember("cummulativeQuoteQty") ? std::stod(root["cummulativeQuoteQty"].asString()) : 0.;
+
+		const auto items = root["fills"];
+		fills.clear();
+		for(Json::ArrayIndex idx = 0; idx < items.size(); ++idx) {
+			const auto& record = items[idx];
+			fills.push_back(Fill {
+				std::stod(record["price"].asString()),
+				std::stod(record["qty"].asString()),
+				std::stod(record["commission"].asString()),
+				Assets::intern(record["commissionAsset"].asString()),
+				record["tradeId"].asLargestInt()
+			});
+		}
 		return true;
 	}
 
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace binance {
+namespace sbe {
+
+/**
+ * The Simple Binary Encoding primitives: https://github.com/real-logic/simple-binary-encoding
+ *
+ * A message is read in place; a view is a pointer into the received frame plus the offsets fixed by the schema,
+ * so a field costs one unaligned load. The frame MUST outlive the views taken from it.
+ * The fields are little-endian, so is the host.
+ */
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "SBE decoding assumes a little-endian host.");
+
+template <typename T>
+static inline T load(const char* ptr) noexcept {
+	T value;
+	memcpy(&value, ptr, sizeof(T));
+	return value;
+}
+
+/**
+ * @return - mantissa * 10^exponent. Binance sends the prices and the quantities as the mantissa fields
+ *           sharing the exponent fields of the message.
+ */
+static inline double decimal(const int64_t mantissa, const int8_t exponent) noexcept {
+	static constexpr double Pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+	};
+	static constexpr int MaxExponent = sizeof(Pow10) / sizeof(*Pow10) - 1;
+
+	if(exponent < 0 && exponent >= -MaxExponent) {
+		return static_cast<double>(mantissa) / Pow10[-exponent];
+	}
+	if(exponent >= 0 && exponent <= MaxExponent) {
+		return static_cast<double>(mantissa) * Pow10[exponent];
+	}
+	return 0.;
+}
+
+/**
+ * messageHeader: blockLength uint16, templateId uint16, schemaId uint16, version uint16.
+ */
+struct MessageHeader {
+	static constexpr size_t Size = 8u;
+
+	uint16_t block_length;
+	uint16_t template_id;
+	uint16_t schema_id;
+	uint16_t version;
+
+	inline bool read(const char* data, const size_t len) noexcept {
+		if(len < Size) {
+			return false;
+		}
+		block_length = load<uint16_t>(data);
+		template_id = load<uint16_t>(data + 2u);
+		schema_id = load<uint16_t>(data + 4u);
+		version = load<uint16_t>(data + 6u);
+		return true;
+	}
+};
+
+/**
+ * groupSizeEncoding: blockLength uint16, numInGroup uint32.
+ */
+struct GroupSize {
+	static constexpr size_t Size = 6u;
+
+	static inline uint32_t count(const char* ptr) noexcept {
+		return load<uint32_t>(ptr + 2u);
+	}
+};
+
+/**
+ * groupSize16Encoding: blockLength uint16, numInGroup uint16.
+ */
+struct GroupSize16 {
+	static constexpr size_t Size = 4u;
+
+	static inline uint32_t count(const char* ptr) noexcept {
+		return load<uint16_t>(ptr + 2u);
+	}
+};
+
+/**
+ * A repeating group. The entry stride is the block length sent with the group,
+ * so the entries extended by a newer schema version are still walked correctly.
+ *
+ * Entry - a view constructible from (const char* block, int8_t price_exponent, int8_t qty_exponent).
+ */
+template <typename Entry>
+class Group {
+
+	const char* _data;  // The first entry.
+	uint16_t _block_length;
+	uint32_t _count;
+	int8_t _price_exponent;
+	int8_t _qty_exponent;
+
+public:
+
+	Group() noexcept : _data(nullptr), _block_length(0u), _count(0u), _price_exponent(0), _qty_exponent(0) {
+	}
+
+	/**
+	 * Wraps the group at 'ptr' and moves 'ptr' past it.
+	 * @return false - if the group runs over 'end' or its entries are shorter than Entry::BlockLength.
+	 */
+	template <typename Dimension>
+	bool wrap(const char*& ptr, const char* end, const int8_t price_exponent, const int8_t qty_exponent) noexcept {
+		if(end - ptr < static_cast<ptrdiff_t>(Dimension::Size)) {
+			return false;
+		}
+		_block_length = load<uint16_t>(ptr);
+		_count = Dimension::count(ptr);
+		_data = ptr + Dimension::Size;
+		_price_exponent = price_exponent;
+		_qty_exponent = qty_exponent;
+
+		const auto bytes = static_cast<uint64_t>(_block_length) * _count;
+		if(_block_length < Entry::BlockLength || static_cast<uint64_t>(end - _data) < bytes) {
+			return false;
+		}
+		ptr = _data + bytes;
+		return true;
+	}
+
+	inline size_t size() const noexcept {
+		return _count;
+	}
+
+	inline bool empty() const noexcept {
+		return _count == 0u;
+	}
+
+	inline Entry operator[](const size_t idx) const noexcept {
+		return Entry(_data + idx * _block_length, _price_exponent, _qty_exponent);
+	}
+};
+
+/**
+ * varString8: length uint8, varData. Wraps the string at 'ptr' and moves 'ptr' past it.
+ */
+static inline bool var_string8(const char*& ptr, const char* end, std::string_view& value) noexcept {
+	if(ptr >= end) {
+		return false;
+	}
+	const auto len = static_cast<uint8_t>(*ptr);
+	if(end - ptr - 1 < len) {
+		return false;
+	}
+	value = std::string_view(ptr + 1, len);
+	ptr += 1u + len;
+	return true;
+}
+
+}; // namespace sbe
+}; // namespace binance
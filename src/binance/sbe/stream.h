@@ -0,0 +1,393 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "Codec.h"
+#include "../types.h"
+
+namespace binance {
+namespace sbe {
+
+/**
+ * The SBE market data streams, schema 1 version 0:
+ * https://github.com/binance/binance-spot-api-docs/blob/master/sbe-market-data-streams.md
+ * https://github.com/binance/binance-spot-api-docs/blob/master/sbe/schemas/stream_1_0.xml
+ *
+ * The offsets below follow the schema. The root block is stepped over by the block length sent in the header,
+ * so a newer schema version appending the fields is still read. The prices and the quantities are the mantissas,
+ * see sbe::decimal(). The times are in microseconds.
+ */
+static constexpr uint16_t StreamSchemaId = 1u;
+static constexpr uint16_t StreamSchemaVersion = 0u;
+
+/**
+ * A trades group entry: id int64, price int64, qty int64, isBuyerMaker uint8.
+ */
+class Trade {
+	const char* _ptr;
+	int8_t _price_exponent;
+	int8_t _qty_exponent;
+
+public:
+	static constexpr uint16_t BlockLength = 25u;
+
+	Trade(const char* ptr, const int8_t price_exponent, const int8_t qty_exponent) noexcept :
+		_ptr(ptr),
+		_price_exponent(price_exponent),
+		_qty_exponent(qty_exponent) {
+	}
+
+	inline int64_t id() const noexcept {
+		return load<int64_t>(_ptr);
+	}
+
+	inline double price() const noexcept {
+		return decimal(load<int64_t>(_ptr + 8u), _price_exponent);
+	}
+
+	inline double qty() const noexcept {
+		return decimal(load<int64_t>(_ptr + 16u), _qty_exponent);
+	}
+
+	inline bool is_buyer_maker() const noexcept {
+		return _ptr[24u] != 0;
+	}
+};
+
+/**
+ * A bids or asks group entry: price int64, qty int64.
+ */
+class PriceLevel {
+	const char* _ptr;
+	int8_t _price_exponent;
+	int8_t _qty_exponent;
+
+public:
+	static constexpr uint16_t BlockLength = 16u;
+
+	PriceLevel(const char* ptr, const int8_t price_exponent, const int8_t qty_exponent) noexcept :
+		_ptr(ptr),
+		_price_exponent(price_exponent),
+		_qty_exponent(qty_exponent) {
+	}
+
+	inline double price() const noexcept {
+		return decimal(load<int64_t>(_ptr), _price_exponent);
+	}
+
+	inline double qty() const noexcept {
+		return decimal(load<int64_t>(_ptr + 8u), _qty_exponent);
+	}
+};
+
+/**
+ * <symbol>@trade
+ * eventTime int64, transactTime int64, priceExponent int8, qtyExponent int8, trades group, symbol varString8.
+ */
+class TradesEvent {
+	const char* _block;
+	Group<Trade> _trades;
+	std::string_view _symbol;
+
+public:
+	static constexpr uint16_t TemplateId = 10000u;
+	static constexpr uint16_t BlockLength = 18u;
+
+	bool wrap(const char* block, const char* end, const uint16_t block_length) noexcept {
+		_block = block;
+		const char* ptr = block + block_length;
+		return _trades.wrap<GroupSize>(ptr, end, price_exponent(), qty_exponent()) && var_string8(ptr, end, _symbol);
+	}
+
+	inline int64_t event_time_us() const noexcept {
+		return load<int64_t>(_block);
+	}
+
+	inline int64_t transact_time_us() const noexcept {
+		return load<int64_t>(_block + 8u);
+	}
+
+	inline int8_t price_exponent() const noexcept {
+		return load<int8_t>(_block + 16u);
+	}
+
+	inline int8_t qty_exponent() const noexcept {
+		return load<int8_t>(_block + 17u);
+	}
+
+	inline const Group<Trade>& trades() const noexcept {
+		return _trades;
+	}
+
+	inline std::string_view symbol() const noexcept {
+		return _symbol;
+	}
+};
+
+/**
+ * <symbol>@bestBidAsk
+ * eventTime int64, bookUpdateId int64, priceExponent int8, qtyExponent int8,
+ * bidPrice int64, bidQty int64, askPrice int64, askQty int64, symbol varString8.
+ */
+class BestBidAskEvent {
+	const char* _block;
+	std::string_view _symbol;
+
+public:
+	static constexpr uint16_t TemplateId = 10001u;
+	static constexpr uint16_t BlockLength = 50u;
+
+	bool wrap(const char* block, const char* end, const uint16_t block_length) noexcept {
+		_block = block;
+		const char* ptr = block + block_length;
+		return var_string8(ptr, end, _symbol);
+	}
+
+	inline int64_t event_time_us() const noexcept {
+		return load<int64_t>(_block);
+	}
+
+	inline int64_t book_update_id() const noexcept {
+		return load<int64_t>(_block + 8u);
+	}
+
+	inline int8_t price_exponent() const noexcept {
+		return load<int8_t>(_block + 16u);
+	}
+
+	inline int8_t qty_exponent() const noexcept {
+		return load<int8_t>(_block + 17u);
+	}
+
+	inline double bid_price() const noexcept {
+		return decimal(load<int64_t>(_block + 18u), price_exponent());
+	}
+
+	inline double bid_qty() const noexcept {
+		return decimal(load<int64_t>(_block + 26u), qty_exponent());
+	}
+
+	inline double ask_price() const noexcept {
+		return decimal(load<int64_t>(_block + 34u), price_exponent());
+	}
+
+	inline double ask_qty() const noexcept {
+		return decimal(load<int64_t>(_block + 42u), qty_exponent());
+	}
+
+	inline std::string_view symbol() const noexcept {
+		return _symbol;
+	}
+};
+
+/**
+ * <symbol>@depth20
+ * eventTime int64, bookUpdateId int64, priceExponent int8, qtyExponent int8, bids group16, asks group16,
+ * symbol varString8.
+ */
+class DepthSnapshotEvent {
+	const char* _block;
+	Group<PriceLevel> _bids;
+	Group<PriceLevel> _asks;
+	std::string_view _symbol;
+
+public:
+	static constexpr uint16_t TemplateId = 10002u;
+	static constexpr uint16_t BlockLength = 18u;
+
+	bool wrap(const char* block, const char* end, const uint16_t block_length) noexcept {
+		_block = block;
+		const char* ptr = block + block_length;
+		return _bids.wrap<GroupSize16>(ptr, end, price_exponent(), qty_exponent())
+		       && _asks.wrap<GroupSize16>(ptr, end, price_exponent(), qty_exponent())
+		       && var_string8(ptr, end, _symbol);
+	}
+
+	inline int64_t event_time_us() const noexcept {
+		return load<int64_t>(_block);
+	}
+
+	inline int64_t book_update_id() const noexcept {
+		return load<int64_t>(_block + 8u);
+	}
+
+	inline int8_t price_exponent() const noexcept {
+		return load<int8_t>(_block + 16u);
+	}
+
+	inline int8_t qty_exponent() const noexcept {
+		return load<int8_t>(_block + 17u);
+	}
+
+	inline const Group<PriceLevel>& bids() const noexcept {
+		return _bids;
+	}
+
+	inline const Group<PriceLevel>& asks() const noexcept {
+		return _asks;
+	}
+
+	inline std::string_view symbol() const noexcept {
+		return _symbol;
+	}
+};
+
+/**
+ * <symbol>@depth
+ * eventTime int64, firstBookUpdateId int64, lastBookUpdateId int64, priceExponent int8, qtyExponent int8,
+ * bids group16, asks group16, symbol varString8.
+ */
+class DepthDiffEvent {
+	const char* _block;
+	Group<PriceLevel> _bids;
+	Group<PriceLevel> _asks;
+	std::string_view _symbol;
+
+public:
+	static constexpr uint16_t TemplateId = 10003u;
+	static constexpr uint16_t BlockLength = 26u;
+
+	bool wrap(const char* block, const char* end, const uint16_t block_length) noexcept {
+		_block = block;
+		const char* ptr = block + block_length;
+		return _bids.wrap<GroupSize16>(ptr, end, price_exponent(), qty_exponent())
+		       && _asks.wrap<GroupSize16>(ptr, end, price_exponent(), qty_exponent())
+		       && var_string8(ptr, end, _symbol);
+	}
+
+	inline int64_t event_time_us() const noexcept {
+		return load<int64_t>(_block);
+	}
+
+	inline int64_t first_book_update_id() const noexcept {
+		return load<int64_t>(_block + 8u);
+	}
+
+	inline int64_t last_book_update_id() const noexcept {
+		return load<int64_t>(_block + 16u);
+	}
+
+	inline int8_t price_exponent() const noexcept {
+		return load<int8_t>(_block + 24u);
+	}
+
+	inline int8_t qty_exponent() const noexcept {
+		return load<int8_t>(_block + 25u);
+	}
+
+	inline const Group<PriceLevel>& bids() const noexcept {
+		return _bids;
+	}
+
+	inline const Group<PriceLevel>& asks() const noexcept {
+		return _asks;
+	}
+
+	inline std::string_view symbol() const noexcept {
+		return _symbol;
+	}
+};
+
+/**
+ * One received stream frame. wrap() checks the header and the bounds of every group and string once,
+ * the accessors of the event read the frame unchecked afterwards.
+ */
+class Frame {
+	MessageHeader _header;
+	TradesEvent _trades;
+	BestBidAskEvent _best_bid_ask;
+	DepthSnapshotEvent _depth_snapshot;
+	DepthDiffEvent _depth_diff;
+
+public:
+
+	/**
+	 * @return false - if the frame is not a known event of the stream schema or it is truncated.
+	 */
+	bool wrap(const char* data, const size_t len) noexcept {
+		if(not _header.read(data, len) || _header.schema_id != StreamSchemaId) {
+			return false;
+		}
+
+		const char* block = data + MessageHeader::Size;
+		const char* end = data + len;
+		if(static_cast<size_t>(end - block) < _header.block_length) {
+			return false;
+		}
+
+		switch(_header.template_id) {
+			case TradesEvent::TemplateId:
+				return _header.block_length >= TradesEvent::BlockLength && _trades.wrap(block, end, _header.block_length);
+			case BestBidAskEvent::TemplateId:
+				return _header.block_length >= BestBidAskEvent::BlockLength
+				       && _best_bid_ask.wrap(block, end, _header.block_length);
+			case DepthSnapshotEvent::TemplateId:
+				return _header.block_length >= DepthSnapshotEvent::BlockLength
+				       && _depth_snapshot.wrap(block, end, _header.block_length);
+			case DepthDiffEvent::TemplateId:
+				return _header.block_length >= DepthDiffEvent::BlockLength
+				       && _depth_diff.wrap(block, end, _header.block_length);
+			default:
+				return false;
+		}
+	}
+
+	inline uint16_t template_id() const noexcept {
+		return _header.template_id;
+	}
+
+	/**
+	 * The event of the frame; nullptr if the frame is another one.
+	 */
+	inline const TradesEvent* trades() const noexcept {
+		return _header.template_id == TradesEvent::TemplateId ? &_trades : nullptr;
+	}
+
+	inline const BestBidAskEvent* best_bid_ask() const noexcept {
+		return _header.template_id == BestBidAskEvent::TemplateId ? &_best_bid_ask : nullptr;
+	}
+
+	inline const DepthSnapshotEvent* depth_snapshot() const noexcept {
+		return _header.template_id == DepthSnapshotEvent::TemplateId ? &_depth_snapshot : nullptr;
+	}
+
+	inline const DepthDiffEvent* depth_diff() const noexcept {
+		return _header.template_id == DepthDiffEvent::TemplateId ? &_depth_diff : nullptr;
+	}
+
+	/**
+	 * All the events start with the event time.
+	 */
+	inline int64_t event_time_us() const noexcept {
+		switch(_header.template_id) {
+			case TradesEvent::TemplateId:
+				return _trades.event_time_us();
+			case BestBidAskEvent::TemplateId:
+				return _best_bid_ask.event_time_us();
+			case DepthSnapshotEvent::TemplateId:
+				return _depth_snapshot.event_time_us();
+			default:
+				return _depth_diff.event_time_us();
+		}
+	}
+
+	/**
+	 * @return - The monotonic key of the frame; the book update ID, the last trade ID of the trades.
+	 */
+	UInteger seq() const noexcept {
+		switch(_header.template_id) {
+			case TradesEvent::TemplateId:
+				return _trades.trades().empty() ? 0u : _trades.trades()[_trades.trades().size() - 1u].id();
+			case BestBidAskEvent::TemplateId:
+				return _best_bid_ask.book_update_id();
+			case DepthSnapshotEvent::TemplateId:
+				return _depth_snapshot.book_update_id();
+			default:
+				return _depth_diff.last_book_update_id();
+		}
+	}
+};
+
+}; // namespace sbe
+}; // namespace binance
@@ -1,29 +1,163 @@
 #pragma once
 
 #include <map>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <poll.h>
 #include <jsoncpp/json/json.h>
 #include <libwebsockets.h>
 
 #include "../../Log.h"
 #include "../../Config.h"
 #include "../../Utils.h"
+#include "../../Reactor.h"
+#include "../../metrics/Metrics.h"
+#include "../types.h"
+#include "../Signer.h"
+#include "../rest/api.h"
+#include "../sbe/stream.h"
+#include "../../parser/Scanner.h"
 
 namespace binance {
 namespace ws {
 
 class Connector {
+public:
+
+	// The event consumer callback reading the frame text itself, e.g. with parser::Scanner. The text is valid during the call only.
+	using TextCallBack_t = int (*)(void* instance, std::string_view text);
+
+	// The SBE event consumer callback. The frame is valid during the call only.
+	using SbeCallBack_t = int (*)(void* instance, const sbe::Frame& frame);
+
+	enum class StreamState : unsigned {
+		Live,  // The stream delivers frames again.
+		Stale  // No frames have been delivered for Config::WSStaleTimeoutMS.
+	};
+
+	// The stream health consumer callback.
+	using StateCallBack_t = void (*)(void* instance, StreamState state);
+
+	/**
+	 * The WebSocket API response consumer callback.
+	 * @param status - The HTTP-like status of the response, 200 on success.
+	 *                 Zero if no response has come, the outcome of the request is unknown then.
+	 * @param result - The 'result' member on success, the 'error' one otherwise.
+	 */
+	using ApiCallBack_t = void (*)(void* instance, uint64_t id, int status, const Json::Value& result);
+
+	/**
+	 * Per-endpoint arbitration statistics.
+	 * The latency is the local wall clock minus the exchange event time, so it includes the clocks offset
+	 * which is the same for all the endpoints.
+	 */
+	struct EndpointStats {
+		size_t frames;      // All the frames received.
+		size_t wins;        // The frames delivered to the consumer, i.e. arrived first.
+		size_t duplicates;  // The frames dropped since another endpoint has delivered them first.
+		size_t reconnects;  // The established sessions lost, the failed connection attempts are not counted.
+		int64_t latency_min_ms;
+		int64_t latency_max_ms;
+		int64_t latency_sum_ms;
+		size_t latency_nb;
+	};
+
+	struct Endpoint {
+		std::string host;
+		int port;
+		EndpointStats stats;
+	};
+
+private:
 
-	// The event consumer callback.
-	using CallBack_t = int (*)(void* instance, const Json::Value& value);
+	struct Stream;
+	struct Api;
 
-	struct CallBackRecord {
-		CallBack_t callback;
+	enum class LinkState : unsigned {
+		Backoff,     // Waiting for the next connection attempt.
+		Connecting,  // The connection attempt is in progress.
+		Established  // The WebSocket session is up.
+	};
+
+	/**
+	 * One physical LWS connection. The link is used as the LWS opaque user data,
+	 * so it must keep its address for the whole lifetime of the connector.
+	 */
+	struct Link {
+		Connector* owner;
+		Stream* stream;     // Either the stream or the API session is served.
+		Api* api;
+		Endpoint* endpoint;
+		lws* wsi;
+		LinkState state;
+		unsigned backoff_ms;
+		uint64_t next_attempt_ms;
+		uint64_t established_ms;
+		uint64_t last_rx_ms;
+		uint64_t last_ping_ms;
+		uint64_t last_pong_ms;
+		bool ping_pending;
+		std::string message;  // The fragments received of a message not complete yet.
+	};
+
+	/**
+	 * One subscribed stream served by a primary link and Config::WSStandbyLinks hot-standby ones per each endpoint.
+	 * The first copy of a frame wins, the duplicates coming over the other links are dropped.
+	 */
+	struct Stream {
+		std::string path;
+		TextCallBack_t text_callback;
+		SbeCallBack_t sbe_callback;    // Set for an SBE stream instead of the text one.
+		StateCallBack_t state_callback;
+		void* instance;
+		std::vector<std::unique_ptr<Link>> links;
+		uint64_t last_rx_ms;
+		UInteger last_seq;  // The arbitration key of the last delivered frame.
+		bool stale;
+		metrics::Counter& frames;          // Received over all the links, the duplicates included.
+		metrics::Counter& parse_failures;
+		metrics::Counter& rejects;         // Returned as an error by the consumer.
+	};
+
+	struct Pending {
+		ApiCallBack_t callback;
 		void* instance;
+		uint64_t sent_ms;
+	};
+
+	/**
+	 * The WebSocket API session. The requests are correlated with the responses by the 'id' member.
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/web-socket-api.md
+	 */
+	struct Api {
+		std::string path;
+		std::string api_key;
+		Signer signer;
+		Endpoint endpoint;
+		std::unique_ptr<Link> link;
+		std::deque<std::string> outbox;        // The requests waiting for the socket to get writable.
+		std::map<uint64_t, Pending> pending;   // The requests waiting for the response.
+		std::vector<unsigned char> tx_buffer;
+		uint64_t next_id;
 	};
 
 	lws_protocols _protocols[Config::WSProtocols_nb + 1u /*Termination item.*/];
 	lws_context* _context;
-	std::map<lws*, CallBackRecord> _handles;
+	const unsigned _standby_links;
+	std::vector<std::unique_ptr<Endpoint>> _endpoints;
+	std::unique_ptr<Endpoint> _sbe_endpoint;  // The SBE streams are served by another host. Optional.
+	std::string _sbe_api_key;
+	std::vector<std::unique_ptr<Stream>> _streams;
+	std::unique_ptr<Api> _api;  // Optional.
+
+	Reactor* _reactor;       // The external event loop, LWS polls on its own if none. Optional.
+	int _supervise_timer;
+
+	FILE* _record;       // The delivered frames capture. Optional.
+	FILE* _replay;       // The frames source replacing the network. Optional.
+	bool _replay_done;
 
 public:
 
@@ -36,7 +170,33 @@ public:
 	Connector(Connector&&) = delete;
 	Connector& operator=(Connector&&) = delete;
 
-	Connector() noexcept : _context(nullptr) {
+	/**
+	 * @param endpoints - 'host:port' items to subscribe every stream on. Config::BinanceWsHost if empty.
+	 * @param standby_links - The number of hot-standby duplicate connections opened for each stream and endpoint.
+	 */
+	explicit Connector(
+		const std::vector<std::string>& endpoints = {}, unsigned standby_links = Config::WSStandbyLinks
+	                  ) noexcept :
+		_context(nullptr),
+		_standby_links(standby_links),
+		_reactor(nullptr),
+		_supervise_timer(-1),
+		_record(nullptr),
+		_replay(nullptr),
+		_replay_done(false) {
+
+		for(const auto& item : endpoints) {
+			const auto colon = item.rfind(':');
+			int port = Config::BinanceWsPort;
+			if(colon != std::string::npos) {
+				port = std::atoi(item.c_str() + colon + 1u);
+			}
+			_endpoints.emplace_back(new Endpoint{item.substr(0, colon), port, EndpointStats()});
+		}
+
+		if(_endpoints.empty()) {
+			_endpoints.emplace_back(new Endpoint{Config::BinanceWsHost, Config::BinanceWsPort, EndpointStats()});
+		}
 
 		size_t idx;
 		for(idx = 0; idx < Config::WSProtocols_nb; ++idx) {
@@ -59,11 +219,41 @@ public:
 
 
 	~Connector() noexcept {
+		// The consumers may be gone by now, so closing the API session must not call them back.
+		if(_api) {
+			_api->outbox.clear();
+			_api->pending.clear();
+		}
 		lws_context_destroy(_context);
+		if(_reactor) {
+			_reactor->remove(_supervise_timer);
+		}
+		if(_record) {
+			fclose(_record);
+		}
+		if(_replay) {
+			fclose(_replay);
+		}
 		LOG_DEBUG("binance::ws::~Connector()\n");
 	}
 
 
+	/**
+	 * Makes LWS use the reactor instead of its own poll loop: the LWS sockets are watched by the reactor
+	 * and the connections are supervised on its timer. MUST be called before init().
+	 * The reactor MUST outlive the connector.
+	 */
+	bool attach(Reactor& reactor) noexcept {
+		LOG_DEBUG("binance::ws::Connector::attach()\n");
+		_supervise_timer = reactor.add_timer(cb_supervise, this);
+		if(_supervise_timer < 0 || not reactor.arm_timer(_supervise_timer, Config::WSSuperviseIntervalMS,
+		                                                 Config::WSSuperviseIntervalMS)) {
+			return false;
+		}
+		_reactor = &reactor;
+		return true;
+	}
+
 	/**
 	 * Opens the socket instance. No one method is allowed to call before getting the instance opened.
 	 * @return false - in case of any errors.
@@ -81,7 +271,8 @@ public:
 			.protocols = _protocols,
 			.gid = -1,
 			.uid = -1,
-			.options = LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT
+			.options = LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT,
+			.user = this  // The poll callbacks may come with no link yet.
 		};
 
 		_context = lws_create_context(&info);
@@ -94,99 +285,864 @@ public:
 		return result;
 	}
 
-	bool register_ticker(CallBack_t callback, void* instance, const std::string& pair) noexcept {
+	/**
+	 * Opens the instance in the offline mode; the frames are read from the capture instead of the network.
+	 * One frame is delivered per service() call. Used to replay a session, e.g. for PGO training.
+	 * @param path - A capture written by record().
+	 */
+	bool init_replay(const char* path) noexcept {
+		LOG_DEBUG("binance::ws::Connector::init_replay('%s')\n", path);
+		_replay = fopen(path, "r");
+		if(_replay == nullptr) {
+			LOG_ERROR("Unable to open the capture '%s'.\n", path);
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Appends every delivered frame to the capture as a '<stream path> <payload>' line.
+	 */
+	bool record(const char* path) noexcept {
+		LOG_DEBUG("binance::ws::Connector::record('%s')\n", path);
+		_record = fopen(path, "a");
+		if(_record == nullptr) {
+			LOG_ERROR("Unable to open the capture '%s'.\n", path);
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @return true - if the capture being replayed is over.
+	 */
+	inline bool replay_done() const noexcept {
+		return _replay_done;
+	}
+
+	/**
+	 * @return - The event loop attached, nullptr if LWS polls on its own.
+	 */
+	inline Reactor* reactor() const noexcept {
+		return _reactor;
+	}
+
+	/**
+	 * The ticker delivered as the frame text, no JSON DOM is built.
+	 * @param state_callback - Optional. Notified when the stream gets stale and when it is live again.
+	 */
+	bool register_ticker(
+		TextCallBack_t callback, void* instance, const std::string& pair, StateCallBack_t state_callback = nullptr
+	                    ) noexcept {
 		std::string url = "/ws/" + pair + std::string("@ticker");
 		Utils::string_to_lower(url);
 
 		LOG_DEBUG("binance::ws::Connector::register_ticker(url='%s')\n", url.c_str());
 
-		return register_callback(callback, instance, url.c_str());
+		return register_callback(callback, nullptr, state_callback, instance, url.c_str());
 	}
 
 	/**
-	 * Enters the LWS service loop.
+	 * Subscribes any JSON stream of the pair, delivered as the frame text.
+	 * @param stream - The stream name after '@', e.g. 'trade' or 'depth@100ms'.
+	 */
+	bool register_stream(
+		TextCallBack_t callback, void* instance, const std::string& pair, const char* stream,
+		StateCallBack_t state_callback = nullptr
+	                    ) noexcept {
+		std::string url = "/ws/" + pair;
+		Utils::string_to_lower(url);
+		url.append("@");
+		url.append(stream);
+
+		LOG_DEBUG("binance::ws::Connector::register_stream(url='%s')\n", url.c_str());
+
+		return register_callback(callback, nullptr, state_callback, instance, url.c_str());
+	}
+
+	/**
+	 * Enables the SBE market data streams. The SBE endpoint requires an API key, an Ed25519 one.
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/sbe-market-data-streams.md
+	 */
+	void init_sbe(
+		std::string api_key, const char* host = Config::BinanceWsSbeHost, int port = Config::BinanceWsSbePort
+	             ) noexcept {
+		LOG_DEBUG("binance::ws::Connector::init_sbe('%s:%d')\n", host, port);
+		_sbe_endpoint.reset(new Endpoint{host, port, EndpointStats()});
+		_sbe_api_key = std::move(api_key);
+	}
+
+	/**
+	 * Subscribes an SBE stream of the pair, the frames are decoded in place.
+	 * @param stream - Either 'trade', 'bestBidAsk', 'depth' or 'depth20'.
+	 */
+	bool register_sbe(
+		SbeCallBack_t callback, void* instance, const std::string& pair, const char* stream,
+		StateCallBack_t state_callback = nullptr
+	                 ) noexcept {
+		std::string url = "/ws/" + pair;
+		Utils::string_to_lower(url);
+		url.append("@");
+		url.append(stream);
+
+		LOG_DEBUG("binance::ws::Connector::register_sbe(url='%s')\n", url.c_str());
+
+		if(not _sbe_endpoint) {
+			LOG_ERROR("binance::ws::Connector::register_sbe() the SBE streams are not enabled.\n");
+			return false;
+		}
+		return register_callback(nullptr, callback, state_callback, instance, url.c_str());
+	}
+
+	/**
+	 * Opens the WebSocket API session for the order entry. The session is kept connected by the supervisor.
+	 * MUST be called after init().
+	 */
+	bool init_api(
+		std::string api_key, std::string secret_key, const char* host = Config::BinanceWsApiHost,
+		int port = Config::BinanceWsApiPort
+	             ) noexcept {
+		LOG_DEBUG("binance::ws::Connector::init_api('%s:%d')\n", host, port);
+		if(_context == nullptr) {
+			LOG_ERROR("binance::ws::Connector::init_api() no LWS context.\n");
+			return false;
+		}
+
+		const auto now = Utils::time_now_ms();
+		_api.reset(new Api{
+			Config::BinanceWsApiPath, std::move(api_key), Signer(std::move(secret_key)), Endpoint{host, port, EndpointStats()},
+			nullptr, {}, {}, {}, 1u
+		});
+		_api->link.reset(new Link{this, nullptr, _api.get(), &_api->endpoint, nullptr, LinkState::Backoff,
+		                          Config::WSReconnectMinMS, now, 0u, 0u, 0u, 0u, false, {}});
+		connect(*_api->link, now);
+		return true;
+	}
+
+	/**
+	 * @return true - if the WebSocket API session is up, so a request is sent right away.
+	 */
+	inline bool api_ready() const noexcept {
+		return _api && _api->link->state == LinkState::Established;
+	}
+
+	/**
+	 * Sends a WebSocket API request.
+	 * @param params - The request parameters. A signed request gets 'apiKey', 'timestamp' and 'signature' added.
+	 * @return - The ID of the request, zero if the request can not be sent.
+	 */
+	uint64_t api_call(
+		const char* method, std::vector<std::pair<std::string, std::string>> params, const bool is_signed,
+		ApiCallBack_t callback, void* instance
+	                 ) noexcept {
+		if(not api_ready()) {
+			LOG_ERROR("binance::ws::Connector::api_call('%s') the session is not established.\n", method);
+			return 0u;
+		}
+
+		auto& api = *_api;
+		const auto id = api.next_id++;
+
+		Json::Value request;
+		request["id"] = Json::UInt64(id);
+		request["method"] = method;
+		Json::Value& json_params = request["params"];
+
+		if(is_signed) {
+			params.emplace_back("apiKey", api.api_key);
+			params.emplace_back("timestamp", std::to_string(Utils::time_wall_ms()));
+
+			// The payload is the parameters sorted by the name.
+			std::sort(params.begin(), params.end());
+			std::string payload;
+			for(const auto& item : params) {
+				payload.append(payload.empty() ? "" : "&");
+				payload.append(item.first + "=" + item.second);
+			}
+			params.emplace_back("signature", api.signer.sign(payload));
+		}
+
+		for(const auto& item : params) {
+			json_params[item.first] = item.second;
+		}
+
+		Json::FastWriter writer;
+		api.outbox.emplace_back(writer.write(request));
+		api.pending.emplace(id, Pending{callback, instance, Utils::time_now_ms()});
+		lws_callback_on_writable(api.link->wsi);
+		return id;
+	}
+
+	/**
+	 * Drops the requests in flight of the consumer without calling it back, e.g. the one being destroyed.
+	 * The responses to them are reported as unknown then.
+	 */
+	void api_forget(const void* instance) noexcept {
+		if(not _api) {
+			return;
+		}
+		for(auto it = _api->pending.begin(); it != _api->pending.end();) {
+			it = (it->second.instance == instance) ? _api->pending.erase(it) : std::next(it);
+		}
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/web-socket-api.md#place-new-order-trade
+	 */
+	uint64_t order_place(const rest::OrderRequest& order, ApiCallBack_t callback, void* instance) noexcept {
+		std::vector<std::pair<std::string, std::string>> params;
+		order.for_each_param([&params](const char* key, const std::string& value) {
+			params.emplace_back(key, value);
+		});
+		params.emplace_back("newOrderRespType", "FULL");
+		return api_call("order.place", std::move(params), true, callback, instance);
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/web-socket-api.md#cancel-order-trade
+	 */
+	uint64_t order_cancel(
+		const std::string& symbol, const std::string& client_order_id, ApiCallBack_t callback, void* instance
+	                     ) noexcept {
+		return api_call("order.cancel", {{"symbol", symbol}, {"origClientOrderId", client_order_id}}, true, callback,
+		                instance);
+	}
+
+	/**
+	 * https://github.com/binance/binance-spot-api-docs/blob/master/web-socket-api.md#account-information-user_data
+	 */
+	uint64_t account_status(ApiCallBack_t callback, void* instance) noexcept {
+		return api_call("account.status", {}, true, callback, instance);
+	}
+
+	inline const std::vector<std::unique_ptr<Endpoint>>& endpoints() const noexcept {
+		return _endpoints;
+	}
+
+	void dump_stats() const noexcept {
+		LOG_INFO("==== WebSocket endpoints ====\n");
+		for(const auto& ep : _endpoints) {
+			dump_stats(*ep);
+		}
+		if(_sbe_endpoint) {
+			dump_stats(*_sbe_endpoint);
+		}
+	}
+
+	/**
+	 * Enters the LWS service loop and supervises the connections afterwards.
+	 * If attached to a reactor, runs the reactor once instead; it returns as soon as any event is handled.
 	 */
 	inline void service() noexcept {
+		if(_replay) {
+			replay_next();
+			return;
+		}
+		if(_reactor) {
+			_reactor->run_once();
+			return;
+		}
 		lws_service(_context, Config::WSServiceTimeoutMS);
+		supervise(Utils::time_now_ms());
 	}
 
 private:
 
-	bool register_callback(CallBack_t callback, void* instance, const char* path) noexcept {
-		bool result = true;
+	bool register_callback(
+		TextCallBack_t text_callback, SbeCallBack_t sbe_callback, StateCallBack_t state_callback,
+		void* instance, const char* path
+	                      ) noexcept {
+		const auto now = Utils::time_now_ms();
+
+		auto& reg = metrics::Registry::instance();
+		const auto labels = metrics::label("stream", path);
+		std::unique_ptr<Stream> stream(new Stream{path, text_callback, sbe_callback, state_callback, instance, {}, now, 0u, false,
+		                                          reg.counter("bintest_ws_frames_total", "The WebSocket frames received.", labels),
+		                                          reg.counter("bintest_ws_parse_failures_total", "The WebSocket frames failed to parse.", labels),
+		                                          reg.counter("bintest_ws_rejects_total", "The WebSocket events rejected by the consumer.", labels)});
+		const auto add_links = [&](Endpoint* endpoint) {
+			for(unsigned idx = 0; idx <= _standby_links; ++idx) {
+				stream->links.emplace_back(new Link{this, stream.get(), nullptr, endpoint, nullptr, LinkState::Backoff,
+				                                    Config::WSReconnectMinMS, now, 0u, 0u, 0u, 0u, false, {}});
+			}
+		};
+		if(sbe_callback) {
+			add_links(_sbe_endpoint.get());
+		} else {
+			for(auto& endpoint : _endpoints) {
+				add_links(endpoint.get());
+			}
+		}
+
+		// At least the primary link has to be connected right away, the rest is up to the supervisor.
+		bool result = (_replay != nullptr);
+		for(auto& link : stream->links) {
+			if(_replay == nullptr) {
+				result |= connect(*link, now);
+			}
+		}
 
+		if(result) {
+			_streams.emplace_back(std::move(stream));
+		} else {
+			LOG_ERROR("Unable to create an LWS connection.");
+		}
+		return result;
+	}
+
+	bool connect(Link& link, const uint64_t now) noexcept {
 		lws_client_connect_info ccinfo;
 		memset(&ccinfo, 0, sizeof(ccinfo));
 
 		ccinfo = {
 			.context = _context,
-			.address = Config::BinanceWsHost,
-			.port = Config::BinanceWsPort,
+			.address = link.endpoint->host.c_str(),
+			.port = link.endpoint->port,
 			.ssl_connection = LCCSCF_USE_SSL | LCCSCF_ALLOW_SELFSIGNED | LCCSCF_SKIP_SERVER_CERT_HOSTNAME_CHECK,
-			.path = path,
+			.path = path_of(link).c_str(),
 			.host = lws_canonical_hostname(_context),
 			.origin = "origin",
 			.protocol = _protocols[0].name,
-			.opaque_user_data = this
+			.opaque_user_data = &link
 		};
+		ccinfo.pwsi = &link.wsi;  // LWS may call back before returning the handle.
+
+		link.state = LinkState::Connecting;
+		link.ping_pending = false;
+		link.message.clear();
+
+		if(lws_client_connect_via_info(&ccinfo) == nullptr) {
+			if(link.state == LinkState::Connecting) {
+				schedule_reconnect(link, now);
+			}
+			return false;
+		}
+		return true;
+	}
+
+	void schedule_reconnect(Link& link, const uint64_t now) noexcept {
+		if(link.wsi) {
+			lws_set_opaque_user_data(link.wsi, nullptr);
+			link.wsi = nullptr;
+		}
+		if(link.state == LinkState::Established) {
+			link.endpoint->stats.reconnects++;
+		}
+		link.state = LinkState::Backoff;
+		link.next_attempt_ms = now + link.backoff_ms;
+		LOG_DEBUG("binance::ws::Connector reconnecting '%s' to '%s:%d' in %u ms\n", path_of(link).c_str(),
+		          link.endpoint->host.c_str(), link.endpoint->port, link.backoff_ms);
+		link.backoff_ms = std::min(link.backoff_ms * 2u, Config::WSReconnectMaxMS);
+	}
+
+	static inline const std::string& path_of(const Link& link) noexcept {
+		return link.stream ? link.stream->path : link.api->path;
+	}
+
+	/**
+	 * Drops the link asynchronously. LWS reports the closing and the link gets rescheduled.
+	 */
+	inline void drop(Link& link) noexcept {
+		lws_set_timeout(link.wsi, PENDING_TIMEOUT_USER_OK, LWS_TO_KILL_ASYNC);
+	}
 
-		lws* connection = lws_client_connect_via_info(&ccinfo);
-		if(connection) {
-			_handles.insert(std::make_pair(connection, CallBackRecord{callback, instance}));
+	/**
+	 * Reconnects the broken links, checks the links liveness and the streams staleness.
+	 */
+	void supervise(const uint64_t now) noexcept {
+		if(_api) {
+			supervise_api(*_api, now);
+		}
+
+		for(auto& stream : _streams) {
+
+			size_t links_live = 0;
+			for(auto& link : stream->links) {
+				links_live += (link->state == LinkState::Established);
+			}
+
+			for(auto& link : stream->links) {
+				switch(link->state) {
+					case LinkState::Backoff:
+						if(now >= link->next_attempt_ms) {
+							connect(*link, now);
+						}
+						break;
+
+					case LinkState::Connecting:
+						break;
+
+					case LinkState::Established:
+						if(link->last_ping_ms > link->last_pong_ms && now - link->last_ping_ms > Config::WSPongTimeoutMS) {
+							LOG_ERROR("binance::ws::Connector no pong over '%s'\n", stream->path.c_str());
+							drop(*link);
+						} else if(now - link->last_rx_ms > 2u * Config::WSStaleTimeoutMS) {
+							LOG_ERROR("binance::ws::Connector a silent link over '%s'\n", stream->path.c_str());
+							drop(*link);
+						} else if(now - link->established_ms > Config::WSMaxSessionAgeMS && links_live > 1u) {
+							// Rotate the aged session while the other links keep the stream alive.
+							LOG_DEBUG("binance::ws::Connector rotating an aged link over '%s'\n", stream->path.c_str());
+							links_live--;
+							drop(*link);
+						} else if(not link->ping_pending && now - link->last_ping_ms > Config::WSPingIntervalMS) {
+							link->ping_pending = true;
+							lws_callback_on_writable(link->wsi);
+						}
+						break;
+				}
+			}
+
+			if(not stream->stale && now - stream->last_rx_ms > Config::WSStaleTimeoutMS) {
+				stream->stale = true;
+				LOG_ERROR("binance::ws::Connector stream '%s' is stale\n", stream->path.c_str());
+				if(stream->state_callback) {
+					stream->state_callback(stream->instance, StreamState::Stale);
+				}
+			}
+		}
+	}
+
+	/**
+	 * The API session is idle most of the time, so the silence is not a failure unlike the streams.
+	 */
+	void supervise_api(Api& api, const uint64_t now) noexcept {
+		auto& link = *api.link;
+		switch(link.state) {
+			case LinkState::Backoff:
+				if(now >= link.next_attempt_ms) {
+					connect(link, now);
+				}
+				break;
+
+			case LinkState::Connecting:
+				break;
+
+			case LinkState::Established:
+				if(link.last_ping_ms > link.last_pong_ms && now - link.last_ping_ms > Config::WSPongTimeoutMS) {
+					LOG_ERROR("binance::ws::Connector no pong over '%s'\n", api.path.c_str());
+					drop(link);
+				} else if(not link.ping_pending && now - link.last_ping_ms > Config::WSPingIntervalMS) {
+					link.ping_pending = true;
+					lws_callback_on_writable(link.wsi);
+				}
+				break;
+		}
+
+		for(auto it = api.pending.begin(); it != api.pending.end();) {
+			if(now - it->second.sent_ms > Config::WSApiTimeoutMS) {
+				LOG_ERROR("binance::ws::Connector request %lu has timed out\n", static_cast<unsigned long>(it->first));
+				const auto pending = it->second;
+				const auto id = it->first;
+				it = api.pending.erase(it);
+				pending.callback(pending.instance, id, 0, Json::Value());
+			} else {
+				++it;
+			}
+		}
+	}
+
+	/**
+	 * Fails all the requests in flight, their outcome is unknown.
+	 */
+	static void api_fail_all(Api& api) noexcept {
+		api.outbox.clear();
+		auto pending = std::move(api.pending);
+		api.pending.clear();
+		for(const auto& item : pending) {
+			item.second.callback(item.second.instance, item.first, 0, Json::Value());
+		}
+	}
+
+	void api_deliver(Api& api, const char* input, size_t len) noexcept {
+		api.link->last_rx_ms = Utils::time_now_ms();
+		api.link->backoff_ms = Config::WSReconnectMinMS;
+
+		Json::Reader reader;
+		Json::Value json;
+		if(not reader.parse(input, input + len, json) || not json.isMember("id")) {
+			LOG_ERROR("binance::ws::Connector unexpected API response '%.*s'\n", static_cast<int>(len), input);
+			return;
+		}
+
+		const auto it = api.pending.find(json["id"].asUInt64());
+		if(it == api.pending.end()) {
+			LOG_ERROR("binance::ws::Connector API response to an unknown request '%.*s'\n", static_cast<int>(len), input);
+			return;
+		}
+
+		const auto pending = it->second;
+		const auto id = it->first;
+		api.pending.erase(it);
+
+		const int status = json["status"].asInt();
+		pending.callback(pending.instance, id, status, status == 200 ? json["result"] : json["error"]);
+	}
+
+	/**
+	 * Writes the next queued request, one per the writable callback.
+	 */
+	int api_write(Api& api) noexcept {
+		if(api.outbox.empty()) {
+			return EXIT_SUCCESS;
+		}
+
+		const auto& message = api.outbox.front();
+		api.tx_buffer.resize(LWS_PRE + message.size());
+		memcpy(api.tx_buffer.data() + LWS_PRE, message.data(), message.size());
+		const auto written = lws_write(api.link->wsi, api.tx_buffer.data() + LWS_PRE, message.size(), LWS_WRITE_TEXT);
+		api.outbox.pop_front();
+
+		if(written < static_cast<int>(message.size())) {
+			return -1;
+		}
+
+		if(not api.outbox.empty()) {
+			lws_callback_on_writable(api.link->wsi);
+		}
+		return EXIT_SUCCESS;
+	}
+
+	static void dump_stats(const Endpoint& ep) noexcept {
+		const auto& st = ep.stats;
+		LOG_INFO("  %s:%d", ep.host.c_str(), ep.port);
+		LOG_PLAIN(" frames=%zu wins=%zu duplicates=%zu reconnects=%zu", st.frames, st.wins, st.duplicates, st.reconnects);
+		if(st.latency_nb) {
+			LOG_PLAIN(" latency-ms min=%ld avg=%.1f max=%ld", static_cast<long>(st.latency_min_ms),
+			          static_cast<double>(st.latency_sum_ms) / st.latency_nb, static_cast<long>(st.latency_max_ms));
+		}
+		LOG_PLAIN("\n");
+	}
+
+	/**
+	 * Also observed by the process wide histogram, the market data delay a backtest draws from, see sim::Latency.
+	 * @param event_ms - The exchange event time, zero if the frame has none.
+	 */
+	static void account_latency(EndpointStats& stats, const int64_t event_ms) noexcept {
+		if(event_ms) {
+			static auto& hist = metrics::Registry::instance().histogram(
+				"bintest_ws_latency_seconds", "The market data delay behind the exchange event time.");
+			const auto latency = static_cast<int64_t>(Utils::time_wall_ms()) - event_ms;
+			hist.observe(static_cast<double>(std::max(latency, int64_t(0))) / 1000.);
+			if(stats.latency_nb == 0u) {
+				stats.latency_min_ms = latency;
+				stats.latency_max_ms = latency;
+			} else {
+				stats.latency_min_ms = std::min(stats.latency_min_ms, latency);
+				stats.latency_max_ms = std::max(stats.latency_max_ms, latency);
+			}
+			stats.latency_sum_ms += latency;
+			stats.latency_nb++;
+		}
+	}
+
+	/**
+	 * Only the arbitration keys are scanned before the consumer reads the text, no JSON DOM is built.
+	 */
+	void deliver_text(Link& link, const char* input, size_t len) noexcept {
+		auto& stream = *link.stream;
+		received(link);
+
+		const std::string_view text(input, len);
+		UInteger seq = 0u;
+		int64_t event_ms = 0;
+		if(not frame_keys(text, seq, event_ms)) {
+			stream.parse_failures.inc();
+			LOG_ERROR("JSON scanning failure. '%.*s'", static_cast<int>(len), input);
+			return;
+		}
+
+		if(not admit(link, seq, event_ms)) {
+			return;
+		}
+
+		if(_record) {
+			fprintf(_record, "%s %.*s\n", stream.path.c_str(), static_cast<int>(len), input);
+		}
+
+		const auto err = stream.text_callback(stream.instance, text);
+		if(err) {
+			stream.rejects.inc();
+			LOG_ERROR("The consumer rejects the event '%.*s' err=%d", static_cast<int>(len), input, err);
+		}
+	}
+
+	/**
+	 * Reads the top level 'u', 't' and 'E' members; the arbitration key is the update ID if the stream has one.
+	 * The trade ID orders the trade stream, several trades may share an event time.
+	 */
+	static bool frame_keys(std::string_view text, UInteger& seq, int64_t& event_ms) noexcept {
+		parser::Scanner scan(text);
+		std::string_view key;
+		UInteger update_id = 0u;
+		UInteger trade_id = 0u;
+		if(not scan.begin_object()) {
+			return false;
+		}
+		while(scan.member(key)) {
+			if(key == "u") {
+				scan.integer(update_id);
+			} else if(key == "t") {
+				scan.integer(trade_id);
+			} else if(key == "E") {
+				scan.integer(event_ms);
+			} else {
+				scan.skip();
+			}
+		}
+		seq = update_id ? update_id : (trade_id ? trade_id : static_cast<UInteger>(event_ms));
+		return scan.ok();
+	}
+
+	/**
+	 * The binary counterpart of deliver_text(); the frame is decoded in place, nothing is parsed upfront.
+	 */
+	void deliver_sbe(Link& link, const char* input, size_t len) noexcept {
+		auto& stream = *link.stream;
+		received(link);
+
+		sbe::Frame frame;
+		if(not frame.wrap(input, len)) {
+			stream.parse_failures.inc();
+			LOG_ERROR("SBE decoding failure. stream='%s' len=%zu\n", stream.path.c_str(), len);
+			return;
+		}
+
+		if(not admit(link, frame.seq(), frame.event_time_us() / 1000)) {
+			return;
+		}
+
+		if(_record) {
+			fprintf(_record, "%s %s\n", stream.path.c_str(), Utils::bin_to_hex(input, len).c_str());
+		}
+
+		const auto err = stream.sbe_callback(stream.instance, frame);
+		if(err) {
+			stream.rejects.inc();
+			LOG_ERROR("The consumer rejects the SBE event %u of '%s' err=%d\n", frame.template_id(), stream.path.c_str(), err);
+		}
+	}
+
+	inline void received(Link& link) noexcept {
+		link.last_rx_ms = Utils::time_now_ms();
+		link.backoff_ms = Config::WSReconnectMinMS;
+		link.stream->frames.inc();
+	}
+
+	/**
+	 * Accounts the frame decoded and arbitrates it against the other links of the stream.
+	 * @return false - if the frame is a duplicate, another link has delivered it first.
+	 */
+	bool admit(Link& link, const UInteger seq, const int64_t event_ms) noexcept {
+		auto& stream = *link.stream;
+		auto& stats = link.endpoint->stats;
+		stats.frames++;
+		account_latency(stats, event_ms);
+
+		// Arbitration; the first arrival wins.
+		if(seq) {
+			if(seq <= stream.last_seq) {
+				stats.duplicates++;
+				return false;
+			}
+			stream.last_seq = seq;
+		}
+		stats.wins++;
+
+		stream.last_rx_ms = link.last_rx_ms;
+		if(stream.stale) {
+			stream.stale = false;
+			LOG_DEBUG("binance::ws::Connector stream '%s' is live again\n", stream.path.c_str());
+			if(stream.state_callback) {
+				stream.state_callback(stream.instance, StreamState::Live);
+			}
+		}
+		return true;
+	}
+
+	void replay_next() noexcept {
+		char* line = nullptr;
+		size_t cap = 0;
+		const auto read = getline(&line, &cap, _replay);
+
+		if(read <= 0) {
+			_replay_done = true;
 		} else {
-			LOG_ERROR("Unable to create an LWS connection.");
-			result = false;
+			const auto len = static_cast<size_t>(read) - (line[read - 1] == '\n');
+			const auto space = static_cast<const char*>(memchr(line, ' ', len));
+			if(space) {
+				const std::string path(line, space - line);
+				const char* payload = space + 1;
+				const size_t payload_len = len - (space + 1 - line);
+				for(auto& stream : _streams) {
+					if(stream->path != path) {
+						continue;
+					}
+					if(stream->sbe_callback) {
+						// The binary frames are captured hex encoded.
+						std::string frame;
+						if(Utils::hex_to_bin(payload, payload_len, frame)) {
+							deliver_sbe(*stream->links.front(), frame.data(), frame.size());
+						}
+					} else {
+						deliver_text(*stream->links.front(), payload, payload_len);
+					}
+					break;
+				}
+			}
 		}
-		return result;
+
+		free(line);
 	}
 
+	static_assert(POLLIN == EPOLLIN && POLLOUT == EPOLLOUT && POLLERR == EPOLLERR && POLLHUP == EPOLLHUP,
+	              "The poll and epoll event flags are passed through as is.");
+
+	/**
+	 * The LWS external poll integration; LWS reports the sockets to watch and their events.
+	 */
+	int poll_callback(enum lws_callback_reasons reason, const lws_pollargs* args) noexcept {
+		if(_reactor == nullptr) {
+			return EXIT_SUCCESS;
+		}
+
+		switch(reason) {
+			case LWS_CALLBACK_ADD_POLL_FD:
+				return _reactor->add(args->fd, static_cast<uint32_t>(args->events), cb_lws_fd, this) ? EXIT_SUCCESS : -1;
+
+			case LWS_CALLBACK_DEL_POLL_FD:
+				_reactor->remove(args->fd);
+				break;
+
+			case LWS_CALLBACK_CHANGE_MODE_POLL_FD:
+				return _reactor->modify(args->fd, static_cast<uint32_t>(args->events)) ? EXIT_SUCCESS : -1;
+
+			default:
+				break;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	static void cb_lws_fd(void* instance, int fd, uint32_t events) noexcept {
+		auto obj = reinterpret_cast<Connector*>(instance);
+
+		lws_pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = static_cast<short>(events);
+		pfd.revents = static_cast<short>(events);
+		lws_service_fd(obj->_context, &pfd);
+
+		// TLS may have buffered more than the socket reports, it is drained without waiting for the socket.
+		while(lws_service_adjust_timeout(obj->_context, 1, 0) == 0) {
+			lws_service_tsi(obj->_context, -1, 0);
+		}
+	}
+
+	static void cb_supervise(void* instance, int, uint32_t) noexcept {
+		auto obj = reinterpret_cast<Connector*>(instance);
+		if(obj->_context) {
+			lws_service_fd(obj->_context, nullptr); // The LWS timeouts.
+			obj->supervise(Utils::time_now_ms());
+		}
+	}
 
 	static int ws_callback(lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len) noexcept {
-		auto instance = reinterpret_cast<Connector*>(lws_get_opaque_user_data(wsi));
-		return instance->ws_callback_instance(wsi, reason, in, len);
+		switch(reason) {
+			case LWS_CALLBACK_ADD_POLL_FD:
+			case LWS_CALLBACK_DEL_POLL_FD:
+			case LWS_CALLBACK_CHANGE_MODE_POLL_FD: {
+				auto owner = reinterpret_cast<Connector*>(lws_context_user(lws_get_context(wsi)));
+				return owner ? owner->poll_callback(reason, reinterpret_cast<const lws_pollargs*>(in)) : EXIT_SUCCESS;
+			}
+
+			default:
+				break;
+		}
+
+		auto link = reinterpret_cast<Link*>(lws_get_opaque_user_data(wsi));
+		if(link == nullptr || link->wsi != wsi) {
+			// The connection has been already given up by the supervisor.
+			return EXIT_SUCCESS;
+		}
+		return link->owner->ws_callback_instance(*link, reason, in, len);
 	}
 
-	int ws_callback_instance(lws* ws, enum lws_callback_reasons reason, void* in, size_t len) noexcept {
+	int ws_callback_instance(Link& link, enum lws_callback_reasons reason, void* in, size_t len) noexcept {
+		const auto now = Utils::time_now_ms();
 
 		switch(reason) {
 
 			case LWS_CALLBACK_CLIENT_ESTABLISHED:
-				lws_callback_on_writable(ws);
+				LOG_DEBUG("binance::ws::Connector established '%s' at '%s:%d'\n", path_of(link).c_str(),
+				          link.endpoint->host.c_str(), link.endpoint->port);
+				link.state = LinkState::Established;
+				link.established_ms = now;
+				link.last_rx_ms = now;
+				link.last_ping_ms = now;
+				link.last_pong_ms = now;
+				lws_callback_on_writable(link.wsi);
 				break;
 
-			case LWS_CALLBACK_CLIENT_RECEIVE: {
+			case LWS_CALLBACK_CLIENT_APPEND_HANDSHAKE_HEADER:
+				if(link.stream && link.stream->sbe_callback && not _sbe_api_key.empty()) {
+					auto pos = reinterpret_cast<unsigned char**>(in);
+					if(lws_add_http_header_by_name(link.wsi, reinterpret_cast<const unsigned char*>("X-MBX-APIKEY:"),
+					                               reinterpret_cast<const unsigned char*>(_sbe_api_key.c_str()),
+					                               static_cast<int>(_sbe_api_key.size()), pos, *pos + len)) {
+						return -1;
+					}
+				}
+				break;
 
-				const auto input_string = reinterpret_cast<const char*>(in);
-				Json::Reader reader;
-				Json::Value json;
-
-				if(reader.parse(std::string(input_string), json)) {
-					const auto it = _handles.find(ws);
-					if(it != _handles.end()) {
-						const auto& record = it->second;
-						const auto err = record.callback(record.instance, json);
-						if(err) {
-							LOG_ERROR("The consumer rejects the event '%s' err=%d", input_string, err);
-						}
-					} else {
-						LOG_ERROR("A LWS event with no consumer. '%s'", input_string);
+			case LWS_CALLBACK_CLIENT_RECEIVE: {
+				// A message larger than the receive buffer of LWS comes in fragments, it is delivered once whole.
+				const char* data = reinterpret_cast<const char*>(in);
+				if(not link.message.empty() || not lws_is_final_fragment(link.wsi)) {
+					link.message.append(data, len);
+					if(not lws_is_final_fragment(link.wsi)) {
+						break;
 					}
+					data = link.message.data();
+					len = link.message.size();
+				}
+				if(link.api) {
+					api_deliver(*link.api, data, len);
+				} else if(link.stream->sbe_callback) {
+					deliver_sbe(link, data, len);
 				} else {
-					LOG_ERROR("JSON parsing failure. '%s'", input_string);
+					deliver_text(link, data, len);
 				}
-
+				link.message.clear();
 			}
 				break;
 
+			case LWS_CALLBACK_CLIENT_WRITEABLE:
+				if(link.ping_pending) {
+					unsigned char buffer[LWS_PRE + 1u];
+					link.ping_pending = false;
+					link.last_ping_ms = now;
+					if(lws_write(link.wsi, buffer + LWS_PRE, 0u, LWS_WRITE_PING) < 0) {
+						return -1;
+					}
+					if(link.api && not link.api->outbox.empty()) {
+						lws_callback_on_writable(link.wsi);
+					}
+				} else if(link.api) {
+					return api_write(*link.api);
+				}
+				break;
+
+			case LWS_CALLBACK_CLIENT_RECEIVE_PONG:
+				link.last_pong_ms = now;
+				break;
+
 			case LWS_CALLBACK_CLOSED:
-			case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:{
-				const auto it = _handles.find(ws);
-				if(it != _handles.end()) {
-					_handles.erase(it);
-				} else {
-					LOG_ERROR("An unknown connection closing event.");
+			case LWS_CALLBACK_CLIENT_CLOSED:
+			case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
+				LOG_ERROR("binance::ws::Connector connection '%s' is lost\n", path_of(link).c_str());
+				schedule_reconnect(link, now);
+				if(link.api) {
+					api_fail_all(*link.api);
 				}
-			}
 				break;
 
 			default:
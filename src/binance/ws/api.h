@@ -2,6 +2,8 @@
 
 #include <jsoncpp/json/json.h>
 #include "../types.h"
+#include "../../parser/Scanner.h"
+#include "../sbe/stream.h"
 
 namespace binance {
 namespace ws {
@@ -61,6 +63,116 @@ struct SymbolTicker {
 		return validate();
 	}
 
+	/**
+	 * The DOM-less counterpart of parse(const Json::Value&), reads the frame text in place.
+	 */
+	bool parse(std::string_view text) noexcept {
+		parser::Scanner scan(text);
+		std::string_view key;
+		if(not scan.begin_object()) {
+			return false;
+		}
+		while(scan.member(key)) {
+			if(key.size() != 1u) {
+				scan.skip();
+				continue;
+			}
+			switch(key[0]) {
+				case 'E':
+					scan.integer(eventTime);
+					break;
+				case 's': {
+					std::string_view value;
+					scan.string(value);
+					symbol.assign(value.data(), value.size());
+				}
+					break;
+				case 'p':
+					scan.decimal(priceChange);
+					break;
+				case 'P':
+					scan.decimal(priceChangePercent);
+					break;
+				case 'w':
+					scan.decimal(weightedAveragePrice);
+					break;
+				case 'x':
+					scan.decimal(firstTrade);
+					break;
+				case 'c':
+					scan.decimal(lastPrice);
+					break;
+				case 'Q':
+					scan.decimal(lastQuantity);
+					break;
+				case 'b':
+					scan.decimal(bestBidPrice);
+					break;
+				case 'B':
+					scan.decimal(bestBidQuantity);
+					break;
+				case 'a':
+					scan.decimal(bestAskPrice);
+					break;
+				case 'A':
+					scan.decimal(bestAskQuantity);
+					break;
+				case 'o':
+					scan.decimal(openPrice);
+					break;
+				case 'h':
+					scan.decimal(highPrice);
+					break;
+				case 'l':
+					scan.decimal(lowPrice);
+					break;
+				case 'v':
+					scan.decimal(totalTradedBase);
+					break;
+				case 'q':
+					scan.decimal(totalTradedQuote);
+					break;
+				case 'O':
+					scan.integer(statisticsPpenTime);
+					break;
+				case 'C':
+					scan.integer(statisticsCloseTime);
+					break;
+				case 'F':
+				case 'L': {
+					SInteger id = 0;  // -1 if there is no trade.
+					scan.integer(id);
+					(key[0] == 'F' ? firstTradeID : lastTradeID) = static_cast<UInteger>(id);
+				}
+					break;
+				case 'n':
+					scan.integer(totalNumberOfTrades);
+					break;
+				default:
+					scan.skip();
+					break;
+			}
+		}
+		return scan.ok() && validate();
+	}
+
+	/**
+	 * Takes the last trade of the SBE trades event; the statistics fields are not sent over the trade stream.
+	 */
+	bool parse(const sbe::TradesEvent& event) noexcept {
+		const auto& trades = event.trades();
+		if(trades.empty()) {
+			return false;
+		}
+		const auto last = trades[trades.size() - 1u];
+		eventTime = static_cast<Time>(event.event_time_us() / 1000);
+		symbol.assign(event.symbol());
+		lastPrice = last.price();
+		lastQuantity = last.qty();
+		lastTradeID = static_cast<UInteger>(last.id());
+		return validate();
+	}
+
 	inline bool validate() const noexcept {
 		return true;
 	}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+#include "Integer.h"
+
+namespace cli {
+
+/**
+ * A list of CPU cores as the kernel writes it, e.g. '0-3,6'.
+ */
+class CpuList {
+public:
+
+	static bool parse(const char* arg, std::vector<unsigned>& value) noexcept {
+		value.clear();
+		while(arg && *arg) {
+			unsigned first, last;
+			auto offset = Integer::parse_offset(arg, first);
+			if(offset == 0u) {
+				return false;
+			}
+			arg += offset;
+			last = first;
+			if(*arg == '-') {
+				offset = Integer::parse_offset(++arg, last);
+				if(offset == 0u || last < first) {
+					return false;
+				}
+				arg += offset;
+			}
+			for(unsigned cpu = first; cpu <= last; ++cpu) {
+				value.push_back(cpu);
+			}
+			if(*arg == ',') {
+				arg++;
+			} else if(*arg) {
+				return false;
+			}
+		}
+		return not value.empty();
+	}
+};
+
+}; // namespace cli
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <new>
+#include <vector>
+#include <cstddef>
+
+#include "../Config.h"
+#include "../Log.h"
+
+namespace coro {
+
+/**
+ * The free list of the fixed size blocks the coroutine frames are placed in.
+ * A frame is allocated once per coroutine call, never per co_await; the blocks are reused, so a strategy running
+ * in a loop makes no heap allocations once the pool has warmed up. A frame larger than a block goes to the heap.
+ * Not thread safe; the strategies run on the event loop thread.
+ */
+class FramePool {
+
+	struct Block {
+		Block* next;
+	};
+
+	std::vector<char*> _chunks;
+	Block* _free;
+	size_t _heap_nb;  // The frames that have not fit the blocks.
+
+public:
+
+	static constexpr size_t BlockBytes = Config::CoroFrameBytes;
+
+	FramePool(const FramePool&) = delete;
+	FramePool& operator=(const FramePool&) = delete;
+
+	static FramePool& instance() noexcept {
+		static FramePool pool;
+		return pool;
+	}
+
+	void* allocate(const size_t size) noexcept {
+		if(size > BlockBytes) {
+			_heap_nb++;
+			return ::operator new(size);
+		}
+		if(_free == nullptr) {
+			grow();
+		}
+		auto block = _free;
+		_free = block->next;
+		return block;
+	}
+
+	void deallocate(void* ptr, const size_t size) noexcept {
+		if(size > BlockBytes) {
+			::operator delete(ptr);
+			return;
+		}
+		auto block = static_cast<Block*>(ptr);
+		block->next = _free;
+		_free = block;
+	}
+
+	inline size_t heap_nb() const noexcept {
+		return _heap_nb;
+	}
+
+private:
+
+	FramePool() noexcept : _free(nullptr), _heap_nb(0u) {
+		grow();
+	}
+
+	~FramePool() noexcept {
+		for(auto chunk : _chunks) {
+			delete[] chunk;
+		}
+	}
+
+	void grow() noexcept {
+		static_assert(BlockBytes % alignof(std::max_align_t) == 0u, "The blocks have to keep the frames aligned.");
+		auto chunk = new char[BlockBytes * Config::CoroFramePoolGrowth];
+		_chunks.push_back(chunk);
+		for(size_t idx = 0; idx < Config::CoroFramePoolGrowth; ++idx) {
+			auto block = reinterpret_cast<Block*>(chunk + idx * BlockBytes);
+			block->next = _free;
+			_free = block;
+		}
+	}
+
+};
+
+}; // namespace coro
@@ -0,0 +1,384 @@
+#pragma once
+
+#include <coroutine>
+#include <cmath>
+#include <string>
+
+#include "Task.h"
+#include "../binance/rest/Connector.h"
+#include "../binance/ws/Connector.h"
+#include "../Config.h"
+#include "../Reactor.h"
+#include "../Log.h"
+#include "../Utils.h"
+
+namespace coro {
+
+/**
+ * The awaitables a strategy is written with and the events resuming them.
+ *
+ *   co_await rt.sleep(sec);                    - the timer;
+ *   co_await rt.next_price(timeout_sec);       - any price update;
+ *   co_await rt.price_move(pct, timeout_sec);  - the price moved by the percent either way;
+ *   co_await rt.place_order(order, result);    - the order response, over the WebSocket API if it is up.
+ *
+ * An awaiter lives in the frame of the coroutine awaiting it and is linked into the runtime intrusively,
+ * so co_await allocates nothing. The events only mark the awaiters ready; the coroutines are resumed by poll(),
+ * outside of the connector callbacks. If the WebSocket connector runs on a reactor, a timer armed for the earliest
+ * deadline wakes the loop, so a timeout is not late for want of events. Everything runs on the event loop thread.
+ */
+class Runtime {
+public:
+
+	enum class Wake : unsigned {
+		Price,    // The price condition is met.
+		Timeout,  // The time is over first.
+		Stale     // The price feed has got stale, the price condition can not be evaluated.
+	};
+
+	/**
+	 * The node of the waiting and the ready lists; the base of all the awaiters.
+	 */
+	struct Waiter {
+		enum class Kind : unsigned {
+			Sleep,
+			Price,
+			Order
+		};
+
+		Runtime& rt;
+		const Kind kind;
+		Waiter* prev;
+		Waiter* next;
+		std::coroutine_handle<> handle;
+		uint64_t deadline_ms;  // Zero if none.
+		Wake wake;
+
+		Waiter(Runtime& runtime, const Kind type, const uint64_t deadline) noexcept :
+			rt(runtime),
+			kind(type),
+			prev(nullptr),
+			next(nullptr),
+			handle(nullptr),
+			deadline_ms(deadline),
+			wake(Wake::Timeout) {
+		}
+
+		Waiter(const Waiter&) = delete;
+		Waiter& operator=(const Waiter&) = delete;
+
+		/**
+		 * An awaiter destroyed with its frame is no longer waited for.
+		 */
+		~Waiter() noexcept {
+			rt.unlink(*this);
+		}
+
+		inline bool await_ready() const noexcept {
+			return false;
+		}
+
+		inline void await_suspend(std::coroutine_handle<> awaiting) noexcept {
+			handle = awaiting;
+			rt.link(rt._waiting, *this);
+			rt.arm(deadline_ms);
+		}
+	};
+
+	struct SleepAwaiter : Waiter {
+		SleepAwaiter(Runtime& runtime, const uint64_t deadline) noexcept : Waiter(runtime, Kind::Sleep, deadline) {
+		}
+
+		inline void await_resume() const noexcept {
+		}
+	};
+
+	struct PriceAwaiter : Waiter {
+		const double start;
+		const double percent;  // Negative for any update.
+
+		PriceAwaiter(Runtime& runtime, const double pct, const uint64_t deadline) noexcept :
+			Waiter(runtime, Kind::Price, deadline),
+			start(runtime._price),
+			percent(pct) {
+		}
+
+		inline Wake await_resume() const noexcept {
+			return wake;
+		}
+	};
+
+	struct OrderAwaiter : Waiter {
+		binance::rest::OrderResult& result;
+		uint64_t id;  // The WebSocket API request ID, zero if placed over REST.
+		bool accepted;
+
+		OrderAwaiter(
+			Runtime& runtime, const binance::rest::OrderRequest& order, binance::rest::OrderResult& response
+		            ) noexcept :
+			Waiter(runtime, Kind::Order, 0u),
+			result(response),
+			id(0u),
+			accepted(false) {
+			if(runtime._ws_api && runtime._conn_ws.api_ready()) {
+				id = runtime._conn_ws.order_place(order, cb_order, &runtime);
+			}
+			if(id == 0u) {
+				accepted = runtime._conn_rest.new_order(result, order);
+			}
+		}
+
+		/**
+		 * Over REST the order is placed right away and the coroutine is not suspended at all.
+		 */
+		inline bool await_ready() const noexcept {
+			return id == 0u;
+		}
+
+		inline bool await_resume() const noexcept {
+			return accepted;
+		}
+	};
+
+private:
+
+	binance::rest::Connector& _conn_rest;
+	binance::ws::Connector& _conn_ws;
+	const bool _ws_api;
+
+	Waiter* _waiting;  // Suspended.
+	Waiter* _ready;    // To be resumed by poll().
+
+	Reactor* _reactor;   // The loop of the WebSocket connector, optional.
+	int _timer;          // Wakes the loop at the earliest deadline.
+	uint64_t _timer_ms;  // The deadline the timer is armed for, zero if disarmed.
+
+	double _price;
+	bool _feed_stale;
+
+public:
+
+	Runtime(const Runtime&) = delete;
+	Runtime& operator=(const Runtime&) = delete;
+
+	/**
+	 * @param ws_api - Place the orders over the WebSocket API while it is up.
+	 */
+	Runtime(binance::rest::Connector& conn_rest, binance::ws::Connector& conn_ws, const bool ws_api) noexcept :
+		_conn_rest(conn_rest),
+		_conn_ws(conn_ws),
+		_ws_api(ws_api),
+		_waiting(nullptr),
+		_ready(nullptr),
+		_reactor(conn_ws.reactor()),
+		_timer(-1),
+		_timer_ms(0u),
+		_price(0.),
+		_feed_stale(false) {
+
+		if(_reactor) {
+			_timer = _reactor->add_timer(cb_timer, this);
+			if(_timer < 0) {
+				LOG_ERROR("The coroutine timeouts are checked as the loop turns only.\n");
+			}
+		}
+	}
+
+	~Runtime() noexcept {
+		_conn_ws.api_forget(this);
+		if(_reactor && _timer >= 0) {
+			_reactor->remove(_timer);
+		}
+		if(_waiting || _ready) {
+			LOG_ERROR("coro::Runtime is destroyed while the coroutines are waiting.\n");
+		}
+	}
+
+	// -----------------------------
+	// The awaitables.
+	// -----------------------------
+
+	inline SleepAwaiter sleep(const unsigned sec) noexcept {
+		return SleepAwaiter(*this, Utils::time_now_ms() + sec * 1000ull);
+	}
+
+	inline SleepAwaiter sleep_ms(const unsigned ms) noexcept {
+		return SleepAwaiter(*this, Utils::time_now_ms() + ms);
+	}
+
+	/**
+	 * @param timeout_sec - Zero to wait however long.
+	 */
+	inline PriceAwaiter next_price(const unsigned timeout_sec = 0u) noexcept {
+		return PriceAwaiter(*this, -1., deadline(timeout_sec));
+	}
+
+	/**
+	 * @param pct - The move relative to the price at the moment of the call, either way.
+	 * @param timeout_sec - Zero to wait however long.
+	 */
+	inline PriceAwaiter price_move(const double pct, const unsigned timeout_sec = 0u) noexcept {
+		return PriceAwaiter(*this, pct, deadline(timeout_sec));
+	}
+
+	/**
+	 * @param result - The response, MUST outlive the co_await.
+	 * @return - The awaiter resuming with true if the order has been accepted.
+	 */
+	inline OrderAwaiter place_order(
+		const binance::rest::OrderRequest& order, binance::rest::OrderResult& result
+	                               ) noexcept {
+		return OrderAwaiter(*this, order, result);
+	}
+
+	// -----------------------------
+	// The events.
+	// -----------------------------
+
+	void price(const double value) noexcept {
+		_price = value;
+		for_each_waiting(Waiter::Kind::Price, [this](Waiter& item) {
+			const auto& awaiter = static_cast<PriceAwaiter&>(item);
+			// No move is measured from the price unknown at the call, the first one only sets it.
+			if(awaiter.percent < 0. || (awaiter.start > 0. && std::abs((_price - awaiter.start) / awaiter.start) * 100. > awaiter.percent)) {
+				ready(item, Wake::Price);
+			}
+		});
+	}
+
+	void feed(const bool stale) noexcept {
+		_feed_stale = stale;
+		if(stale) {
+			for_each_waiting(Waiter::Kind::Price, [this](Waiter& item) {
+				ready(item, Wake::Stale);
+			});
+		}
+	}
+
+	/**
+	 * Fires the expired timers, resumes the coroutines ready and rearms the timer for the deadlines left.
+	 */
+	void poll(const uint64_t now_ms) noexcept {
+		uint64_t earliest = 0u;
+		for(auto item = _waiting; item;) {
+			const auto next = item->next;
+			if(item->deadline_ms && now_ms >= item->deadline_ms) {
+				ready(*item, Wake::Timeout);
+			} else if(item->deadline_ms && (earliest == 0u || item->deadline_ms < earliest)) {
+				earliest = item->deadline_ms;
+			}
+			item = next;
+		}
+		// The deadline armed may be gone with its awaiter, or fired.
+		if(_timer_ms != earliest) {
+			_timer_ms = 0u;
+			if(_reactor && _timer >= 0) {
+				_reactor->disarm_timer(_timer);
+			}
+			arm(earliest);
+		}
+
+		while(_ready) {
+			auto& item = *_ready;
+			unlink(item);
+			item.handle.resume();
+		}
+	}
+
+	inline double last_price() const noexcept {
+		return _price;
+	}
+
+	inline bool feed_stale() const noexcept {
+		return _feed_stale;
+	}
+
+private:
+
+	static inline uint64_t deadline(const unsigned timeout_sec) noexcept {
+		return timeout_sec ? Utils::time_now_ms() + timeout_sec * 1000ull : 0u;
+	}
+
+	/**
+	 * Brings the timer forward to the deadline if it is the earliest one.
+	 */
+	void arm(const uint64_t deadline_ms) noexcept {
+		if(_timer < 0 || deadline_ms == 0u || (_timer_ms && _timer_ms <= deadline_ms)) {
+			return;
+		}
+		const uint64_t now_ms = Utils::time_now_ms();
+		if(_reactor->arm_timer(_timer, deadline_ms > now_ms ? static_cast<unsigned>(deadline_ms - now_ms) : 0u)) {
+			_timer_ms = deadline_ms;
+		}
+	}
+
+	void link(Waiter*& list, Waiter& item) noexcept {
+		item.prev = nullptr;
+		item.next = list;
+		if(list) {
+			list->prev = &item;
+		}
+		list = &item;
+	}
+
+	void unlink(Waiter& item) noexcept {
+		if(item.prev) {
+			item.prev->next = item.next;
+		} else if(_waiting == &item) {
+			_waiting = item.next;
+		} else if(_ready == &item) {
+			_ready = item.next;
+		}
+		if(item.next) {
+			item.next->prev = item.prev;
+		}
+		item.prev = nullptr;
+		item.next = nullptr;
+	}
+
+	void ready(Waiter& item, const Wake wake) noexcept {
+		unlink(item);
+		item.wake = wake;
+		link(_ready, item);
+	}
+
+	template <typename CallBack>
+	void for_each_waiting(const Waiter::Kind kind, CallBack&& cb) noexcept {
+		for(auto item = _waiting; item;) {
+			const auto next = item->next;
+			if(item->kind == kind) {
+				cb(*item);
+			}
+			item = next;
+		}
+	}
+
+	/**
+	 * Only wakes the loop, the expired awaiters are resumed by poll() as the applications are serviced.
+	 */
+	static void cb_timer(void* instance, int, uint32_t) noexcept {
+		reinterpret_cast<Runtime*>(instance)->_timer_ms = 0u;
+	}
+
+	/**
+	 * The WebSocket API response; the awaiter is found by the request ID, it may be gone already.
+	 */
+	static void cb_order(void* instance, uint64_t id, int status, const Json::Value& result) noexcept {
+		auto obj = reinterpret_cast<Runtime*>(instance);
+		obj->for_each_waiting(Waiter::Kind::Order, [&](Waiter& item) {
+			auto& awaiter = static_cast<OrderAwaiter&>(item);
+			if(awaiter.id != id) {
+				return;
+			}
+			if(status == 200) {
+				awaiter.accepted = awaiter.result.parse(result);
+			} else {
+				LOG_ERROR("The order has failed. status=%d '%s'\n", status, Json::FastWriter().write(result).c_str());
+			}
+			obj->ready(item, item.wake);
+		});
+	}
+
+};
+
+}; // namespace coro
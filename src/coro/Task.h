@@ -0,0 +1,211 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include "FramePool.h"
+#include "../Log.h"
+
+namespace coro {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+/**
+ * The part of the promise common to all the result types.
+ * The frames come from the FramePool; a task starts suspended and resumes its awaiter once it is over.
+ */
+struct PromiseBase {
+
+	std::coroutine_handle<> continuation;
+
+	struct FinalAwaiter {
+		inline bool await_ready() const noexcept {
+			return false;
+		}
+
+		template <typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+			const auto next = handle.promise().continuation;
+			return next ? next : std::noop_coroutine();
+		}
+
+		inline void await_resume() const noexcept {
+		}
+	};
+
+	static void* operator new(size_t size) noexcept {
+		return FramePool::instance().allocate(size);
+	}
+
+	static void operator delete(void* ptr, size_t size) noexcept {
+		FramePool::instance().deallocate(ptr, size);
+	}
+
+	inline std::suspend_always initial_suspend() const noexcept {
+		return {};
+	}
+
+	inline FinalAwaiter final_suspend() const noexcept {
+		return {};
+	}
+
+	void unhandled_exception() const noexcept {
+		LOG_CRITICAL("An exception has escaped a coroutine.\n");
+		std::terminate();
+	}
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+	T value;
+
+	Task<T> get_return_object() noexcept;
+
+	static Task<T> get_return_object_on_allocation_failure() noexcept;
+
+	void return_value(T result) noexcept {
+		value = std::move(result);
+	}
+
+	inline T result() noexcept {
+		return std::move(value);
+	}
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+
+	Task<void> get_return_object() noexcept;
+
+	static Task<void> get_return_object_on_allocation_failure() noexcept;
+
+	inline void return_void() const noexcept {
+	}
+
+	inline void result() const noexcept {
+	}
+};
+
+}; // namespace detail
+
+/**
+ * A lazily started coroutine owning its frame.
+ * A task is either started by start() as the top-level one or co_awaited by another task,
+ * which resumes once the task is over. Destroying a suspended task destroys the whole chain it awaits.
+ */
+template <typename T>
+class Task {
+public:
+
+	using promise_type = detail::Promise<T>;
+	using Handle_t = std::coroutine_handle<promise_type>;
+
+private:
+
+	Handle_t _handle;
+
+public:
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	Task() noexcept : _handle(nullptr) {
+	}
+
+	explicit Task(Handle_t handle) noexcept : _handle(handle) {
+	}
+
+	Task(Task&& rv) noexcept : _handle(std::exchange(rv._handle, nullptr)) {
+	}
+
+	Task& operator=(Task&& rv) noexcept {
+		if(this != &rv) {
+			reset();
+			_handle = std::exchange(rv._handle, nullptr);
+		}
+		return *this;
+	}
+
+	~Task() noexcept {
+		reset();
+	}
+
+	/**
+	 * Runs the task until its first suspension.
+	 */
+	inline void start() noexcept {
+		if(_handle && not _handle.done()) {
+			_handle.resume();
+		}
+	}
+
+	inline bool valid() const noexcept {
+		return static_cast<bool>(_handle);
+	}
+
+	/**
+	 * @return true - if the task is over or there is no task.
+	 */
+	inline bool done() const noexcept {
+		return not _handle || _handle.done();
+	}
+
+	/**
+	 * Destroys the frame wherever the task is suspended.
+	 */
+	void reset() noexcept {
+		if(_handle) {
+			_handle.destroy();
+			_handle = nullptr;
+		}
+	}
+
+	auto operator co_await() && noexcept {
+		struct Awaiter {
+			Handle_t handle;
+
+			inline bool await_ready() const noexcept {
+				return not handle || handle.done();
+			}
+
+			inline std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+				handle.promise().continuation = awaiting;
+				return handle;
+			}
+
+			inline T await_resume() noexcept {
+				return handle.promise().result();
+			}
+		};
+		return Awaiter {_handle};
+	}
+
+};
+
+namespace detail {
+
+template <typename T>
+inline Task<T> Promise<T>::get_return_object() noexcept {
+	return Task<T>(Task<T>::Handle_t::from_promise(*this));
+}
+
+template <typename T>
+inline Task<T> Promise<T>::get_return_object_on_allocation_failure() noexcept {
+	return Task<T>();
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+	return Task<void>(Task<void>::Handle_t::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object_on_allocation_failure() noexcept {
+	return Task<void>();
+}
+
+}; // namespace detail
+
+}; // namespace coro
@@ -1,12 +1,30 @@
+#include <atomic>
 #include <csignal>
+#include <memory>
+#include <vector>
 
 #include "CliConfig.h"
+#include "Reactor.h"
+#include "Realtime.h"
 #include "binance/rest/Connector.h"
+#include "binance/rest/HistoryFile.h"
+#include "binance/rest/HistorySync.h"
 #include "binance/ws/Connector.h"
+#include "market/Plane.h"
+#include "metrics/Exporter.h"
+#include "params/Watcher.h"
+#include "pnl/Portfolio.h"
+#include "shm/Publisher.h"
+#include "sim/Exchange.h"
+#include "sim/Latency.h"
+#include "sim/Market.h"
 
 #include "app/AppDefault.h"
+#include "app/AppCoro.h"
+#include "app/AppArbitrage.h"
 
 bool signal_abort = false;
+std::atomic<bool> signal_reload(false);
 
 void signal_handler(int signum) {
 	if(signum == SIGINT || signum == SIGTERM) {
@@ -16,44 +34,264 @@ void signal_handler(int signum) {
 		} else {
 			exit(EXIT_FAILURE);
 		}
+	} else if(signum == SIGHUP) {
+		LOG_DEBUG("Reload signal.\n");
+		signal_reload = true;
 	}
 
 }
 
+void signal_reactor_handler(void*, int signum) {
+	signal_handler(signum);
+}
+
+/**
+ * Brings the order history up to date since the previous run, the new records are appended to the history files.
+ */
+bool sync_history(const CliConfig& cli, const binance::rest::Connector& rest_conn, Reactor& reactor) noexcept {
+	binance::rest::HistoryFile records;
+	if(not records.open(cli.history_path)) {
+		return false;
+	}
+
+	binance::rest::HistorySync sync(rest_conn, binance::rest::HistoryFile::cb_orders,
+	                                binance::rest::HistoryFile::cb_trades, &records);
+	if(not sync.attach(reactor)) {
+		return false;
+	}
+
+	sync.add_symbol(Config::BasicSymbol + cli.currency_symbol);
+	for(const auto& item : cli.history_symbols) {
+		sync.add_symbol(item);
+	}
+
+	if(not sync.load(cli.history_path.c_str())) {
+		return false;
+	}
+
+	LOG_DEBUG("Syncing the order history...\n");
+	while(not signal_abort && sync.service()) {
+	}
+
+	sync.dump();
+	// The records first, the marks saved must not pass the records written.
+	return records.close() && sync.save(cli.history_path.c_str()) && sync.succeeded();
+}
+
+/**
+ * @return - The 'BASE', 'QUOTE' pairs the application trades or watches.
+ */
+std::vector<std::pair<std::string, std::string>> traded_pairs(const CliConfig& cli) noexcept {
+	std::vector<std::pair<std::string, std::string>> result;
+	if(cli.app == "arbitrage") {
+		for(const auto& item : cli.arbitrage_pairs()) {
+			const auto slash = item.find('/');
+			result.emplace_back(item.substr(0, slash), item.substr(slash + 1u));
+		}
+	} else {
+		result.emplace_back(Config::BasicSymbol, cli.currency_symbol);
+	}
+	return result;
+}
+
+/**
+ * The streams subscribed to be recorded only.
+ */
+int record_only(void*, std::string_view) {
+	return 0;
+}
+
 template <typename Application>
 int run(const CliConfig& cli, CURL* culr_handler) noexcept {
 
 	int err = EXIT_SUCCESS;
 
-	signal(SIGINT, signal_handler);
-	signal(SIGTERM, signal_handler);
+	// Before any thread is started, so the helper ones inherit their cores.
+	Realtime realtime(cli.loop_cpu, cli.helper_cpus, cli.fifo_priority, cli.lock_memory);
+	if(not realtime.init()) {
+		LOG_ERROR("The process is not tuned as asked.\n");
+	}
 
-	binance::rest::Connector rest_conn(culr_handler, Config::BinanceRestHost, cli.api_key, cli.secret_key);
+	Reactor reactor(cli.busy_poll);
+	if(not reactor.init()) {
+		LOG_CRITICAL("Reactor initializing failure.\n");
+		return EXIT_FAILURE;
+	}
 
-	binance::ws::Connector ws_conn;
-	if(not ws_conn.init()) {
-		LOG_CRITICAL("WebSocket initializing failure.\n");
+	// The replay does not run the reactor, so the signals are asynchronous then.
+	if(cli.replay_path.empty()) {
+		if(not reactor.watch_signals({SIGINT, SIGTERM, SIGHUP}, signal_reactor_handler, nullptr)) {
+			return EXIT_FAILURE;
+		}
+	} else {
+		signal(SIGINT, signal_handler);
+		signal(SIGTERM, signal_handler);
+		signal(SIGHUP, signal_handler);
+	}
+
+	auto& params = params::Store::instance();
+	params.publish(cli.params());
+	params::Watcher params_watcher(params, cli.params_path, signal_reload);
+	if(not cli.params_path.empty() && not params_watcher.start()) {
+		LOG_CRITICAL("The parameters file can not be loaded.\n");
 		return EXIT_FAILURE;
 	}
 
-	Application app(rest_conn, ws_conn, cli);
+	// An account has a connector of its own: the signer, the curl handle and the order budget.
+	std::vector<CliConfig> accounts;
+	std::vector<std::unique_ptr<binance::rest::Connector>> rest_conns;
+	for(size_t idx = 0; idx < cli.accounts_nb(); ++idx) {
+		accounts.push_back(cli.account(idx));
+		const auto curl = idx ? curl_easy_init() : culr_handler;
+		if(curl == nullptr) {
+			LOG_CRITICAL("curl_easy_init() fails.\n");
+			return EXIT_FAILURE;
+		}
+		rest_conns.emplace_back(new binance::rest::Connector(
+			curl, Config::BinanceRestHost, accounts.back().api_key, accounts.back().secret_key));
+		if(not cli.mock_dir.empty()) {
+			rest_conns.back()->mock(cli.mock_dir);
+		}
+	}
+
+	// The backtest: the accounts trade against the simulated exchange in the time of the capture.
+	const auto pairs = traded_pairs(cli);
+	sim::Latency latency;
+	sim::Market market(latency);
+	std::vector<std::unique_ptr<sim::Exchange>> exchanges;
+	if(cli.backtest) {
+		if(not latency.init(cli.latency_model)) {
+			LOG_CRITICAL("The latency model '%s' can not be loaded.\n", cli.latency_model.c_str());
+			return EXIT_FAILURE;
+		}
+		for(const auto& item : pairs) {
+			market.add_pair(item.first, item.second);
+		}
+		if(not market.open(cli.replay_path.c_str())) {
+			return EXIT_FAILURE;
+		}
+		for(auto& conn : rest_conns) {
+			exchanges.emplace_back(new sim::Exchange(market));
+			conn->simulate(exchanges.back().get());
+		}
+	}
 
-	while(not app.init()) {
-		LOG_CRITICAL("Application initialization has failed.\n");
+	if(not cli.history_path.empty() && not sync_history(cli, *rest_conns.front(), reactor)) {
+		LOG_CRITICAL("Order history sync failure.\n");
 		return EXIT_FAILURE;
 	}
 
+	binance::ws::Connector ws_conn(cli.ws_endpoints, cli.ws_standby_links);
+	if(cli.sbe) {
+		ws_conn.init_sbe(cli.api_key);
+	}
+	if(cli.replay_path.empty() && not ws_conn.attach(reactor)) {
+		LOG_CRITICAL("WebSocket initializing failure.\n");
+		return EXIT_FAILURE;
+	}
+	const bool ws_ready = cli.replay_path.empty() ? ws_conn.init() : ws_conn.init_replay(cli.replay_path.c_str());
+	if(not ws_ready) {
+		LOG_CRITICAL("WebSocket initializing failure.\n");
+		return EXIT_FAILURE;
+	}
+
+	if(not cli.record_path.empty() && not ws_conn.record(cli.record_path.c_str())) {
+		return EXIT_FAILURE;
+	}
+
+	// The depth and the trades make a capture a backtest one, see sim::Market.
+	if(not cli.record_path.empty() && cli.replay_path.empty()) {
+		for(const auto& item : pairs) {
+			if(not ws_conn.register_stream(record_only, nullptr, item.first + item.second, "depth@100ms")
+			   || not ws_conn.register_stream(record_only, nullptr, item.first + item.second, "trade")) {
+				LOG_ERROR("The book of '%s%s' is not recorded.\n", item.first.c_str(), item.second.c_str());
+			}
+		}
+	}
+
+	if(cli.ws_api && not ws_conn.init_api(cli.api_key, cli.secret_key)) {
+		LOG_ERROR("WebSocket API initializing failure, the orders go over REST.\n");
+	}
+
+	metrics::Exporter exporter;
+	if(cli.metrics_port && not exporter.start(cli.metrics_port)) {
+		LOG_ERROR("The metrics are not exposed.\n");
+	}
+
+	// The streams are subscribed once and fanned out to the accounts.
+	market::Plane plane(ws_conn, cli.sbe, cli.tick_store_sec);
+
+	// Ahead of the applications, so the exchange is brought to the time of a tick before they take it.
+	if(cli.backtest) {
+		for(const auto& item : pairs) {
+			plane.subscribe(item.first + item.second, sim::Market::cb_tick, nullptr, &market);
+		}
+	}
+
+	shm::Publisher publisher;
+	if(not cli.shm_name.empty()) {
+		if(not publisher.create(cli.shm_name, Config::ShmRingCapacity)) {
+			LOG_CRITICAL("The market data bus initializing failure.\n");
+			return EXIT_FAILURE;
+		}
+		for(const auto& item : pairs) {
+			plane.subscribe(item.first + item.second, shm::Publisher::cb_tick, shm::Publisher::cb_stream_state, &publisher);
+		}
+	}
+
+	std::vector<std::unique_ptr<Application>> apps;
+	for(size_t idx = 0; idx < accounts.size(); ++idx) {
+		apps.emplace_back(new Application(*rest_conns[idx], plane, accounts[idx]));
+		if(not apps.back()->init()) {
+			LOG_CRITICAL("Application initialization has failed, account %zu.\n", idx);
+			// The accounts started detach their requests in flight, the connector outlives them.
+			apps.pop_back();
+			for(auto& app : apps) {
+				app->finit();
+			}
+			return EXIT_FAILURE;
+		}
+	}
+
+	// An account failing stops on its own, the others keep trading.
+	std::vector<bool> running(apps.size(), true);
+	size_t running_nb = apps.size();
+
+	if(not realtime.enter()) {
+		LOG_ERROR("The service loop is not tuned as asked.\n");
+	}
+
 	LOG_DEBUG("Entering the service loop...\n");
-	while(not signal_abort){
-		if(not app.service()) {
-			LOG_CRITICAL("Application servicing failure.\n");
-			err = EXIT_FAILURE;
-			break;
+	while(running_nb && not signal_abort && not ws_conn.replay_done()){
+		plane.service();
+		for(size_t idx = 0; idx < apps.size(); ++idx) {
+			if(running[idx] && not apps[idx]->service()) {
+				LOG_CRITICAL("Application servicing failure, account %zu.\n", idx);
+				err = EXIT_FAILURE;
+				apps[idx]->finit();
+				running[idx] = false;
+				running_nb--;
+			}
 		}
+		params.reclaim();
 	}
 	LOG_DEBUG("Leaving the service loop.\n");
 
-	app.finit();
+	for(size_t idx = 0; idx < apps.size(); ++idx) {
+		if(running[idx]) {
+			apps[idx]->finit();
+		}
+	}
+	ws_conn.dump_stats();
+	realtime.dump();
+	pnl::Portfolio::instance().dump();
+	if(cli.backtest) {
+		market.dump();
+		for(const auto& item : exchanges) {
+			item->dump();
+		}
+		latency.dump();
+	}
 
 	return err;
 }
@@ -88,7 +326,18 @@ int main(int argc, char** argv) {
 		return EXIT_FAILURE;
 	}
 
-	const auto err = run<AppDefault>(cli, culr_handler);
+	int err;
+	if(cli.app == "coro") {
+		err = run<AppCoro>(cli, culr_handler);
+	} else if(cli.app == "arbitrage") {
+		err = run<AppArbitrage>(cli, culr_handler);
+	} else if(cli.app == "volatility") {
+		err = run<AppVolatility>(cli, culr_handler);
+	} else if(cli.app == "decay") {
+		err = run<AppDecay>(cli, culr_handler);
+	} else {
+		err = run<AppDefault>(cli, culr_handler);
+	}
 
 	curl_global_cleanup();
 
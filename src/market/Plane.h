@@ -0,0 +1,173 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "TickStore.h"
+#include "../binance/ws/Connector.h"
+#include "../binance/ws/api.h"
+#include "../binance/sbe/stream.h"
+#include "../Log.h"
+
+namespace bench {
+struct AppDefaultProbe;
+}; // namespace bench
+
+namespace market {
+
+/**
+ * The market data shared by all the account contexts of the process.
+ *
+ * A symbol pair is subscribed once however many strategies watch it. A frame is parsed once, stored once into the
+ * TickStore of the pair and handed over to every subscriber by reference, so N accounts cost one subscription,
+ * one parse and no copies. The subscribers get the ticker and the TickStore read-only; both are valid during
+ * the callback, the store as long as the plane.
+ * Not thread safe, all the accounts run on the event loop thread.
+ */
+class Plane {
+
+	friend struct bench::AppDefaultProbe;
+
+public:
+
+	using TickCallBack_t = void (*)(void* instance, const binance::ws::SymbolTicker& ticker);
+	using StateCallBack_t = binance::ws::Connector::StateCallBack_t;
+
+private:
+
+	struct Subscriber {
+		TickCallBack_t callback;
+		StateCallBack_t state_callback;
+		void* instance;
+	};
+
+	struct Feed {
+		const std::string pair;
+		TickStore ticks;
+		bool registered;  // The stream is subscribed.
+		std::vector<Subscriber> subscribers;
+	};
+
+	binance::ws::Connector& _ws;
+	const bool _sbe;
+	const unsigned _tick_store_sec;
+	std::vector<std::unique_ptr<Feed>> _feeds;  // The stable addresses are the stream callback instances.
+
+public:
+
+	Plane(const Plane&) = delete;
+	Plane& operator=(const Plane&) = delete;
+
+	/**
+	 * @param sbe - The prices come from the SBE trade streams instead of the JSON tickers.
+	 * @param tick_store_sec - The retention of the TickStore of a pair.
+	 */
+	Plane(binance::ws::Connector& ws, const bool sbe, const unsigned tick_store_sec) noexcept :
+		_ws(ws),
+		_sbe(sbe),
+		_tick_store_sec(tick_store_sec) {
+	}
+
+	inline binance::ws::Connector& ws() noexcept {
+		return _ws;
+	}
+
+	/**
+	 * @return - The ticks of the pair. Written by the plane only, a subscriber reads them.
+	 */
+	inline TickStore& ticks(const std::string& pair) noexcept {
+		return feed(pair).ticks;
+	}
+
+	/**
+	 * Adds a consumer of the pair, the stream is subscribed on the first one.
+	 * @param state_callback - Optional.
+	 */
+	bool subscribe(
+		const std::string& pair, TickCallBack_t callback, StateCallBack_t state_callback, void* instance
+	              ) noexcept {
+		auto& item = feed(pair);
+		if(not item.registered) {
+			item.registered = _sbe ? _ws.register_sbe(cb_sbe_trade, &item, pair, "trade", cb_stream_state)
+			                       : _ws.register_ticker(cb_ticker, &item, pair, cb_stream_state);
+			if(not item.registered) {
+				LOG_ERROR("market::Plane::subscribe() unable to subscribe '%s'\n", pair.c_str());
+				return false;
+			}
+		}
+		item.subscribers.push_back(Subscriber{callback, state_callback, instance});
+		return true;
+	}
+
+	/**
+	 * Removes the consumer, the stream stays subscribed.
+	 */
+	void unsubscribe(const std::string& pair, void* instance) noexcept {
+		auto& subscribers = feed(pair).subscribers;
+		for(auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+			if(it->instance == instance) {
+				subscribers.erase(it);
+				break;
+			}
+		}
+	}
+
+	/**
+	 * Runs the streams once, the subscribers are called from within.
+	 */
+	inline void service() noexcept {
+		_ws.service();
+	}
+
+private:
+
+	Feed& feed(const std::string& pair) noexcept {
+		for(auto& item : _feeds) {
+			if(item->pair == pair) {
+				return *item;
+			}
+		}
+		_feeds.emplace_back(new Feed{pair, TickStore(_tick_store_sec), false, {}});
+		return *_feeds.back();
+	}
+
+	static inline void publish(Feed& feed, const binance::ws::SymbolTicker& ticker) noexcept {
+		feed.ticks.push(ticker);
+		for(const auto& item : feed.subscribers) {
+			item.callback(item.instance, ticker);
+		}
+	}
+
+	static int cb_ticker(void* instance, std::string_view text) noexcept {
+		binance::ws::SymbolTicker ticker;
+		if(not ticker.parse(text)) {
+			LOG_ERROR("market::Plane::cb_ticker() malformed ticker\n");
+			return EXIT_FAILURE;
+		}
+		publish(*reinterpret_cast<Feed*>(instance), ticker);
+		return EXIT_SUCCESS;
+	}
+
+	static int cb_sbe_trade(void* instance, const binance::sbe::Frame& frame) noexcept {
+		binance::ws::SymbolTicker ticker;
+		const auto event = frame.trades();
+		if(event == nullptr || not ticker.parse(*event)) {
+			return EXIT_FAILURE;
+		}
+		publish(*reinterpret_cast<Feed*>(instance), ticker);
+		return EXIT_SUCCESS;
+	}
+
+	static void cb_stream_state(void* instance, binance::ws::Connector::StreamState state) noexcept {
+		for(const auto& item : reinterpret_cast<Feed*>(instance)->subscribers) {
+			if(item.state_callback) {
+				item.state_callback(item.instance, state);
+			}
+		}
+	}
+
+};
+
+}; // namespace market
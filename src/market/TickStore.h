@@ -0,0 +1,370 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+#include "../binance/types.h"
+#include "../binance/ws/api.h"
+#include "../Log.h"
+#include "../Config.h"
+#include "../snapshot/Buffer.h"
+
+namespace market {
+
+/**
+ * A columnar ring of the recent ticks of one symbol.
+ * The fields are kept as struct-of-arrays, so a scan over one column walks contiguous memory.
+ * The ring is bounded by both the capacity and the retention duration; the oldest ticks are evicted first.
+ * The ticks are expected to come in the event time order, the late ones are rejected.
+ */
+class TickStore {
+public:
+
+	using Time = binance::Time;
+
+	struct Stats {
+		size_t count;
+		double price_first;
+		double price_last;
+		double price_min;
+		double price_max;
+		double price_mean;
+		double price_stddev;
+		double spread_mean;  // The mean of (ask - bid).
+		double vwap;         // Weighted by the last quantity.
+	};
+
+	/**
+	 * A range of the logical indexes [begin, end). The index 0 is the oldest tick.
+	 */
+	struct Range {
+		size_t begin;
+		size_t end;
+	};
+
+private:
+
+	const Time _duration_ms;
+	const size_t _capacity;
+
+	size_t _head;  // The physical index of the oldest tick.
+	size_t _size;
+
+	std::vector<Time> _time;
+	std::vector<double> _price;
+	std::vector<double> _quantity;
+	std::vector<double> _bid;
+	std::vector<double> _bid_qty;
+	std::vector<double> _ask;
+	std::vector<double> _ask_qty;
+
+public:
+
+	TickStore(const TickStore&) = delete;
+	TickStore& operator=(const TickStore&) = delete;
+
+	TickStore(TickStore&&) = default;
+	TickStore& operator=(TickStore&&) = delete;
+
+	/**
+	 * @param duration_sec - The retention period. MUST be greater than zero.
+	 * @param rate_per_sec - The expected ticks per second, used to size the columns.
+	 */
+	TickStore(unsigned duration_sec, unsigned rate_per_sec = Config::TickStoreRatePerSec) noexcept :
+		_duration_ms(duration_sec * 1000ull),
+		_capacity(std::max<size_t>(size_t(duration_sec) * rate_per_sec, 1u)),
+		_head(0u),
+		_size(0u),
+		_time(_capacity),
+		_price(_capacity),
+		_quantity(_capacity),
+		_bid(_capacity),
+		_bid_qty(_capacity),
+		_ask(_capacity),
+		_ask_qty(_capacity) {
+	}
+
+	inline size_t size() const noexcept {
+		return _size;
+	}
+
+	inline size_t capacity() const noexcept {
+		return _capacity;
+	}
+
+	inline Time duration_ms() const noexcept {
+		return _duration_ms;
+	}
+
+	/**
+	 * @return false - if the tick is older than the last one stored.
+	 */
+	bool push(const binance::ws::SymbolTicker& ticker) noexcept {
+		const auto time = ticker.eventTime;
+
+		if(_size && time < _time[physical(_size - 1u)]) {
+			return false;
+		}
+
+		// Eviction by the retention period.
+		while(_size && _time[_head] + _duration_ms < time) {
+			pop_front();
+		}
+
+		// Eviction by the capacity.
+		if(_size == _capacity) {
+			pop_front();
+		}
+
+		const auto idx = physical(_size);
+		_time[idx] = time;
+		_price[idx] = ticker.lastPrice;
+		_quantity[idx] = ticker.lastQuantity;
+		_bid[idx] = ticker.bestBidPrice;
+		_bid_qty[idx] = ticker.bestBidQuantity;
+		_ask[idx] = ticker.bestAskPrice;
+		_ask_qty[idx] = ticker.bestAskQuantity;
+		_size++;
+		return true;
+	}
+
+	inline void clear() noexcept {
+		_head = 0u;
+		_size = 0u;
+	}
+
+	/**
+	 * @return - The event time of the logical index. MUST be less than size().
+	 */
+	inline Time time(size_t idx) const noexcept {
+		return _time[physical(idx)];
+	}
+
+	inline double price(size_t idx) const noexcept {
+		return _price[physical(idx)];
+	}
+
+	inline Time time_last() const noexcept {
+		return _size ? time(_size - 1u) : 0u;
+	}
+
+	/**
+	 * O(log n).
+	 * @return - The logical index of the first tick not older than 'time'.
+	 */
+	size_t lower_bound(const Time time) const noexcept {
+		size_t lo = 0u;
+		size_t hi = _size;
+		while(lo < hi) {
+			const auto mid = lo + (hi - lo) / 2u;
+			if(_time[physical(mid)] < time) {
+				lo = mid + 1u;
+			} else {
+				hi = mid;
+			}
+		}
+		return lo;
+	}
+
+	/**
+	 * @return - The ticks of the time range [from, to].
+	 */
+	inline Range range(const Time from, const Time to) const noexcept {
+		const auto begin = lower_bound(from);
+		const auto end = (to == ~Time(0u)) ? _size : lower_bound(to + 1u);
+		return Range{begin, std::max(begin, end)};
+	}
+
+	/**
+	 * @return - The stats of the last 'window_ms' milliseconds counting from the last tick.
+	 */
+	inline Stats stats_last(const Time window_ms) const noexcept {
+		const auto last = time_last();
+		const auto from = last > window_ms ? last - window_ms : 0u;
+		return stats(range(from, ~Time(0u)));
+	}
+
+	inline Stats stats(const Time from, const Time to) const noexcept {
+		return stats(range(from, to));
+	}
+
+	Stats stats(const Range& rng) const noexcept {
+		Stats result;
+		memset(&result, 0, sizeof(result));
+
+		const auto count = rng.end - rng.begin;
+		if(count == 0u) {
+			return result;
+		}
+
+		Accumulator acc;
+		acc.reset(_price[physical(rng.begin)]);
+
+		// The ring is scanned as at most two contiguous spans.
+		const auto first = physical(rng.begin);
+		const auto first_nb = std::min(count, _capacity - first);
+		scan(acc, first, first_nb);
+		scan(acc, 0u, count - first_nb);
+
+		const auto n = static_cast<double>(count);
+		result.count = count;
+		result.price_first = _price[physical(rng.begin)];
+		result.price_last = _price[physical(rng.end - 1u)];
+		result.price_min = acc.min;
+		result.price_max = acc.max;
+		result.price_mean = acc.sum / n;
+		result.price_stddev = std::sqrt(std::max(acc.sum_sq / n - result.price_mean * result.price_mean, 0.));
+		result.spread_mean = acc.spread / n;
+		result.vwap = acc.volume > 0. ? acc.notional / acc.volume : result.price_mean;
+		return result;
+	}
+
+	/**
+	 * Writes the ticks from the oldest one.
+	 */
+	void save(snapshot::Encoder& enc) const noexcept {
+		enc.put(static_cast<uint64_t>(_size));
+		for(size_t idx = 0; idx < _size; ++idx) {
+			const auto phy = physical(idx);
+			enc.put(_time[phy]);
+			enc.put(_price[phy]);
+			enc.put(_quantity[phy]);
+			enc.put(_bid[phy]);
+			enc.put(_bid_qty[phy]);
+			enc.put(_ask[phy]);
+			enc.put(_ask_qty[phy]);
+		}
+	}
+
+	/**
+	 * Fills the empty store with the saved ticks; the newest ones are kept if the capacity is smaller now.
+	 * The ticks out of the retention period are evicted by the next push().
+	 * A store holding the ticks already, e.g. restored by another account, keeps them; the saved ones are read through.
+	 */
+	bool restore(snapshot::Decoder& dec) noexcept {
+		uint64_t count = 0u;
+		dec.get(count);
+		if(_size) {
+			Time time;
+			double value;
+			for(uint64_t idx = 0; idx < count && dec.get(time); ++idx) {
+				for(unsigned col = 0; col < 6u; ++col) {
+					dec.get(value);
+				}
+			}
+			return dec.ok();
+		}
+		for(uint64_t idx = 0; idx < count && dec.ok(); ++idx) {
+			if(_size == _capacity) {
+				pop_front();
+			}
+			const auto phy = physical(_size);
+			dec.get(_time[phy]);
+			dec.get(_price[phy]);
+			dec.get(_quantity[phy]);
+			dec.get(_bid[phy]);
+			dec.get(_bid_qty[phy]);
+			dec.get(_ask[phy]);
+			dec.get(_ask_qty[phy]);
+			_size++;
+		}
+		if(not dec.ok()) {
+			clear();
+		}
+		return dec.ok();
+	}
+
+	void dump(const char* symbol, const Time window_ms) const noexcept {
+		const auto st = stats_last(window_ms);
+		LOG_INFO("'%s' ticks=%zu/%zu over %zu sec", symbol, st.count, _size, static_cast<size_t>(window_ms / 1000u));
+		LOG_PLAIN(" min=%f max=%f mean=%f stddev=%f vwap=%f spread=%f\n", st.price_min, st.price_max,
+		          st.price_mean, st.price_stddev, st.vwap, st.spread_mean);
+	}
+
+private:
+
+	struct Accumulator {
+		double min;
+		double max;
+		double sum;
+		double sum_sq;
+		double spread;
+		double notional;
+		double volume;
+
+		inline void reset(double price) noexcept {
+			min = max = price;
+			sum = sum_sq = spread = notional = volume = 0.;
+		}
+	};
+
+	inline size_t physical(size_t idx) const noexcept {
+		idx += _head;
+		return idx < _capacity ? idx : idx - _capacity;
+	}
+
+	inline void pop_front() noexcept {
+		_head = physical(1u);
+		_size--;
+	}
+
+	/**
+	 * A branch-free scan over the contiguous span of the columns.
+	 * The reductions are kept in independent lanes, so the loop is vectorizable without -ffast-math.
+	 */
+	void scan(Accumulator& acc, const size_t begin, const size_t nb) const noexcept {
+		static constexpr size_t Lanes = 4u;
+
+		const double* price = _price.data() + begin;
+		const double* qty = _quantity.data() + begin;
+		const double* bid = _bid.data() + begin;
+		const double* ask = _ask.data() + begin;
+
+		double mn[Lanes], mx[Lanes], sum[Lanes], sq[Lanes], spr[Lanes], ntl[Lanes], vol[Lanes];
+		for(size_t l = 0; l < Lanes; ++l) {
+			mn[l] = acc.min;
+			mx[l] = acc.max;
+			sum[l] = sq[l] = spr[l] = ntl[l] = vol[l] = 0.;
+		}
+
+		size_t idx = 0;
+		for(; idx + Lanes <= nb; idx += Lanes) {
+			for(size_t l = 0; l < Lanes; ++l) {
+				const double p = price[idx + l];
+				mn[l] = p < mn[l] ? p : mn[l];
+				mx[l] = p > mx[l] ? p : mx[l];
+				sum[l] += p;
+				sq[l] += p * p;
+				spr[l] += ask[idx + l] - bid[idx + l];
+				ntl[l] += p * qty[idx + l];
+				vol[l] += qty[idx + l];
+			}
+		}
+
+		for(; idx < nb; ++idx) {
+			const double p = price[idx];
+			mn[0] = p < mn[0] ? p : mn[0];
+			mx[0] = p > mx[0] ? p : mx[0];
+			sum[0] += p;
+			sq[0] += p * p;
+			spr[0] += ask[idx] - bid[idx];
+			ntl[0] += p * qty[idx];
+			vol[0] += qty[idx];
+		}
+
+		for(size_t l = 0; l < Lanes; ++l) {
+			acc.min = std::min(acc.min, mn[l]);
+			acc.max = std::max(acc.max, mx[l]);
+			acc.sum += sum[l];
+			acc.sum_sq += sq[l];
+			acc.spread += spr[l];
+			acc.notional += ntl[l];
+			acc.volume += vol[l];
+		}
+	}
+
+};
+
+}; // namespace market
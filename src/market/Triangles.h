@@ -0,0 +1,277 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../binance/Assets.h"
+#include "../parser/Simd.h"
+
+namespace market {
+
+/**
+ * The triangular arbitrage over a set of pairs, e.g. BNB/BTC, BTC/USDT, BNB/USDT.
+ *
+ * The best bid and ask of a pair are two edges of a dense adjacency matrix of the assets: the rate of the
+ * asset 'from' into the asset 'to' net of the taker fee. A cycle A->B->C->A is profitable if the product of its
+ * three rates exceeds one by the minimum profit. update() writes the two edges of the pair and evaluates only the
+ * cycles through the pair, four at a time with AVX2 gathers if the target has them.
+ * The cycles of a pair are padded to a multiple of four with a zero rate edge, which is never profitable.
+ */
+class Triangles {
+
+	using Index_t = int32_t;  // A flat index into the matrix.
+
+	static constexpr uint32_t NoCycle = ~uint32_t(0u);
+	static constexpr size_t Lanes = 4u;
+
+	struct Pair {
+		uint32_t base;   // The asset indices.
+		uint32_t quote;
+		size_t begin;    // The cycles through the pair, [begin, end) of the SoA arrays.
+		size_t end;
+	};
+
+	struct Cycle {
+		uint32_t assets[3];
+		Index_t edges[3];
+	};
+
+	double _fee_factor;  // One minus the taker fee.
+	double _threshold;   // One plus the minimum profit.
+
+	std::vector<binance::AssetId> _assets;  // The index -> the asset.
+	std::vector<Pair> _pairs;
+	std::vector<Cycle> _cycles;
+	std::vector<double> _rates;  // N x N, [from * N + to]; the diagonal is zero.
+
+	// The cycles through each of the pairs, the SoA for the gathers.
+	std::vector<Index_t> _edge0;
+	std::vector<Index_t> _edge1;
+	std::vector<Index_t> _edge2;
+	std::vector<uint32_t> _cycle;
+
+	std::vector<uint8_t> _open;     // The cycle is profitable, reported once until it is not.
+	std::vector<uint32_t> _opened;  // The cycles became profitable by the last update().
+	size_t _open_nb;
+
+	uint64_t _updates;
+	uint64_t _evaluations;
+
+public:
+
+	Triangles() noexcept : _fee_factor(1.), _threshold(1.), _open_nb(0u), _updates(0u), _evaluations(0u) {
+	}
+
+	/**
+	 * Called before build().
+	 * @return - The ID of the pair for update().
+	 */
+	uint32_t add_pair(const binance::AssetId base, const binance::AssetId quote) noexcept {
+		_pairs.push_back(Pair{index_of(base), index_of(quote), 0u, 0u});
+		return _pairs.size() - 1u;
+	}
+
+	/**
+	 * Enumerates the cycles of the pairs added.
+	 * @param fee - The taker commission rate, e.g. 0.001.
+	 * @param min_profit - The net profit a cycle is reported from, e.g. 0.0005.
+	 */
+	void build(const double fee, const double min_profit) noexcept {
+		_fee_factor = 1. - fee;
+		_threshold = 1. + min_profit;
+
+		const size_t nb = _assets.size();
+		_rates.assign(nb * nb, 0.);
+
+		std::vector<uint8_t> adjacent(nb * nb, 0u);
+		for(const auto& item : _pairs) {
+			adjacent[item.base * nb + item.quote] = 1u;
+			adjacent[item.quote * nb + item.base] = 1u;
+		}
+
+		// Both directions of each triangle.
+		_cycles.clear();
+		for(uint32_t a = 0; a < nb; ++a) {
+			for(uint32_t b = a + 1u; b < nb; ++b) {
+				if(not adjacent[a * nb + b]) {
+					continue;
+				}
+				for(uint32_t c = b + 1u; c < nb; ++c) {
+					if(adjacent[b * nb + c] && adjacent[c * nb + a]) {
+						_cycles.push_back(make_cycle(a, b, c));
+						_cycles.push_back(make_cycle(a, c, b));
+					}
+				}
+			}
+		}
+
+		_edge0.clear();
+		_edge1.clear();
+		_edge2.clear();
+		_cycle.clear();
+		for(auto& item : _pairs) {
+			item.begin = _cycle.size();
+			for(uint32_t idx = 0; idx < _cycles.size(); ++idx) {
+				if(touches(_cycles[idx], item)) {
+					push(_cycles[idx].edges, idx);
+				}
+			}
+			while((_cycle.size() - item.begin) % Lanes) {
+				const Index_t zero[3] = {0, 0, 0};
+				push(zero, NoCycle);
+			}
+			item.end = _cycle.size();
+		}
+
+		_open.assign(_cycles.size(), 0u);
+		_opened.clear();
+		_open_nb = 0u;
+	}
+
+	/**
+	 * Takes the quote of the pair and evaluates the cycles through it.
+	 * A zero bid or ask, e.g. of a stale stream, takes the direction out of the evaluation.
+	 * @return - The cycles became profitable, see opened().
+	 */
+	size_t update(const uint32_t pair, const double bid, const double ask) noexcept {
+		const auto& item = _pairs[pair];
+		const size_t nb = _assets.size();
+		_rates[item.base * nb + item.quote] = (bid > 0.) ? bid * _fee_factor : 0.;
+		_rates[item.quote * nb + item.base] = (ask > 0.) ? _fee_factor / ask : 0.;
+
+		_opened.clear();
+		_updates++;
+		_evaluations += item.end - item.begin;
+		for(size_t idx = item.begin; idx < item.end; idx += Lanes) {
+			const unsigned mask = evaluate(idx);
+			if(mask || _open_nb) {
+				transition(idx, mask);
+			}
+		}
+		return _opened.size();
+	}
+
+	inline const std::vector<uint32_t>& opened() const noexcept {
+		return _opened;
+	}
+
+	/**
+	 * @return - The net rate of the cycle, above one is a profit.
+	 */
+	inline double rate(const uint32_t cycle) const noexcept {
+		const auto& item = _cycles[cycle];
+		return _rates[item.edges[0]] * _rates[item.edges[1]] * _rates[item.edges[2]];
+	}
+
+	/**
+	 * @param leg - 0, 1 or 2.
+	 * @return - The asset the leg of the cycle starts from.
+	 */
+	inline binance::AssetId asset(const uint32_t cycle, const unsigned leg) const noexcept {
+		return _assets[_cycles[cycle].assets[leg]];
+	}
+
+	inline size_t assets_nb() const noexcept {
+		return _assets.size();
+	}
+
+	inline size_t pairs_nb() const noexcept {
+		return _pairs.size();
+	}
+
+	inline size_t cycles_nb() const noexcept {
+		return _cycles.size();
+	}
+
+	inline uint64_t updates() const noexcept {
+		return _updates;
+	}
+
+	inline uint64_t evaluations() const noexcept {
+		return _evaluations;
+	}
+
+private:
+
+	uint32_t index_of(const binance::AssetId asset) noexcept {
+		for(uint32_t idx = 0; idx < _assets.size(); ++idx) {
+			if(_assets[idx] == asset) {
+				return idx;
+			}
+		}
+		_assets.push_back(asset);
+		return _assets.size() - 1u;
+	}
+
+	Cycle make_cycle(const uint32_t a, const uint32_t b, const uint32_t c) const noexcept {
+		const Index_t nb = _assets.size();
+		return Cycle {
+			{a, b, c},
+			{static_cast<Index_t>(a * nb + b), static_cast<Index_t>(b * nb + c), static_cast<Index_t>(c * nb + a)}
+		};
+	}
+
+	static bool touches(const Cycle& cycle, const Pair& pair) noexcept {
+		for(unsigned leg = 0; leg < 3u; ++leg) {
+			const auto from = cycle.assets[leg];
+			const auto to = cycle.assets[(leg + 1u) % 3u];
+			if((from == pair.base && to == pair.quote) || (from == pair.quote && to == pair.base)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void push(const Index_t* edges, const uint32_t cycle) noexcept {
+		_edge0.push_back(edges[0]);
+		_edge1.push_back(edges[1]);
+		_edge2.push_back(edges[2]);
+		_cycle.push_back(cycle);
+	}
+
+	/**
+	 * @return - The bit of a lane is set if the cycle of the lane is profitable.
+	 */
+	inline unsigned evaluate(const size_t idx) const noexcept {
+		const double* rates = _rates.data();
+#if defined(BINTEST_SIMD_AVX2)
+		const auto e0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&_edge0[idx]));
+		const auto e1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&_edge1[idx]));
+		const auto e2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&_edge2[idx]));
+		// The masked gathers, as the plain ones leave GCC warning of an uninitialized source.
+		const auto zero = _mm256_setzero_pd();
+		const auto all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+		auto product = _mm256_mask_i32gather_pd(zero, rates, e0, all, sizeof(double));
+		product = _mm256_mul_pd(product, _mm256_mask_i32gather_pd(zero, rates, e1, all, sizeof(double)));
+		product = _mm256_mul_pd(product, _mm256_mask_i32gather_pd(zero, rates, e2, all, sizeof(double)));
+		return _mm256_movemask_pd(_mm256_cmp_pd(product, _mm256_set1_pd(_threshold), _CMP_GT_OQ));
+#else
+		unsigned mask = 0u;
+		for(size_t lane = 0; lane < Lanes; ++lane) {
+			const double product = rates[_edge0[idx + lane]] * rates[_edge1[idx + lane]] * rates[_edge2[idx + lane]];
+			mask |= static_cast<unsigned>(product > _threshold) << lane;
+		}
+		return mask;
+#endif
+	}
+
+	void transition(const size_t idx, const unsigned mask) noexcept {
+		for(size_t lane = 0; lane < Lanes; ++lane) {
+			const auto cycle = _cycle[idx + lane];
+			const uint8_t profitable = (mask >> lane) & 1u;
+			if(cycle == NoCycle || _open[cycle] == profitable) {
+				continue;
+			}
+			_open[cycle] = profitable;
+			if(profitable) {
+				_open_nb++;
+				_opened.push_back(cycle);
+			} else {
+				_open_nb--;
+			}
+		}
+	}
+
+};
+
+}; // namespace market
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "Metrics.h"
+#include "../Config.h"
+#include "../Log.h"
+
+namespace metrics {
+
+/**
+ * The HTTP/1.0 listener serving the Registry at 'GET /metrics'.
+ *
+ * Runs on its own thread and only reads the metrics, so the scrapes never touch the event loop.
+ * One request per connection, the connection is closed after the response.
+ */
+class Exporter {
+
+	int _fd;
+	std::atomic<bool> _stop;
+	std::thread _thread;
+
+public:
+
+	Exporter(const Exporter&) = delete;
+	Exporter& operator=(const Exporter&) = delete;
+
+	Exporter() noexcept : _fd(-1), _stop(false) {
+	}
+
+	~Exporter() noexcept {
+		stop();
+	}
+
+	/**
+	 * @param port - The port at Config::MetricsBindAddress.
+	 */
+	bool start(const unsigned port) noexcept {
+		_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if(_fd < 0) {
+			LOG_ERROR("metrics::Exporter::start() socket() fails. errno=%d\n", errno);
+			return false;
+		}
+
+		const int yes = 1;
+		setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+		sockaddr_in addr {};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(static_cast<uint16_t>(port));
+		if(inet_pton(AF_INET, Config::MetricsBindAddress, &addr.sin_addr) != 1
+		   || bind(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+		   || listen(_fd, Config::MetricsBacklog) != 0) {
+			LOG_ERROR("metrics::Exporter::start() fails to listen at %s:%u. errno=%d\n", Config::MetricsBindAddress, port, errno);
+			close(_fd);
+			_fd = -1;
+			return false;
+		}
+
+		_stop = false;
+		_thread = std::thread(&Exporter::run, this);
+		LOG_INFO("The metrics are exposed at http://%s:%u/metrics\n", Config::MetricsBindAddress, port);
+		return true;
+	}
+
+	void stop() noexcept {
+		_stop = true;
+		if(_thread.joinable()) {
+			_thread.join();
+		}
+		if(_fd >= 0) {
+			close(_fd);
+			_fd = -1;
+		}
+	}
+
+private:
+
+	void run() noexcept {
+		pollfd pfd {_fd, POLLIN, 0};
+		while(not _stop) {
+			if(poll(&pfd, 1, Config::MetricsPollTimeoutMS) <= 0) {
+				continue;
+			}
+			const int client = accept4(_fd, nullptr, nullptr, SOCK_CLOEXEC);
+			if(client >= 0) {
+				serve(client);
+				close(client);
+			}
+		}
+	}
+
+	void serve(const int client) noexcept {
+		timeval timeout {0, Config::MetricsPollTimeoutMS * 1000};
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+		// Only the request line matters, the headers are not read through.
+		char request[Config::MetricsRequestBytes];
+		const ssize_t len = recv(client, request, sizeof(request) - 1u, 0);
+		if(len <= 0) {
+			return;
+		}
+		request[len] = 0;
+
+		std::string body;
+		const char* status = "404 Not Found";
+		if(strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET / ", 6) == 0) {
+			status = "200 OK";
+			Registry::instance().expose(body);
+		}
+
+		std::string response("HTTP/1.0 ");
+		response.append(status);
+		response.append("\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: ");
+		response.append(std::to_string(body.size()));
+		response.append("\r\nConnection: close\r\n\r\n");
+		response.append(body);
+
+		size_t sent = 0;
+		while(sent < response.size()) {
+			const ssize_t rc = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+			if(rc <= 0) {
+				break;
+			}
+			sent += rc;
+		}
+	}
+
+};
+
+}; // namespace metrics
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+#include "../Config.h"
+#include "../Log.h"
+
+/**
+ * The process wide metrics in the Prometheus text exposition format.
+ *
+ * A metric is registered once, off the hot path, and the reference returned is updated afterwards.
+ * The counters and the histograms are sharded per thread over the cache line sized cells, so the threads
+ * updating a metric never share a cache line and the exposition only reads. The updates are relaxed atomics.
+ */
+namespace metrics {
+
+static constexpr size_t CacheLine = 64u;
+
+/**
+ * @return - The shard of the calling thread. The threads beyond Config::MetricsThreads share the shards.
+ */
+inline size_t thread_slot() noexcept {
+	static std::atomic<size_t> next {0u};
+	thread_local const size_t slot = next.fetch_add(1u, std::memory_order_relaxed) % Config::MetricsThreads;
+	return slot;
+}
+
+/**
+ * @return - The label pair 'key="value"' with the value escaped.
+ */
+inline std::string label(const char* key, std::string_view value) noexcept {
+	std::string result(key);
+	result.append("=\"");
+	for(const auto ch : value) {
+		switch(ch) {
+			case '\\':
+				result.append("\\\\");
+				break;
+			case '"':
+				result.append("\\\"");
+				break;
+			case '\n':
+				result.append("\\n");
+				break;
+			default:
+				result.push_back(ch);
+				break;
+		}
+	}
+	result.push_back('"');
+	return result;
+}
+
+class Counter {
+
+	struct alignas(CacheLine) Cell {
+		std::atomic<uint64_t> value {0u};
+	};
+
+	Cell _cells[Config::MetricsThreads];
+
+public:
+
+	inline void inc(const uint64_t value = 1u) noexcept {
+		_cells[thread_slot()].value.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	uint64_t value() const noexcept {
+		uint64_t result = 0u;
+		for(const auto& cell : _cells) {
+			result += cell.value.load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+};
+
+/**
+ * A value set by one owner, e.g. the trading thread.
+ */
+class Gauge {
+
+	alignas(CacheLine) std::atomic<double> _value {0.};
+
+public:
+
+	inline void set(const double value) noexcept {
+		_value.store(value, std::memory_order_relaxed);
+	}
+
+	inline void add(const double value) noexcept {
+		_value.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	inline double value() const noexcept {
+		return _value.load(std::memory_order_relaxed);
+	}
+};
+
+class Histogram {
+
+	struct alignas(CacheLine) Shard {
+		std::atomic<uint64_t> buckets[Config::MetricsMaxBuckets + 1u /*+Inf*/] {};
+		std::atomic<double> sum {0.};
+	};
+
+	const std::vector<double> _bounds;  // The bucket upper bounds, ascending.
+	Shard _shards[Config::MetricsThreads];
+
+public:
+
+	Histogram(const Histogram&) = delete;
+	Histogram& operator=(const Histogram&) = delete;
+
+	/**
+	 * @param bounds - No more than Config::MetricsMaxBuckets, the excess is dropped.
+	 */
+	explicit Histogram(std::vector<double> bounds) noexcept : _bounds(sorted(std::move(bounds))) {
+	}
+
+	inline void observe(const double value) noexcept {
+		const auto idx = std::lower_bound(_bounds.begin(), _bounds.end(), value) - _bounds.begin();
+		auto& shard = _shards[thread_slot()];
+		shard.buckets[idx].fetch_add(1u, std::memory_order_relaxed);
+		shard.sum.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	inline const std::vector<double>& bounds() const noexcept {
+		return _bounds;
+	}
+
+	/**
+	 * @return - The observations in the bucket, not cumulative. The last bucket is +Inf.
+	 */
+	uint64_t bucket(const size_t idx) const noexcept {
+		uint64_t result = 0u;
+		for(const auto& shard : _shards) {
+			result += shard.buckets[idx].load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	double sum() const noexcept {
+		double result = 0.;
+		for(const auto& shard : _shards) {
+			result += shard.sum.load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+private:
+
+	static std::vector<double> sorted(std::vector<double> bounds) noexcept {
+		std::sort(bounds.begin(), bounds.end());
+		if(bounds.size() > Config::MetricsMaxBuckets) {
+			bounds.resize(Config::MetricsMaxBuckets);
+		}
+		return bounds;
+	}
+};
+
+/**
+ * The latency buckets in seconds, from 100us to 10s.
+ */
+inline std::vector<double> latency_buckets() noexcept {
+	return {.0001, .00025, .0005, .001, .0025, .005, .01, .025, .05, .1, .25, .5, 1., 2.5, 10.};
+}
+
+class Registry {
+
+	enum class Type : unsigned {
+		Counter,
+		Gauge,
+		Histogram
+	};
+
+	struct Series {
+		std::string labels;
+		std::unique_ptr<Counter> counter;
+		std::unique_ptr<Gauge> gauge;
+		std::unique_ptr<Histogram> histogram;
+	};
+
+	struct Family {
+		std::string name;
+		std::string help;
+		Type type;
+		std::deque<Series> series;
+	};
+
+	mutable std::mutex _mutex;  // The registration and the exposition only.
+	std::deque<Family> _families;
+	std::deque<Series> _rejected;  // Registered with the type other than the family one, never exposed.
+
+public:
+
+	Registry(const Registry&) = delete;
+	Registry& operator=(const Registry&) = delete;
+
+	static Registry& instance() noexcept {
+		static Registry reg;
+		return reg;
+	}
+
+	/**
+	 * @return - The series of the family with the labels, a new one if it has not been registered yet.
+	 */
+	Counter& counter(const char* name, const char* help, const std::string& labels = "") noexcept {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto& series = find(name, help, Type::Counter, labels);
+		if(not series.counter) {
+			series.counter.reset(new Counter());
+		}
+		return *series.counter;
+	}
+
+	Gauge& gauge(const char* name, const char* help, const std::string& labels = "") noexcept {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto& series = find(name, help, Type::Gauge, labels);
+		if(not series.gauge) {
+			series.gauge.reset(new Gauge());
+		}
+		return *series.gauge;
+	}
+
+	/**
+	 * @param bounds - Used by the first registration of the series only.
+	 */
+	Histogram& histogram(
+		const char* name, const char* help, const std::string& labels = "", std::vector<double> bounds = latency_buckets()
+	                    ) noexcept {
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto& series = find(name, help, Type::Histogram, labels);
+		if(not series.histogram) {
+			series.histogram.reset(new Histogram(std::move(bounds)));
+		}
+		return *series.histogram;
+	}
+
+	/**
+	 * Appends all the metrics in the text exposition format.
+	 */
+	void expose(std::string& out) const noexcept {
+		std::lock_guard<std::mutex> lock(_mutex);
+		char buffer[64];
+
+		for(const auto& family : _families) {
+			out.append("# HELP " + family.name + " " + family.help + "\n");
+			out.append("# TYPE " + family.name + " " + type_name(family.type) + "\n");
+
+			for(const auto& series : family.series) {
+				const std::string labels = series.labels.empty() ? "" : "{" + series.labels + "}";
+				switch(family.type) {
+					case Type::Counter:
+						snprintf(buffer, sizeof(buffer), " %lu\n", static_cast<unsigned long>(series.counter->value()));
+						out.append(family.name + labels + buffer);
+						break;
+
+					case Type::Gauge:
+						snprintf(buffer, sizeof(buffer), " %.17g\n", series.gauge->value());
+						out.append(family.name + labels + buffer);
+						break;
+
+					case Type::Histogram:
+						expose(out, family.name, series.labels, *series.histogram);
+						break;
+				}
+			}
+		}
+	}
+
+private:
+
+	Registry() noexcept = default;
+
+	Series& find(const char* name, const char* help, const Type type, const std::string& labels) noexcept {
+		auto family = std::find_if(_families.begin(), _families.end(), [name](const Family& item) {
+			return item.name == name;
+		});
+		if(family == _families.end()) {
+			_families.push_back(Family {name, help, type, {}});
+			family = std::prev(_families.end());
+		} else if(family->type != type) {
+			LOG_ERROR("metrics::Registry '%s' is a %s, not a %s, the series is not exposed.\n",
+			          name, type_name(family->type), type_name(type));
+			_rejected.push_back(Series {labels, nullptr, nullptr, nullptr});
+			return _rejected.back();
+		}
+
+		auto series = std::find_if(family->series.begin(), family->series.end(), [&labels](const Series& item) {
+			return item.labels == labels;
+		});
+		if(series == family->series.end()) {
+			family->series.push_back(Series {labels, nullptr, nullptr, nullptr});
+			series = std::prev(family->series.end());
+		}
+		return *series;
+	}
+
+	static void expose(std::string& out, const std::string& name, const std::string& labels, const Histogram& hist) noexcept {
+		char buffer[64];
+		const std::string prefix = labels.empty() ? "" : labels + ",";
+		uint64_t count = 0u;
+
+		for(size_t idx = 0; idx <= hist.bounds().size(); ++idx) {
+			count += hist.bucket(idx);
+			if(idx < hist.bounds().size()) {
+				snprintf(buffer, sizeof(buffer), "le=\"%g\"} %lu\n", hist.bounds()[idx], static_cast<unsigned long>(count));
+			} else {
+				snprintf(buffer, sizeof(buffer), "le=\"+Inf\"} %lu\n", static_cast<unsigned long>(count));
+			}
+			out.append(name + "_bucket{" + prefix + buffer);
+		}
+
+		const std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+		snprintf(buffer, sizeof(buffer), " %.17g\n", hist.sum());
+		out.append(name + "_sum" + suffix + buffer);
+		snprintf(buffer, sizeof(buffer), " %lu\n", static_cast<unsigned long>(count));
+		out.append(name + "_count" + suffix + buffer);
+	}
+
+	static const char* type_name(const Type type) noexcept {
+		switch(type) {
+			case Type::Counter:
+				return "counter";
+			case Type::Gauge:
+				return "gauge";
+			case Type::Histogram:
+				return "histogram";
+		}
+		return "untyped";
+	}
+
+};
+
+}; // namespace metrics
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string_view>
+
+#include "../cli/types/Integer.h"
+#include "../cli/types/Float.h"
+#include "../Log.h"
+
+namespace params {
+
+/**
+ * The strategy parameters which may be changed while trading, see params::Store.
+ * Taken from the CLI at the start, then from the parameters file if any.
+ */
+struct Params {
+	double price_trigger_percent;
+	unsigned trade_period_sec;
+	unsigned wait_period_sec;
+	double quantity;
+
+	/**
+	 * The rules of CliConfig::validate() for these parameters.
+	 */
+	bool validate() const noexcept {
+		bool result = true;
+		result &= (trade_period_sec > 0u);
+		result &= (wait_period_sec > 0u);
+		result &= (price_trigger_percent > .0);
+		result &= (quantity > .0);
+		return result;
+	}
+
+	/**
+	 * Parses the value of the parameter named as the CliConfig field.
+	 * @return false - if the name is unknown or the value is malformed.
+	 */
+	bool set(const std::string_view name, const char* value) noexcept {
+		if(name == "price_trigger_percent") {
+			return cli::Float::parse(value, price_trigger_percent);
+		} else if(name == "trade_period_sec") {
+			return cli::Integer::parse(value, trade_period_sec);
+		} else if(name == "wait_period_sec") {
+			return cli::Integer::parse(value, wait_period_sec);
+		} else if(name == "quantity") {
+			return cli::Float::parse(value, quantity);
+		}
+		return false;
+	}
+
+	/**
+	 * Continues the current log line.
+	 */
+	void dump() const noexcept {
+		LOG_PLAIN(" price_trigger_percent=%f", price_trigger_percent);
+		LOG_PLAIN(" trade_period_sec=%u", trade_period_sec);
+		LOG_PLAIN(" wait_period_sec=%u", wait_period_sec);
+		LOG_PLAIN(" quantity=%f\n", quantity);
+	}
+};
+
+}; // namespace params
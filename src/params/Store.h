@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Params.h"
+#include "../CliConfig.h"
+#include "../Log.h"
+
+namespace params {
+
+/**
+ * The process wide current Params, the CLI defaults until the first publish().
+ *
+ * A snapshot is immutable once published; a reload publishes a new one by swapping the pointer, so get() is
+ * a single acquire load on the tick path. The replaced snapshots are retired, not freed: the event loop frees
+ * them at its quiescent point, reclaim(), between the iterations. So a reader MUST NOT keep the reference
+ * across the loop iterations, a copy is to be taken instead.
+ * get() and reclaim() are called on the event loop thread, publish() on one other thread at a time,
+ * which may get() the current snapshot too as nobody else retires it.
+ */
+class Store {
+
+	std::atomic<const Params*> _current;
+	std::atomic<size_t> _retired_nb;
+	std::mutex _mutex;               // Guards the retired ones against publish().
+	std::vector<const Params*> _retired;
+	std::atomic<uint64_t> _version;  // The number of the snapshots published.
+
+public:
+
+	Store(const Store&) = delete;
+	Store& operator=(const Store&) = delete;
+
+	static Store& instance() noexcept {
+		static Store store;
+		return store;
+	}
+
+	~Store() noexcept {
+		reclaim();
+		delete _current.load();
+	}
+
+	/**
+	 * Wait-free.
+	 */
+	inline const Params& get() const noexcept {
+		return *_current.load(std::memory_order_acquire);
+	}
+
+	inline uint64_t version() const noexcept {
+		return _version.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Makes the parameters the current ones.
+	 * @return false - if the parameters are not valid, the current ones stay.
+	 */
+	bool publish(const Params& params) noexcept {
+		if(not params.validate()) {
+			return false;
+		}
+		const auto prev = _current.exchange(new Params(params), std::memory_order_acq_rel);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_retired.push_back(prev);
+			_retired_nb.store(_retired.size(), std::memory_order_release);
+		}
+		_version.fetch_add(1u, std::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	 * Frees the retired snapshots. Only a relaxed load unless a reload has happened.
+	 */
+	inline void reclaim() noexcept {
+		if(_retired_nb.load(std::memory_order_relaxed)) {
+			reclaim_retired();
+		}
+	}
+
+	/**
+	 * Reads the parameters file over 'params': 'name = value' lines, named as the CliConfig fields;
+	 * '#' starts a comment. The parameters missing in the file are left as they are.
+	 * @return false - if the file can not be read or has a malformed line.
+	 */
+	static bool load(const char* path, Params& params) noexcept {
+		FILE* file = fopen(path, "r");
+		if(file == nullptr) {
+			LOG_ERROR("params::Store::load() unable to open '%s'\n", path);
+			return false;
+		}
+
+		bool result = true;
+		char line[256];
+		unsigned line_nb = 0u;
+		while(result && fgets(line, sizeof(line), file)) {
+			line_nb++;
+			char* comment = strchr(line, '#');
+			if(comment) {
+				*comment = 0;
+			}
+
+			if(line[strspn(line, " \t\r\n")] == 0) {
+				continue;
+			}
+
+			char name[64];
+			char value[64];
+			char rest[2];
+			if(sscanf(line, " %63[A-Za-z_] = %63s %1s", name, value, rest) != 2 || not params.set(name, value)) {
+				LOG_ERROR("params::Store::load() '%s' malformed line %u\n", path, line_nb);
+				result = false;
+			}
+		}
+		fclose(file);
+		return result;
+	}
+
+private:
+
+	Store() noexcept : _current(new Params(CliConfig().params())), _retired_nb(0u), _version(0u) {
+	}
+
+	void reclaim_retired() noexcept {
+		std::lock_guard<std::mutex> lock(_mutex);
+		for(const auto item : _retired) {
+			delete item;
+		}
+		_retired.clear();
+		_retired_nb.store(0u, std::memory_order_relaxed);
+	}
+
+};
+
+}; // namespace params
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <string>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "Store.h"
+#include "../Config.h"
+#include "../Log.h"
+
+namespace params {
+
+/**
+ * Reloads the parameters file into the Store once the file is changed or a reload is requested, e.g. on SIGHUP.
+ *
+ * Runs on its own thread, so the file is read and parsed off the event loop. The directory is watched rather than
+ * the file, as an editor or a deployment usually replaces the file by a rename. A file failing to parse or to
+ * validate is rejected as a whole, the parameters in effect stay.
+ */
+class Watcher {
+
+	Store& _store;
+	const std::string _path;
+	std::string _dir;
+	std::string _name;
+	std::atomic<bool>& _reload;  // Set by the signal handler, cleared by the watcher.
+	int _fd;
+	std::atomic<bool> _stop;
+	std::thread _thread;
+
+public:
+
+	Watcher(const Watcher&) = delete;
+	Watcher& operator=(const Watcher&) = delete;
+
+	/**
+	 * @param reload - The flag requesting a reload, set asynchronously.
+	 */
+	Watcher(Store& store, std::string path, std::atomic<bool>& reload) noexcept :
+		_store(store),
+		_path(std::move(path)),
+		_reload(reload),
+		_fd(-1),
+		_stop(false) {
+		const auto slash = _path.rfind('/');
+		_dir = (slash == std::string::npos) ? "." : (slash ? _path.substr(0, slash) : "/");
+		_name = (slash == std::string::npos) ? _path : _path.substr(slash + 1u);
+	}
+
+	~Watcher() noexcept {
+		stop();
+	}
+
+	/**
+	 * Loads the file into the store and starts watching it.
+	 * @return false - if the file can not be loaded.
+	 */
+	bool start() noexcept {
+		if(not reload()) {
+			return false;
+		}
+
+		_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(_fd < 0 || inotify_add_watch(_fd, _dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+			LOG_ERROR("params::Watcher::start() unable to watch '%s', the reload is by SIGHUP only. errno=%d\n",
+			          _dir.c_str(), errno);
+		}
+
+		_stop = false;
+		_thread = std::thread(&Watcher::run, this);
+		return true;
+	}
+
+	void stop() noexcept {
+		_stop = true;
+		if(_thread.joinable()) {
+			_thread.join();
+		}
+		if(_fd >= 0) {
+			close(_fd);
+			_fd = -1;
+		}
+	}
+
+	/**
+	 * Reads the file over the current parameters and publishes them if valid.
+	 */
+	bool reload() noexcept {
+		auto params = _store.get();
+		if(not Store::load(_path.c_str(), params)) {
+			LOG_ERROR("The parameters of '%s' are rejected.\n", _path.c_str());
+			return false;
+		}
+		if(not _store.publish(params)) {
+			LOG_ERROR("The parameters of '%s' are not valid, rejected.\n", _path.c_str());
+			return false;
+		}
+		LOG_INFO("The parameters of '%s' are in effect, version %llu:", _path.c_str(),
+		         static_cast<unsigned long long>(_store.version()));
+		params.dump();
+		return true;
+	}
+
+private:
+
+	void run() noexcept {
+		pollfd pfd {_fd, POLLIN, 0};
+		while(not _stop) {
+			const bool changed = (_fd >= 0) && poll(&pfd, 1, Config::ParamsPollTimeoutMS) > 0 && drain();
+			if(_fd < 0) {
+				usleep(Config::ParamsPollTimeoutMS * 1000u);
+			}
+			if(_reload.exchange(false) || changed) {
+				reload();
+			}
+		}
+	}
+
+	/**
+	 * @return true - if any of the events is of the file.
+	 */
+	bool drain() noexcept {
+		alignas(inotify_event) char buffer[Config::ParamsEventBytes];
+		bool result = false;
+		ssize_t len;
+		while((len = read(_fd, buffer, sizeof(buffer))) > 0) {
+			for(ssize_t offset = 0; offset < len;) {
+				const auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				result |= (event->len && _name == event->name);
+				offset += sizeof(inotify_event) + event->len;
+			}
+		}
+		return result;
+	}
+
+};
+
+}; // namespace params
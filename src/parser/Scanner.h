@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <charconv>
+#include <type_traits>
+
+#include "Simd.h"
+
+namespace parser {
+
+/**
+ * A pull scanner reading JSON in place. No DOM is built and nothing is copied;
+ * the strings are returned as views into the scanned text, the escape sequences are left as is.
+ * The input is trusted to be a well formed JSON, so the scanner is lenient with the separators.
+ *
+ * The members of an object are iterated as:
+ *
+ *     std::string_view key;
+ *     if(scan.begin_object()) {
+ *         while(scan.member(key)) {
+ *             if(key == "price") scan.decimal(price); else scan.skip();
+ *         }
+ *     }
+ */
+class Scanner {
+
+	const char* _ptr;
+	const char* _end;
+	bool _ok;
+
+public:
+
+	explicit Scanner(std::string_view text) noexcept :
+		_ptr(text.data()),
+		_end(text.data() + text.size()),
+		_ok(true) {
+	}
+
+	/**
+	 * @return false - if any of the calls has failed.
+	 */
+	inline bool ok() const noexcept {
+		return _ok;
+	}
+
+	inline bool begin_object() noexcept {
+		return expect('{');
+	}
+
+	inline bool begin_array() noexcept {
+		return expect('[');
+	}
+
+	/**
+	 * @return true - if the next member exists, its key is read and the value is to be read next.
+	 * @return false - if the object is over, the closing brace is consumed.
+	 */
+	bool member(std::string_view& key) noexcept {
+		skip_ws_comma();
+		if(_ptr < _end && *_ptr == '}') {
+			++_ptr;
+			return false;
+		}
+		if(not string(key)) {
+			return false;
+		}
+		return expect(':');
+	}
+
+	/**
+	 * @return true - if the next element exists and is to be read next.
+	 * @return false - if the array is over, the closing bracket is consumed.
+	 */
+	bool element() noexcept {
+		skip_ws_comma();
+		if(_ptr < _end && *_ptr == ']') {
+			++_ptr;
+			return false;
+		}
+		return _ok && _ptr < _end;
+	}
+
+	/**
+	 * Reads a string value without the quotes.
+	 */
+	bool string(std::string_view& value) noexcept {
+		if(not expect('"')) {
+			return false;
+		}
+		const auto begin = _ptr;
+		for(;;) {
+			_ptr = simd::find_quote(_ptr, _end);
+			if(_ptr >= _end || *_ptr == '"') {
+				break;
+			}
+			_ptr += 2;  // The escape sequence.
+		}
+		if(_ptr >= _end) {
+			return fail();
+		}
+		value = std::string_view(begin, _ptr - begin);
+		++_ptr;
+		return true;
+	}
+
+	/**
+	 * Reads the raw token of a string or a number or a literal.
+	 * The quotes are stripped, so "0.001" and 0.001 give the same token.
+	 */
+	bool token(std::string_view& value) noexcept {
+		skip_ws();
+		if(_ptr < _end && *_ptr == '"') {
+			return string(value);
+		}
+		const auto begin = _ptr;
+		_ptr = simd::find_delimiter(_ptr, _end);
+		if(_ptr == begin) {
+			return fail();
+		}
+		value = std::string_view(begin, _ptr - begin);
+		return true;
+	}
+
+	/**
+	 * Reads an integer, either bare or quoted.
+	 */
+	template <typename T>
+	bool integer(T& value) noexcept {
+		static_assert(std::is_integral<T>::value, "parser::Scanner::integer");
+		std::string_view tok;
+		return token(tok) && (to_integer(tok, value) || fail());
+	}
+
+	/**
+	 * Reads a decimal, either bare or quoted as Binance sends the prices and the quantities.
+	 */
+	bool decimal(double& value) noexcept {
+		std::string_view tok;
+		return token(tok) && (to_decimal(tok, value) || fail());
+	}
+
+	bool boolean(bool& value) noexcept {
+		std::string_view tok;
+		if(not token(tok)) {
+			return false;
+		}
+		value = (tok == "true");
+		return value || tok == "false" || fail();
+	}
+
+	/**
+	 * Skips a value of any kind including the nested objects and arrays.
+	 */
+	bool skip() noexcept {
+		skip_ws();
+		if(_ptr >= _end) {
+			return fail();
+		}
+
+		if(*_ptr == '{' || *_ptr == '[') {
+			size_t depth = 0;
+			do {
+				switch(*_ptr) {
+					case '"': {
+						std::string_view ignored;
+						if(not string(ignored)) {
+							return false;
+						}
+					}
+						continue;
+
+					case '{':
+					case '[':
+						depth++;
+						break;
+
+					case '}':
+					case ']':
+						depth--;
+						break;
+
+					default:
+						break;
+				}
+				++_ptr;
+			} while(depth && _ptr < _end);
+			return depth == 0u || fail();
+		}
+
+		std::string_view ignored;
+		return token(ignored);
+	}
+
+	template <typename T>
+	static inline bool to_integer(std::string_view tok, T& value) noexcept {
+		const auto res = std::from_chars(tok.data(), tok.data() + tok.size(), value);
+		return res.ec == std::errc() && res.ptr == tok.data() + tok.size();
+	}
+
+	static inline bool to_decimal(std::string_view tok, double& value) noexcept {
+		if(simd::parse_decimal(tok.data(), tok.data() + tok.size(), value)) {
+			return true;
+		}
+		const auto res = std::from_chars(tok.data(), tok.data() + tok.size(), value);
+		return res.ec == std::errc() && res.ptr == tok.data() + tok.size();
+	}
+
+private:
+
+	inline bool fail() noexcept {
+		_ok = false;
+		_ptr = _end;
+		return false;
+	}
+
+	inline void skip_ws() noexcept {
+		while(_ptr < _end && (*_ptr == ' ' || *_ptr == '\n' || *_ptr == '\r' || *_ptr == '\t')) {
+			++_ptr;
+		}
+	}
+
+	inline void skip_ws_comma() noexcept {
+		while(_ptr < _end && (*_ptr == ',' || *_ptr == ' ' || *_ptr == '\n' || *_ptr == '\r' || *_ptr == '\t')) {
+			++_ptr;
+		}
+	}
+
+	inline bool expect(const char ch) noexcept {
+		skip_ws();
+		if(_ptr < _end && *_ptr == ch) {
+			++_ptr;
+			return true;
+		}
+		return fail();
+	}
+
+};
+
+}; // namespace parser
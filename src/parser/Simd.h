@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if not defined(BINTEST_SCALAR) && defined(__AVX2__)
+#include <immintrin.h>
+#define BINTEST_SIMD_AVX2 1
+#elif not defined(BINTEST_SCALAR) && defined(__SSE2__)
+#include <emmintrin.h>
+#define BINTEST_SIMD_SSE2 1
+#endif
+
+/**
+ * The scanning kernels of parser::Scanner.
+ *
+ * The structural characters are searched 32 (AVX2) or 16 (SSE2) bytes at a time, whichever the target has;
+ * the tail shorter than a vector is done byte by byte, so nothing is read past the end. BINTEST_SCALAR
+ * forces the byte by byte fallback everywhere. The decimals are parsed 8 digits at a time in a general register.
+ */
+namespace parser {
+namespace simd {
+
+namespace detail {
+
+static inline const char* scalar_find(const char* ptr, const char* end, const char a, const char b) noexcept {
+	while(ptr < end && *ptr != a && *ptr != b) {
+		++ptr;
+	}
+	return ptr;
+}
+
+static inline bool is_delimiter(const char ch) noexcept {
+	return ch == ',' || ch == '}' || ch == ']' || ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+/**
+ * @return true - if all the 8 bytes are the ASCII digits.
+ */
+static inline bool eight_digits(const uint64_t chunk) noexcept {
+	return ((chunk & 0xF0F0F0F0F0F0F0F0ull) | (((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4u))
+	       == 0x3333333333333333ull;
+}
+
+/**
+ * @return - The value of the 8 ASCII digits, the first one is the most significant.
+ */
+static inline uint32_t parse_eight_digits(uint64_t chunk) noexcept {
+	chunk -= 0x3030303030303030ull;
+	chunk = (chunk * 10u) + (chunk >> 8u);
+	chunk = (((chunk & 0x000000FF000000FFull) * (100u + (1000000ull << 32u)))
+	         + (((chunk >> 16u) & 0x000000FF000000FFull) * (1u + (10000ull << 32u)))) >> 32u;
+	return static_cast<uint32_t>(chunk);
+}
+
+}; // namespace detail
+
+/**
+ * @return - The first '"' or '\' in [ptr, end), 'end' if none.
+ */
+static inline const char* find_quote(const char* ptr, const char* end) noexcept {
+#if defined(BINTEST_SIMD_AVX2)
+	const auto quote = _mm256_set1_epi8('"');
+	const auto escape = _mm256_set1_epi8('\\');
+	for(; end - ptr >= 32; ptr += 32) {
+		const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+		const auto hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, escape));
+		const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+		if(mask) {
+			return ptr + __builtin_ctz(mask);
+		}
+	}
+#elif defined(BINTEST_SIMD_SSE2)
+	const auto quote = _mm_set1_epi8('"');
+	const auto escape = _mm_set1_epi8('\\');
+	for(; end - ptr >= 16; ptr += 16) {
+		const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+		const auto hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, escape));
+		const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+		if(mask) {
+			return ptr + __builtin_ctz(mask);
+		}
+	}
+#endif
+	return detail::scalar_find(ptr, end, '"', '\\');
+}
+
+/**
+ * @return - The first of ',' '}' ']' or a white space in [ptr, end), 'end' if none.
+ */
+static inline const char* find_delimiter(const char* ptr, const char* end) noexcept {
+#if defined(BINTEST_SIMD_AVX2)
+	const auto comma = _mm256_set1_epi8(',');
+	const auto brace = _mm256_set1_epi8('}');
+	const auto bracket = _mm256_set1_epi8(']');
+	const auto space = _mm256_set1_epi8(' ');
+	const auto control = _mm256_set1_epi8('\r');  // '\t' and '\n' are below.
+	for(; end - ptr >= 32; ptr += 32) {
+		const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+		auto hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, comma), _mm256_cmpeq_epi8(chunk, brace));
+		hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, bracket));
+		hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, space));
+		hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk));
+		const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+		if(mask) {
+			// The control bytes other than the white spaces are not valid JSON outside of a string anyway.
+			return ptr + __builtin_ctz(mask);
+		}
+	}
+#elif defined(BINTEST_SIMD_SSE2)
+	const auto comma = _mm_set1_epi8(',');
+	const auto brace = _mm_set1_epi8('}');
+	const auto bracket = _mm_set1_epi8(']');
+	const auto space = _mm_set1_epi8(' ');
+	const auto control = _mm_set1_epi8('\r');
+	for(; end - ptr >= 16; ptr += 16) {
+		const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+		auto hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, comma), _mm_cmpeq_epi8(chunk, brace));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, bracket));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, space));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+		const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+		if(mask) {
+			return ptr + __builtin_ctz(mask);
+		}
+	}
+#endif
+	while(ptr < end && not detail::is_delimiter(*ptr)) {
+		++ptr;
+	}
+	return ptr;
+}
+
+/**
+ * Parses a plain decimal '[-]digits[.digits]' as Binance sends the prices and the quantities.
+ * The digits are accumulated into an integer mantissa, 8 at a time where possible, and scaled once,
+ * which is exact for up to 15 significant digits.
+ * @return false - if the token is anything else, e.g. has an exponent or too many digits;
+ *                 the caller falls back to the generic conversion then.
+ */
+static inline bool parse_decimal(const char* ptr, const char* end, double& value) noexcept {
+	static constexpr double Pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18,
+		1e19, 1e20, 1e21, 1e22
+	};
+	static constexpr uint64_t MaxExact = 1ull << 53u;
+	static constexpr unsigned MaxDigits = 19u;
+
+	const bool negative = (ptr < end && *ptr == '-');
+	ptr += negative;
+
+	uint64_t mantissa = 0u;
+	unsigned digits = 0u;
+	unsigned fraction = 0u;
+	bool dot = false;
+
+	while(ptr < end) {
+		uint64_t chunk;
+		if(end - ptr >= 8 && digits + 8u <= MaxDigits && (memcpy(&chunk, ptr, 8u), detail::eight_digits(chunk))) {
+			mantissa = mantissa * 100000000u + detail::parse_eight_digits(chunk);
+			digits += 8u;
+			fraction += dot ? 8u : 0u;
+			ptr += 8;
+			continue;
+		}
+
+		const char ch = *ptr;
+		if(ch >= '0' && ch <= '9') {
+			if(++digits > MaxDigits) {
+				return false;
+			}
+			mantissa = mantissa * 10u + static_cast<unsigned>(ch - '0');
+			fraction += dot;
+		} else if(ch == '.' && not dot && digits) {
+			dot = true;
+		} else {
+			return false;
+		}
+		++ptr;
+	}
+
+	if(digits == 0u || mantissa > MaxExact || fraction >= sizeof(Pow10) / sizeof(*Pow10)) {
+		return false;
+	}
+
+	const double result = static_cast<double>(mantissa) / Pow10[fraction];
+	value = negative ? -result : result;
+	return true;
+}
+
+}; // namespace simd
+}; // namespace parser
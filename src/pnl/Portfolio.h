@@ -0,0 +1,143 @@
+#pragma once
+
+#include <vector>
+
+#include "../binance/Assets.h"
+#include "../metrics/Metrics.h"
+#include "../Config.h"
+#include "../Log.h"
+
+namespace pnl {
+
+/**
+ * The process wide totals of all the pnl::Position of all the strategies and accounts.
+ *
+ * The positions push their changes as deltas, so a mark to market is O(1) whatever the number of the positions.
+ * The PnL is in the quote asset of the pair, so the totals are per quote asset; the exposure is the net quantity
+ * of an asset bought; the fees are converted into BNB by the BNB/<asset> prices seen so far.
+ * Not thread safe, all the strategies run on the event loop thread.
+ */
+class Portfolio {
+
+	struct Asset {
+		double realized;
+		double unrealized;
+		double exposure;
+		double bnb_price;  // The price of BNB in the asset, zero if not seen yet.
+		metrics::Gauge* pnl;
+		metrics::Gauge* pnl_realized;
+		metrics::Gauge* exposure_gauge;
+	};
+
+	std::vector<Asset> _assets;  // By binance::AssetId.
+	double _fees_bnb;
+	double _fees_unconverted;    // The fees of the assets with no BNB price, in their own units.
+	metrics::Gauge& _fees_gauge;
+
+public:
+
+	Portfolio(const Portfolio&) = delete;
+	Portfolio& operator=(const Portfolio&) = delete;
+
+	static Portfolio& instance() noexcept {
+		static Portfolio portfolio;
+		return portfolio;
+	}
+
+	inline void realized(const binance::AssetId quote, const double delta) noexcept {
+		auto& item = asset(quote);
+		item.realized += delta;
+		item.pnl_realized->set(item.realized);
+		item.pnl->set(item.realized + item.unrealized);
+	}
+
+	inline void unrealized(const binance::AssetId quote, const double delta) noexcept {
+		auto& item = asset(quote);
+		item.unrealized += delta;
+		item.pnl->set(item.realized + item.unrealized);
+	}
+
+	inline void exposure(const binance::AssetId id, const double delta) noexcept {
+		auto& item = asset(id);
+		item.exposure += delta;
+		item.exposure_gauge->set(item.exposure);
+	}
+
+	/**
+	 * @return - The fee in BNB.
+	 */
+	double fee(const binance::AssetId id, const double amount) noexcept {
+		const double bnb = to_bnb(id, amount);
+		if(amount > 0. && bnb == 0.) {
+			_fees_unconverted += amount;
+		}
+		_fees_bnb += bnb;
+		_fees_gauge.set(_fees_bnb);
+		return bnb;
+	}
+
+	/**
+	 * Takes the price of the BNB/<quote> pair for the fee conversion.
+	 */
+	inline void bnb_price(const binance::AssetId quote, const double price) noexcept {
+		asset(quote).bnb_price = price;
+	}
+
+	/**
+	 * @return - The amount in BNB, zero if the asset has no BNB price yet.
+	 */
+	double to_bnb(const binance::AssetId id, const double amount) noexcept {
+		if(binance::Assets::name(id) == Config::BasicSymbol) {
+			return amount;
+		}
+		const double price = asset(id).bnb_price;
+		return (price > 0.) ? amount / price : 0.;
+	}
+
+	inline double fees_bnb() const noexcept {
+		return _fees_bnb;
+	}
+
+	void dump() const noexcept {
+		LOG_INFO("Portfolio :");
+		for(binance::AssetId id = 0; id < _assets.size(); ++id) {
+			const auto& item = _assets[id];
+			if(item.pnl == nullptr || (item.realized == 0. && item.unrealized == 0. && item.exposure == 0.)) {
+				continue;
+			}
+			LOG_PLAIN(" %s realized=%.8f unrealized=%.8f exposure=%.8f;", binance::Assets::name(id).c_str(),
+			          item.realized, item.unrealized, item.exposure);
+		}
+		LOG_PLAIN(" fees=%.8f %s", _fees_bnb, Config::BasicSymbol);
+		if(_fees_unconverted > 0.) {
+			LOG_PLAIN(" (not converted %.8f)", _fees_unconverted);
+		}
+		LOG_PLAIN("\n");
+	}
+
+private:
+
+	Portfolio() noexcept :
+		_fees_bnb(0.),
+		_fees_unconverted(0.),
+		_fees_gauge(metrics::Registry::instance().gauge("bintest_fees_bnb", "The fees paid, in BNB.")) {
+	}
+
+	Asset& asset(const binance::AssetId id) noexcept {
+		if(id >= _assets.size()) {
+			_assets.resize(id + 1u, Asset {0., 0., 0., 0., nullptr, nullptr, nullptr});
+		}
+		auto& item = _assets[id];
+		if(item.pnl == nullptr) {
+			auto& reg = metrics::Registry::instance();
+			const auto label = metrics::label("asset", binance::Assets::name(id));
+			item.pnl = &reg.gauge("bintest_pnl", "The session PnL, realized and unrealized.", label);
+			item.pnl_realized = &reg.gauge("bintest_pnl_realized", "The session realized PnL.", label);
+			item.exposure_gauge = &reg.gauge("bintest_exposure", "The net quantity of the asset bought.", label);
+		}
+		return item;
+	}
+
+};
+
+}; // namespace pnl
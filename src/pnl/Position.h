@@ -0,0 +1,254 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "Portfolio.h"
+#include "../binance/Assets.h"
+#include "../binance/rest/api.h"
+#include "../snapshot/Buffer.h"
+#include "../Config.h"
+#include "../Log.h"
+
+namespace pnl {
+
+/**
+ * The position of a strategy in a pair, built from the fills; no account query is needed.
+ *
+ * The quantity is of the base asset, signed; the average entry price and the PnL are in the quote asset.
+ * The realized PnL is taken by the average cost when the position is reduced; the unrealized one is marked
+ * to the last price on every tick in O(1). The fees are in BNB. The changes are pushed to the pnl::Portfolio.
+ */
+class Position {
+
+	static constexpr double Epsilon = 1e-12;
+
+	// The quantities of the recent orders taken so far, so the fills and the order states do not double count.
+	struct Order {
+		binance::SInteger id;
+		double executed;
+		double quote;
+	};
+
+	Portfolio& _portfolio;
+	const binance::AssetId _base;
+	const binance::AssetId _quote;
+	const bool _bnb_base;  // The pair prices BNB, so its price converts the fees.
+
+	double _qty;
+	double _avg;
+	double _mark;
+	double _realized;
+	double _unrealized;
+	double _fees_bnb;
+	double _exposure_base;
+	double _exposure_quote;
+
+	std::vector<Order> _orders;  // Config::PnlOrdersKept at most, the oldest is replaced.
+	size_t _orders_next;
+
+public:
+
+	Position(const Position&) = delete;
+	Position& operator=(const Position&) = delete;
+
+	Position(Portfolio& portfolio, const binance::AssetId base, const binance::AssetId quote) noexcept :
+		_portfolio(portfolio),
+		_base(base),
+		_quote(quote),
+		_bnb_base(binance::Assets::name(base) == Config::BasicSymbol),
+		_qty(0.),
+		_avg(0.),
+		_mark(0.),
+		_realized(0.),
+		_unrealized(0.),
+		_fees_bnb(0.),
+		_exposure_base(0.),
+		_exposure_quote(0.),
+		_orders_next(0u) {
+		_orders.reserve(Config::PnlOrdersKept);
+	}
+
+	/**
+	 * Takes the fills of the order entry response.
+	 * @return false - if the response has no fills, e.g. of an order not matched yet.
+	 */
+	template <typename Response>
+	bool fills(const Response& response) noexcept {
+		const bool buy = (response.side == "BUY");
+		for(const auto& item : response.fills) {
+			fill(response.orderId, buy, item.qty, item.price, item.commission, item.commissionAsset);
+		}
+		return not response.fills.empty();
+	}
+
+	/**
+	 * Takes the order state with no fills, e.g. of a query: the quantity executed since the last one
+	 * is a fill at its average price. The fee is not known then.
+	 */
+	void order(const binance::rest::OrderResult& result) noexcept {
+		auto& entry = order_entry(result.orderId);
+		const double qty = result.executedQty - entry.executed;
+		const double quote = result.cummulativeQuoteQty - entry.quote;
+		if(qty > Epsilon) {
+			entry.executed = result.executedQty;
+			entry.quote = result.cummulativeQuoteQty;
+			trade(result.side == "BUY", qty, quote / qty);
+		}
+	}
+
+	void fill(
+		const binance::SInteger order_id, const bool buy, const double qty, const double price,
+		const double commission, const binance::AssetId commission_asset
+	         ) noexcept {
+		auto& entry = order_entry(order_id);
+		entry.executed += qty;
+		entry.quote += qty * price;
+		trade(buy, qty, price);
+		if(commission > 0.) {
+			const double bnb = _portfolio.fee(commission_asset, commission);
+			_fees_bnb += bnb;
+		}
+	}
+
+	/**
+	 * O(1).
+	 */
+	inline void mark(const double price) noexcept {
+		_mark = price;
+		if(_bnb_base) {
+			_portfolio.bnb_price(_quote, price);
+		}
+		remark();
+	}
+
+	inline double quantity() const noexcept {
+		return _qty;
+	}
+
+	inline double average_price() const noexcept {
+		return _avg;
+	}
+
+	inline double realized() const noexcept {
+		return _realized;
+	}
+
+	inline double unrealized() const noexcept {
+		return _unrealized;
+	}
+
+	inline double fees_bnb() const noexcept {
+		return _fees_bnb;
+	}
+
+	/**
+	 * Continues the current log line.
+	 */
+	void dump() const noexcept {
+		LOG_PLAIN(" position=%.8f %s avg=%.8f mark=%.8f", _qty, binance::Assets::name(_base).c_str(), _avg, _mark);
+		LOG_PLAIN(" realized=");
+		LOG_LESS_GREATER_FLOAT(_realized, .0);
+		LOG_PLAIN(" unrealized=");
+		LOG_LESS_GREATER_FLOAT(_unrealized, .0);
+		LOG_PLAIN(" %s fees=%.8f %s\n", binance::Assets::name(_quote).c_str(), _fees_bnb, Config::BasicSymbol);
+	}
+
+	void save(snapshot::Encoder& enc) const noexcept {
+		enc.put(_qty);
+		enc.put(_avg);
+		enc.put(_realized);
+		enc.put(_fees_bnb);
+		enc.put(_exposure_base);
+		enc.put(_exposure_quote);
+		enc.put(static_cast<uint32_t>(_orders.size()));
+		for(const auto& item : _orders) {
+			enc.put(item);
+		}
+	}
+
+	/**
+	 * Continues the position of the snapshot, the unrealized PnL comes with the next tick.
+	 * The quantities of the orders are restored too, so a query of an order of the snapshot counts the rest only.
+	 */
+	bool restore(snapshot::Decoder& dec) noexcept {
+		uint32_t count = 0u;
+		dec.get(_qty);
+		dec.get(_avg);
+		dec.get(_realized);
+		dec.get(_fees_bnb);
+		dec.get(_exposure_base);
+		dec.get(_exposure_quote);
+		dec.get(count);
+		_orders.clear();
+		_orders_next = 0u;
+		for(uint32_t idx = 0; idx < count && dec.ok(); ++idx) {
+			Order item;
+			if(dec.get(item) && _orders.size() < Config::PnlOrdersKept) {
+				_orders.push_back(item);
+			}
+		}
+		if(not dec.ok()) {
+			return false;
+		}
+		_portfolio.realized(_quote, _realized);
+		_portfolio.fee(binance::Assets::intern(Config::BasicSymbol), _fees_bnb);
+		_portfolio.exposure(_base, _exposure_base);
+		_portfolio.exposure(_quote, _exposure_quote);
+		return true;
+	}
+
+private:
+
+	Order& order_entry(const binance::SInteger id) noexcept {
+		for(auto& item : _orders) {
+			if(item.id == id) {
+				return item;
+			}
+		}
+		if(_orders.size() < Config::PnlOrdersKept) {
+			_orders.push_back(Order{id, 0., 0.});
+			return _orders.back();
+		}
+		auto& item = _orders[_orders_next];
+		_orders_next = (_orders_next + 1u) % Config::PnlOrdersKept;
+		item = Order{id, 0., 0.};
+		return item;
+	}
+
+	void trade(const bool buy, const double qty, const double price) noexcept {
+		const double signed_qty = buy ? qty : -qty;
+		_exposure_base += signed_qty;
+		_exposure_quote -= signed_qty * price;
+		_portfolio.exposure(_base, signed_qty);
+		_portfolio.exposure(_quote, -signed_qty * price);
+
+		if(std::fabs(_qty) < Epsilon || (_qty > 0.) == buy) {
+			const double size = std::fabs(_qty);
+			_avg = (_avg * size + price * qty) / (size + qty);
+			_qty += signed_qty;
+		} else {
+			const double closed = std::min(qty, std::fabs(_qty));
+			const double pnl = closed * (price - _avg) * (_qty > 0. ? 1. : -1.);
+			_realized += pnl;
+			_portfolio.realized(_quote, pnl);
+			_qty += signed_qty;
+			if(std::fabs(_qty) < Epsilon) {
+				_qty = 0.;
+				_avg = 0.;
+			} else if(qty > closed) {
+				_avg = price;  // Reversed, the rest is opened at the price.
+			}
+		}
+		remark();
+	}
+
+	inline void remark() noexcept {
+		const double value = (_mark > 0.) ? _qty * (_mark - _avg) : 0.;
+		_portfolio.unrealized(_quote, value - _unrealized);
+		_unrealized = value;
+	}
+
+};
+
+}; // namespace pnl
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "Ring.h"
+#include "../binance/ws/api.h"
+#include "../binance/ws/Connector.h"
+#include "../Log.h"
+
+namespace shm {
+
+/**
+ * Writes the ticks into the shared memory ring for the other processes of the host, see shm::Subscriber.
+ * publish() is a plain memory write, no syscall; the ring is subscribed to the market::Plane as a strategy is.
+ */
+class Publisher {
+
+	std::string _name;
+	Header* _header;
+	Slot* _slots;
+	uint64_t _mask;
+	uint64_t _head;
+
+public:
+
+	Publisher(const Publisher&) = delete;
+	Publisher& operator=(const Publisher&) = delete;
+
+	Publisher() noexcept : _header(nullptr), _slots(nullptr), _mask(0u), _head(0u) {
+	}
+
+	~Publisher() noexcept {
+		close();
+	}
+
+	/**
+	 * Creates the shared memory object, replacing the one of a previous publisher.
+	 * @param name - The POSIX shared memory name, e.g. '/bintest'.
+	 * @param capacity - The slots, a power of two.
+	 */
+	bool create(std::string name, const uint32_t capacity) noexcept {
+		if(capacity == 0u || (capacity & (capacity - 1u))) {
+			LOG_ERROR("shm::Publisher::create() the capacity %u is not a power of two\n", capacity);
+			return false;
+		}
+
+		shm_unlink(name.c_str());
+		const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+		if(fd < 0) {
+			LOG_ERROR("shm::Publisher::create() unable to create '%s'. errno=%d\n", name.c_str(), errno);
+			return false;
+		}
+
+		const auto size = Ring::size(capacity);
+		void* addr = MAP_FAILED;
+		if(ftruncate(fd, size) == 0) {
+			addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+		}
+		::close(fd);
+		if(addr == MAP_FAILED) {
+			LOG_ERROR("shm::Publisher::create() unable to map '%s'. errno=%d\n", name.c_str(), errno);
+			shm_unlink(name.c_str());
+			return false;
+		}
+
+		// The object is zero filled, so are the sequences of the slots.
+		_name = std::move(name);
+		_header = static_cast<Header*>(addr);
+		_slots = Ring::slots(_header);
+		_mask = capacity - 1u;
+		_head = 0u;
+		_header->version = Header::Version;
+		_header->capacity = capacity;
+		_header->slot_size = sizeof(Slot);
+		_header->magic.store(Header::Magic, std::memory_order_release);
+		LOG_INFO("The market data bus '%s' is up, %u slots.\n", _name.c_str(), capacity);
+		return true;
+	}
+
+	/**
+	 * Marks the ring closed for the clients and removes the name.
+	 */
+	void close() noexcept {
+		if(_header) {
+			_header->closed.store(1u, std::memory_order_release);
+			munmap(_header, Ring::size(_header->capacity));
+			shm_unlink(_name.c_str());
+			_header = nullptr;
+			_slots = nullptr;
+		}
+	}
+
+	inline bool ready() const noexcept {
+		return _header != nullptr;
+	}
+
+	/**
+	 * Wait-free, the slowest client does not hold the writer back, it loses the overwritten ticks instead.
+	 */
+	void publish(const binance::ws::SymbolTicker& ticker) noexcept {
+		Tick tick;
+		tick.event_time = ticker.eventTime;
+		memset(tick.symbol, 0, sizeof(tick.symbol));
+		memcpy(tick.symbol, ticker.symbol.data(), std::min(ticker.symbol.size(), sizeof(tick.symbol) - 1u));
+		tick.last_price = ticker.lastPrice;
+		tick.last_quantity = ticker.lastQuantity;
+		tick.bid_price = ticker.bestBidPrice;
+		tick.bid_quantity = ticker.bestBidQuantity;
+		tick.ask_price = ticker.bestAskPrice;
+		tick.ask_quantity = ticker.bestAskQuantity;
+
+		auto& slot = _slots[_head & _mask];
+		slot.seq.store(2u * _head + 1u, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		Ring::store(slot.tick, tick);
+		slot.seq.store(2u * _head + 2u, std::memory_order_release);
+		_head++;
+		_header->head.store(_head, std::memory_order_release);
+	}
+
+	/**
+	 * A market::Plane subscriber.
+	 */
+	static void cb_tick(void* instance, const binance::ws::SymbolTicker& ticker) noexcept {
+		reinterpret_cast<Publisher*>(instance)->publish(ticker);
+	}
+
+	/**
+	 * Counts the stale feeds, the ring carries the ticks of all the pairs subscribed.
+	 */
+	static void cb_stream_state(void* instance, binance::ws::Connector::StreamState state) noexcept {
+		auto& stale = reinterpret_cast<Publisher*>(instance)->_header->stale;
+		const auto count = stale.load(std::memory_order_relaxed);
+		if(state == binance::ws::Connector::StreamState::Stale) {
+			stale.store(count + 1u, std::memory_order_relaxed);
+		} else if(count) {
+			stale.store(count - 1u, std::memory_order_relaxed);
+		}
+	}
+
+};
+
+}; // namespace shm
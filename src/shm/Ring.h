@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace shm {
+
+/**
+ * The shared memory layout of the market data bus, common to the publisher and the clients.
+ *
+ * One writer, any number of readers, none of them blocks another. The ring is a power of two of slots, a slot is
+ * a seqlock of its own: the sequence is odd while the slot is written and tells the position of the record once
+ * it is even, so a reader detects both a torn record and a record overwritten by the writer lapping it.
+ * The records are copied word by word with relaxed atomics, so a torn copy is discarded, never a data race.
+ *
+ *   Header, then 'capacity' Slots. The shared memory object is sized as Ring::size(capacity).
+ */
+struct Tick {
+	uint64_t event_time;  // ms
+	char symbol[16];      // The pair, zero terminated.
+	double last_price;
+	double last_quantity;
+	double bid_price;
+	double bid_quantity;
+	double ask_price;
+	double ask_quantity;
+};
+
+static_assert(sizeof(Tick) % sizeof(uint64_t) == 0u, "shm::Tick is copied word by word.");
+
+struct alignas(64) Slot {
+	std::atomic<uint64_t> seq;  // 2 * pos + 1 while the record of 'pos' is written, 2 * pos + 2 once it is.
+	Tick tick;
+};
+
+struct Header {
+	static constexpr uint32_t Magic = 0x53554254u;  // 'TBUS'
+	static constexpr uint32_t Version = 1u;
+
+	std::atomic<uint32_t> magic;  // Set last by the publisher, the header is valid then.
+	uint32_t version;
+	uint32_t capacity;
+	uint32_t slot_size;
+	std::atomic<uint32_t> stale;   // The publisher's feeds stale at the moment, the ticks may be old if any.
+	std::atomic<uint32_t> closed;  // The publisher has gone, a new one creates a new object.
+	alignas(64) std::atomic<uint64_t> head;  // The position to be written next.
+};
+
+class Ring {
+public:
+
+	static constexpr size_t size(const uint32_t capacity) noexcept {
+		return sizeof(Header) + sizeof(Slot) * capacity;
+	}
+
+	static inline Slot* slots(Header* header) noexcept {
+		return reinterpret_cast<Slot*>(reinterpret_cast<char*>(header) + sizeof(Header));
+	}
+
+	static inline const Slot* slots(const Header* header) noexcept {
+		return reinterpret_cast<const Slot*>(reinterpret_cast<const char*>(header) + sizeof(Header));
+	}
+
+	static inline void store(Tick& dst, const Tick& src) noexcept {
+		auto to = reinterpret_cast<uint64_t*>(&dst);
+		uint64_t word;
+		for(size_t idx = 0; idx < sizeof(Tick) / sizeof(uint64_t); ++idx) {
+			memcpy(&word, reinterpret_cast<const char*>(&src) + idx * sizeof(uint64_t), sizeof(uint64_t));
+			std::atomic_ref<uint64_t>(to[idx]).store(word, std::memory_order_relaxed);
+		}
+	}
+
+	static inline void load(Tick& dst, const Tick& src) noexcept {
+		auto from = reinterpret_cast<uint64_t*>(const_cast<Tick*>(&src));
+		uint64_t word;
+		for(size_t idx = 0; idx < sizeof(Tick) / sizeof(uint64_t); ++idx) {
+			word = std::atomic_ref<uint64_t>(from[idx]).load(std::memory_order_relaxed);
+			memcpy(reinterpret_cast<char*>(&dst) + idx * sizeof(uint64_t), &word, sizeof(uint64_t));
+		}
+	}
+
+};
+
+}; // namespace shm
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Ring.h"
+
+namespace shm {
+
+/**
+ * The client side of the market data bus, for the other processes of the host. Depends on shm/Ring.h only.
+ *
+ *   shm::Subscriber sub;
+ *   if(sub.open("/bintest")) {
+ *       shm::Tick tick;
+ *       while(running) {
+ *           if(sub.read(tick) == shm::Subscriber::Result::Ok) { ... }
+ *       }
+ *   }
+ *
+ * read() is a few loads from the mapped memory, no syscall, so a client may busy-poll it. The ring is read-only
+ * to the clients, the publisher never waits for them: a client falling behind by the capacity loses the ticks.
+ */
+class Subscriber {
+
+	const Header* _header;
+	const Slot* _slots;
+	size_t _size;
+	uint64_t _mask;
+	uint64_t _next;  // The position to be read next.
+	uint64_t _lost;
+
+public:
+
+	enum class Result {
+		Ok,     // A tick is read.
+		Empty,  // No new tick yet.
+		Lost,   // The publisher has lapped the client, the ticks are lost; read on from a recent one.
+		Closed  // The publisher has gone.
+	};
+
+	Subscriber(const Subscriber&) = delete;
+	Subscriber& operator=(const Subscriber&) = delete;
+
+	Subscriber() noexcept : _header(nullptr), _slots(nullptr), _size(0u), _mask(0u), _next(0u), _lost(0u) {
+	}
+
+	~Subscriber() noexcept {
+		close();
+	}
+
+	/**
+	 * Maps the bus, the reading starts from the next tick published.
+	 * @return false - if there is no bus of the name or it is of another version.
+	 */
+	bool open(const char* name) noexcept {
+		close();
+		const int fd = shm_open(name, O_RDONLY, 0);
+		if(fd < 0) {
+			return false;
+		}
+
+		struct stat st;
+		void* addr = MAP_FAILED;
+		if(fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(Header)) {
+			addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		}
+		::close(fd);
+		if(addr == MAP_FAILED) {
+			return false;
+		}
+
+		const auto header = static_cast<const Header*>(addr);
+		_size = st.st_size;
+		const bool valid = header->magic.load(std::memory_order_acquire) == Header::Magic
+		                   && header->version == Header::Version
+		                   && header->slot_size == sizeof(Slot)
+		                   && Ring::size(header->capacity) <= _size;
+		if(not valid) {
+			munmap(const_cast<Header*>(header), _size);
+			return false;
+		}
+
+		_header = header;
+		_slots = Ring::slots(_header);
+		_mask = _header->capacity - 1u;
+		_next = _header->head.load(std::memory_order_acquire);
+		_lost = 0u;
+		return true;
+	}
+
+	void close() noexcept {
+		if(_header) {
+			munmap(const_cast<Header*>(_header), _size);
+			_header = nullptr;
+			_slots = nullptr;
+		}
+	}
+
+	Result read(Tick& tick) noexcept {
+		const auto& slot = _slots[_next & _mask];
+		const auto published = 2u * _next + 2u;
+		const auto seq = slot.seq.load(std::memory_order_acquire);
+		if(seq < published) {
+			return _header->closed.load(std::memory_order_relaxed) ? Result::Closed : Result::Empty;
+		}
+
+		if(seq == published) {
+			Ring::load(tick, slot.tick);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if(slot.seq.load(std::memory_order_relaxed) == published) {
+				_next++;
+				return Result::Ok;
+			}
+		}
+
+		// Lapped, resume from the middle of the ring to have a margin against the writer.
+		const auto head = _header->head.load(std::memory_order_acquire);
+		const auto next = head - std::min<uint64_t>(head, (_mask + 1u) / 2u);
+		_lost += next - _next;
+		_next = next;
+		return Result::Lost;
+	}
+
+	/**
+	 * @return - The ticks lost to the overruns so far.
+	 */
+	inline uint64_t lost() const noexcept {
+		return _lost;
+	}
+
+	/**
+	 * @return - A feed of the publisher is stale, the ticks of its pair may be old.
+	 */
+	inline bool stale() const noexcept {
+		return _header->stale.load(std::memory_order_relaxed);
+	}
+
+};
+
+}; // namespace shm
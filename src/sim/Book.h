@@ -0,0 +1,190 @@
+#pragma once
+
+#include <map>
+#include <set>
+
+namespace sim {
+
+/**
+ * The order book of a pair as recorded; the orders of the backtest are not in it.
+ *
+ * Built from the depth stream if the capture has one. A level of it is known once a diff event has set it or within
+ * the range of the last partial snapshot; the diffs tell nothing of the levels they have not touched. Otherwise the
+ * book is the best bid and ask of the ticker, and a level other than the top one is not known.
+ */
+class Book {
+
+	using Levels = std::map<double, double>;  // The price -> the quantity, ascending.
+
+	Levels _bids;
+	Levels _asks;
+	std::set<double> _seen_bids;  // The levels set by the depth stream, the removed ones included.
+	std::set<double> _seen_asks;
+	double _range_bid;            // The worst price of the last partial snapshot, zero if none.
+	double _range_ask;
+	bool _depth;
+
+public:
+
+	enum class Side {
+		Bid,
+		Ask
+	};
+
+	Book() noexcept : _range_bid(0.), _range_ask(0.), _depth(false) {
+	}
+
+	/**
+	 * @return true - if the book comes from a depth stream.
+	 */
+	inline bool depth() const noexcept {
+		return _depth;
+	}
+
+	inline void depth(const bool value) noexcept {
+		_depth = value;
+	}
+
+	inline void clear(const Side side) noexcept {
+		levels(side).clear();
+		seen(side).clear();
+		range(side) = 0.;
+	}
+
+	/**
+	 * @param qty - Zero removes the level.
+	 * @return - The quantity of the level before, zero if there was none.
+	 */
+	double set(const Side side, const double price, const double qty) noexcept {
+		auto& items = levels(side);
+		if(_depth) {
+			seen(side).insert(price);
+		}
+		if(qty <= 0.) {
+			const auto it = items.find(price);
+			if(it == items.end()) {
+				return 0.;
+			}
+			const double old = it->second;
+			items.erase(it);
+			return old;
+		}
+		const auto res = items.emplace(price, qty);
+		if(res.second) {
+			return 0.;
+		}
+		const double old = res.first->second;
+		res.first->second = qty;
+		return old;
+	}
+
+	/**
+	 * @return - The best price of the side, zero if the side is empty.
+	 */
+	inline double best(const Side side) const noexcept {
+		if(side == Side::Bid) {
+			return _bids.empty() ? 0. : _bids.rbegin()->first;
+		}
+		return _asks.empty() ? 0. : _asks.begin()->first;
+	}
+
+	inline double best_qty(const Side side) const noexcept {
+		if(side == Side::Bid) {
+			return _bids.empty() ? 0. : _bids.rbegin()->second;
+		}
+		return _asks.empty() ? 0. : _asks.begin()->second;
+	}
+
+	inline double quantity(const Side side, const double price) const noexcept {
+		const auto& items = levels(side);
+		const auto it = items.find(price);
+		return (it == items.end()) ? 0. : it->second;
+	}
+
+	/**
+	 * @return true - if the quantity of the level is known: a level of a depth book seen or within the snapshot range;
+	 * the top one of a ticker book or a price better than the best, which is a new level.
+	 */
+	inline bool known(const Side side, const double price) const noexcept {
+		if(_depth) {
+			const double worst = (side == Side::Bid) ? _range_bid : _range_ask;
+			const auto& items = (side == Side::Bid) ? _seen_bids : _seen_asks;
+			return (worst > 0. && not better(side, worst, price)) || items.count(price);
+		}
+		const double top = best(side);
+		return top == 0. || price == top || better(side, price, top);
+	}
+
+	/**
+	 * @return true - if the price of the side is better than the other one, e.g. a higher bid.
+	 */
+	static inline bool better(const Side side, const double price, const double other) noexcept {
+		return (side == Side::Bid) ? price > other : price < other;
+	}
+
+	/**
+	 * Walks the levels of the side from the best one.
+	 * @param cb - Called as bool cb(double price, double qty), returns false to stop.
+	 */
+	template <typename CallBack>
+	void walk(const Side side, CallBack&& cb) const {
+		if(side == Side::Bid) {
+			for(auto it = _bids.rbegin(); it != _bids.rend(); ++it) {
+				if(not cb(it->first, it->second)) {
+					return;
+				}
+			}
+		} else {
+			for(const auto& item : _asks) {
+				if(not cb(item.first, item.second)) {
+					return;
+				}
+			}
+		}
+	}
+
+	/**
+	 * Removes the levels of the side worse than the price, e.g. out of the range of a partial depth snapshot,
+	 * the ones up to it are known then.
+	 */
+	void trim(const Side side, const double price) noexcept {
+		auto& items = levels(side);
+		auto& marks = seen(side);
+		if(side == Side::Bid) {
+			items.erase(items.begin(), items.lower_bound(price));
+			marks.erase(marks.begin(), marks.lower_bound(price));
+		} else {
+			items.erase(items.upper_bound(price), items.end());
+			marks.erase(marks.upper_bound(price), marks.end());
+		}
+		range(side) = price;
+	}
+
+	/**
+	 * @return - The side the orders of the other side rest on.
+	 */
+	static inline Side opposite(const Side side) noexcept {
+		return (side == Side::Bid) ? Side::Ask : Side::Bid;
+	}
+
+private:
+
+	inline Levels& levels(const Side side) noexcept {
+		return (side == Side::Bid) ? _bids : _asks;
+	}
+
+	inline const Levels& levels(const Side side) const noexcept {
+		return (side == Side::Bid) ? _bids : _asks;
+	}
+
+	inline std::set<double>& seen(const Side side) noexcept {
+		return (side == Side::Bid) ? _seen_bids : _seen_asks;
+	}
+
+	inline double& range(const Side side) noexcept {
+		return (side == Side::Bid) ? _range_bid : _range_ask;
+	}
+
+};
+
+}; // namespace sim
@@ -0,0 +1,932 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Book.h"
+#include "Market.h"
+#include "../binance/Assets.h"
+#include "../binance/types.h"
+#include "../binance/rest/api.h"
+#include "../parser/Scanner.h"
+#include "../Config.h"
+#include "../Log.h"
+
+namespace sim {
+
+/**
+ * The exchange side of an account in a backtest. Answers the REST requests of a binance::rest::Connector switched
+ * to it, see Connector::simulate(), and matches the orders against the books of the sim::Market.
+ *
+ *  - A request is matched once the send latency has passed and answered after the ack one; the clock of the
+ *    strategy, blocked on the request, advances by both.
+ *  - A taking order walks the recorded book from the best level; past the last level known, e.g. of a ticker book,
+ *    the rest is filled at its price. The recorded book is not depleted by the orders of the backtest.
+ *  - A resting order joins the queue behind the quantity shown at its price, or behind the one shown once the
+ *    level is known if it is not at the time. The trades at the price consume the queue ahead and then the order;
+ *    a trade through the price fills it up to the trade quantity; the other side reaching the price fills it up to
+ *    the quantity shown there. A decrease of the level not explained by the trades is taken as the cancels,
+ *    spread over the queue ahead and behind in proportion.
+ *  - The stop orders trigger on the trades; a fill or a trigger of an OCO leg expires the other one.
+ *  - The commission is charged of the asset received at Config::SimMakerFee or Config::SimTakerFee.
+ *    The balances start at Config::SimStartBalance of every asset of the pairs and are not enforced.
+ */
+class Exchange {
+public:
+
+	enum class Method {
+		Get,
+		Post,
+		Delete
+	};
+
+private:
+
+	using Side = Book::Side;  // The side of the book an order rests on, Bid for a BUY.
+	using Type = binance::rest::OrderRequest::Type;
+	using TimeInForce = binance::rest::OrderRequest::TimeInForce;
+
+	static constexpr double Epsilon = 1e-12;
+	static constexpr double Unknown = -1.;  // The queue ahead is not known yet.
+	static constexpr size_t NoOrder = ~size_t(0u);
+
+	enum class Status {
+		New,
+		PartiallyFilled,
+		Filled,
+		Canceled,
+		Expired
+	};
+
+	struct Order {
+		std::string client_id;
+		binance::SInteger id;
+		binance::SInteger list_id;  // -1 if none.
+		size_t pair;
+		Side side;
+		Type type;
+		TimeInForce time_in_force;
+		double price;
+		double stop_price;
+		double qty;        // Zero if the quote quantity is given.
+		double quote_qty;
+		double executed;
+		double quote;      // The cummulativeQuoteQty.
+		double ahead;      // The queue ahead at the price, Unknown if not known yet.
+		double traded;     // At the price since the last change of the level.
+		Status status;
+		bool working;      // In the book or waiting for the trigger.
+		bool triggered;    // The stop order works as its MARKET or LIMIT counterpart.
+		binance::Time time;
+		binance::Time update_time;
+	};
+
+	struct Fill {
+		double price;
+		double qty;
+		double commission;
+		binance::AssetId asset;
+		binance::SInteger trade_id;
+	};
+
+	Market& _market;
+	std::vector<Order> _orders;    // All of the session, the ID of an order is its index plus one.
+	std::vector<size_t> _working;
+	std::vector<size_t> _scan;     // The working orders an event goes over, as it may change them.
+	std::vector<double> _balances; // By binance::AssetId.
+	std::vector<Fill> _fills;      // Of the order being entered, for the FULL response.
+	size_t _entering;
+	binance::SInteger _next_list_id;
+	binance::SInteger _next_trade_id;
+	std::string _response;
+
+	uint64_t _fills_maker;
+	uint64_t _fills_taker;
+	uint64_t _rejects;
+
+public:
+
+	Exchange(const Exchange&) = delete;
+	Exchange& operator=(const Exchange&) = delete;
+
+	/**
+	 * The pairs of the market are added before.
+	 */
+	explicit Exchange(Market& market) noexcept :
+		_market(market),
+		_entering(NoOrder),
+		_next_list_id(1),
+		_next_trade_id(1),
+		_fills_maker(0u),
+		_fills_taker(0u),
+		_rejects(0u) {
+
+		for(size_t idx = 0; idx < market.pairs_nb(); ++idx) {
+			balance(market.pair(idx).base) = Config::SimStartBalance;
+			balance(market.pair(idx).quote) = Config::SimStartBalance;
+		}
+		market.listen(cb_market, this);
+	}
+
+	/**
+	 * Serves a request in the simulated time.
+	 * @param endpoint - The path after '/api/v3/', e.g. 'order'.
+	 * @param query - The parameters, either of the URL or of the POST body.
+	 * @return - The response body, either the one of Binance or its error.
+	 */
+	const std::string& request(const Method method, std::string_view endpoint, std::string_view query) noexcept {
+		_market.send();
+		_response.clear();
+		_fills.clear();
+		_entering = NoOrder;
+
+		if(method == Method::Get && endpoint == "account") {
+			account();
+		} else if(method == Method::Get && endpoint == "allOrders") {
+			all_orders(query);
+		} else if(method == Method::Get && endpoint == "order") {
+			query_order(query);
+		} else if(method == Method::Post && endpoint == "order") {
+			new_order(query);
+		} else if(method == Method::Post && endpoint == "order/cancelReplace") {
+			cancel_replace(query);
+		} else if(method == Method::Post && endpoint == "orderList/oco") {
+			new_oco(query);
+		} else if(method == Method::Delete && endpoint == "order") {
+			cancel_order(query);
+		} else if(method == Method::Delete && endpoint == "openOrders") {
+			cancel_open_orders(query);
+		} else {
+			error(-1000, "Not supported by the simulator.");
+		}
+
+		_market.ack();
+		return _response;
+	}
+
+	void dump() const noexcept {
+		LOG_INFO("Exchange : orders=%zu fills maker=%llu taker=%llu rejects=%llu;", _orders.size(),
+		         static_cast<unsigned long long>(_fills_maker), static_cast<unsigned long long>(_fills_taker),
+		         static_cast<unsigned long long>(_rejects));
+		for(binance::AssetId id = 0; id < _balances.size(); ++id) {
+			if(_balances[id] != 0.) {
+				LOG_PLAIN(" %s=%.8f", binance::Assets::name(id).c_str(), _balances[id]);
+			}
+		}
+		LOG_PLAIN("\n");
+	}
+
+private:
+
+	// ---------------------------------
+	// The endpoints.
+	// ---------------------------------
+
+	void account() noexcept {
+		char buffer[256];
+		snprintf(buffer, sizeof(buffer),
+		         "{\"makerCommission\":%d,\"takerCommission\":%d,\"buyerCommission\":0,\"sellerCommission\":0,"
+		         "\"commissionRates\":{\"maker\":\"%.8f\",\"taker\":\"%.8f\",\"buyer\":\"0.00000000\",\"seller\":\"0.00000000\"},",
+		         static_cast<int>(std::lround(Config::SimMakerFee * 10000.)),
+		         static_cast<int>(std::lround(Config::SimTakerFee * 10000.)), Config::SimMakerFee, Config::SimTakerFee);
+		_response.append(buffer);
+		_response.append("\"canTrade\":true,\"canWithdraw\":false,\"canDeposit\":false,\"brokered\":false,"
+		                 "\"requireSelfTradePrevention\":false,");
+		snprintf(buffer, sizeof(buffer), "\"updateTime\":%llu,\"accountType\":\"SPOT\",\"balances\":[",
+		         static_cast<unsigned long long>(_market.now()));
+		_response.append(buffer);
+
+		bool first = true;
+		for(binance::AssetId id = 0; id < _balances.size(); ++id) {
+			if(std::isnan(_balances[id])) {
+				continue;
+			}
+			_response.append(first ? "{\"asset\":\"" : ",{\"asset\":\"");
+			_response.append(binance::Assets::name(id));
+			_response.append("\",\"free\":");
+			decimal(_balances[id]);
+			_response.append(",\"locked\":\"0.00000000\"}");
+			first = false;
+		}
+		_response.append("],\"permissions\":[\"SPOT\"]}");
+	}
+
+	void all_orders(std::string_view query) noexcept {
+		const auto pair = _market.find(param(query, "symbol"));
+		if(pair == Market::NoPair) {
+			error(-1121, "Invalid symbol.");
+			return;
+		}
+		_response.append("[");
+		bool first = true;
+		for(const auto& item : _orders) {
+			if(item.pair == pair) {
+				if(not first) {
+					_response.append(",");
+				}
+				order_json(item, nullptr, false);
+				first = false;
+			}
+		}
+		_response.append("]");
+	}
+
+	void query_order(std::string_view query) noexcept {
+		const auto idx = find(query, "origClientOrderId", false);
+		if(idx == NoOrder) {
+			error(-2013, "Order does not exist.");
+			return;
+		}
+		order_json(_orders[idx], nullptr, false);
+	}
+
+	void new_order(std::string_view query) noexcept {
+		Order order;
+		if(not parse(query, "", param(query, "newClientOrderId"), order) || not check(order)) {
+			return;
+		}
+		const auto idx = place(std::move(order));
+		order_json(_orders[idx], nullptr, true);
+	}
+
+	void cancel_order(std::string_view query) noexcept {
+		const auto idx = find(query, "origClientOrderId", true);
+		if(idx == NoOrder) {
+			error(-2011, "Unknown order sent.");
+			return;
+		}
+		cancel(idx);
+		order_json(_orders[idx], &_orders[idx].client_id, false);
+	}
+
+	void cancel_open_orders(std::string_view query) noexcept {
+		const auto pair = _market.find(param(query, "symbol"));
+		_scan.clear();
+		for(const auto idx : _working) {
+			if(_orders[idx].pair == pair) {
+				_scan.push_back(idx);
+			}
+		}
+		if(_scan.empty()) {
+			error(-2011, "Unknown order sent.");
+			return;
+		}
+
+		_response.append("[");
+		for(size_t pos = 0; pos < _scan.size(); ++pos) {
+			const auto idx = _scan[pos];
+			if(_orders[idx].working) {
+				cancel(idx);
+			}
+			if(pos) {
+				_response.append(",");
+			}
+			order_json(_orders[idx], &_orders[idx].client_id, false);
+		}
+		_response.append("]");
+	}
+
+	/**
+	 * STOP_ON_FAILURE, the new order is not placed if the cancel fails.
+	 */
+	void cancel_replace(std::string_view query) noexcept {
+		const auto cancel_idx = find(query, "cancelOrigClientOrderId", true);
+		Order order;
+		if(cancel_idx == NoOrder) {
+			error(-2022, "Order cancel-replace failed.");
+			return;
+		}
+		cancel(cancel_idx);
+		if(not parse(query, "", param(query, "newClientOrderId"), order) || not check(order)) {
+			error(-2021, "Order cancel-replace partially failed.");
+			return;
+		}
+		const auto idx = place(std::move(order));
+
+		_response.append("{\"cancelResult\":\"SUCCESS\",\"newOrderResult\":\"SUCCESS\",\"cancelResponse\":");
+		order_json(_orders[cancel_idx], &_orders[cancel_idx].client_id, false);
+		_response.append(",\"newOrderResponse\":");
+		order_json(_orders[idx], nullptr, false);
+		_response.append("}");
+	}
+
+	void new_oco(std::string_view query) noexcept {
+		Order above;
+		Order below;
+		if(not parse(query, "above", param(query, "aboveClientOrderId"), above) || not check(above)
+		   || not parse(query, "below", param(query, "belowClientOrderId"), below) || not check(below)) {
+			return;
+		}
+		above.list_id = _next_list_id;
+		below.list_id = _next_list_id;
+		_next_list_id++;
+
+		// Placed both before either is matched, a leg filled at once expires the other one.
+		const auto above_idx = add(std::move(above));
+		const auto below_idx = add(std::move(below));
+		execute(above_idx);
+		if(_orders[below_idx].working) {
+			execute(below_idx);
+		}
+
+		char buffer[192];
+		const auto& leg = _orders[above_idx];
+		snprintf(buffer, sizeof(buffer), "{\"orderListId\":%lld,\"contingencyType\":\"OCO\",\"listStatusType\":\"%s\","
+		                                 "\"listOrderStatus\":\"%s\",\"transactionTime\":%llu,\"listClientOrderId\":\"",
+		         static_cast<long long>(leg.list_id), working_list(leg.list_id) ? "EXEC_STARTED" : "ALL_DONE",
+		         working_list(leg.list_id) ? "EXECUTING" : "ALL_DONE", static_cast<unsigned long long>(_market.now()));
+		_response.append(buffer);
+		_response.append(param(query, "listClientOrderId"));
+		_response.append("\",\"symbol\":\"");
+		_response.append(_market.pair(leg.pair).symbol);
+		_response.append("\",\"orderReports\":[");
+		order_json(_orders[above_idx], nullptr, false);
+		_response.append(",");
+		order_json(_orders[below_idx], nullptr, false);
+		_response.append("]}");
+	}
+
+	// ---------------------------------
+	// The matching.
+	// ---------------------------------
+
+	/**
+	 * Reads the order of the request, the parameters of an OCO leg are prefixed, e.g. 'abovePrice'.
+	 * @param client_id - Empty if the exchange assigns one.
+	 */
+	bool parse(std::string_view query, const std::string& prefix, std::string_view client_id, Order& order) noexcept {
+		const auto key = [&prefix](const char* name) {
+			std::string result(prefix.empty() ? std::string(1u, static_cast<char>(tolower(name[0]))) + (name + 1) : prefix + name);
+			return result;
+		};
+
+		order = Order{std::string(client_id), 0, -1, _market.find(param(query, "symbol")), Side::Bid, Type::MARKET,
+		              TimeInForce::GTC, 0., 0., 0., 0., 0., 0., Unknown, 0., Status::New, false, false, 0u, 0u};
+		if(order.pair == Market::NoPair) {
+			return error(-1121, "Invalid symbol.");
+		}
+		order.side = (param(query, "side") == "SELL") ? Side::Ask : Side::Bid;
+
+		bool result = enum_param(param(query, key("Type")), order.type);
+		if(not param(query, key("TimeInForce")).empty()) {
+			result &= enum_param(param(query, key("TimeInForce")), order.time_in_force);
+		}
+		result &= decimal_param(param(query, "quantity"), order.qty);
+		result &= decimal_param(param(query, "quoteOrderQty"), order.quote_qty);
+		result &= decimal_param(param(query, key("Price")), order.price);
+		result &= decimal_param(param(query, key("StopPrice")), order.stop_price);
+		if(not result) {
+			return error(-1102, "Mandatory parameter was not sent, was empty/null, or malformed.");
+		}
+		return true;
+	}
+
+	/**
+	 * The checks of the exchange filters are left out, the orders are the ones the strategy would send live.
+	 */
+	bool check(const Order& order) noexcept {
+		const auto& item = _market.pair(order.pair);
+		bool valid = (order.qty > 0.) || (order.type == Type::MARKET && order.quote_qty > 0.);
+		valid &= not has_price(order.type) || order.price > 0.;
+		valid &= not has_stop(order.type) || order.stop_price > 0.;
+		if(not valid) {
+			return error(-1102, "Mandatory parameter was not sent, was empty/null, or malformed.");
+		}
+
+		for(const auto idx : _working) {
+			if(_orders[idx].client_id == order.client_id) {
+				return error(-2010, "Duplicate order sent.");
+			}
+		}
+
+		if(order.type == Type::LIMIT_MAKER && crosses(order, order.price)) {
+			return error(-2010, "Order would immediately match and take.");
+		}
+
+		if(has_stop(order.type) && item.last_price > 0. && trigger(order, item.last_price)) {
+			return error(-2010, "Stop price would trigger immediately.");
+		}
+		return true;
+	}
+
+	size_t add(Order&& order) noexcept {
+		order.id = static_cast<binance::SInteger>(_orders.size() + 1u);
+		if(order.client_id.empty()) {
+			order.client_id = "sim" + std::to_string(order.id);  // Assigned by the exchange if not given.
+		}
+		order.time = _market.now();
+		order.update_time = order.time;
+		order.working = true;
+		_orders.push_back(std::move(order));
+		_working.push_back(_orders.size() - 1u);
+		return _orders.size() - 1u;
+	}
+
+	size_t place(Order&& order) noexcept {
+		const auto idx = add(std::move(order));
+		_entering = idx;
+		execute(idx);
+		return idx;
+	}
+
+	/**
+	 * Matches a working order as its type says: takes the book, rests in it or waits for the trigger.
+	 */
+	void execute(const size_t idx) noexcept {
+		auto& order = _orders[idx];
+		auto type = order.type;
+		if(has_stop(type)) {
+			if(not order.triggered) {
+				return;
+			}
+			type = has_price(type) ? Type::LIMIT : Type::MARKET;
+		}
+
+		switch(type) {
+			case Type::MARKET:
+				take(idx, 0.);
+				if(_orders[idx].working) {
+					finish(idx, Status::Expired);
+				}
+				break;
+
+			case Type::LIMIT:
+				if(order.time_in_force == TimeInForce::FOK && available(order) < order.qty - Epsilon) {
+					finish(idx, Status::Expired);
+					break;
+				}
+				take(idx, order.price);
+				if(_orders[idx].working) {
+					if(_orders[idx].time_in_force == TimeInForce::GTC) {
+						rest(idx);
+					} else {
+						finish(idx, Status::Expired);
+					}
+				}
+				break;
+
+			default:
+				rest(idx);
+				break;
+		}
+	}
+
+	/**
+	 * Fills the order by the levels of the other side as long as they are within the limit price, zero is none.
+	 */
+	void take(const size_t idx, const double limit) noexcept {
+		const auto& order = _orders[idx];
+		const auto& book = _market.pair(order.pair).book;
+		double last = 0.;
+
+		book.walk(Book::opposite(order.side), [&](const double price, const double qty) {
+			if(limit > 0. && Book::better(order.side, price, limit)) {
+				return false;
+			}
+			last = price;
+			fill(idx, price, std::min(qty, remaining(order, price)), false);
+			return order.working;
+		});
+
+		// The depth is not known past the last level.
+		if(order.working && last > 0. && (limit == 0. || not book.depth())) {
+			fill(idx, last, remaining(order, last), false);
+		}
+	}
+
+	/**
+	 * @return - The quantity the book offers within the limit price of the order, for a FOK one.
+	 */
+	double available(const Order& order) const noexcept {
+		const auto& book = _market.pair(order.pair).book;
+		double result = 0.;
+		double last = 0.;
+		book.walk(Book::opposite(order.side), [&](const double price, const double qty) {
+			if(Book::better(order.side, price, order.price)) {
+				return false;
+			}
+			last = price;
+			result += qty;
+			return true;
+		});
+		return (last > 0. && not book.depth()) ? order.qty : result;
+	}
+
+	void rest(const size_t idx) noexcept {
+		auto& order = _orders[idx];
+		const auto& book = _market.pair(order.pair).book;
+		order.ahead = book.known(order.side, order.price) ? book.quantity(order.side, order.price) : Unknown;
+		order.traded = 0.;
+	}
+
+	void fill(const size_t idx, const double price, const double qty, const bool maker) noexcept {
+		if(qty <= Epsilon) {
+			return;
+		}
+		auto& order = _orders[idx];
+		const auto& item = _market.pair(order.pair);
+		const double rate = maker ? Config::SimMakerFee : Config::SimTakerFee;
+		const double quote = qty * price;
+
+		Fill result{price, qty, 0., item.base, _next_trade_id++};
+		if(order.side == Side::Bid) {
+			result.commission = qty * rate;
+			balance(item.base) += qty - result.commission;
+			balance(item.quote) -= quote;
+		} else {
+			result.commission = quote * rate;
+			result.asset = item.quote;
+			balance(item.base) -= qty;
+			balance(item.quote) += quote - result.commission;
+		}
+		if(idx == _entering) {
+			_fills.push_back(result);
+		}
+		(maker ? _fills_maker : _fills_taker)++;
+
+		order.executed += qty;
+		order.quote += quote;
+		order.update_time = _market.now();
+		order.status = Status::PartiallyFilled;
+		if(remaining(order, price) <= Epsilon) {
+			finish(idx, Status::Filled);
+		}
+		expire_list(idx);
+	}
+
+	/**
+	 * @return - The base quantity left, of the quote one at the price if the order is of the quote quantity.
+	 */
+	static inline double remaining(const Order& order, const double price) noexcept {
+		if(order.qty > 0.) {
+			return std::max(order.qty - order.executed, 0.);
+		}
+		return std::max(order.quote_qty - order.quote, 0.) / price;
+	}
+
+	void finish(const size_t idx, const Status status) noexcept {
+		auto& order = _orders[idx];
+		order.status = status;
+		order.update_time = _market.now();
+		if(order.working) {
+			order.working = false;
+			_working.erase(std::find(_working.begin(), _working.end(), idx));
+		}
+	}
+
+	void cancel(const size_t idx) noexcept {
+		const auto list_id = _orders[idx].list_id;
+		finish(idx, Status::Canceled);
+		if(list_id >= 0) {
+			for(size_t pos = _working.size(); pos-- > 0;) {
+				if(_orders[_working[pos]].list_id == list_id) {
+					finish(_working[pos], Status::Canceled);
+				}
+			}
+		}
+	}
+
+	/**
+	 * The other legs of an OCO expire once a leg is filled or triggered.
+	 */
+	void expire_list(const size_t idx) noexcept {
+		const auto list_id = _orders[idx].list_id;
+		if(list_id < 0) {
+			return;
+		}
+		for(size_t pos = _working.size(); pos-- > 0;) {
+			const auto other = _working[pos];
+			if(other != idx && _orders[other].list_id == list_id) {
+				finish(other, Status::Expired);
+			}
+		}
+	}
+
+	bool working_list(const binance::SInteger list_id) const noexcept {
+		for(const auto idx : _working) {
+			if(_orders[idx].list_id == list_id) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// ---------------------------------
+	// The market events.
+	// ---------------------------------
+
+	static void cb_market(void* instance, const Market::Event& event) noexcept {
+		auto obj = reinterpret_cast<Exchange*>(instance);
+		if(obj->_working.empty()) {
+			return;
+		}
+
+		obj->_scan.clear();
+		for(const auto idx : obj->_working) {
+			if(obj->_orders[idx].pair == event.pair) {
+				obj->_scan.push_back(idx);
+			}
+		}
+		for(const auto idx : obj->_scan) {
+			if(not obj->_orders[idx].working) {
+				continue;
+			}
+			switch(event.type) {
+				case Market::Event::Type::Trade:
+					obj->on_trade(idx, event);
+					break;
+
+				case Market::Event::Type::Level:
+					obj->on_level(idx, event);
+					break;
+
+				case Market::Event::Type::Book:
+					obj->on_book(idx);
+					break;
+			}
+		}
+	}
+
+	void on_trade(const size_t idx, const Market::Event& event) noexcept {
+		auto& order = _orders[idx];
+		if(has_stop(order.type) && not order.triggered) {
+			if(trigger(order, event.price)) {
+				order.triggered = true;
+				order.update_time = _market.now();
+				expire_list(idx);
+				execute(idx);
+			}
+			return;
+		}
+
+		if(order.side != event.side) {
+			return;
+		}
+		if(Book::better(order.side, order.price, event.price)) {
+			// Through the price, the order would have been taken first.
+			fill(idx, order.price, std::min(event.qty, remaining(order, order.price)), true);
+		} else if(order.price == event.price) {
+			if(order.ahead == Unknown) {
+				const auto& book = _market.pair(order.pair).book;
+				if(not book.known(order.side, order.price)) {
+					return;
+				}
+				order.ahead = book.quantity(order.side, order.price);
+			}
+			order.traded += event.qty;
+			if(order.ahead >= event.qty) {
+				order.ahead -= event.qty;
+			} else {
+				const double qty = event.qty - order.ahead;
+				order.ahead = 0.;
+				fill(idx, order.price, std::min(qty, remaining(order, order.price)), true);
+			}
+		}
+	}
+
+	void on_level(const size_t idx, const Market::Event& event) noexcept {
+		auto& order = _orders[idx];
+		if(order.side != event.side || order.price != event.price || order.ahead == Unknown || is_waiting(order)) {
+			return;
+		}
+		const double decrease = event.old_qty - event.qty;
+		if(decrease > 0. && event.old_qty > 0.) {
+			const double cancels = std::max(decrease - order.traded, 0.);
+			order.ahead = std::max(order.ahead - cancels * order.ahead / event.old_qty, 0.);
+		}
+		order.ahead = std::min(order.ahead, event.qty);
+		order.traded = 0.;
+	}
+
+	void on_book(const size_t idx) noexcept {
+		auto& order = _orders[idx];
+		if(is_waiting(order)) {
+			return;
+		}
+		const auto& book = _market.pair(order.pair).book;
+		const auto other = Book::opposite(order.side);
+		const double price = book.best(other);
+		if(price > 0. && crosses(order, order.price)) {
+			fill(idx, order.price, std::min(book.best_qty(other), remaining(order, order.price)), true);
+			if(not order.working) {
+				return;
+			}
+		}
+		if(book.known(order.side, order.price)) {
+			const double qty = book.quantity(order.side, order.price);
+			order.ahead = (order.ahead == Unknown) ? qty : std::min(order.ahead, qty);
+		}
+	}
+
+	// ---------------------------------
+	// The helpers.
+	// ---------------------------------
+
+	/**
+	 * @return true - if the price of the order reaches the other side of the book.
+	 */
+	bool crosses(const Order& order, const double price) const noexcept {
+		const auto& book = _market.pair(order.pair).book;
+		const double other = book.best(Book::opposite(order.side));
+		return other > 0. && (price == other || Book::better(order.side, price, other));
+	}
+
+	static bool trigger(const Order& order, const double last) noexcept {
+		const bool buy = (order.side == Side::Bid);
+		switch(order.type) {
+			case Type::STOP_LOSS:
+			case Type::STOP_LOSS_LIMIT:
+				return buy ? last >= order.stop_price : last <= order.stop_price;
+
+			case Type::TAKE_PROFIT:
+			case Type::TAKE_PROFIT_LIMIT:
+				return buy ? last <= order.stop_price : last >= order.stop_price;
+
+			default:
+				return false;
+		}
+	}
+
+	static inline bool is_waiting(const Order& order) noexcept {
+		return has_stop(order.type) && not order.triggered;
+	}
+
+	static inline bool has_price(const Type type) noexcept {
+		return type != Type::MARKET && type != Type::STOP_LOSS && type != Type::TAKE_PROFIT;
+	}
+
+	static inline bool has_stop(const Type type) noexcept {
+		return type == Type::STOP_LOSS || type == Type::STOP_LOSS_LIMIT || type == Type::TAKE_PROFIT
+		       || type == Type::TAKE_PROFIT_LIMIT;
+	}
+
+	/**
+	 * @param working - Only the working orders.
+	 * @return - The order of the client ID in the parameter, or of the 'orderId' one; NoOrder if none.
+	 */
+	size_t find(std::string_view query, const char* key, const bool working) const noexcept {
+		const auto client_id = param(query, key);
+		binance::SInteger id = 0;
+		parser::Scanner::to_integer(param(query, "orderId"), id);
+		for(size_t idx = _orders.size(); idx-- > 0;) {
+			const auto& item = _orders[idx];
+			if((item.client_id == client_id || item.id == id) && (item.working || not working)) {
+				return idx;
+			}
+		}
+		return NoOrder;
+	}
+
+	inline double& balance(const binance::AssetId id) noexcept {
+		if(id >= _balances.size()) {
+			_balances.resize(id + 1u, std::nan(""));
+		}
+		if(std::isnan(_balances[id])) {
+			_balances[id] = 0.;
+		}
+		return _balances[id];
+	}
+
+	static std::string_view param(std::string_view query, std::string_view key) noexcept {
+		while(not query.empty()) {
+			const auto amp = query.find('&');
+			const auto item = query.substr(0, amp);
+			if(item.size() > key.size() && item[key.size()] == '=' && item.substr(0, key.size()) == key) {
+				return item.substr(key.size() + 1u);
+			}
+			if(amp == std::string_view::npos) {
+				break;
+			}
+			query.remove_prefix(amp + 1u);
+		}
+		return {};
+	}
+
+	/**
+	 * An absent parameter is zero.
+	 */
+	static bool decimal_param(std::string_view value, double& result) noexcept {
+		return value.empty() || parser::Scanner::to_decimal(value, result);
+	}
+
+	static bool enum_param(std::string_view value, Type& result) noexcept {
+		for(const auto item : {Type::MARKET, Type::LIMIT, Type::LIMIT_MAKER, Type::STOP_LOSS, Type::STOP_LOSS_LIMIT,
+		                       Type::TAKE_PROFIT, Type::TAKE_PROFIT_LIMIT}) {
+			if(value == binance::rest::OrderRequest::to_string(item)) {
+				result = item;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static bool enum_param(std::string_view value, TimeInForce& result) noexcept {
+		for(const auto item : {TimeInForce::GTC, TimeInForce::IOC, TimeInForce::FOK}) {
+			if(value == binance::rest::OrderRequest::to_string(item)) {
+				result = item;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static const char* to_string(const Status status) noexcept {
+		switch(status) {
+			case Status::New:
+				return "NEW";
+			case Status::PartiallyFilled:
+				return "PARTIALLY_FILLED";
+			case Status::Filled:
+				return "FILLED";
+			case Status::Canceled:
+				return "CANCELED";
+			case Status::Expired:
+				return "EXPIRED";
+		}
+		return "";
+	}
+
+	// ---------------------------------
+	// The response writing.
+	// ---------------------------------
+
+	/**
+	 * @return - Always false, so a check returns it.
+	 */
+	bool error(const int code, const char* msg) noexcept {
+		char buffer[160];
+		snprintf(buffer, sizeof(buffer), "{\"code\":%d,\"msg\":\"%s\"}", code, msg);
+		_response.assign(buffer);
+		_rejects++;
+		return false;
+	}
+
+	inline void decimal(const double value) noexcept {
+		char buffer[48];
+		snprintf(buffer, sizeof(buffer), "\"%.8f\"", value);
+		_response.append(buffer);
+	}
+
+	/**
+	 * @param orig_client_id - The one of a cancel, nullptr if none.
+	 * @param fills - The FULL response of the order entry.
+	 */
+	void order_json(const Order& order, const std::string* orig_client_id, const bool fills) noexcept {
+		char buffer[160];
+		_response.append("{\"symbol\":\"");
+		_response.append(_market.pair(order.pair).symbol);
+		snprintf(buffer, sizeof(buffer), "\",\"orderId\":%lld,\"orderListId\":%lld,\"clientOrderId\":\"",
+		         static_cast<long long>(order.id), static_cast<long long>(order.list_id));
+		_response.append(buffer);
+		_response.append(order.client_id);
+		if(orig_client_id) {
+			_response.append("\",\"origClientOrderId\":\"");
+			_response.append(*orig_client_id);
+		}
+		snprintf(buffer, sizeof(buffer), "\",\"transactTime\":%llu,\"time\":%llu,\"updateTime\":%llu,\"price\":",
+		         static_cast<unsigned long long>(order.update_time), static_cast<unsigned long long>(order.time),
+		         static_cast<unsigned long long>(order.update_time));
+		_response.append(buffer);
+		decimal(order.price);
+		_response.append(",\"origQty\":");
+		decimal(order.qty > 0. ? order.qty : order.executed);
+		_response.append(",\"executedQty\":");
+		decimal(order.executed);
+		_response.append(",\"cummulativeQuoteQty\":");
+		decimal(order.quote);
+		snprintf(buffer, sizeof(buffer), ",\"status\":\"%s\",\"timeInForce\":\"%s\",\"type\":\"%s\",\"side\":\"%s\",\"stopPrice\":",
+		         to_string(order.status), binance::rest::OrderRequest::to_string(order.time_in_force),
+		         binance::rest::OrderRequest::to_string(order.type), order.side == Side::Bid ? "BUY" : "SELL");
+		_response.append(buffer);
+		decimal(order.stop_price);
+		snprintf(buffer, sizeof(buffer), ",\"workingTime\":%llu,\"selfTradePreventionMode\":\"NONE\"",
+		         static_cast<unsigned long long>(order.time));
+		_response.append(buffer);
+
+		if(fills) {
+			_response.append(",\"fills\":[");
+			for(size_t idx = 0; idx < _fills.size(); ++idx) {
+				const auto& item = _fills[idx];
+				_response.append(idx ? ",{\"price\":" : "{\"price\":");
+				decimal(item.price);
+				_response.append(",\"qty\":");
+				decimal(item.qty);
+				_response.append(",\"commission\":");
+				decimal(item.commission);
+				_response.append(",\"commissionAsset\":\"");
+				_response.append(binance::Assets::name(item.asset));
+				snprintf(buffer, sizeof(buffer), "\",\"tradeId\":%lld}", static_cast<long long>(item.trade_id));
+				_response.append(buffer);
+			}
+			_response.append("]");
+		}
+		_response.append("}");
+	}
+
+};
+
+}; // namespace sim
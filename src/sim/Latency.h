@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../Config.h"
+#include "../Log.h"
+
+namespace sim {
+
+/**
+ * The latencies of a backtest: the order round trip, split into the send and the ack, and the market data delay.
+ *
+ * Either fixed or drawn from the histograms of a live run as scraped from its metrics endpoint:
+ * 'bintest_rest_latency_seconds{endpoint="order"}' is the round trip of the order entry, split by
+ * Config::SimSendShare, and 'bintest_ws_latency_seconds' is the delay of a frame behind its exchange event time.
+ * A draw picks a bucket by its share of the observations and a uniform point within it; the +Inf bucket gives
+ * its lower bound. The draws are seeded by Config::SimSeed, so a backtest repeats.
+ */
+class Latency {
+
+	struct Distribution {
+		double fixed_ms;               // Used if there are no observations.
+		std::vector<double> bounds_ms; // The bucket upper bounds, ascending, the last is +Inf.
+		std::vector<uint64_t> counts;  // Cumulative, as exposed.
+	};
+
+	Distribution _order;
+	Distribution _market;
+	double _send_share;
+	uint64_t _state;
+
+public:
+
+	Latency() noexcept :
+		_order{Config::SimSendMS + Config::SimAckMS, {}, {}},
+		_market{Config::SimMarketMS, {}, {}},
+		_send_share(Config::SimSendShare),
+		_state(Config::SimSeed) {
+	}
+
+	/**
+	 * @param spec - Either the fixed 'send:ack:market' milliseconds, e.g. '5:5:2', or the path of a metrics dump.
+	 * Empty keeps the Config::SimSendMS, Config::SimAckMS and Config::SimMarketMS ones.
+	 */
+	bool init(const std::string& spec) noexcept {
+		if(spec.empty()) {
+			return true;
+		}
+
+		double send, ack, market;
+		char tail;
+		if(sscanf(spec.c_str(), "%lf:%lf:%lf%c", &send, &ack, &market, &tail) == 3) {
+			if(send < 0. || ack < 0. || market < 0.) {
+				return false;
+			}
+			_order.fixed_ms = send + ack;
+			_send_share = (send + ack > 0.) ? send / (send + ack) : Config::SimSendShare;
+			_market.fixed_ms = market;
+			return true;
+		}
+		return load(spec.c_str());
+	}
+
+	/**
+	 * Draws the latencies of an order request.
+	 * @param send_ms - Till the request is matched.
+	 * @param ack_ms - Till the response is received since then.
+	 */
+	void order(uint64_t& send_ms, uint64_t& ack_ms) noexcept {
+		const auto round_trip = std::llround(draw(_order));
+		send_ms = static_cast<uint64_t>(std::llround(static_cast<double>(round_trip) * _send_share));
+		ack_ms = static_cast<uint64_t>(round_trip) - send_ms;
+	}
+
+	/**
+	 * Draws the delay of a market data frame.
+	 */
+	inline uint64_t market() noexcept {
+		return static_cast<uint64_t>(std::llround(draw(_market)));
+	}
+
+	void dump() const noexcept {
+		LOG_INFO("Latency : order ");
+		dump(_order);
+		LOG_PLAIN(" (send %.0f%%), market data ", _send_share * 100.);
+		dump(_market);
+		LOG_PLAIN("\n");
+	}
+
+private:
+
+	bool load(const char* path) noexcept {
+		FILE* file = fopen(path, "r");
+		if(file == nullptr) {
+			LOG_ERROR("Unable to open the metrics dump '%s'.\n", path);
+			return false;
+		}
+
+		char* line = nullptr;
+		size_t cap = 0;
+		while(getline(&line, &cap, file) > 0) {
+			if(strncmp(line, "bintest_rest_latency_seconds_bucket{", 36u) == 0) {
+				if(strstr(line, "endpoint=\"order\"")) {
+					bucket(_order, line);
+				}
+			} else if(strncmp(line, "bintest_ws_latency_seconds_bucket{", 34u) == 0) {
+				bucket(_market, line);
+			}
+		}
+		free(line);
+		fclose(file);
+
+		if(_order.counts.empty() || _order.counts.back() == 0u) {
+			LOG_INFO("The metrics dump '%s' has no order latency, %.1f ms is taken.\n", path, _order.fixed_ms);
+		}
+		if(_market.counts.empty() || _market.counts.back() == 0u) {
+			LOG_INFO("The metrics dump '%s' has no market data latency, %.1f ms is taken.\n", path, _market.fixed_ms);
+		}
+		return true;
+	}
+
+	/**
+	 * Takes a '<family>_bucket{...,le="0.005"} 42' line.
+	 */
+	static void bucket(Distribution& dist, const char* line) noexcept {
+		const char* le = strstr(line, "le=\"");
+		const char* close = strchr(line, '}');
+		if(le == nullptr || close == nullptr) {
+			return;
+		}
+		le += 4;
+		double bound = std::numeric_limits<double>::infinity();
+		if(strncmp(le, "+Inf", 4u) != 0) {
+			bound = strtod(le, nullptr) * 1000.;
+		}
+		dist.bounds_ms.push_back(bound);
+		dist.counts.push_back(strtoull(close + 1, nullptr, 10));
+	}
+
+	double draw(const Distribution& dist) noexcept {
+		if(dist.counts.empty() || dist.counts.back() == 0u) {
+			return dist.fixed_ms;
+		}
+		const auto pick = static_cast<uint64_t>(uniform() * static_cast<double>(dist.counts.back()));
+		size_t idx = 0;
+		while(idx + 1u < dist.counts.size() && dist.counts[idx] <= pick) {
+			idx++;
+		}
+		const double lower = idx ? dist.bounds_ms[idx - 1u] : 0.;
+		const double upper = dist.bounds_ms[idx];
+		if(std::isinf(upper)) {
+			return lower;
+		}
+		return lower + uniform() * (upper - lower);
+	}
+
+	/**
+	 * xorshift64*, [0, 1).
+	 */
+	inline double uniform() noexcept {
+		_state ^= _state >> 12u;
+		_state ^= _state << 25u;
+		_state ^= _state >> 27u;
+		return static_cast<double>((_state * 0x2545F4914F6CDD1Dull) >> 11u) * 0x1.0p-53;
+	}
+
+	static void dump(const Distribution& dist) noexcept {
+		if(dist.counts.empty() || dist.counts.back() == 0u) {
+			LOG_PLAIN("fixed %.1f ms", dist.fixed_ms);
+		} else {
+			LOG_PLAIN("of %llu observations", static_cast<unsigned long long>(dist.counts.back()));
+		}
+	}
+
+};
+
+}; // namespace sim
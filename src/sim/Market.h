@@ -0,0 +1,547 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Book.h"
+#include "Latency.h"
+#include "../binance/Assets.h"
+#include "../binance/types.h"
+#include "../binance/ws/api.h"
+#include "../parser/Scanner.h"
+#include "../Utils.h"
+#include "../Log.h"
+
+namespace sim {
+
+/**
+ * The market of a backtest: replays the capture recorded by 'bintest -X' into the books of the pairs
+ * and drives the clock of the process, see Utils::time_simulate().
+ *
+ * The capture is read apart from the ws::Connector replay the strategy takes its frames from, since the exchange is
+ * ahead of the strategy: a record is applied to the book at its event time, the strategy receives it the market
+ * data latency later. The records taken are:
+ *  - '@depth*', either the diff depth stream or the partial book depth snapshots;
+ *  - '@trade' and '@aggTrade', the aggressor side is the one of the 'm' flag;
+ *  - '@ticker', the best bid and ask if the pair has no depth stream, the last trade if it has no trade stream;
+ *    the aggressor of a ticker trade is the side of the book its price is closer to.
+ * The listeners, i.e. the sim::Exchange of the accounts, are told the changes as they are applied.
+ * Not thread safe, runs on the event loop thread.
+ */
+class Market {
+public:
+
+	struct Event {
+		enum class Type {
+			Trade,  // A trade of the quantity at the price, the side is the one of the book hit.
+			Level,  // The quantity of the level has changed from the old one.
+			Book    // A record has been applied.
+		};
+
+		Type type;
+		size_t pair;
+		Book::Side side;
+		double price;
+		double qty;
+		double old_qty;
+	};
+
+	using CallBack_t = void (*)(void* instance, const Event& event);
+
+	struct Pair {
+		std::string symbol;  // 'BNBBTC'
+		std::string stream;  // The stream path prefix, '/ws/bnbbtc@'.
+		binance::AssetId base;
+		binance::AssetId quote;
+		Book book;
+		bool trades;         // The pair has a trade stream, the ticker trades are not taken then.
+		double last_price;   // Of the last trade.
+		double last_qty;
+		binance::UInteger last_trade_id;
+	};
+
+	static constexpr size_t NoPair = ~size_t(0u);
+
+private:
+
+	enum class Kind {
+		Ticker,
+		Trade,
+		Depth
+	};
+
+	struct Listener {
+		CallBack_t callback;
+		void* instance;
+	};
+
+	Latency& _latency;
+	std::vector<Pair> _pairs;
+	std::vector<Listener> _listeners;
+
+	FILE* _file;
+	char* _line;
+	size_t _cap;
+
+	// The record read ahead, applied once the clock reaches its time.
+	bool _pending;
+	size_t _pending_pair;
+	Kind _pending_kind;
+	std::string_view _pending_payload;
+	binance::Time _pending_time;
+
+	binance::Time _now;         // The clock of the strategy, ms.
+	binance::Time _event_time;  // The latest event time read.
+	uint64_t _ack_ms;           // Of the request being served.
+
+	std::vector<std::pair<double, double>> _levels;  // The scratch of a depth record.
+	std::vector<double> _removed;
+
+	uint64_t _records;
+	uint64_t _trades;
+	uint64_t _level_updates;
+	uint64_t _requests;
+	binance::Time _start;
+
+public:
+
+	Market(const Market&) = delete;
+	Market& operator=(const Market&) = delete;
+
+	explicit Market(Latency& latency) noexcept :
+		_latency(latency),
+		_file(nullptr),
+		_line(nullptr),
+		_cap(0u),
+		_pending(false),
+		_pending_pair(NoPair),
+		_pending_kind(Kind::Ticker),
+		_pending_time(0u),
+		_now(0u),
+		_event_time(0u),
+		_ack_ms(0u),
+		_records(0u),
+		_trades(0u),
+		_level_updates(0u),
+		_requests(0u),
+		_start(0u) {
+	}
+
+	~Market() noexcept {
+		if(_file) {
+			fclose(_file);
+		}
+		free(_line);
+		Utils::time_simulate(0u);
+	}
+
+	/**
+	 * Called before open(); the records of the other pairs are skipped.
+	 * @return - The ID of the pair.
+	 */
+	size_t add_pair(const std::string& base, const std::string& quote) noexcept {
+		std::string stream("/ws/" + base + quote + "@");
+		Utils::string_to_lower(stream);
+		_pairs.push_back(Pair{
+			base + quote, stream, binance::Assets::intern(base), binance::Assets::intern(quote), Book(), false, 0., 0., 0u
+		});
+		return _pairs.size() - 1u;
+	}
+
+	/**
+	 * @return - The ID of the pair, NoPair if it is not simulated.
+	 */
+	size_t find(std::string_view symbol) const noexcept {
+		for(size_t idx = 0; idx < _pairs.size(); ++idx) {
+			if(_pairs[idx].symbol == symbol) {
+				return idx;
+			}
+		}
+		return NoPair;
+	}
+
+	inline const Pair& pair(const size_t id) const noexcept {
+		return _pairs[id];
+	}
+
+	inline size_t pairs_nb() const noexcept {
+		return _pairs.size();
+	}
+
+	void listen(CallBack_t callback, void* instance) noexcept {
+		_listeners.push_back(Listener{callback, instance});
+	}
+
+	/**
+	 * Opens the capture, the clock starts at its first record.
+	 */
+	bool open(const char* path) noexcept {
+		LOG_DEBUG("sim::Market::open('%s')\n", path);
+		_file = fopen(path, "r");
+		if(_file == nullptr) {
+			LOG_ERROR("Unable to open the capture '%s'.\n", path);
+			return false;
+		}
+		if(not read()) {
+			LOG_ERROR("The capture '%s' has no record of the simulated pairs.\n", path);
+			return false;
+		}
+		_start = _pending_time;
+		_now = _pending_time;
+		Utils::time_simulate(_now);
+		return true;
+	}
+
+	inline binance::Time now() const noexcept {
+		return _now;
+	}
+
+	/**
+	 * The strategy receives a frame of the event time; the clock moves to the time it arrives at.
+	 */
+	inline void receive(const binance::Time event_time) noexcept {
+		const auto at = event_time + _latency.market();
+		if(at > _now) {
+			_now = at;
+			Utils::time_simulate(_now);
+		}
+		advance(_now);
+	}
+
+	/**
+	 * A request of the strategy reaches the exchange; the book is brought up to the time.
+	 */
+	void send() noexcept {
+		uint64_t send_ms;
+		_latency.order(send_ms, _ack_ms);
+		_requests++;
+		_now += send_ms;
+		Utils::time_simulate(_now);
+		advance(_now);
+	}
+
+	/**
+	 * The response reaches the strategy, which has been waiting for it.
+	 */
+	inline void ack() noexcept {
+		_now += _ack_ms;
+		Utils::time_simulate(_now);
+	}
+
+	/**
+	 * Applies the records up to the time.
+	 */
+	void advance(const binance::Time time) noexcept {
+		while(_pending || read()) {
+			if(_pending_time > time) {
+				break;
+			}
+			_pending = false;
+			apply(_pending_pair, _pending_kind, _pending_payload);
+		}
+	}
+
+	/**
+	 * Applies a '<stream path> <payload>' record at once, whatever the clock.
+	 * @return false - if the record is not of a simulated pair or stream.
+	 */
+	bool process(std::string_view line) noexcept {
+		size_t pair;
+		Kind kind;
+		std::string_view payload;
+		binance::Time time;
+		if(not header(line, pair, kind, payload, time)) {
+			return false;
+		}
+		apply(pair, kind, payload);
+		return true;
+	}
+
+	/**
+	 * A plane subscriber, the ticks of the strategy drive the clock.
+	 */
+	static void cb_tick(void* instance, const binance::ws::SymbolTicker& ticker) noexcept {
+		reinterpret_cast<Market*>(instance)->receive(ticker.eventTime);
+	}
+
+	void dump() const noexcept {
+		LOG_INFO("Market : records=%llu trades=%llu levels=%llu requests=%llu simulated=%.1f min\n",
+		         static_cast<unsigned long long>(_records), static_cast<unsigned long long>(_trades),
+		         static_cast<unsigned long long>(_level_updates), static_cast<unsigned long long>(_requests),
+		         static_cast<double>(_now - _start) / 60000.);
+	}
+
+private:
+
+	/**
+	 * Reads the next record of the simulated pairs.
+	 */
+	bool read() noexcept {
+		if(_file == nullptr) {
+			return false;
+		}
+		ssize_t len;
+		while((len = getline(&_line, &_cap, _file)) > 0) {
+			const auto size = static_cast<size_t>(len) - (_line[len - 1] == '\n');
+			if(header(std::string_view(_line, size), _pending_pair, _pending_kind, _pending_payload, _pending_time)) {
+				_pending = true;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Parses the stream path and the event time of the record; a record with no event time, e.g. a partial depth
+	 * snapshot, takes the one of the record before.
+	 */
+	bool header(
+		std::string_view line, size_t& pair, Kind& kind, std::string_view& payload, binance::Time& time
+	           ) noexcept {
+		const auto space = line.find(' ');
+		if(space == std::string_view::npos) {
+			return false;
+		}
+		const auto path = line.substr(0, space);
+
+		pair = NoPair;
+		for(size_t idx = 0; idx < _pairs.size(); ++idx) {
+			if(path.substr(0, _pairs[idx].stream.size()) == _pairs[idx].stream) {
+				pair = idx;
+				break;
+			}
+		}
+		if(pair == NoPair) {
+			return false;
+		}
+
+		const auto stream = path.substr(_pairs[pair].stream.size());
+		if(stream.substr(0, 5u) == "depth") {
+			kind = Kind::Depth;
+		} else if(stream == "trade" || stream == "aggTrade") {
+			kind = Kind::Trade;
+		} else if(stream == "ticker") {
+			kind = Kind::Ticker;
+		} else {
+			return false;
+		}
+
+		payload = line.substr(space + 1u);
+		const auto key = payload.find("\"E\":");
+		if(key != std::string_view::npos) {
+			parser::Scanner::to_integer(payload.substr(key + 4u, payload.find_first_of(",}", key) - key - 4u), _event_time);
+		}
+		time = _event_time;
+		return true;
+	}
+
+	void apply(const size_t pair, const Kind kind, std::string_view payload) noexcept {
+		_records++;
+		switch(kind) {
+			case Kind::Ticker:
+				apply_ticker(pair, payload);
+				break;
+
+			case Kind::Trade:
+				apply_trade(pair, payload);
+				break;
+
+			case Kind::Depth:
+				apply_depth(pair, payload);
+				break;
+		}
+		emit(Event{Event::Type::Book, pair, Book::Side::Bid, 0., 0., 0.});
+	}
+
+	void apply_ticker(const size_t id, std::string_view payload) noexcept {
+		binance::ws::SymbolTicker ticker;
+		if(not ticker.parse(payload)) {
+			return;
+		}
+
+		// The trade first, the book shows its outcome.
+		auto& item = _pairs[id];
+		if(not item.trades && ticker.lastQuantity > 0.) {
+			const bool fresh = ticker.lastTradeID ? (ticker.lastTradeID != item.last_trade_id)
+			                                      : (ticker.lastPrice != item.last_price || ticker.lastQuantity != item.last_qty);
+			if(fresh) {
+				const double bid = item.book.best(Book::Side::Bid);
+				const double ask = item.book.best(Book::Side::Ask);
+				auto side = Book::Side::Ask;
+				if(bid > 0. && ticker.lastPrice <= bid) {
+					side = Book::Side::Bid;
+				} else if(ask > 0. && ticker.lastPrice < ask && bid > 0. && ticker.lastPrice < (bid + ask) / 2.) {
+					side = Book::Side::Bid;
+				}
+				trade(id, side, ticker.lastPrice, ticker.lastQuantity);
+			}
+		}
+		item.last_trade_id = ticker.lastTradeID;
+
+		if(not item.book.depth()) {
+			top(id, Book::Side::Bid, ticker.bestBidPrice, ticker.bestBidQuantity);
+			top(id, Book::Side::Ask, ticker.bestAskPrice, ticker.bestAskQuantity);
+		}
+	}
+
+	/**
+	 * The ticker book: the quantity of the top level is known while the price stays.
+	 */
+	void top(const size_t id, const Book::Side side, const double price, const double qty) noexcept {
+		auto& book = _pairs[id].book;
+		if(price == book.best(side)) {
+			level(id, side, price, qty);
+		} else {
+			book.clear(side);
+			if(price > 0.) {
+				book.set(side, price, qty);
+			}
+		}
+	}
+
+	void apply_trade(const size_t id, std::string_view payload) noexcept {
+		parser::Scanner scan(payload);
+		std::string_view key;
+		double price = 0.;
+		double qty = 0.;
+		bool maker = false;  // The buyer is the maker, the seller hits the bids.
+		if(not scan.begin_object()) {
+			return;
+		}
+		while(scan.member(key)) {
+			if(key == "p") {
+				scan.decimal(price);
+			} else if(key == "q") {
+				scan.decimal(qty);
+			} else if(key == "m") {
+				scan.boolean(maker);
+			} else {
+				scan.skip();
+			}
+		}
+		if(scan.ok() && price > 0. && qty > 0.) {
+			_pairs[id].trades = true;
+			trade(id, maker ? Book::Side::Bid : Book::Side::Ask, price, qty);
+		}
+	}
+
+	/**
+	 * Either a diff depth event, 'b' and 'a', or a partial book depth snapshot, 'bids' and 'asks'.
+	 */
+	void apply_depth(const size_t id, std::string_view payload) noexcept {
+		auto& book = _pairs[id].book;
+		if(not book.depth()) {
+			// The ticker book is replaced.
+			book.depth(true);
+			book.clear(Book::Side::Bid);
+			book.clear(Book::Side::Ask);
+		}
+
+		parser::Scanner scan(payload);
+		std::string_view key;
+		if(not scan.begin_object()) {
+			return;
+		}
+		while(scan.member(key)) {
+			const bool partial = (key == "bids" || key == "asks");
+			if(not partial && key != "b" && key != "a") {
+				scan.skip();
+				continue;
+			}
+			if(not levels(scan)) {
+				return;
+			}
+			const auto side = (key[0] == 'b') ? Book::Side::Bid : Book::Side::Ask;
+			if(partial) {
+				snapshot(id, side);
+			} else {
+				for(const auto& item : _levels) {
+					level(id, side, item.first, item.second);
+				}
+			}
+		}
+	}
+
+	/**
+	 * Reads the '[["price","qty"],...]' array into the scratch.
+	 */
+	bool levels(parser::Scanner& scan) noexcept {
+		_levels.clear();
+		if(not scan.begin_array()) {
+			return false;
+		}
+		while(scan.element()) {
+			double price = 0.;
+			double qty = 0.;
+			if(not scan.begin_array() || not scan.element() || not scan.decimal(price) || not scan.element()
+			   || not scan.decimal(qty)) {
+				return false;
+			}
+			while(scan.element()) {
+				scan.skip();
+			}
+			_levels.emplace_back(price, qty);
+		}
+		return scan.ok();
+	}
+
+	/**
+	 * The levels of the snapshot replace the ones within its range, the ones out of it are not known any more.
+	 */
+	void snapshot(const size_t id, const Book::Side side) noexcept {
+		auto& book = _pairs[id].book;
+		if(_levels.empty()) {
+			book.clear(side);
+			return;
+		}
+		book.trim(side, _levels.back().first);
+
+		_removed.clear();
+		book.walk(side, [this](const double price, const double) {
+			bool found = false;
+			for(const auto& item : _levels) {
+				found |= (item.first == price);
+			}
+			if(not found) {
+				_removed.push_back(price);
+			}
+			return true;
+		});
+		for(const auto price : _removed) {
+			level(id, side, price, 0.);
+		}
+		for(const auto& item : _levels) {
+			level(id, side, item.first, item.second);
+		}
+	}
+
+	inline void level(const size_t id, const Book::Side side, const double price, const double qty) noexcept {
+		const double old = _pairs[id].book.set(side, price, qty);
+		if(old != qty) {
+			_level_updates++;
+			emit(Event{Event::Type::Level, id, side, price, qty, old});
+		}
+	}
+
+	inline void trade(const size_t id, const Book::Side side, const double price, const double qty) noexcept {
+		auto& item = _pairs[id];
+		item.last_price = price;
+		item.last_qty = qty;
+		_trades++;
+		emit(Event{Event::Type::Trade, id, side, price, qty, 0.});
+	}
+
+	inline void emit(const Event& event) noexcept {
+		for(const auto& item : _listeners) {
+			item.callback(item.instance, event);
+		}
+	}
+
+};
+
+}; // namespace sim
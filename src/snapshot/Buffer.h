@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace snapshot {
+
+/**
+ * The compact binary form of the state: the fields are written as they are in memory, one after another,
+ * with no names and no padding. The strings are prefixed by the uint16 length.
+ * The layout is versioned as a whole by snapshot::File, a component reads back exactly what it has written.
+ */
+class Encoder {
+
+	std::string& _buffer;
+
+public:
+
+	/**
+	 * @param buffer - Appended to. Keeps its capacity between the snapshots.
+	 */
+	explicit Encoder(std::string& buffer) noexcept : _buffer(buffer) {
+	}
+
+	template <typename T>
+	inline void put(const T value) noexcept {
+		static_assert(std::is_trivially_copyable<T>::value, "The value is stored as it is in memory.");
+		_buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	inline void put(const std::string_view value) noexcept {
+		const auto len = static_cast<uint16_t>(std::min<size_t>(value.size(), UINT16_MAX));
+		put(len);
+		_buffer.append(value.data(), len);
+	}
+
+	inline void put(const std::string& value) noexcept {
+		put(std::string_view(value));
+	}
+
+	inline void put(const char* value) noexcept {
+		put(std::string_view(value));
+	}
+
+	inline size_t size() const noexcept {
+		return _buffer.size();
+	}
+};
+
+/**
+ * Reads the Encoder output back. A read past the end fails the decoder once and for all,
+ * so a sequence of reads is checked once with ok() at the end.
+ */
+class Decoder {
+
+	const char* _ptr;
+	const char* _end;
+	bool _ok;
+
+public:
+
+	Decoder(const char* data, const size_t len) noexcept : _ptr(data), _end(data + len), _ok(true) {
+	}
+
+	template <typename T>
+	inline bool get(T& value) noexcept {
+		static_assert(std::is_trivially_copyable<T>::value, "The value is stored as it is in memory.");
+		if(not _ok || static_cast<size_t>(_end - _ptr) < sizeof(T)) {
+			_ok = false;
+			return false;
+		}
+		memcpy(&value, _ptr, sizeof(T));
+		_ptr += sizeof(T);
+		return true;
+	}
+
+	inline bool get(std::string& value) noexcept {
+		uint16_t len;
+		if(not get(len) || static_cast<size_t>(_end - _ptr) < len) {
+			_ok = false;
+			return false;
+		}
+		value.assign(_ptr, len);
+		_ptr += len;
+		return true;
+	}
+
+	/**
+	 * Marks the decoder failed, e.g. by a value out of the range.
+	 */
+	inline void fail() noexcept {
+		_ok = false;
+	}
+
+	inline bool ok() const noexcept {
+		return _ok;
+	}
+
+	/**
+	 * @return true - if everything has been read and nothing has failed.
+	 */
+	inline bool done() const noexcept {
+		return _ok && _ptr == _end;
+	}
+};
+
+}; // namespace snapshot
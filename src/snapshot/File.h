@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+
+#include "Buffer.h"
+#include "../Log.h"
+
+namespace snapshot {
+
+/**
+ * The snapshot file: a header followed by the Encoder payload.
+ *   magic uint32, version uint32, payload size uint64, payload FNV-1a uint64, payload.
+ *
+ * The file is replaced atomically, a crash leaves either the previous snapshot or the new one.
+ * The writing and the fsync() are done by a thread of its own, so the event loop only encodes the state
+ * and hands the buffer over; a snapshot not written yet is replaced by a newer one.
+ */
+class File {
+
+	static constexpr uint32_t Magic = 0x4E535442u;  // 'BTSN'
+	static constexpr size_t HeaderSize = 24u;
+
+	const std::string _path;
+	const uint32_t _version;
+
+	std::mutex _mutex;
+	std::condition_variable _cv;
+	std::string _pending;  // The latest snapshot handed over, guarded by the mutex.
+	bool _dirty;
+	bool _stop;
+	std::thread _thread;
+
+public:
+
+	File(const File&) = delete;
+	File& operator=(const File&) = delete;
+
+	/**
+	 * @param version - The payload layout version, a snapshot of another version is not loaded.
+	 */
+	File(std::string path, const uint32_t version) noexcept :
+		_path(std::move(path)),
+		_version(version),
+		_dirty(false),
+		_stop(false) {
+	}
+
+	~File() noexcept {
+		stop();
+	}
+
+	inline const std::string& path() const noexcept {
+		return _path;
+	}
+
+	/**
+	 * Starts the writing thread.
+	 */
+	void start() noexcept {
+		_stop = false;
+		_thread = std::thread(&File::run, this);
+	}
+
+	/**
+	 * Hands the snapshot over to the writing thread.
+	 * @param payload - Swapped with the previous pending one, so the buffers keep their capacity.
+	 */
+	void submit(std::string& payload) noexcept {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_pending.swap(payload);
+			_dirty = true;
+		}
+		_cv.notify_one();
+	}
+
+	/**
+	 * Stops the writing thread, the pending snapshot is written first.
+	 */
+	void stop() noexcept {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_cv.notify_one();
+		if(_thread.joinable()) {
+			_thread.join();
+		}
+	}
+
+	/**
+	 * Writes the snapshot synchronously.
+	 */
+	bool save(const std::string& payload) const noexcept {
+		const std::string tmp_path(_path + ".tmp");
+		FILE* file = fopen(tmp_path.c_str(), "wb");
+		if(file == nullptr) {
+			LOG_ERROR("snapshot::File::save() unable to open '%s'\n", tmp_path.c_str());
+			return false;
+		}
+
+		std::string header;
+		Encoder enc(header);
+		enc.put(Magic);
+		enc.put(_version);
+		enc.put(static_cast<uint64_t>(payload.size()));
+		enc.put(checksum(payload.data(), payload.size()));
+
+		bool result = fwrite(header.data(), 1u, header.size(), file) == header.size();
+		result &= fwrite(payload.data(), 1u, payload.size(), file) == payload.size();
+		result &= (fflush(file) == 0) && (fsync(fileno(file)) == 0);
+		result &= (fclose(file) == 0);
+		result = result && (rename(tmp_path.c_str(), _path.c_str()) == 0);
+
+		if(not result) {
+			LOG_ERROR("snapshot::File::save() unable to write '%s'\n", _path.c_str());
+		}
+		return result;
+	}
+
+	/**
+	 * @return false - if there is no snapshot or it is not a valid one of the version.
+	 */
+	bool load(std::string& payload) const noexcept {
+		FILE* file = fopen(_path.c_str(), "rb");
+		if(file == nullptr) {
+			LOG_INFO("No snapshot in '%s', starting from scratch.\n", _path.c_str());
+			return false;
+		}
+
+		char header[HeaderSize];
+		uint32_t magic = 0u;
+		uint32_t version = 0u;
+		uint64_t size = 0u;
+		uint64_t sum = 0u;
+
+		bool result = fread(header, 1u, HeaderSize, file) == HeaderSize;
+		if(result) {
+			Decoder dec(header, HeaderSize);
+			dec.get(magic);
+			dec.get(version);
+			dec.get(size);
+			dec.get(sum);
+			result = (magic == Magic) && (version == _version) && (size <= MaxPayload);
+		}
+		if(result) {
+			payload.resize(size);
+			result = fread(&payload[0], 1u, size, file) == size && fgetc(file) == EOF;
+		}
+		fclose(file);
+
+		if(not result || checksum(payload.data(), payload.size()) != sum) {
+			LOG_ERROR("snapshot::File::load() '%s' is malformed or of another version, ignored.\n", _path.c_str());
+			return false;
+		}
+		return true;
+	}
+
+private:
+
+	static constexpr uint64_t MaxPayload = 64ull << 20u;
+
+	void run() noexcept {
+		std::string payload;
+		std::unique_lock<std::mutex> lock(_mutex);
+		while(true) {
+			_cv.wait(lock, [this] { return _dirty || _stop; });
+			if(_dirty) {
+				payload.swap(_pending);
+				_dirty = false;
+				lock.unlock();
+				save(payload);
+				lock.lock();
+			} else {
+				break;
+			}
+		}
+	}
+
+	static uint64_t checksum(const char* data, const size_t len) noexcept {
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for(size_t idx = 0; idx < len; ++idx) {
+			hash ^= static_cast<uint8_t>(data[idx]);
+			hash *= 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+};
+
+}; // namespace snapshot
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "../Config.h"
+#include "../Utils.h"
+#include "../CliConfig.h"
+#include "../market/TickStore.h"
+#include "../params/Store.h"
+
+/**
+ * The components AppStrategy is assembled from. Every policy is a plain class constructed from the CLI parameters
+ * with the non-virtual methods below, so the whole decision path of a tick is inlined into the state machine.
+ * The parameters which may be reloaded are read from params::Store on every call, not kept.
+ *
+ *   Signal - the price move closing the position, in percents, fixed at the entry:
+ *            double threshold_percent(const market::TickStore& ticks) const;
+ *   Entry  - the pauses before the trades:
+ *            unsigned first_wait_sec(); unsigned wait_sec() const;
+ *   Exit   - the holding period and the trigger scale as the position ages:
+ *            unsigned hold_sec() const; double scale(uint64_t entry_ms) const;
+ *   Sizing - the quote quantity of a trade:
+ *            double quote_quantity(double price) const;
+ *   Risk   - whether a trade may start and whether a stale feed closes the position:
+ *            bool allow_entry(bool feed_stale) const; bool exit_on_stale() const;
+ */
+namespace strategy {
+
+// ---------------------------------
+// Signal
+// ---------------------------------
+
+/**
+ * The fixed percent of the parameters.
+ */
+class PercentTrigger {
+	const params::Store& _params;
+
+public:
+
+	explicit PercentTrigger(const CliConfig&) noexcept : _params(params::Store::instance()) {
+	}
+
+	inline double threshold_percent(const market::TickStore&) const noexcept {
+		return _params.get().price_trigger_percent;
+	}
+};
+
+/**
+ * The multiple of the recent price deviation, so the trigger widens in a volatile market and narrows in a calm one.
+ * Falls back to the percent of the parameters until enough ticks are collected.
+ */
+class VolatilityTrigger {
+	const params::Store& _params;
+
+public:
+
+	explicit VolatilityTrigger(const CliConfig&) noexcept : _params(params::Store::instance()) {
+	}
+
+	double threshold_percent(const market::TickStore& ticks) const noexcept {
+		const double fixed = _params.get().price_trigger_percent;
+		const auto stats = ticks.stats_last(Config::VolatilityWindowSec * 1000ull);
+		if(stats.count < Config::VolatilityMinTicks || stats.price_mean <= 0.) {
+			return fixed;
+		}
+		const double percent = Config::VolatilityTriggerK * stats.price_stddev / stats.price_mean * 100.;
+		return std::max(percent, fixed * Config::VolatilityFloorRatio);
+	}
+};
+
+// ---------------------------------
+// Entry
+// ---------------------------------
+
+/**
+ * A random pause within the wait period before the first trade, the whole period between the trades.
+ */
+class RandomEntry {
+	const params::Store& _params;
+
+public:
+
+	explicit RandomEntry(const CliConfig&) noexcept : _params(params::Store::instance()) {
+		srand(Utils::time_now_sec()); // TODO: std::random would be a better way to do that
+	}
+
+	inline unsigned first_wait_sec() noexcept {
+		// TODO: not uniformly distributed.
+		return std::abs(std::rand()) % _params.get().wait_period_sec;
+	}
+
+	inline unsigned wait_sec() const noexcept {
+		return _params.get().wait_period_sec;
+	}
+};
+
+// ---------------------------------
+// Exit
+// ---------------------------------
+
+/**
+ * Holds the position for the trade period, the trigger stays the same.
+ */
+class PeriodExit {
+	const params::Store& _params;
+
+public:
+
+	explicit PeriodExit(const CliConfig&) noexcept : _params(params::Store::instance()) {
+	}
+
+	inline unsigned hold_sec() const noexcept {
+		return _params.get().trade_period_sec;
+	}
+
+	inline double scale(uint64_t) const noexcept {
+		return 1.;
+	}
+};
+
+/**
+ * Holds the position for the trade period, the trigger shrinks linearly to zero by its end,
+ * so an aging position is closed by an ever smaller move.
+ */
+class DecayingExit {
+	const params::Store& _params;
+
+public:
+
+	explicit DecayingExit(const CliConfig&) noexcept : _params(params::Store::instance()) {
+	}
+
+	inline unsigned hold_sec() const noexcept {
+		return _params.get().trade_period_sec;
+	}
+
+	inline double scale(const uint64_t entry_ms) const noexcept {
+		const double elapsed = static_cast<double>(Utils::time_now_ms() - entry_ms);
+		return std::max(0., 1. - elapsed / (hold_sec() * 1000.));
+	}
+};
+
+// ---------------------------------
+// Sizing
+// ---------------------------------
+
+/**
+ * The quote quantity of the parameters.
+ */
+class FixedSize {
+	const params::Store& _params;
+
+public:
+
+	explicit FixedSize(const CliConfig&) noexcept : _params(params::Store::instance()) {
+	}
+
+	inline double quote_quantity(double) const noexcept {
+		return _params.get().quantity;
+	}
+};
+
+// ---------------------------------
+// Risk
+// ---------------------------------
+
+/**
+ * No trade starts on a stale feed; an open position is closed once the feed gets stale.
+ */
+class FeedRisk {
+public:
+
+	explicit FeedRisk(const CliConfig&) noexcept {
+	}
+
+	inline bool allow_entry(const bool feed_stale) const noexcept {
+		return not feed_stale;
+	}
+
+	inline bool exit_on_stale() const noexcept {
+		return true;
+	}
+};
+
+}; // namespace strategy
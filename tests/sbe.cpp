@@ -0,0 +1,186 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Utils.h"
+#include "binance/sbe/stream.h"
+
+// ---------------------------------
+// Decodes the SBE stream frames of BNBBTC, hex encoded as 'bintest -X' records them, and checks every field.
+// The frames follow the stream schema 1 version 0 byte by byte, so an offset mistaken in the views fails here.
+// ---------------------------------
+
+namespace {
+
+unsigned failures = 0u;
+
+#define CHECK(Cond) { \
+    if(not (Cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #Cond); \
+        failures++; \
+    } \
+}
+
+inline bool near(const double value, const double expected) noexcept {
+	return std::fabs(value - expected) < 1e-12;
+}
+
+std::string frame(const char* hex) {
+	std::string result;
+	if(not Utils::hex_to_bin(hex, strlen(hex), result)) {
+		fprintf(stderr, "The frame is not hex encoded.\n");
+		exit(EXIT_FAILURE);
+	}
+	return result;
+}
+
+// <symbol>@trade, two trades.
+const char* const TradesHex =
+	"120010270100000040222018240a060008222018240a0600f8f8190002000000015ed0b20000000091d0030000000000ecda1a0900"
+	"00000000025ed0b2000000008fd0030000000000a9f2e705000000000106424e42425443";
+
+// <symbol>@bestBidAsk.
+const char* const BestBidAskHex =
+	"3200112701000000e0a82118240a06004e61bc0000000000f8f88fd00300000000003c58650d0000000091d003000000000000e1f5"
+	"050000000006424e42425443";
+
+// <symbol>@depth20, two levels a side.
+const char* const DepthSnapshotHex =
+	"1200122701000000802f2318240a06005061bc0000000000f8f8100002008fd00300000000003c58650d000000008ed00300000000"
+	"0086426b13000000001000020091d003000000000000e1f5050000000092d00300000000004c7b81170000000006424e42425443";
+
+// <symbol>@depth, a bid removed and two asks.
+const char* const DepthDiffHex =
+	"1a0013270100000020b62418240a06005161bc00000000005a61bc0000000000f8f8100001008fd0030000000000000000000000"
+	"00001000020091d00300000000008117cc020000000093d00300000000002a46d8000000000006424e42425443";
+
+void trades() {
+	const auto data = frame(TradesHex);
+	binance::sbe::Frame frm;
+	CHECK(frm.wrap(data.data(), data.size()));
+	CHECK(frm.template_id() == 10000u);
+	const auto event = frm.trades();
+	CHECK(event != nullptr);
+	if(event == nullptr) {
+		return;
+	}
+	CHECK(event->event_time_us() == 1700000000123456);
+	CHECK(event->transact_time_us() == 1700000000123400);
+	CHECK(event->price_exponent() == -8);
+	CHECK(event->qty_exponent() == -8);
+	CHECK(event->symbol() == "BNBBTC");
+	CHECK(event->trades().size() == 2u);
+	if(event->trades().size() == 2u) {
+		const auto first = event->trades()[0];
+		CHECK(first.id() == 3000000001);
+		CHECK(near(first.price(), 0.00250001));
+		CHECK(near(first.qty(), 1.52754924));
+		CHECK(not first.is_buyer_maker());
+		const auto second = event->trades()[1];
+		CHECK(second.id() == 3000000002);
+		CHECK(near(second.price(), 0.00249999));
+		CHECK(near(second.qty(), 0.99087017));
+		CHECK(second.is_buyer_maker());
+	}
+	CHECK(frm.seq() == 3000000002u);
+	CHECK(frm.event_time_us() == 1700000000123456);
+}
+
+void best_bid_ask() {
+	const auto data = frame(BestBidAskHex);
+	binance::sbe::Frame frm;
+	CHECK(frm.wrap(data.data(), data.size()));
+	const auto event = frm.best_bid_ask();
+	CHECK(event != nullptr && frm.trades() == nullptr);
+	if(event == nullptr) {
+		return;
+	}
+	CHECK(event->event_time_us() == 1700000000223456);
+	CHECK(event->book_update_id() == 12345678);
+	CHECK(near(event->bid_price(), 0.00249999));
+	CHECK(near(event->bid_qty(), 2.24745532));
+	CHECK(near(event->ask_price(), 0.00250001));
+	CHECK(near(event->ask_qty(), 1.));
+	CHECK(event->symbol() == "BNBBTC");
+	CHECK(frm.seq() == 12345678u);
+}
+
+void depth_snapshot() {
+	const auto data = frame(DepthSnapshotHex);
+	binance::sbe::Frame frm;
+	CHECK(frm.wrap(data.data(), data.size()));
+	const auto event = frm.depth_snapshot();
+	CHECK(event != nullptr);
+	if(event == nullptr) {
+		return;
+	}
+	CHECK(event->event_time_us() == 1700000000323456);
+	CHECK(event->book_update_id() == 12345680);
+	CHECK(event->bids().size() == 2u && event->asks().size() == 2u);
+	if(event->bids().size() == 2u && event->asks().size() == 2u) {
+		CHECK(near(event->bids()[0].price(), 0.00249999) && near(event->bids()[0].qty(), 2.24745532));
+		CHECK(near(event->bids()[1].price(), 0.00249998) && near(event->bids()[1].qty(), 3.25796486));
+		CHECK(near(event->asks()[0].price(), 0.00250001) && near(event->asks()[0].qty(), 1.));
+		CHECK(near(event->asks()[1].price(), 0.00250002) && near(event->asks()[1].qty(), 3.94361676));
+	}
+	CHECK(event->symbol() == "BNBBTC");
+	CHECK(frm.seq() == 12345680u);
+}
+
+void depth_diff() {
+	const auto data = frame(DepthDiffHex);
+	binance::sbe::Frame frm;
+	CHECK(frm.wrap(data.data(), data.size()));
+	const auto event = frm.depth_diff();
+	CHECK(event != nullptr);
+	if(event == nullptr) {
+		return;
+	}
+	CHECK(event->event_time_us() == 1700000000423456);
+	CHECK(event->first_book_update_id() == 12345681);
+	CHECK(event->last_book_update_id() == 12345690);
+	CHECK(event->price_exponent() == -8 && event->qty_exponent() == -8);
+	CHECK(event->bids().size() == 1u && event->asks().size() == 2u);
+	if(event->bids().size() == 1u && event->asks().size() == 2u) {
+		CHECK(near(event->bids()[0].price(), 0.00249999) && event->bids()[0].qty() == 0.);
+		CHECK(near(event->asks()[0].price(), 0.00250001) && near(event->asks()[0].qty(), 0.46929793));
+		CHECK(near(event->asks()[1].price(), 0.00250003) && near(event->asks()[1].qty(), 0.14173738));
+	}
+	CHECK(event->symbol() == "BNBBTC");
+	CHECK(frm.seq() == 12345690u);
+}
+
+/**
+ * A truncated frame or one of another schema is not wrapped.
+ */
+void malformed() {
+	binance::sbe::Frame frm;
+	for(const char* hex : {TradesHex, BestBidAskHex, DepthSnapshotHex, DepthDiffHex}) {
+		const auto data = frame(hex);
+		for(size_t len = 0; len < data.size(); ++len) {
+			CHECK(not frm.wrap(data.data(), len));
+		}
+		auto other = data;
+		other[4] = 2;  // schemaId
+		CHECK(not frm.wrap(other.data(), other.size()));
+	}
+}
+
+}; // namespace
+
+int main() {
+	trades();
+	best_bid_ask();
+	depth_snapshot();
+	depth_diff();
+	malformed();
+
+	if(failures) {
+		fprintf(stderr, "%u checks failed.\n", failures);
+		return EXIT_FAILURE;
+	}
+	printf("All checks passed.\n");
+	return EXIT_SUCCESS;
+}
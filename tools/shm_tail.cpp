@@ -0,0 +1,100 @@
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <ctime>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "shm/Subscriber.h"
+
+// ---------------------------------
+// Prints the ticks of the market data bus published by 'bintest -Z <name>'.
+// A sample of the shm::Subscriber use, it links nothing but the C++ runtime.
+// ---------------------------------
+
+static volatile sig_atomic_t signal_abort = 0;
+
+static void signal_handler(int) {
+	signal_abort = 1;
+}
+
+static void print_usage(FILE* out, const char* bin) noexcept {
+	fprintf(out, "usage %s [options]\n", bin);
+	fprintf(out, "\t-n String. The bus name. [default value = '/bintest']\n");
+	fprintf(out, "\t-B Busy-poll the bus instead of sleeping when it is empty.\n");
+	fprintf(out, "\t-h Print this screen and exit.\n");
+}
+
+int main(int argc, char** argv) {
+	const char* name = "/bintest";
+	bool busy_poll = false;
+
+	int opt;
+	while((opt = getopt(argc, argv, "n:Bh")) != EOF) {
+		switch(opt) {
+			case 'n':
+				name = optarg;
+				break;
+
+			case 'B':
+				busy_poll = true;
+				break;
+
+			case 'h':
+				print_usage(stdout, argv[0]);
+				return EXIT_SUCCESS;
+
+			default:
+				print_usage(stderr, argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	signal(SIGINT, signal_handler);
+	signal(SIGTERM, signal_handler);
+
+	shm::Subscriber sub;
+	shm::Tick tick;
+	bool opened = false;
+	uint64_t lost = 0u;
+	while(not signal_abort) {
+		if(not opened) {
+			opened = sub.open(name);
+			lost = 0u;
+			if(not opened) {
+				fprintf(stderr, "Waiting for the bus '%s'...\n", name);
+				sleep(1u);
+			}
+			continue;
+		}
+
+		switch(sub.read(tick)) {
+			case shm::Subscriber::Result::Ok:
+				printf("%llu %s last=%.8f/%.8f bid=%.8f/%.8f ask=%.8f/%.8f%s\n",
+				       static_cast<unsigned long long>(tick.event_time), tick.symbol,
+				       tick.last_price, tick.last_quantity, tick.bid_price, tick.bid_quantity,
+				       tick.ask_price, tick.ask_quantity, sub.stale() ? " stale" : "");
+				break;
+
+			case shm::Subscriber::Result::Lost:
+				fprintf(stderr, "Lost %llu ticks.\n", static_cast<unsigned long long>(sub.lost() - lost));
+				lost = sub.lost();
+				break;
+
+			case shm::Subscriber::Result::Empty:
+				fflush(stdout);
+				if(not busy_poll) {
+					usleep(1000u);
+				}
+				break;
+
+			case shm::Subscriber::Result::Closed:
+				fprintf(stderr, "The bus '%s' is closed.\n", name);
+				sub.close();
+				opened = false;
+				break;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}